@@ -0,0 +1,75 @@
+// bench/bench_harness.hpp
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// operator new calls so far in this process (counted in lidar_bench.cpp).
+uint64_t allocationCount();
+
+struct BenchResult {
+  std::string name;
+  uint64_t packets = 0;           // packets per round
+  uint64_t points  = 0;           // points produced per round
+  double ns_per_packet      = 0;  // best round
+  double points_per_second  = 0;  // best round
+  double allocs_per_packet  = 0;  // mean over all measured rounds
+};
+
+/// Runs each benchmark body for one warm-up round plus `rounds` measured
+/// rounds. Time is taken from the fastest round, which filters out scheduler
+/// noise; allocations are averaged over every measured round.
+class BenchRunner {
+public:
+  BenchRunner(int rounds, const std::string& filter) : rounds_(rounds), filter_(filter) {}
+
+  /// body() processes `packets` packets and returns the number of points it
+  /// produced. Skipped if the name does not contain the filter string.
+  template <class Body>
+  void run(const std::string& name, size_t packets, Body body) {
+    if (!filter_.empty() && name.find(filter_) == std::string::npos) return;
+
+    uint64_t points = body();  // warm-up: caches, lazily sized buffers
+    double best_ns = 1e300;
+    uint64_t allocations = 0;
+    for (int r = 0; r < rounds_; ++r) {
+      uint64_t allocs_before = allocationCount();
+      auto start = std::chrono::steady_clock::now();
+      points = body();
+      auto end = std::chrono::steady_clock::now();
+      allocations += allocationCount() - allocs_before;
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      if (ns < best_ns) best_ns = ns;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.packets = packets;
+    result.points = points;
+    result.ns_per_packet = best_ns / packets;
+    result.points_per_second = points * 1e9 / best_ns;
+    result.allocs_per_packet = double(allocations) / (double(packets) * rounds_);
+    results_.push_back(result);
+  }
+
+  const std::vector<BenchResult>& results() const { return results_; }
+
+private:
+  int rounds_;
+  std::string filter_;
+  std::vector<BenchResult> results_;
+};
+
+/// Keeps a computed value alive so the optimizer cannot drop the work.
+template <class T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Benchmark groups, one per source tree (each in its own translation unit so
+// the two projects' same-named packet structs never meet)
+void runReader2Benches(BenchRunner& runner, const std::vector<uint8_t>& packets);
+void runSlamBenches(BenchRunner& runner, const std::vector<uint8_t>& packets);
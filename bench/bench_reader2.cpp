@@ -0,0 +1,177 @@
+// bench/bench_reader2.cpp -- reader2.0 parser, azimuth interpolation and angle-bin filter
+
+// reader2.0 and slam_lidar_cpp both define MSOPParser, MSOPPacket, DataBlock...
+// with different layouts. This translation unit compiles the reader2.0 sources
+// inside namespace reader2, so nothing it defines can collide at link time.
+// System headers come first; their include guards keep them out of the namespace.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace reader2 {
+#include "reader2.0/msop_parser.cpp"
+#include "reader2.0/msop_block_decoder.cpp"
+#include "reader2.0/point_cloud_soa.cpp"
+#include "reader2.0/angle_bin_filter.cpp"
+}  // namespace reader2
+
+#include "bench_harness.hpp"
+#include "msop_synth.hpp"
+
+using namespace reader2;
+
+// lidar_visualizer filters after every 150 packets
+static constexpr size_t FILTER_BATCH_PACKETS = 150;
+
+void runReader2Benches(BenchRunner& runner, const std::vector<uint8_t>& stream) {
+  const size_t count = stream.size() / MSOP_PAYLOAD_SIZE;
+  const uint8_t* packets = stream.data();
+
+  {
+    MSOPParser parser;
+    std::vector<LidarPoint> points;
+    runner.run("reader2/MSOPParser::parsePacket/vector", count, [&] {
+      uint64_t total = 0;
+      for (size_t i = 0; i < count; ++i) {
+        parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE, points);
+        total += points.size();
+      }
+      return total;
+    });
+  }
+
+  {
+    MSOPParser parser;
+    LidarPoint points[MSOPParser::MAX_POINTS_PER_PACKET];
+    runner.run("reader2/MSOPParser::parsePacket/array", count, [&] {
+      uint64_t total = 0;
+      for (size_t i = 0; i < count; ++i) {
+        total += parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE,
+                                    points, MSOPParser::MAX_POINTS_PER_PACKET);
+      }
+      doNotOptimize(points[0]);
+      return total;
+    });
+  }
+
+  {
+    MSOPParser parser;
+    PointCloudSoA cloud(MSOPParser::MAX_POINTS_PER_PACKET);
+    runner.run("reader2/MSOPParser::parsePacket/soa", count, [&] {
+      uint64_t total = 0;
+      for (size_t i = 0; i < count; ++i) {
+        cloud.clear();
+        parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE, cloud);
+        total += cloud.size();
+      }
+      return total;
+    });
+  }
+
+  {
+    // Every measurement of every valid block, as the parse loop calls it
+    MSOPParser parser;
+    runner.run("reader2/MSOPParser::calculateAzimuth", count, [&] {
+      uint64_t total = 0;
+      float sum = 0;
+      for (size_t i = 0; i < count; ++i) {
+        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(packets + i * MSOP_PAYLOAD_SIZE);
+        for (int b = 0; b < 12; ++b) {
+          if (ntohs(packet->data_blocks[b].flag) != 0xFFEE) continue;
+          uint16_t azimuth = ntohs(packet->data_blocks[b].azimuth);
+          uint16_t next = azimuth;
+          if (b < 11 && ntohs(packet->data_blocks[b + 1].flag) == 0xFFEE) {
+            next = ntohs(packet->data_blocks[b + 1].azimuth);
+          }
+          for (int m = 0; m < 16; ++m) {
+            sum += parser.calculateAzimuth(azimuth, next, m);
+          }
+          total += 16;
+        }
+      }
+      doNotOptimize(sum);
+      return total;
+    });
+  }
+
+  {
+    // Samples prepared the way lidar_visualizer collects them; only the filter is timed
+    MSOPParser parser;
+    std::vector<PointCloudSoA> batches;
+    std::vector<std::vector<uint16_t>> batch_bins;
+    PointCloudSoA packet_points(MSOPParser::MAX_POINTS_PER_PACKET);
+    for (size_t first = 0; first < count; first += FILTER_BATCH_PACKETS) {
+      batches.emplace_back();
+      batch_bins.emplace_back();
+      for (size_t i = first; i < std::min(count, first + FILTER_BATCH_PACKETS); ++i) {
+        packet_points.clear();
+        parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE, packet_points);
+        for (size_t k = 0; k < packet_points.size(); ++k) {
+          if (packet_points.range()[k] < 14.0f && packet_points.rssi()[k] > 15) {
+            batches.back().push_back(packet_points, k);
+            batch_bins.back().push_back(uint16_t(packet_points.azimuth()[k] * 2.0f));
+          }
+        }
+      }
+    }
+
+    PointCloudSoA filtered(ANGLE_BIN_COUNT);
+    runner.run("reader2/filterAngleBins", count, [&] {
+      uint64_t total = 0;
+      AngleBinFilterStats stats;
+      for (size_t b = 0; b < batches.size(); ++b) {
+        filtered.clear();
+        filterAngleBins(batches[b], batch_bins[b].data(), filtered, stats);
+        total += filtered.size();
+      }
+      return total;
+    });
+
+    // Same samples fed as they arrive, with filtered output taken at the same points
+    StreamingAngleFilter streaming;
+    runner.run("reader2/StreamingAngleFilter", count, [&] {
+      uint64_t total = 0;
+      AngleBinFilterStats stats;
+      streaming.reset();
+      for (size_t b = 0; b < batches.size(); ++b) {
+        streaming.addPoints(batches[b]);
+        filtered.clear();
+        streaming.writeFiltered(filtered, stats);
+        total += filtered.size();
+      }
+      return total;
+    });
+
+    // Each batch closed as a revolution of the sliding-window denoiser; the cost per
+    // revolution should not grow with the window
+    for (int revolutions : {5, 50}) {
+      SlidingWindowDenoiser denoiser(revolutions);
+      std::string name = "reader2/SlidingWindowDenoiser/N=" + std::to_string(revolutions);
+      runner.run(name, count, [&] {
+        uint64_t total = 0;
+        AngleBinFilterStats stats;
+        denoiser.reset();
+        for (size_t b = 0; b < batches.size(); ++b) {
+          denoiser.addPoints(batches[b]);
+          filtered.clear();
+          denoiser.finishRevolution(filtered, stats);
+          total += filtered.size();
+        }
+        return total;
+      });
+    }
+  }
+}
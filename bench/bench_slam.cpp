@@ -0,0 +1,119 @@
+// bench/bench_slam.cpp -- slam_lidar_cpp MSOPParser and LiDARReader scan decoding
+
+#include "lidar_reader.hpp"
+#include "occupancy_grid.hpp"
+#include "pcap_io.hpp"
+
+// The standalone MSOPParser in slam_lidar_cpp/src/msop_parser.cpp redefines the
+// data_type.h packet structs, so it is compiled inside its own namespace.
+// System headers come first; their include guards keep them out of the namespace.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <arpa/inet.h>
+
+namespace slam_standalone {
+#include "slam_lidar_cpp/src/msop_parser.cpp"
+}  // namespace slam_standalone
+
+#include "bench_harness.hpp"
+#include "msop_synth.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+void runSlamBenches(BenchRunner& runner, const std::vector<uint8_t>& stream) {
+  const size_t count = stream.size() / MSOP_PAYLOAD_SIZE;
+  const uint8_t* packets = stream.data();
+
+  {
+    slam_standalone::MSOPParser parser;
+    runner.run("slam/MSOPParser::parsePacket/vector", count, [&] {
+      uint64_t total = 0;
+      for (size_t i = 0; i < count; ++i) {
+        total += parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE).size();
+      }
+      return total;
+    });
+  }
+
+  {
+    slam_standalone::MSOPParser parser;
+    std::vector<slam_standalone::ParsedPoint> points(slam_standalone::MSOPParser::MAX_POINTS_PER_PACKET);
+    runner.run("slam/MSOPParser::parsePacket/array", count, [&] {
+      uint64_t total = 0;
+      for (size_t i = 0; i < count; ++i) {
+        total += parser.parsePacket(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE,
+                                    points.data(), points.size());
+      }
+      return total;
+    });
+  }
+
+  // LiDARReader only takes packets from a socket or a capture, so feed it the
+  // stream through a temporary pcap replayed as fast as possible
+  char path[] = "/tmp/lidar_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return;
+  }
+  close(fd);
+  {
+    PcapWriter writer(path);
+    timespec ts{};
+    for (size_t i = 0; i < count; ++i) {
+      ts.tv_sec  = time_t(i / 500);  // 2 ms apart; replay ignores it at speed 0
+      ts.tv_nsec = long(i % 500) * 2000000;
+      writer.write(packets + i * MSOP_PAYLOAD_SIZE, MSOP_PAYLOAD_SIZE, ts);
+    }
+  }
+
+  for (int copy = 0; copy < 2; ++copy) {
+    std::unique_ptr<PcapReplay> source(new PcapReplay(path));
+    source->setSpeed(0);
+    PcapReplay& capture = *source;
+    LiDARReader reader(std::move(source));
+
+    auto readAll = [&] {
+      uint64_t total = 0;
+      capture.rewind();
+      try {
+        while (true) {
+          total += copy ? reader.readScan().size() : reader.readRevolution().size();
+        }
+      } catch (const EndOfCapture&) {
+      }
+      return total;
+    };
+    runner.run(copy ? "slam/LiDARReader::readScan" : "slam/LiDARReader::readRevolution", count, readAll);
+  }
+
+  // Occupancy grid: the same revolutions ray cast from the origin, into a
+  // grid kept across rounds so tiles are allocated during warm-up only
+  std::vector<std::vector<ScanPoint>> scans;
+  {
+    std::unique_ptr<PcapReplay> source(new PcapReplay(path));
+    source->setSpeed(0);
+    LiDARReader reader(std::move(source));
+    try {
+      while (true) scans.push_back(reader.readScan());
+    } catch (const EndOfCapture&) {
+    }
+  }
+  for (int threads : {1, 4}) {
+    OccupancyGrid::Options options;
+    options.threads = threads;
+    OccupancyGrid grid(options);
+    runner.run(threads == 1 ? "slam/OccupancyGrid::integrate/1-thread" : "slam/OccupancyGrid::integrate/4-threads",
+               count, [&] {
+      uint64_t beams = grid.stats().beams;
+      for (const auto& scan : scans) grid.integrate(scan, Pose2D());
+      return grid.stats().beams - beams;
+    });
+  }
+  unlink(path);
+}
@@ -0,0 +1,111 @@
+// bench/lidar_bench.cpp -- hot-path microbenchmarks for reader2.0 and slam_lidar_cpp
+
+#include "bench_harness.hpp"
+#include "msop_synth.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+#ifndef LIDAR_BENCH_REVISION
+#define LIDAR_BENCH_REVISION "unknown"
+#endif
+
+// Every operator new in the process goes through here
+static uint64_t g_allocations = 0;
+
+uint64_t allocationCount() { return g_allocations; }
+
+void* operator new(size_t size) {
+  ++g_allocations;
+  void* memory = std::malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+static int usage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [--packets N] [--rounds N] [--seed N] [--filter TEXT] [--json FILE]\n"
+            << "  --packets N    synthetic MSOP packets per round (default 20000)\n"
+            << "  --rounds N     measured rounds per benchmark; the fastest is reported (default 5)\n"
+            << "  --filter TEXT  only run benchmarks whose name contains TEXT\n"
+            << "  --json FILE    also write the results as JSON (\"-\" for stdout)\n";
+  return 1;
+}
+
+static void writeJson(std::ostream& out, const std::vector<BenchResult>& results,
+                      size_t packets, int rounds, uint32_t seed) {
+  // One benchmark per line, fixed key order: results diff cleanly between commits
+  out << "{\n"
+      << "  \"revision\": \"" << LIDAR_BENCH_REVISION << "\",\n"
+      << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+      << "  \"packets\": " << packets << ",\n"
+      << "  \"rounds\": " << rounds << ",\n"
+      << "  \"seed\": " << seed << ",\n"
+      << "  \"benchmarks\": [\n";
+  char line[512];
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult& r = results[i];
+    std::snprintf(line, sizeof(line),
+                  "    {\"name\": \"%s\", \"ns_per_packet\": %.1f, \"points_per_second\": %.0f, "
+                  "\"allocs_per_packet\": %.3f, \"points\": %llu}%s\n",
+                  r.name.c_str(), r.ns_per_packet, r.points_per_second, r.allocs_per_packet,
+                  (unsigned long long)r.points, i + 1 < results.size() ? "," : "");
+    out << line;
+  }
+  out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+  size_t packets = 20000;
+  int rounds = 5;
+  std::string filter, json_path;
+  MsopSynthOptions synth;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return usage(argv[0]);
+    if (arg == "--packets")     packets = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--rounds") rounds = std::atoi(argv[++i]);
+    else if (arg == "--seed")   synth.seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--filter") filter = argv[++i];
+    else if (arg == "--json")   json_path = argv[++i];
+    else return usage(argv[0]);
+  }
+  if (packets == 0 || rounds < 1) return usage(argv[0]);
+
+  const std::vector<uint8_t> stream = synthesizeMsop(packets, synth);
+
+  BenchRunner runner(rounds, filter);
+  runReader2Benches(runner, stream);
+  runSlamBenches(runner, stream);
+
+  std::printf("%zu synthetic packets, best of %d rounds (revision %s)\n\n",
+              packets, rounds, LIDAR_BENCH_REVISION);
+  std::printf("%-42s %12s %14s %14s\n", "benchmark", "ns/packet", "Mpoints/s", "allocs/packet");
+  for (const BenchResult& r : runner.results()) {
+    std::printf("%-42s %12.1f %14.2f %14.3f\n",
+                r.name.c_str(), r.ns_per_packet, r.points_per_second / 1e6, r.allocs_per_packet);
+  }
+
+  if (json_path == "-") {
+    writeJson(std::cout, runner.results(), packets, rounds, synth.seed);
+  } else if (!json_path.empty()) {
+    std::ofstream out(json_path);
+    if (!out) {
+      std::cerr << "Cannot write " << json_path << "\n";
+      return 1;
+    }
+    writeJson(out, runner.results(), packets, rounds, synth.seed);
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+// bench/msop_synth.cpp
+
+#include "msop_synth.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int BLOCKS = 12;
+constexpr int MEASUREMENTS = 16;
+constexpr size_t BLOCK_SIZE = 4 + MEASUREMENTS * 6;
+
+/// xorshift64*: same sequence on every platform, unlike <random> distributions.
+struct Rng {
+  uint64_t state;
+  explicit Rng(uint32_t seed) : state(0x9E3779B97F4A7C15ull ^ seed) {}
+  uint64_t next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+  }
+  double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+void put16(uint8_t* p, uint16_t v) {
+  p[0] = uint8_t(v >> 8);
+  p[1] = uint8_t(v);
+}
+
+void put32(uint8_t* p, uint32_t v) {
+  put16(p, uint16_t(v >> 16));
+  put16(p + 2, uint16_t(v));
+}
+
+/// Range to the walls of a 8 m x 5.5 m room, sensor off-centre, in mm.
+double wallDistanceMm(double azimuth_deg) {
+  double a = azimuth_deg * M_PI / 180.0;
+  double c = std::cos(a), s = std::sin(a);
+  double tx = std::fabs(c) > 1e-9 ? (c > 0 ? 4.5 : 3.5) / std::fabs(c) : 1e9;
+  double ty = std::fabs(s) > 1e-9 ? (s > 0 ? 3.0 : 2.5) / std::fabs(s) : 1e9;
+  return std::min(std::min(tx, ty), 12.0) * 1000.0;
+}
+
+}  // namespace
+
+std::vector<uint8_t> synthesizeMsop(size_t count, const MsopSynthOptions& options) {
+  std::vector<uint8_t> out(count * MSOP_PAYLOAD_SIZE, 0);
+  Rng rng(options.seed);
+
+  const double us_per_block = 1e6 / options.rotation_hz * options.block_step / 36000.0;
+  uint32_t azimuth = 0;
+  double time_us = 0;
+
+  for (size_t p = 0; p < count; ++p) {
+    uint8_t* packet = &out[p * MSOP_PAYLOAD_SIZE];
+    put32(packet + BLOCKS * BLOCK_SIZE, uint32_t(time_us));
+    put16(packet + BLOCKS * BLOCK_SIZE + 4, 0x3740);
+
+    for (int b = 0; b < BLOCKS; ++b) {
+      uint8_t* block = packet + b * BLOCK_SIZE;
+      if (azimuth >= 36000) {
+        // Revolution complete: pad the packet with invalid blocks (last-packet marker)
+        put16(block, 0xFFFF);
+        put16(block + 2, 0xFFFF);
+        continue;
+      }
+      put16(block, 0xFFEE);
+      put16(block + 2, uint16_t(azimuth));
+
+      for (int m = 0; m < MEASUREMENTS; ++m) {
+        uint8_t* meas = block + 4 + m * 6;
+        if (rng.uniform() < options.dropout_fraction) continue;  // both returns 0
+
+        double az = (azimuth + double(options.block_step) * m / MEASUREMENTS) / 100.0;
+        double strongest = wallDistanceMm(az) + (rng.uniform() - 0.5) * 20.0;
+        uint8_t rssi = uint8_t(20 + rng.next() % 60);
+        double last = strongest;
+        uint8_t last_rssi = rssi;
+        if (rng.uniform() < options.dual_fraction) {
+          // Partial hit on a near object, full hit on the wall behind it
+          last = strongest;
+          strongest = std::max(150.0, strongest * rng.uniform());
+          last_rssi = uint8_t(10 + rng.next() % 40);
+        }
+        put16(meas, uint16_t(strongest));
+        meas[2] = rssi;
+        put16(meas + 3, uint16_t(last));
+        meas[5] = last_rssi;
+      }
+      azimuth += options.block_step;
+      time_us += us_per_block;
+    }
+    if (azimuth >= 36000) azimuth -= 36000;
+  }
+  return out;
+}
@@ -0,0 +1,23 @@
+// bench/msop_synth.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr size_t MSOP_PAYLOAD_SIZE = 1206;
+
+/// Shape of a synthetic LakiBeam1(L) packet stream.
+struct MsopSynthOptions {
+  uint32_t seed            = 1;
+  uint16_t block_step      = 400;    // block-to-block azimuth step, 0.01° (400 = 0.25°/point)
+  double   rotation_hz     = 10.0;   // sets the tail timestamp spacing
+  double   dual_fraction   = 0.3;    // measurements whose last return differs from the strongest
+  double   dropout_fraction = 0.05;  // measurements with no return (distance 0)
+};
+
+/// Generate `count` back-to-back MSOP payloads (network byte order, 1206 bytes
+/// each) covering whole revolutions of a room-like scene: walls 1-12 m away with
+/// range noise, varied RSSI, dual returns and dropouts. Each revolution ends in a
+/// last-packet marker (blocks 6-11 flagged 0xFFFF) when it does not fill a packet.
+std::vector<uint8_t> synthesizeMsop(size_t count, const MsopSynthOptions& options = MsopSynthOptions());
@@ -0,0 +1,220 @@
+// bench/scan_match_bench.cpp -- ScanMatcher iterations and time per match, scan to scan and scan to submap
+
+#include "lidar_reader.hpp"
+#include "pcap_io.hpp"
+#include "scan_matcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static int usage(const char* prog) {
+  std::cerr << "Usage: " << prog << " [--scans N] [--submap K] [--pcap FILE]\n"
+            << "  --scans N    synthetic revolutions along a loop through a room (default 300)\n"
+            << "  --submap K   keyframes in the scan-to-submap target (default 5)\n"
+            << "  --pcap FILE  match the revolutions of a capture instead (no ground truth)\n";
+  return 1;
+}
+
+struct Segment {
+  double x0, y0, x1, y1;
+};
+
+/// Hall 24 x 16 m, a block in the middle and a few boxes along the walls.
+static std::vector<Segment> hallScene() {
+  std::vector<Segment> scene = {{-12, -8, 12, -8}, {12, -8, 12, 8}, {12, 8, -12, 8}, {-12, 8, -12, -8}};
+  const double boxes[][4] = {{-3, -1.5, 3, 1.5}, {9, 5.5, 11, 7}, {-11, -7, -9.5, -5},
+                             {-1, 6.8, 1, 8}, {10.5, -4, 12, -2}};
+  for (const auto& b : boxes) {
+    scene.push_back({b[0], b[1], b[2], b[1]});
+    scene.push_back({b[2], b[1], b[2], b[3]});
+    scene.push_back({b[2], b[3], b[0], b[3]});
+    scene.push_back({b[0], b[3], b[0], b[1]});
+  }
+  return scene;
+}
+
+/// One revolution of 1440 beams with ±1 cm uniform range noise and no return past 30 m.
+static std::vector<ScanPoint> castScan(const std::vector<Segment>& scene, const Pose2D& pose, uint32_t seed) {
+  std::vector<ScanPoint> scan(1440);
+  for (size_t i = 0; i < scan.size(); ++i) {
+    double a = -M_PI + double(i) * (2 * M_PI / scan.size());
+    double dx = std::cos(pose.theta + a), dy = std::sin(pose.theta + a);
+    double range = std::numeric_limits<double>::infinity();
+    for (const Segment& s : scene) {
+      double ex = s.x1 - s.x0, ey = s.y1 - s.y0;
+      double det = dx * -ey + dy * ex;
+      if (std::fabs(det) < 1e-12) continue;
+      double wx = s.x0 - pose.x, wy = s.y0 - pose.y;
+      double t = (wx * -ey + wy * ex) / det;
+      double u = (dx * wy - dy * wx) / det;
+      if (t > 0 && u >= 0 && u <= 1 && t < range) range = t;
+    }
+    seed = seed * 1664525u + 1013904223u;
+    if (range > 30) range = std::numeric_limits<double>::infinity();
+    else range += 0.01 * (2.0 * (seed >> 8) / double(1 << 24) - 1.0);
+    scan[i].angle       = a;
+    scan[i].range       = range;
+    scan[i].intensity   = 100;
+    scan[i].raw_azimuth = uint16_t(i * 25);
+  }
+  return scan;
+}
+
+/// `b` expressed in the frame of `a`.
+static Pose2D relative(const Pose2D& a, const Pose2D& b) {
+  double c = std::cos(a.theta), s = std::sin(a.theta);
+  double dx = b.x - a.x, dy = b.y - a.y;
+  return {c * dx + s * dy, -s * dx + c * dy, std::remainder(b.theta - a.theta, 2 * M_PI)};
+}
+
+/// `delta`, given in the frame of `a`, in the map frame.
+static Pose2D compose(const Pose2D& a, const Pose2D& delta) {
+  Pose2D p;
+  a.transform(delta.x, delta.y, p.x, p.y);
+  p.theta = std::remainder(a.theta + delta.theta, 2 * M_PI);
+  return p;
+}
+
+struct Summary {
+  std::vector<double> us;
+  uint64_t iterations = 0, converged = 0;
+  double rms = 0, translation_error = 0, rotation_error = 0;
+
+  void add(const ScanMatcher::Result& r, double micros) {
+    us.push_back(micros);
+    iterations += uint64_t(r.iterations);
+    converged += r.converged;
+    rms += r.rms;
+  }
+
+  void print(const char* name, bool truth) {
+    if (us.empty()) return;
+    size_t n = us.size();
+    double total = 0;
+    for (double u : us) total += u;
+    std::sort(us.begin(), us.end());
+    std::printf("%-16s %6zu %8.2f %9.0f %9.0f %9.0f %7.1f%% %8.2f", name, n, double(iterations) / n,
+                total / n, us[n / 2], us[std::min(n - 1, n * 99 / 100)], 100.0 * converged / n, rms / n * 1000);
+    if (truth) std::printf(" %9.2f %9.3f", translation_error / n * 1000, rotation_error / n * 180 / M_PI);
+    std::printf("\n");
+  }
+};
+
+int main(int argc, char** argv) {
+  size_t scan_count = 300;
+  size_t keyframes = 5;
+  std::string pcap;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return usage(argv[0]);
+    if (arg == "--scans")       scan_count = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--submap") keyframes = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--pcap")   pcap = argv[++i];
+    else return usage(argv[0]);
+  }
+
+  std::vector<std::vector<ScanPoint>> scans;
+  std::vector<Pose2D> truth;
+  try {
+    if (!pcap.empty()) {
+      std::unique_ptr<PcapReplay> source(new PcapReplay(pcap));
+      source->setSpeed(0);
+      LiDARReader reader(std::move(source));
+      std::vector<ScanPoint> scan;
+      while (reader.readScan(scan, LiDARReader::Clock::now() + std::chrono::seconds(1)) ==
+             LiDARReader::ReadStatus::Ok) {
+        scans.push_back(scan);
+      }
+    } else {
+      // 10 Hz revolutions along an ellipse round the middle block, about 1 m/s
+      const std::vector<Segment> scene = hallScene();
+      for (size_t k = 0; k < scan_count; ++k) {
+        double t = double(k) * 0.1 * (2 * M_PI / 38.0);
+        Pose2D pose = {7.0 * std::cos(t), 4.5 * std::sin(t),
+                       std::atan2(4.5 * std::cos(t), -7.0 * std::sin(t))};
+        truth.push_back(pose);
+        scans.push_back(castScan(scene, pose, uint32_t(k + 1)));
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+  if (scans.size() < 2) {
+    std::cerr << "Need at least two revolutions\n";
+    return 1;
+  }
+  bool has_truth = !truth.empty();
+  std::printf("%zu %s revolutions of about %zu points, submap of %zu keyframes\n\n", scans.size(),
+              has_truth ? "synthetic" : "recorded", scans[0].size(), keyframes);
+  std::printf("%-16s %6s %8s %9s %9s %9s %8s %8s", "match", "count", "iter", "mean us", "p50 us",
+              "p99 us", "conv", "rms mm");
+  if (has_truth) std::printf(" %9s %9s", "err mm", "err deg");
+  std::printf("\n");
+
+  // Scan to scan: each revolution against the one before, no motion prior.
+  // The time includes fitting the new target's normals, done by the first match
+  ScanMatcher matcher;
+  Summary scan_to_scan;
+  for (size_t k = 1; k < scans.size(); ++k) {
+    matcher.setTarget(scans[k - 1]);
+    auto start = Clock::now();
+    ScanMatcher::Result r = matcher.match(scans[k], Pose2D());
+    scan_to_scan.add(r, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    if (has_truth) {
+      Pose2D delta = relative(truth[k - 1], truth[k]);
+      scan_to_scan.translation_error += std::hypot(r.pose.x - delta.x, r.pose.y - delta.y);
+      scan_to_scan.rotation_error += std::fabs(std::remainder(r.pose.theta - delta.theta, 2 * M_PI));
+    }
+  }
+  scan_to_scan.print("scan-to-scan", has_truth);
+
+  // Scan to submap: the last `keyframes` revolutions at their estimated poses,
+  // seen from the newest, with a constant-velocity guess. Building the
+  // submap is timed separately
+  std::vector<Pose2D> estimate = {has_truth ? truth[0] : Pose2D()};
+  Summary scan_to_submap, build;
+  for (size_t k = 1; k < scans.size(); ++k) {
+    auto start = Clock::now();
+    matcher.clearTarget(estimate.back());
+    for (size_t j = k > keyframes ? k - keyframes : 0; j < k; ++j) matcher.addToTarget(scans[j], estimate[j]);
+    matcher.targetSize();
+    build.us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+    Pose2D guess = estimate.back();
+    if (k >= 2) guess = compose(estimate.back(), relative(estimate[k - 2], estimate.back()));
+    start = Clock::now();
+    ScanMatcher::Result r = matcher.match(scans[k], guess);
+    scan_to_submap.add(r, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    estimate.push_back(r.pose);
+    if (has_truth) {
+      Pose2D delta = relative(truth[k - 1], truth[k]);
+      Pose2D step = relative(estimate[k - 1], estimate[k]);
+      scan_to_submap.translation_error += std::hypot(step.x - delta.x, step.y - delta.y);
+      scan_to_submap.rotation_error += std::fabs(std::remainder(step.theta - delta.theta, 2 * M_PI));
+    }
+  }
+  scan_to_submap.print("scan-to-submap", has_truth);
+
+  double build_total = 0;
+  for (double u : build.us) build_total += u;
+  std::printf("\nSubmap build: %.0f us mean", build_total / build.us.size());
+  if (has_truth) {
+    const Pose2D& last = estimate.back();
+    std::printf("; drift after %zu revolutions: %.0f mm, %.2f deg", scans.size(),
+                std::hypot(last.x - truth.back().x, last.y - truth.back().y) * 1000,
+                std::fabs(std::remainder(last.theta - truth.back().theta, 2 * M_PI)) * 180 / M_PI);
+  }
+  std::printf("\nconv: matches that converged%s\n", has_truth ? "; err: mean error of the per-revolution motion" : "");
+  return 0;
+}
@@ -0,0 +1,266 @@
+#include "continuity_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+static const int AZIMUTH_RANGE = 36000;    // 0.01° units per turn
+
+ContinuityTracker::ContinuityTracker() {
+    reset();
+}
+
+void ContinuityTracker::reset() {
+    stats_ = ContinuityStats();
+    last_revolution_ = RevolutionCoverage();
+    revolution_closed_ = false;
+    have_last_ = false;
+    last_timestamp_ = 0;
+    last_azimuth_ = -1;
+    at_marker_ = false;
+    timestamp_step_ = 0.0;
+    azimuth_step_ = 0.0;
+    revolution_period_ = 0.0;
+    packets_per_revolution_ = 0;
+    reference_start_ = 0;
+    have_reference_ = false;
+    have_full_revolution_ = false;
+    revolution_received_ = 0;
+    revolution_missing_ = 0;
+    revolution_start_ = 0;
+    revolution_clean_ = false;
+    expected_packets_ = 0;
+    recent_count_ = 0;
+    recent_next_ = 0;
+}
+
+ContinuityTracker::Verdict ContinuityTracker::processPacket(const uint8_t* data, size_t size) {
+    if (!MSOPPacketView::isPacketSize(size)) {
+        revolution_closed_ = false;
+        stats_.malformed++;
+        return MALFORMED;
+    }
+    return addPacket(MSOPPacketView(data));
+}
+
+ContinuityTracker::Verdict ContinuityTracker::addPacket(MSOPPacketView packet) {
+    revolution_closed_ = false;
+    uint32_t timestamp = packet.timestamp();
+    int azimuth = -1;
+    bool marker = true;
+    for (int i = 0; i < MSOPPacketView::BLOCK_COUNT; ++i) {
+        uint16_t flag = packet.blockFlag(i);
+        if (azimuth < 0 && flag == MSOPPacketView::VALID_BLOCK_FLAG) {
+            uint16_t value = packet.blockAzimuth(i);
+            if (value < AZIMUTH_RANGE) {
+                azimuth = value;
+            }
+        }
+        if (i >= 6 && flag != MSOPPacketView::INVALID_BLOCK_FLAG) {
+            marker = false;
+        }
+    }
+
+    if (seenRecently(timestamp, azimuth)) {
+        stats_.duplicates++;
+        return DUPLICATE;
+    }
+
+    uint32_t missing = 0;
+    if (!have_last_) {
+        startRevolution(timestamp, false);  // Joined mid-stream
+    } else {
+        int32_t timestamp_delta = static_cast<int32_t>(timestamp - last_timestamp_);
+        int azimuth_delta = (azimuth >= 0 && last_azimuth_ >= 0) ? azimuth - last_azimuth_ : 0;
+
+        if (timestamp_delta < 0) {
+            if (timestamp_step_ > 0.0 && -timestamp_delta <= timestamp_step_ * RECENT_PACKETS) {
+                // A packet from just before the newest one: it was counted lost when the
+                // gap it left was seen, so give it back. It is dropped rather than
+                // assembled, and may belong to the previous revolution, so it stays
+                // missing from the coverage.
+                stats_.out_of_order++;
+                if (stats_.lost > 0) {
+                    stats_.lost--;
+                }
+                remember(timestamp, azimuth);
+                return OUT_OF_ORDER;
+            }
+            // Far in the past: the sensor restarted, so resynchronise
+            closeRevolution();
+            startRevolution(timestamp, false);
+        } else if (timestamp_delta > 0 && isLocked()) {
+            int64_t last_revolution, last_index, revolution, index;
+            locate(last_timestamp_, last_revolution, last_index);
+            locate(timestamp, revolution, index);
+
+            if (revolution > last_revolution || at_marker_) {
+                // Count what is missing from the end of the old revolution, any whole
+                // revolutions in between and the start of this one
+                int64_t p = packets_per_revolution_;
+                int64_t tail = at_marker_ ? 0 : std::max<int64_t>(0, p - 1 - last_index);
+                int64_t skipped = std::max<int64_t>(0, revolution - last_revolution - 1) * p;
+                int64_t head = revolution > last_revolution ? std::min<int64_t>(std::max<int64_t>(0, index), p - 1) : 0;
+                if (!at_marker_) {
+                    revolution_missing_ += static_cast<uint32_t>(tail);
+                    closeRevolution();
+                }
+                missing = static_cast<uint32_t>(tail + skipped + head);
+                startRevolution(timestamp, at_marker_ && missing == 0);
+                revolution_missing_ = static_cast<uint32_t>(head);
+            } else {
+                missing = index > last_index + 1 ? static_cast<uint32_t>(index - last_index - 1) : 0;
+                revolution_missing_ += missing;
+                if (missing == 0) {
+                    learnStep(timestamp_delta, azimuth_delta);
+                }
+            }
+        } else {
+            bool wrapped = azimuth >= 0 && last_azimuth_ >= 0 &&
+                           last_azimuth_ - azimuth > AZIMUTH_RANGE / 2;
+            if (at_marker_) {
+                startRevolution(timestamp, true);
+            } else if (wrapped) {
+                // No marker (the last packet had more than six valid blocks, or it was
+                // lost), but the azimuth wrapped, so the revolution still ended
+                closeRevolution();
+                startRevolution(timestamp, true);
+            } else {
+                learnStep(timestamp_delta, azimuth_delta);
+                missing = estimateMissing(timestamp_delta, azimuth_delta);
+                revolution_missing_ += missing;
+            }
+        }
+    }
+
+    Verdict verdict = IN_SEQUENCE;
+    if (missing > 0) {
+        stats_.lost += missing;
+        stats_.gaps++;
+        revolution_clean_ = false;
+        verdict = AFTER_GAP;
+    }
+
+    stats_.packets++;
+    revolution_received_++;
+    have_last_ = true;
+    last_timestamp_ = timestamp;
+    if (azimuth >= 0) {
+        last_azimuth_ = azimuth;
+    }
+    remember(timestamp, azimuth);
+
+    at_marker_ = marker;
+    if (marker) {
+        closeRevolution();
+    }
+    return verdict;
+}
+
+void ContinuityTracker::locate(uint32_t timestamp, int64_t& revolution, int64_t& index) const {
+    // The last packet of a revolution can be short (few valid blocks), so the next
+    // revolution may start well under one step after it: allow only a little jitter
+    double offset = static_cast<int32_t>(timestamp - reference_start_);
+    revolution = static_cast<int64_t>(std::floor((offset + timestamp_step_ / 16) / revolution_period_));
+    index = std::llround((offset - revolution * revolution_period_) / timestamp_step_);
+}
+
+void ContinuityTracker::learnStep(int32_t timestamp_delta, int azimuth_delta) {
+    // A delta well below the estimate means the first one seen spanned a gap
+    if (timestamp_delta > 0) {
+        if (timestamp_step_ == 0.0 || timestamp_delta < timestamp_step_ * 0.75) {
+            timestamp_step_ = timestamp_delta;
+        } else if (timestamp_delta < timestamp_step_ * 1.5) {
+            timestamp_step_ += (timestamp_delta - timestamp_step_) / 8.0;
+        }
+    }
+    if (azimuth_delta > 0) {
+        if (azimuth_step_ == 0.0 || azimuth_delta < azimuth_step_ * 0.75) {
+            azimuth_step_ = azimuth_delta;
+        } else if (azimuth_delta < azimuth_step_ * 1.5) {
+            azimuth_step_ += (azimuth_delta - azimuth_step_) / 8.0;
+        }
+    }
+}
+
+uint32_t ContinuityTracker::estimateMissing(int32_t timestamp_delta, int azimuth_delta) const {
+    // Timestamps decide when the sensor sets them; azimuth only when it does not
+    long packets = 1;
+    if (timestamp_delta > 0 && timestamp_step_ > 0.0) {
+        packets = std::lround(timestamp_delta / timestamp_step_);
+    } else if (timestamp_delta == 0 && azimuth_delta > 0 && azimuth_step_ > 0.0) {
+        packets = std::lround(azimuth_delta / azimuth_step_);
+    }
+    return packets > 1 ? static_cast<uint32_t>(packets - 1) : 0;
+}
+
+void ContinuityTracker::startRevolution(uint32_t timestamp, bool clean) {
+    revolution_start_ = timestamp;
+    revolution_clean_ = clean;
+    revolution_received_ = 0;
+    revolution_missing_ = 0;
+}
+
+void ContinuityTracker::closeRevolution() {
+    if (revolution_received_ == 0) {
+        return;
+    }
+
+    // A revolution that started at a boundary and had no gap is complete unless it lost
+    // its first or last packet, so the largest one shows how many packets a revolution
+    // has. Two complete revolutions in a row start exactly one period apart.
+    bool full = false;
+    if (revolution_clean_ && revolution_missing_ == 0) {
+        if (revolution_received_ > packets_per_revolution_) {
+            packets_per_revolution_ = revolution_received_;
+            revolution_period_ = 0.0;   // Measured against too small a revolution
+            have_full_revolution_ = false;
+        }
+        full = revolution_received_ == packets_per_revolution_;
+    }
+    if (full && have_full_revolution_) {
+        double period = static_cast<int32_t>(revolution_start_ - reference_start_);
+        if (period > 0.0) {
+            if (revolution_period_ == 0.0 || std::fabs(period - revolution_period_) > revolution_period_ / 4) {
+                revolution_period_ = period;
+            } else {
+                revolution_period_ += (period - revolution_period_) / 8.0;
+            }
+        }
+    }
+    if (full) {
+        reference_start_ = revolution_start_;
+        have_reference_ = true;
+    }
+    have_full_revolution_ = full;
+
+    if (revolution_received_ > expected_packets_) {
+        expected_packets_ = revolution_received_;
+    }
+    uint32_t expected = packets_per_revolution_ > 0 ? packets_per_revolution_ : expected_packets_;
+    last_revolution_.received = revolution_received_;
+    last_revolution_.missing = revolution_missing_;
+    last_revolution_.expected = expected;
+    last_revolution_.coverage_percent = revolution_received_ >= expected ? 100.0 :
+                                        100.0 * revolution_received_ / expected;
+    stats_.revolutions++;
+    revolution_closed_ = true;
+    revolution_received_ = 0;
+    revolution_missing_ = 0;
+}
+
+bool ContinuityTracker::seenRecently(uint32_t timestamp, int azimuth) const {
+    for (int i = 0; i < recent_count_; ++i) {
+        if (recent_timestamps_[i] == timestamp && recent_azimuths_[i] == azimuth) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ContinuityTracker::remember(uint32_t timestamp, int azimuth) {
+    recent_timestamps_[recent_next_] = timestamp;
+    recent_azimuths_[recent_next_] = azimuth;
+    recent_next_ = (recent_next_ + 1) % RECENT_PACKETS;
+    if (recent_count_ < RECENT_PACKETS) {
+        recent_count_++;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef CONTINUITY_TRACKER_H
+#define CONTINUITY_TRACKER_H
+
+#include <cstdint>
+#include <cstddef>
+#include "msop_packet_view.h"
+
+// Running totals of stream continuity problems
+struct ContinuityStats {
+    uint64_t packets;           // Packets accepted in sequence (including after a gap)
+    uint64_t lost;              // Packets missing from gaps, less those that showed up late
+    uint64_t gaps;              // Runs of one or more missing packets
+    uint64_t duplicates;        // Packets seen before (same timestamp and azimuth)
+    uint64_t out_of_order;      // Packets older than one already accepted
+    uint64_t malformed;         // Datagrams that were not MSOP packets
+    uint64_t revolutions;       // Revolutions closed
+
+    ContinuityStats() : packets(0), lost(0), gaps(0), duplicates(0), out_of_order(0),
+                        malformed(0), revolutions(0) {}
+};
+
+// Packet coverage of one revolution
+struct RevolutionCoverage {
+    uint32_t received;          // Packets accepted into the revolution
+    uint32_t missing;           // Packets missing from it, including ones that arrived late
+    uint32_t expected;          // Packets in a complete revolution, as learned from the stream
+    double coverage_percent;    // received / expected, at most 100
+
+    RevolutionCoverage() : received(0), missing(0), expected(0), coverage_percent(0.0) {}
+};
+
+// Detects missing, duplicated and out-of-order MSOP packets.
+// The MSOPTail timestamp advances by a fixed step per packet and by a fixed period
+// per revolution; both are learned from gap-free revolutions, together with the
+// number of packets per revolution. A packet's timestamp then gives its revolution
+// and its index within it, so gaps are counted exactly even when they swallow the
+// last-packet marker, the start of a revolution or whole revolutions, and the time
+// outside the field of view (where the sensor sends nothing) is never counted as loss.
+// Before that is learned, or when a sensor leaves the timestamp at zero, gaps are
+// estimated from the timestamp or first-block azimuth step within a revolution.
+// A repeated timestamp and azimuth is a duplicate; an older timestamp a late packet.
+// Both readers drop duplicate and late packets before assembly, so a late packet is
+// no longer lost but its revolution's coverage still counts it missing.
+// Shared by reader2.0 and slam_lidar_cpp.
+class ContinuityTracker {
+public:
+    enum Verdict {
+        IN_SEQUENCE,
+        AFTER_GAP,              // Accepted, but packets before it are missing
+        DUPLICATE,
+        OUT_OF_ORDER,
+        MALFORMED
+    };
+
+    ContinuityTracker();
+
+    // Classify one packet (network byte order, UDP header already stripped)
+    Verdict processPacket(const uint8_t* data, size_t size);
+    // Classify a packet already known to be the right size
+    Verdict addPacket(MSOPPacketView packet);
+    // Count a datagram that was not an MSOP packet, for callers that check it themselves
+    void countMalformed() { stats_.malformed++; }
+
+    // True if the last processPacket() or addPacket() call closed a revolution, now in getLastRevolution()
+    bool revolutionClosed() const { return revolution_closed_; }
+    const RevolutionCoverage& getLastRevolution() const { return last_revolution_; }
+
+    const ContinuityStats& getStats() const { return stats_; }
+    void reset();
+
+private:
+    static const int RECENT_PACKETS = 16;   // Window for duplicate and late-packet checks
+
+    bool isLocked() const {
+        return timestamp_step_ > 0.0 && revolution_period_ > 0.0 && packets_per_revolution_ > 0 && have_reference_;
+    }
+    void locate(uint32_t timestamp, int64_t& revolution, int64_t& index) const;
+    uint32_t estimateMissing(int32_t timestamp_delta, int azimuth_delta) const;
+    void learnStep(int32_t timestamp_delta, int azimuth_delta);
+    void startRevolution(uint32_t timestamp, bool clean);
+    void closeRevolution();
+    bool seenRecently(uint32_t timestamp, int azimuth) const;
+    void remember(uint32_t timestamp, int azimuth);
+
+    ContinuityStats stats_;
+    RevolutionCoverage last_revolution_;
+    bool revolution_closed_;
+
+    bool have_last_;
+    uint32_t last_timestamp_;
+    int last_azimuth_;                  // First valid block of the newest packet, -1 if none
+    bool at_marker_;                    // The newest packet carried the last-packet marker
+
+    // Learned stream geometry
+    double timestamp_step_;             // Microseconds per packet, 0 until known
+    double azimuth_step_;               // 0.01° per packet, 0 until known
+    double revolution_period_;          // Microseconds from one revolution start to the next
+    uint32_t packets_per_revolution_;   // Packets in a complete revolution
+    uint32_t reference_start_;          // First timestamp of the latest complete revolution
+    bool have_reference_;
+    bool have_full_revolution_;         // The previous revolution was complete
+
+    // Revolution in progress
+    uint32_t revolution_received_;
+    uint32_t revolution_missing_;
+    uint32_t revolution_start_;         // Timestamp of its first packet
+    bool revolution_clean_;             // Started at a revolution boundary without a gap
+    uint32_t expected_packets_;         // Largest revolution seen; coverage denominator until
+                                        // packets_per_revolution_ is known
+
+    uint32_t recent_timestamps_[RECENT_PACKETS];
+    int recent_azimuths_[RECENT_PACKETS];
+    int recent_count_;
+    int recent_next_;
+};
+
+#endif // CONTINUITY_TRACKER_H
@@ -0,0 +1,95 @@
+#include "latency_histogram.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < 2 * SUB_BUCKETS) {
+        return static_cast<int>(ns);
+    }
+    if (ns >= (1ULL << MAX_MAGNITUDE)) {
+        ns = (1ULL << MAX_MAGNITUDE) - 1;
+    }
+    // Position of the leading one, then the SUB_BUCKET_BITS bits below it
+    int magnitude = 63 - __builtin_clzll(ns);
+    int sub = static_cast<int>(ns >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return 2 * SUB_BUCKETS + (magnitude - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int magnitude = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+    int sub = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    int shift = magnitude - SUB_BUCKET_BITS;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t count = getCount();
+    uint64_t max = getMax();
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * count));
+    if (target < 1) target = 1;
+    if (target > count) target = count;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += load(counts_[i]);
+        if (seen >= target) {
+            uint64_t bound = bucketUpperBound(i);
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {
+    "socket wait",
+    "kernel->user",
+    "parse",
+    "assembly",
+    "handoff"
+};
+
+void PipelineLatency::print(std::ostream& out) const {
+    char line[160];
+    snprintf(line, sizeof(line), "%-14s %10s %9s %9s %9s %9s %9s %9s\n",
+             "stage (us)", "count", "min", "p50", "p90", "p99", "p99.9", "max");
+    out << line;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& h = stages_[i];
+        if (h.getCount() == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-14s %10llu %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                 STAGE_NAMES[i], static_cast<unsigned long long>(h.getCount()),
+                 h.getMin() / 1000.0,
+                 h.getPercentile(50.0) / 1000.0,
+                 h.getPercentile(90.0) / 1000.0,
+                 h.getPercentile(99.0) / 1000.0,
+                 h.getPercentile(99.9) / 1000.0,
+                 h.getMax() / 1000.0);
+        out << line;
+    }
+}
+
+void PipelineLatency::reset() {
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        stages_[i].reset();
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <ostream>
+#include <time.h>
+
+// HDR-style histogram of nanosecond latencies with fixed storage, shared by
+// reader2.0 and slam_lidar_cpp.
+// Values below 64 ns get exact buckets; above that every power of two is split
+// into 32 linear sub-buckets, so any recorded value is known to within ~3%.
+// Recording is an index computation and an increment, never an allocation.
+//
+// One thread records; any other thread may read and print at the same time.
+// The counters are relaxed atomics updated with a plain load and store (no locked
+// instruction), so a concurrent reader sees each counter whole but may see a
+// packet in the bucket before it is in the total.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_MAGNITUDE = 40;    // Values up to 2^40 ns (~18 minutes), larger ones are clamped
+    static const int BUCKET_COUNT = 2 * SUB_BUCKETS + (MAX_MAGNITUDE - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t ns) {
+        increment(counts_[bucketOf(ns)], 1);
+        increment(count_, 1);
+        increment(sum_, ns);
+        if (ns < load(min_)) min_.store(ns, std::memory_order_relaxed);
+        if (ns > load(max_)) max_.store(ns, std::memory_order_relaxed);
+    }
+
+    // Only while nothing is recording
+    void reset();
+
+    uint64_t getCount() const { return load(count_); }
+    uint64_t getMin() const { return getCount() ? load(min_) : 0; }
+    uint64_t getMax() const { return load(max_); }
+    double getMean() const { return getCount() ? double(load(sum_)) / getCount() : 0.0; }
+
+    // Smallest bucket bound that at least `percentile` % of the values do not exceed
+    uint64_t getPercentile(double percentile) const;
+
+private:
+    typedef std::atomic<uint64_t> Counter;
+
+    static uint64_t load(const Counter& counter) { return counter.load(std::memory_order_relaxed); }
+
+    // Single writer, so no read-modify-write instruction is needed
+    static void increment(Counter& counter, uint64_t value) {
+        counter.store(load(counter) + value, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketUpperBound(int bucket);
+
+    Counter counts_[BUCKET_COUNT];
+    Counter count_;
+    Counter sum_;
+    Counter min_;
+    Counter max_;
+};
+
+// Stages a packet passes through between the socket and a consumer
+enum LatencyStage {
+    STAGE_SOCKET_WAIT,      // Time blocked in recvfrom()/recvmmsg()
+    STAGE_KERNEL_TO_USER,   // Kernel receive timestamp to the receive call returning
+    STAGE_PARSE,            // Decoding one packet
+    STAGE_ASSEMBLY,         // Adding a packet to its revolution (and closing or writing it out)
+    STAGE_HANDOFF,          // Passing data to its consumer: reader2.0's receive ring to the parse
+                            // thread, slam_lidar_cpp's finished revolution to readScan()
+    STAGE_COUNT
+};
+
+// One histogram per pipeline stage. Disabled by default; while disabled, start()
+// returns 0 without reading the clock and stop() returns at once, so the
+// instrumentation can stay compiled into production builds.
+// Each stage must only be recorded from one thread; print() may run on another.
+class PipelineLatency {
+public:
+    PipelineLatency() : enabled_(false) {}
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool isEnabled() const { return enabled_; }
+
+    // Timestamp to pass to stop(), or 0 when disabled
+    uint64_t start() const { return enabled_ ? now() : 0; }
+
+    void stop(LatencyStage stage, uint64_t start_ns) {
+        if (start_ns != 0) {
+            stages_[stage].record(now() - start_ns);
+        }
+    }
+
+    void record(LatencyStage stage, uint64_t ns) {
+        if (enabled_) {
+            stages_[stage].record(ns);
+        }
+    }
+
+    const LatencyHistogram& getStage(LatencyStage stage) const { return stages_[stage]; }
+
+    // Table of count, min, p50, p90, p99, p99.9 and max per stage, in microseconds
+    void print(std::ostream& out) const;
+    void reset();
+
+    // CLOCK_MONOTONIC in nanoseconds
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+private:
+    bool enabled_;
+    LatencyHistogram stages_[STAGE_COUNT];
+};
+
+#endif // LATENCY_HISTOGRAM_H
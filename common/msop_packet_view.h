@@ -0,0 +1,79 @@
+#ifndef MSOP_PACKET_VIEW_H
+#define MSOP_PACKET_VIEW_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Read-only view of one MSOP packet (network byte order, UDP header already stripped).
+// Fields are decoded from the bytes on each access, so a packet can be read where it
+// lies - a receive buffer, a capture ring slot or an mmap'd pcap - without copying it
+// into a packet struct or casting the memory to one. Offsets follow MSOPPacket in
+// reader2.0's msop_parser.h and MSOP_Data_t in slam_lidar_cpp's data_type.h, but the
+// view depends on neither. It holds only a pointer and is cheap to pass by value.
+class MSOPPacketView {
+public:
+    static constexpr size_t PACKET_SIZE = 1206;         // 12 blocks + 6-byte tail
+    static constexpr int BLOCK_COUNT = 12;
+    static constexpr int MEASUREMENTS_PER_BLOCK = 16;
+
+    static constexpr size_t BLOCK_SIZE = 100;
+    static constexpr size_t FLAG_OFFSET = 0;            // Within a block
+    static constexpr size_t AZIMUTH_OFFSET = 2;
+    static constexpr size_t MEASUREMENT_OFFSET = 4;
+    static constexpr size_t MEASUREMENT_SIZE = 6;
+    static constexpr size_t STRONGEST_OFFSET = 0;       // Within a measurement
+    static constexpr size_t LAST_OFFSET = 3;
+    static constexpr size_t TIMESTAMP_OFFSET = 1200;    // Within the packet
+    static constexpr size_t FACTORY_INFO_OFFSET = 1204;
+
+    static constexpr uint16_t VALID_BLOCK_FLAG = 0xFFEE;
+    static constexpr uint16_t INVALID_BLOCK_FLAG = 0xFFFF;
+
+    // data must hold PACKET_SIZE bytes; check the datagram length with isPacketSize() first
+    explicit MSOPPacketView(const uint8_t* data) : data_(data) {}
+
+    static bool isPacketSize(size_t size) { return size == PACKET_SIZE; }
+
+    const uint8_t* data() const { return data_; }
+    const uint8_t* block(int block) const { return data_ + block * BLOCK_SIZE; }
+
+    uint16_t blockFlag(int block) const { return load16(this->block(block) + FLAG_OFFSET); }
+    uint16_t blockAzimuth(int block) const { return load16(this->block(block) + AZIMUTH_OFFSET); }
+
+    uint16_t distanceStrongest(int block, int index) const { return load16(measurement(block, index) + STRONGEST_OFFSET); }
+    uint8_t rssiStrongest(int block, int index) const { return measurement(block, index)[STRONGEST_OFFSET + 2]; }
+    uint16_t distanceLast(int block, int index) const { return load16(measurement(block, index) + LAST_OFFSET); }
+    uint8_t rssiLast(int block, int index) const { return measurement(block, index)[LAST_OFFSET + 2]; }
+
+    uint32_t timestamp() const { return load32(data_ + TIMESTAMP_OFFSET); }
+    uint16_t factoryInfo() const { return load16(data_ + FACTORY_INFO_OFFSET); }
+
+    // The last packet of a rotation carries the invalid flag in blocks 6-11
+    bool isLastPacket() const {
+        for (int i = 6; i < BLOCK_COUNT; ++i) {
+            if (blockFlag(i) != INVALID_BLOCK_FLAG) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* measurement(int block, int index) const {
+        return this->block(block) + MEASUREMENT_OFFSET + index * MEASUREMENT_SIZE;
+    }
+
+    // Byte loads need no alignment and no aliasing exemption; compilers fold them
+    // into a single load plus byte swap
+    static uint16_t load16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+    static uint32_t load32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    const uint8_t* data_;
+};
+
+#endif // MSOP_PACKET_VIEW_H
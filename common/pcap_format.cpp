@@ -0,0 +1,195 @@
+#include "pcap_format.h"
+#include <cstring>
+#include <arpa/inet.h>
+
+static const uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;
+static const uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+
+static const uint32_t LINKTYPE_ETHERNET = 1;
+static const uint32_t LINKTYPE_RAW = 101;
+static const uint32_t LINKTYPE_LINUX_SLL = 113;
+static const uint32_t LINKTYPE_LINUX_SLL2 = 276;
+
+static const size_t ETH_HEADER = 14;
+static const size_t IPV4_HEADER = 20;
+static const size_t UDP_HEADER = 8;
+
+void buildPcapFileHeader(uint8_t* header) {
+    // Version 2.4, zone and sigfigs 0, snaplen 65535
+    const uint32_t fields[6] = { PCAP_MAGIC_NS, 2 | (4u << 16), 0, 0, 65535, LINKTYPE_ETHERNET };
+    memcpy(header, fields, sizeof(fields));
+}
+
+void buildPcapRecordPrefix(uint8_t* prefix, size_t payload_size, const struct timespec& ts,
+                           uint16_t dst_port, const struct sockaddr_in* src) {
+    const uint32_t frame = static_cast<uint32_t>(PCAP_UDP_FRAME_HEADERS + payload_size);
+    const uint32_t record[4] = { static_cast<uint32_t>(ts.tv_sec), static_cast<uint32_t>(ts.tv_nsec),
+                                 frame, frame };
+    memcpy(prefix, record, sizeof(record));
+
+    uint8_t* hdr = prefix + PCAP_RECORD_HEADER_SIZE;
+    memset(hdr, 0, PCAP_UDP_FRAME_HEADERS);
+    // Ethernet: zero MACs, IPv4 ethertype
+    hdr[12] = 0x08;
+    hdr[13] = 0x00;
+
+    // IPv4: no options, don't fragment, TTL 64, UDP
+    uint8_t* ip = hdr + ETH_HEADER;
+    uint16_t ip_length = htons(static_cast<uint16_t>(IPV4_HEADER + UDP_HEADER + payload_size));
+    ip[0] = 0x45;
+    memcpy(ip + 2, &ip_length, 2);
+    ip[6] = 0x40;
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP;
+    if (src != NULL) {
+        memcpy(ip + 12, &src->sin_addr, 4);
+    }
+    uint32_t sum = 0;
+    for (size_t i = 0; i < IPV4_HEADER; i += 2) {
+        sum += (ip[i] << 8) | ip[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    uint16_t checksum = htons(static_cast<uint16_t>(~sum));
+    memcpy(ip + 10, &checksum, 2);
+
+    // UDP: checksum 0 (not computed)
+    uint8_t* udp = ip + IPV4_HEADER;
+    uint16_t source_port = (src != NULL) ? src->sin_port : htons(dst_port);
+    uint16_t destination_port = htons(dst_port);
+    uint16_t udp_length = htons(static_cast<uint16_t>(UDP_HEADER + payload_size));
+    memcpy(udp, &source_port, 2);
+    memcpy(udp + 2, &destination_port, 2);
+    memcpy(udp + 4, &udp_length, 2);
+}
+
+PcapParser::PcapParser()
+    : data_(NULL), size_(0), offset_(0), swapped_(false), nanosecond_(false), linktype_(0) {
+}
+
+bool PcapParser::open(const uint8_t* data, size_t size, std::string& error) {
+    data_ = NULL;
+    if (size < PCAP_FILE_HEADER_SIZE) {
+        error = "too short to be a pcap file";
+        return false;
+    }
+
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    swapped_ = false;
+    if (magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS)) {
+        swapped_ = true;
+        magic = __builtin_bswap32(magic);
+    }
+    if (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) {
+        error = "not a pcap file (pcapng is not supported)";
+        return false;
+    }
+    nanosecond_ = (magic == PCAP_MAGIC_NS);
+
+    linktype_ = read32(data + 20) & 0x0FFFFFFF;
+    if (linktype_ != LINKTYPE_ETHERNET && linktype_ != LINKTYPE_RAW &&
+        linktype_ != LINKTYPE_LINUX_SLL && linktype_ != LINKTYPE_LINUX_SLL2) {
+        error = "unsupported link type " + std::to_string(linktype_);
+        return false;
+    }
+
+    data_ = data;
+    size_ = size;
+    offset_ = PCAP_FILE_HEADER_SIZE;
+    return true;
+}
+
+void PcapParser::rewind() {
+    offset_ = PCAP_FILE_HEADER_SIZE;
+}
+
+uint32_t PcapParser::read32(const uint8_t* p) const {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped_ ? __builtin_bswap32(value) : value;
+}
+
+bool PcapParser::nextRecord(const uint8_t*& frame, size_t& length, int64_t& timestamp_ns) {
+    if (data_ == NULL || offset_ + PCAP_RECORD_HEADER_SIZE > size_) {
+        return false;
+    }
+    const uint8_t* record = data_ + offset_;
+    uint32_t seconds = read32(record);
+    uint32_t fraction = read32(record + 4);
+    uint32_t captured = read32(record + 8);
+
+    // An all-zero header is the padding an interrupted recording leaves behind
+    if (seconds == 0 && fraction == 0 && captured == 0) {
+        return false;
+    }
+    if (captured > size_ - offset_ - PCAP_RECORD_HEADER_SIZE) {
+        return false;  // Truncated last record
+    }
+    offset_ += PCAP_RECORD_HEADER_SIZE + captured;
+
+    frame = record + PCAP_RECORD_HEADER_SIZE;
+    length = captured;
+    timestamp_ns = static_cast<int64_t>(seconds) * 1000000000 +
+                   (nanosecond_ ? fraction : static_cast<int64_t>(fraction) * 1000);
+    return true;
+}
+
+bool PcapParser::udpPayload(const uint8_t* frame, size_t length, uint16_t port,
+                            const uint8_t*& payload, size_t& size) const {
+    // Find the IPv4 header behind this capture's link-layer framing
+    size_t ip_offset = 0;
+    uint16_t protocol = 0x0800;
+    if (linktype_ == LINKTYPE_ETHERNET) {
+        ip_offset = ETH_HEADER;
+        if (length < ip_offset) {
+            return false;
+        }
+        protocol = (frame[12] << 8) | frame[13];
+        while (protocol == 0x8100 || protocol == 0x88A8) {  // 802.1Q / 802.1ad tags
+            if (length < ip_offset + 4) {
+                return false;
+            }
+            protocol = (frame[ip_offset + 2] << 8) | frame[ip_offset + 3];
+            ip_offset += 4;
+        }
+    } else if (linktype_ == LINKTYPE_LINUX_SLL) {
+        ip_offset = 16;
+        if (length < ip_offset) {
+            return false;
+        }
+        protocol = (frame[14] << 8) | frame[15];
+    } else if (linktype_ == LINKTYPE_LINUX_SLL2) {
+        ip_offset = 20;
+        if (length < ip_offset) {
+            return false;
+        }
+        protocol = (frame[0] << 8) | frame[1];
+    }
+    if (protocol != 0x0800 || length < ip_offset + IPV4_HEADER) {
+        return false;
+    }
+
+    const uint8_t* ip = frame + ip_offset;
+    size_t ip_header = (ip[0] & 0x0F) * 4;
+    if ((ip[0] >> 4) != 4 || ip_header < IPV4_HEADER || ip[9] != IPPROTO_UDP ||
+        length < ip_offset + ip_header + UDP_HEADER) {
+        return false;
+    }
+    if (((ip[6] & 0x3F) | ip[7]) != 0) {
+        return false;  // IP fragment (MF set or offset != 0)
+    }
+
+    const uint8_t* udp = ip + ip_header;
+    uint16_t dest_port = static_cast<uint16_t>((udp[2] << 8) | udp[3]);
+    size_t udp_length = (udp[4] << 8) | udp[5];
+    if ((port != 0 && dest_port != port) || udp_length < UDP_HEADER ||
+        ip_offset + ip_header + udp_length > length) {
+        return false;
+    }
+
+    payload = udp + UDP_HEADER;
+    size = udp_length - UDP_HEADER;
+    return true;
+}
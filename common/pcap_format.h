@@ -0,0 +1,70 @@
+#ifndef PCAP_FORMAT_H
+#define PCAP_FORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <time.h>
+#include <netinet/in.h>
+
+// Classic pcap framing shared by reader2.0 and slam_lidar_cpp, so every recording
+// path writes the same files and every replay reads them the same way.
+//
+// Writing: nanosecond timestamps, Ethernet link type, and each MSOP payload behind
+// synthesized Ethernet/IPv4/UDP headers. Headers are written in host byte order,
+// which readers detect from the magic number.
+
+static const size_t PCAP_FILE_HEADER_SIZE = 24;
+static const size_t PCAP_RECORD_HEADER_SIZE = 16;
+static const size_t PCAP_UDP_FRAME_HEADERS = 14 + 20 + 8;    // Ethernet + IPv4 + UDP
+
+// Bytes written in front of each payload: record header plus frame headers
+static const size_t PCAP_RECORD_PREFIX_SIZE = PCAP_RECORD_HEADER_SIZE + PCAP_UDP_FRAME_HEADERS;
+
+// Fill the PCAP_FILE_HEADER_SIZE-byte file header
+void buildPcapFileHeader(uint8_t* header);
+
+// Fill the PCAP_RECORD_PREFIX_SIZE bytes that precede a payload of payload_size bytes
+// received at ts (CLOCK_REALTIME) on dst_port. src is the sender if known, else NULL.
+void buildPcapRecordPrefix(uint8_t* prefix, size_t payload_size, const struct timespec& ts,
+                           uint16_t dst_port, const struct sockaddr_in* src);
+
+// Reading: walks the records of a classic pcap held in memory (usually a mapped
+// file) and finds the UDP payload in each. Understands microsecond and nanosecond
+// files of either byte order, with Ethernet (802.1Q/802.1ad tags), raw IP or Linux
+// cooked (SLL, SLL2) framing. Only unfragmented IPv4/UDP packets are returned.
+// pcapng is not supported.
+class PcapParser {
+public:
+    PcapParser();
+
+    // Check the file header and position at the first record. On failure, error
+    // says why (not pcap, unsupported link type, too short).
+    bool open(const uint8_t* data, size_t size, std::string& error);
+
+    // Next record: its captured bytes and capture time. Returns false at the end of
+    // the data, at a truncated last record, or at the all-zero header an
+    // interrupted recording leaves as padding.
+    bool nextRecord(const uint8_t*& frame, size_t& length, int64_t& timestamp_ns);
+
+    // UDP payload of a record's frame if it is addressed to port (0 = any port)
+    bool udpPayload(const uint8_t* frame, size_t length, uint16_t port,
+                    const uint8_t*& payload, size_t& size) const;
+
+    // Back to the first record
+    void rewind();
+
+    uint32_t linktype() const { return linktype_; }
+
+private:
+    uint32_t read32(const uint8_t* p) const;
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;             // Next record header
+    bool swapped_;              // Written on a host of the other byte order
+    bool nanosecond_;
+    uint32_t linktype_;
+};
+
+#endif // PCAP_FORMAT_H
@@ -0,0 +1,481 @@
+#include "angle_bin_filter.h"
+#include "point_cloud_soa.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+void filterAngleBins(const PointCloudSoA& samples, const uint16_t* sample_bins,
+                     PointCloudSoA& out, AngleBinFilterStats& stats) {
+    const int num_bins = ANGLE_BIN_COUNT;
+    stats = AngleBinFilterStats();
+    if (samples.empty()) {
+        return;
+    }
+
+    // Group sample indices by bin (stable counting sort keeps arrival order within a bin)
+    std::vector<uint32_t> bin_counts(num_bins, 0);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        bin_counts[sample_bins[i]]++;
+    }
+    std::vector<uint32_t> bin_start(num_bins + 1, 0);
+    for (int bin = 0; bin < num_bins; ++bin) {
+        bin_start[bin + 1] = bin_start[bin] + bin_counts[bin];
+    }
+    std::vector<uint32_t> order(samples.size());
+    std::vector<uint32_t> fill(bin_start.begin(), bin_start.end() - 1);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        order[fill[sample_bins[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    const float* sample_distance = samples.range();
+    const uint8_t* sample_rssi = samples.rssi();
+
+    std::vector<float> distances, rssi_values;
+    std::vector<uint32_t> filtered_samples;
+
+    // Select the best sample of each bin
+    for (int bin = 0; bin < num_bins; ++bin) {
+        const uint32_t* bin_samples = &order[0] + bin_start[bin];
+        const size_t bin_size = bin_counts[bin];
+        stats.total_samples += bin_size;
+
+        if (bin_size >= 3) {
+            stats.multi_sample_bins++;
+
+            // Multiple samples: use median-based filtering for robustness
+            distances.resize(bin_size);
+            rssi_values.resize(bin_size);
+            for (size_t i = 0; i < bin_size; ++i) {
+                distances[i] = sample_distance[bin_samples[i]];
+                rssi_values[i] = sample_rssi[bin_samples[i]];
+            }
+
+            // Sort for median calculation
+            std::sort(distances.begin(), distances.end());
+            std::sort(rssi_values.begin(), rssi_values.end());
+
+            // Calculate medians
+            float median_distance = distances[distances.size() / 2];
+            float median_rssi = rssi_values[rssi_values.size() / 2];
+
+            // Filter out obvious outliers (beyond 50% of median)
+            filtered_samples.clear();
+            for (size_t i = 0; i < bin_size; ++i) {
+                uint32_t sample = bin_samples[i];
+                float distance_deviation = std::abs(sample_distance[sample] - median_distance) / median_distance;
+                if (distance_deviation <= 0.50f && sample_rssi[sample] >= median_rssi * 0.7f) {
+                    filtered_samples.push_back(sample);
+                }
+            }
+
+            if (!filtered_samples.empty() && median_rssi > 20) {  // Higher threshold for LV3 filtered data
+                // Select the sample closest to median distance with good RSSI
+                uint32_t best_sample = *std::min_element(filtered_samples.begin(), filtered_samples.end(),
+                    [&](uint32_t a, uint32_t b) {
+                        float diff_a = std::abs(sample_distance[a] - median_distance);
+                        float diff_b = std::abs(sample_distance[b] - median_distance);
+                        if (std::abs(diff_a - diff_b) < 0.1f) {
+                            return sample_rssi[a] > sample_rssi[b];  // If distances similar, prefer higher RSSI
+                        }
+                        return diff_a < diff_b;
+                    });
+
+                out.push_back(samples, best_sample);
+            } else {
+                stats.filtered_bins++;
+            }
+
+        } else if (bin_size == 2) {
+            stats.two_sample_bins++;
+
+            // Two samples: check if they're reasonably consistent
+            uint32_t a = bin_samples[0], b = bin_samples[1];
+            float distance_diff = std::abs(sample_distance[a] - sample_distance[b]);
+            float avg_distance = (sample_distance[a] + sample_distance[b]) / 2.0f;
+            float relative_diff = distance_diff / avg_distance;
+
+            if (relative_diff <= 0.30f &&
+                std::min(sample_rssi[a], sample_rssi[b]) > 20) {  // Higher threshold for LV3 data
+                // Use the sample with higher RSSI
+                out.push_back(samples, (sample_rssi[a] > sample_rssi[b]) ? a : b);
+            } else {
+                stats.filtered_bins++;
+            }
+
+        } else if (bin_size == 1) {
+            stats.single_sample_bins++;
+
+            // Single sample: be more accepting but require decent RSSI
+            // With LV3 hardware filtering, we can be more confident in single samples
+            if (sample_rssi[bin_samples[0]] > 25) {  // Higher threshold for single samples with LV3
+                out.push_back(samples, bin_samples[0]);
+            } else {
+                stats.filtered_bins++;
+            }
+        }
+    }
+}
+
+namespace {
+
+// Outlier gate of the 3+ sample rule: within 50% of the median range and at least
+// 70% of the median RSSI
+inline bool nearMedian(float range, uint8_t rssi, float median_distance, float median_rssi) {
+    float distance_deviation = std::abs(range - median_distance) / median_distance;
+    return distance_deviation <= 0.50f && rssi >= median_rssi * 0.7f;
+}
+
+// Whether a candidate beats the current best: closer to the median range, or higher
+// RSSI when the two are within 0.1 m of each other
+inline bool closerToMedian(float diff, uint8_t rssi, float best_diff, uint8_t best_rssi) {
+    if (std::abs(diff - best_diff) < 0.1f) {
+        return rssi > best_rssi;
+    }
+    return diff < best_diff;
+}
+
+// Two-sample rule: ranges within 30% of their mean and both RSSIs above 20
+inline bool consistentPair(float range_a, uint8_t rssi_a, float range_b, uint8_t rssi_b) {
+    float distance_diff = std::abs(range_a - range_b);
+    float avg_distance = (range_a + range_b) / 2.0f;
+    return distance_diff / avg_distance <= 0.30f && std::min(rssi_a, rssi_b) > 20;
+}
+
+} // namespace
+
+StreamingAngleFilter::StreamingAngleFilter()
+    : bins_(BIN_COUNT), sample_count_(0), occupied_bins_(0) {
+    reset();
+}
+
+void StreamingAngleFilter::reset() {
+    for (int i = 0; i < BIN_COUNT; ++i) {
+        Bin& bin = bins_[i];
+        bin.head = 0;
+        bin.count = 0;
+        bin.dirty = false;
+        bin.best = -1;
+    }
+    sample_count_ = 0;
+    occupied_bins_ = 0;
+}
+
+void StreamingAngleFilter::addSample(float azimuth, float range, uint8_t rssi, uint8_t flags) {
+    int index = static_cast<int>(azimuth * 2.0f);
+    if (index < 0) {
+        return;
+    }
+    if (index >= BIN_COUNT) {
+        index %= BIN_COUNT;
+    }
+    Bin& bin = bins_[index];
+    int slot = bin.head;
+
+    // A full window overwrites its oldest sample
+    if (bin.count == 0) {
+        occupied_bins_++;
+    }
+    if (bin.count < WINDOW) {
+        bin.count++;
+    }
+    bin.azimuth[slot] = azimuth;
+    bin.range[slot] = range;
+    bin.rssi[slot] = rssi;
+    bin.flags[slot] = flags;
+    bin.head = static_cast<uint8_t>((slot + 1) % WINDOW);
+    bin.dirty = true;
+    sample_count_++;
+}
+
+void StreamingAngleFilter::addPoints(const PointCloudSoA& points) {
+    const float* azimuth = points.azimuth();
+    const float* range = points.range();
+    const uint8_t* rssi = points.rssi();
+    const uint8_t* flags = points.flags();
+    for (size_t i = 0; i < points.size(); ++i) {
+        addSample(azimuth[i], range[i], rssi[i], flags[i]);
+    }
+}
+
+void StreamingAngleFilter::select(Bin& bin) {
+    // Slots in arrival order, so ties resolve as in filterAngleBins()
+    int slots[WINDOW];
+    const int count = bin.count;
+    for (int i = 0; i < count; ++i) {
+        slots[i] = (bin.head - count + i + WINDOW) % WINDOW;
+    }
+    bin.best = -1;
+    bin.dirty = false;
+
+    if (count >= 3) {
+        // Upper medians, as filterAngleBins() takes them from the sorted samples
+        float ranges[WINDOW];
+        uint8_t rssis[WINDOW];
+        std::copy(bin.range, bin.range + count, ranges);
+        std::copy(bin.rssi, bin.rssi + count, rssis);
+        std::nth_element(ranges, ranges + count / 2, ranges + count);
+        std::nth_element(rssis, rssis + count / 2, rssis + count);
+        float median_distance = ranges[count / 2];
+        float median_rssi = rssis[count / 2];
+        if (median_rssi <= 20) {
+            return;
+        }
+
+        // Among the samples near the median, the one closest to the median range
+        float best_diff = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            int slot = slots[i];
+            if (!nearMedian(bin.range[slot], bin.rssi[slot], median_distance, median_rssi)) {
+                continue;
+            }
+            float diff = std::abs(bin.range[slot] - median_distance);
+            if (bin.best < 0 || closerToMedian(diff, bin.rssi[slot], best_diff, bin.rssi[bin.best])) {
+                bin.best = static_cast<int8_t>(slot);
+                best_diff = diff;
+            }
+        }
+    } else if (count == 2) {
+        int a = slots[0], b = slots[1];
+        if (consistentPair(bin.range[a], bin.rssi[a], bin.range[b], bin.rssi[b])) {
+            bin.best = static_cast<int8_t>(bin.rssi[a] > bin.rssi[b] ? a : b);
+        }
+    } else if (count == 1) {
+        if (bin.rssi[slots[0]] > 25) {
+            bin.best = static_cast<int8_t>(slots[0]);
+        }
+    }
+}
+
+void StreamingAngleFilter::writeFiltered(PointCloudSoA& out, AngleBinFilterStats& stats) {
+    stats = AngleBinFilterStats();
+    for (int i = 0; i < BIN_COUNT; ++i) {
+        Bin& bin = bins_[i];
+        if (bin.count == 0) {
+            continue;
+        }
+        if (bin.dirty) {
+            select(bin);
+        }
+
+        stats.total_samples += bin.count;
+        if (bin.count >= 3) {
+            stats.multi_sample_bins++;
+        } else if (bin.count == 2) {
+            stats.two_sample_bins++;
+        } else {
+            stats.single_sample_bins++;
+        }
+
+        if (bin.best >= 0) {
+            out.push_back(bin.azimuth[bin.best], bin.range[bin.best], bin.rssi[bin.best], bin.flags[bin.best]);
+        } else {
+            stats.filtered_bins++;
+        }
+    }
+}
+
+namespace {
+
+inline uint16_t rangeBucket(float range) {
+    int bucket = static_cast<int>(range * (1000.0f / SlidingWindowDenoiser::RANGE_BUCKET_MM));
+    if (bucket < 0) {
+        return 0;
+    }
+    return static_cast<uint16_t>(std::min(bucket, SlidingWindowDenoiser::RANGE_BUCKETS - 1));
+}
+
+} // namespace
+
+SlidingWindowDenoiser::SlidingWindowDenoiser(int revolutions)
+    : window_size_(std::max(1, std::min(revolutions, static_cast<int>(MAX_WINDOW)))),
+      revolutions_held_(0), current_(0),
+      revolutions_(window_size_),
+      bin_stats_(BIN_COUNT),
+      range_histograms_(BIN_COUNT * RANGE_BUCKETS),
+      rssi_histograms_(BIN_COUNT * 256),
+      current_azimuth_(BIN_COUNT * MAX_SAMPLES_PER_BIN),
+      current_range_(BIN_COUNT * MAX_SAMPLES_PER_BIN),
+      current_flags_(BIN_COUNT * MAX_SAMPLES_PER_BIN) {
+    for (size_t i = 0; i < revolutions_.size(); ++i) {
+        revolutions_[i].counts.resize(BIN_COUNT);
+        revolutions_[i].range_buckets.resize(BIN_COUNT * MAX_SAMPLES_PER_BIN);
+        revolutions_[i].rssi.resize(BIN_COUNT * MAX_SAMPLES_PER_BIN);
+    }
+    reset();
+}
+
+void SlidingWindowDenoiser::reset() {
+    for (size_t i = 0; i < revolutions_.size(); ++i) {
+        std::fill(revolutions_[i].counts.begin(), revolutions_[i].counts.end(), 0);
+    }
+    for (int bin = 0; bin < BIN_COUNT; ++bin) {
+        BinStats& stats = bin_stats_[bin];
+        stats.count = 0;
+        stats.range_median.bucket = 0;
+        stats.range_median.below = 0;
+        stats.rssi_median.bucket = 0;
+        stats.rssi_median.below = 0;
+    }
+    std::fill(range_histograms_.begin(), range_histograms_.end(), 0);
+    std::fill(rssi_histograms_.begin(), rssi_histograms_.end(), 0);
+    revolutions_held_ = 0;
+    current_ = 0;
+}
+
+void SlidingWindowDenoiser::addSample(float azimuth, float range, uint8_t rssi, uint8_t flags) {
+    int bin = static_cast<int>(azimuth * 2.0f);
+    if (bin < 0) {
+        return;
+    }
+    if (bin >= BIN_COUNT) {
+        bin %= BIN_COUNT;
+    }
+    Revolution& revolution = revolutions_[current_];
+    int n = revolution.counts[bin];
+    if (n == MAX_SAMPLES_PER_BIN) {
+        return;
+    }
+    int slot = bin * MAX_SAMPLES_PER_BIN + n;
+    revolution.range_buckets[slot] = rangeBucket(range);
+    revolution.rssi[slot] = rssi;
+    revolution.counts[bin] = static_cast<uint8_t>(n + 1);
+    current_azimuth_[slot] = azimuth;
+    current_range_[slot] = range;
+    current_flags_[slot] = flags;
+}
+
+void SlidingWindowDenoiser::addPoints(const PointCloudSoA& points) {
+    const float* azimuth = points.azimuth();
+    const float* range = points.range();
+    const uint8_t* rssi = points.rssi();
+    const uint8_t* flags = points.flags();
+    for (size_t i = 0; i < points.size(); ++i) {
+        addSample(azimuth[i], range[i], rssi[i], flags[i]);
+    }
+}
+
+namespace {
+
+// Move a cursor to the bucket holding the sample of rank count / 2 (the upper median).
+// Only the buckets between the old and new median are visited.
+template <typename Cursor>
+inline int moveToMedian(const uint16_t* histogram, Cursor& cursor, uint32_t count) {
+    uint32_t rank = count / 2;
+    while (cursor.below > rank) {
+        cursor.bucket--;
+        cursor.below -= histogram[cursor.bucket];
+    }
+    while (cursor.below + histogram[cursor.bucket] <= rank) {
+        cursor.below += histogram[cursor.bucket];
+        cursor.bucket++;
+    }
+    return cursor.bucket;
+}
+
+} // namespace
+
+void SlidingWindowDenoiser::addToWindow(int bin, uint16_t range_bucket, uint8_t rssi) {
+    BinStats& stats = bin_stats_[bin];
+    range_histograms_[bin * RANGE_BUCKETS + range_bucket]++;
+    rssi_histograms_[bin * 256 + rssi]++;
+    if (range_bucket < stats.range_median.bucket) {
+        stats.range_median.below++;
+    }
+    if (rssi < stats.rssi_median.bucket) {
+        stats.rssi_median.below++;
+    }
+    stats.count++;
+}
+
+void SlidingWindowDenoiser::removeFromWindow(int bin, uint16_t range_bucket, uint8_t rssi) {
+    BinStats& stats = bin_stats_[bin];
+    range_histograms_[bin * RANGE_BUCKETS + range_bucket]--;
+    rssi_histograms_[bin * 256 + rssi]--;
+    if (range_bucket < stats.range_median.bucket) {
+        stats.range_median.below--;
+    }
+    if (rssi < stats.rssi_median.bucket) {
+        stats.rssi_median.below--;
+    }
+    stats.count--;
+}
+
+void SlidingWindowDenoiser::evict(Revolution& revolution) {
+    for (int bin = 0; bin < BIN_COUNT; ++bin) {
+        int n = revolution.counts[bin];
+        for (int i = 0; i < n; ++i) {
+            int slot = bin * MAX_SAMPLES_PER_BIN + i;
+            removeFromWindow(bin, revolution.range_buckets[slot], revolution.rssi[slot]);
+        }
+        revolution.counts[bin] = 0;
+    }
+}
+
+void SlidingWindowDenoiser::finishRevolution(PointCloudSoA& out, AngleBinFilterStats& stats) {
+    stats = AngleBinFilterStats();
+    Revolution& revolution = revolutions_[current_];
+
+    for (int bin = 0; bin < BIN_COUNT; ++bin) {
+        const int n = revolution.counts[bin];
+        if (n == 0) {
+            continue;
+        }
+        const int first = bin * MAX_SAMPLES_PER_BIN;
+        for (int i = 0; i < n; ++i) {
+            addToWindow(bin, revolution.range_buckets[first + i], revolution.rssi[first + i]);
+        }
+        BinStats& window = bin_stats_[bin];
+        stats.total_samples += n;
+
+        int best = -1;
+        if (window.count >= 3) {
+            stats.multi_sample_bins++;
+            int range_bucket = moveToMedian(&range_histograms_[bin * RANGE_BUCKETS], window.range_median, window.count);
+            float median_distance = (range_bucket + 0.5f) * (RANGE_BUCKET_MM / 1000.0f);
+            float median_rssi = moveToMedian(&rssi_histograms_[bin * 256], window.rssi_median, window.count);
+
+            if (median_rssi > 20) {
+                float best_diff = 0.0f;
+                for (int i = first; i < first + n; ++i) {
+                    if (!nearMedian(current_range_[i], revolution.rssi[i], median_distance, median_rssi)) {
+                        continue;
+                    }
+                    float diff = std::abs(current_range_[i] - median_distance);
+                    if (best < 0 || closerToMedian(diff, revolution.rssi[i], best_diff, revolution.rssi[best])) {
+                        best = i;
+                        best_diff = diff;
+                    }
+                }
+            }
+        } else if (window.count == 2) {
+            stats.two_sample_bins++;
+            // Both samples are this revolution's when the window holds no other
+            if (n == 2 && consistentPair(current_range_[first], revolution.rssi[first],
+                                         current_range_[first + 1], revolution.rssi[first + 1])) {
+                best = revolution.rssi[first] > revolution.rssi[first + 1] ? first : first + 1;
+            } else if (n == 1 && revolution.rssi[first] > 25) {
+                best = first;
+            }
+        } else {
+            stats.single_sample_bins++;
+            if (revolution.rssi[first] > 25) {
+                best = first;
+            }
+        }
+
+        if (best >= 0) {
+            out.push_back(current_azimuth_[best], current_range_[best], revolution.rssi[best], current_flags_[best]);
+        } else {
+            stats.filtered_bins++;
+        }
+    }
+
+    // The next slot holds the oldest revolution once the window is full
+    if (revolutions_held_ < window_size_) {
+        revolutions_held_++;
+    }
+    current_ = (current_ + 1) % window_size_;
+    if (revolutions_held_ == window_size_) {
+        evict(revolutions_[current_]);
+    }
+}
@@ -0,0 +1,164 @@
+#ifndef ANGLE_BIN_FILTER_H
+#define ANGLE_BIN_FILTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class PointCloudSoA;
+
+// 0.5° angle bins over 0-360°: bin = azimuth * 2
+static const int ANGLE_BIN_COUNT = 721;
+
+// What filterAngleBins() did with the samples it was given
+struct AngleBinFilterStats {
+    int total_samples;
+    int filtered_bins;          // Occupied bins that produced no point
+    int multi_sample_bins;      // Bins with 3+ samples (median filtered)
+    int two_sample_bins;
+    int single_sample_bins;
+
+    AngleBinFilterStats()
+        : total_samples(0), filtered_bins(0), multi_sample_bins(0), two_sample_bins(0), single_sample_bins(0) {}
+};
+
+// Reduce many samples per angle bin to one reliable point per bin, as lidar_visualizer
+// does after collecting its packets. Bins with 3+ samples keep the sample closest to the
+// median distance once outliers (>50% off the median range or <70% of the median RSSI)
+// are dropped; 2 consistent samples keep the stronger; a single sample needs RSSI > 25.
+// sample_bins[i] is the angle bin of samples point i. Points are appended to out in
+// increasing bin order, so the output is sorted by azimuth.
+void filterAngleBins(const PointCloudSoA& samples, const uint16_t* sample_bins,
+                     PointCloudSoA& out, AngleBinFilterStats& stats);
+
+// Streaming form of filterAngleBins(). Each 0.5° bin keeps a ring of its most recent
+// samples, so adding a sample is O(1) and memory is fixed at construction. The medians
+// are not kept up to date as samples arrive: each bin caches its selected sample, and
+// writeFiltered() recomputes the medians (two nth_element calls) and the selection for
+// every bin that changed since the last call. A read therefore costs O(WINDOW) per
+// changed bin, up to O(bins × WINDOW), and O(bins) only when nothing changed. This
+// suits lidar_visualizer, which adds every sample and reads once; keeping each window
+// sorted made adding samples about four times slower. Same rules as filterAngleBins(),
+// applied to the window: as long as no bin has received more than WINDOW samples, the
+// output is identical.
+class StreamingAngleFilter {
+public:
+    static const int BIN_COUNT = 720;   // Azimuth 360.0 folds into bin 0
+    static const int WINDOW = 32;       // Recent samples kept per bin
+
+    StreamingAngleFilter();
+
+    // Add one sample; the bin is azimuth * 2
+    void addSample(float azimuth, float range, uint8_t rssi, uint8_t flags);
+
+    // Add every point of a cloud
+    void addPoints(const PointCloudSoA& points);
+
+    // Append the selected point of every bin, in increasing bin order (sorted by
+    // azimuth). stats.total_samples counts the samples currently in the windows.
+    void writeFiltered(PointCloudSoA& out, AngleBinFilterStats& stats);
+
+    // Samples added since construction or reset(), including those that left the window
+    uint64_t getSampleCount() const { return sample_count_; }
+    int getOccupiedBins() const { return occupied_bins_; }
+
+    void reset();
+
+private:
+    struct Bin {
+        float azimuth[WINDOW];          // Ring, oldest sample at (head - count) mod WINDOW
+        float range[WINDOW];
+        uint8_t rssi[WINDOW];
+        uint8_t flags[WINDOW];
+        uint8_t head;                   // Next slot to write
+        uint8_t count;
+        bool dirty;                     // Samples changed since best was chosen
+        int8_t best;                    // Slot of the selected sample, -1 if none passes
+    };
+
+    static void select(Bin& bin);
+
+    std::vector<Bin> bins_;             // BIN_COUNT bins, allocated once
+    uint64_t sample_count_;
+    int occupied_bins_;
+};
+
+// Continuous denoising over the last N revolutions. Each revolution's samples are
+// judged against robust per-bin statistics of the whole window, and the survivors
+// form that revolution's denoised scan. The window keeps, per bin, a histogram of
+// range (2 cm buckets) and of RSSI, each with a cursor at its upper median. Closing
+// a revolution adds its samples, removes those of the revolution leaving the window
+// and moves the cursors, so the work per revolution depends on the samples in the
+// two revolutions and not on N. All storage is allocated by the constructor.
+//
+// Rules follow filterAngleBins(): where the window holds 3+ samples for a bin, the
+// revolution's samples within 50% of the median range and at least 70% of the median
+// RSSI compete, the one closest to the median range winning (higher RSSI within
+// 0.1 m), and nothing is emitted if the median RSSI is 20 or less. Sparser bins fall
+// back to the two-sample consistency check or the single-sample RSSI > 25 rule.
+class SlidingWindowDenoiser {
+public:
+    static const int BIN_COUNT = 720;                   // 0.5° bins; azimuth 360.0 folds into bin 0
+    static const int MAX_SAMPLES_PER_BIN = 16;          // Per revolution; further samples are dropped
+    static const int RANGE_BUCKET_MM = 20;
+    static const int RANGE_BUCKETS = 15000 / RANGE_BUCKET_MM;  // Longer ranges share the last bucket
+    static const int MAX_WINDOW = 1024;                 // Keeps the 16-bit histogram counts from overflowing
+
+    // N is clamped to 1..MAX_WINDOW; getWindowSize() gives the window in use
+    explicit SlidingWindowDenoiser(int revolutions);
+
+    // Add a sample to the revolution in progress; the bin is azimuth * 2
+    void addSample(float azimuth, float range, uint8_t rssi, uint8_t flags);
+    void addPoints(const PointCloudSoA& points);
+
+    // Close the revolution in progress: fold it into the window (dropping the oldest
+    // revolution once N are held) and append its denoised points to out in increasing
+    // bin order. stats.total_samples counts the samples of this revolution.
+    void finishRevolution(PointCloudSoA& out, AngleBinFilterStats& stats);
+
+    int getWindowSize() const { return window_size_; }            // N
+    int getRevolutionsHeld() const { return revolutions_held_; }  // Up to N
+    uint32_t getBinSampleCount(int bin) const { return bin_stats_[bin].count; }
+
+    void reset();
+
+private:
+    // One revolution of the window: per bin, up to MAX_SAMPLES_PER_BIN samples
+    struct Revolution {
+        std::vector<uint8_t> counts;            // [BIN_COUNT]
+        std::vector<uint16_t> range_buckets;    // [BIN_COUNT * MAX_SAMPLES_PER_BIN]
+        std::vector<uint8_t> rssi;              // [BIN_COUNT * MAX_SAMPLES_PER_BIN]
+    };
+
+    // Position of a histogram's upper median: bucket and samples in buckets below it
+    struct MedianCursor {
+        uint16_t bucket;
+        uint32_t below;
+    };
+
+    struct BinStats {
+        uint32_t count;                         // Samples in the window
+        MedianCursor range_median;
+        MedianCursor rssi_median;
+    };
+
+    void addToWindow(int bin, uint16_t range_bucket, uint8_t rssi);
+    void removeFromWindow(int bin, uint16_t range_bucket, uint8_t rssi);
+    void evict(Revolution& revolution);
+
+    int window_size_;
+    int revolutions_held_;
+    int current_;                               // Slot of the revolution in progress
+
+    std::vector<Revolution> revolutions_;       // Ring of window_size_ slots
+    std::vector<BinStats> bin_stats_;           // [BIN_COUNT]
+    std::vector<uint16_t> range_histograms_;    // [BIN_COUNT * RANGE_BUCKETS]
+    std::vector<uint16_t> rssi_histograms_;     // [BIN_COUNT * 256]
+
+    // Full-precision samples of the revolution in progress, for the output
+    std::vector<float> current_azimuth_;        // [BIN_COUNT * MAX_SAMPLES_PER_BIN]
+    std::vector<float> current_range_;
+    std::vector<uint8_t> current_flags_;
+};
+
+#endif // ANGLE_BIN_FILTER_H
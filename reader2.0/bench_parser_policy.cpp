@@ -0,0 +1,129 @@
+#include "msop_parser.h"
+#include "msop_policy_parser.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <time.h>
+#include <arpa/inet.h>
+
+static const int PACKET_POOL = 1024;     // Distinct packets, cycled through
+static const int DEFAULT_PACKETS = 200000;
+
+static double nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Sensor-like packets: 4° per block, mostly in-range returns, some dropouts,
+// every eighth packet ends a revolution with invalid blocks
+static void fillPackets(std::vector<MSOPPacket>& packets) {
+    srand(42);
+    uint16_t azimuth = 4500;
+    for (size_t p = 0; p < packets.size(); ++p) {
+        MSOPPacket& packet = packets[p];
+        for (int b = 0; b < 12; ++b) {
+            DataBlock& block = packet.data_blocks[b];
+            bool valid = (p % 8 != 7) || b < 6;
+            block.flag = htons(valid ? 0xFFEE : 0xFFFF);
+            block.azimuth = htons(valid ? azimuth : 0xFFFF);
+            azimuth = static_cast<uint16_t>((azimuth + 400) % 36000);
+            for (int m = 0; m < 16; ++m) {
+                uint16_t strongest = (rand() % 10 == 0) ? 0 : static_cast<uint16_t>(50 + rand() % 16000);
+                uint16_t last = (rand() % 3 == 0) ? strongest : static_cast<uint16_t>(50 + rand() % 16000);
+                block.measurements[m].distance_strongest = htons(strongest);
+                block.measurements[m].distance_last = htons(last);
+                block.measurements[m].rssi_strongest = static_cast<uint8_t>(rand());
+                block.measurements[m].rssi_last = static_cast<uint8_t>(rand());
+            }
+        }
+        packet.tail.timestamp = htonl(static_cast<uint32_t>(p));
+        packet.tail.factory_info = htons(0x3740);
+    }
+}
+
+static void report(const char* name, double micros, int packets, unsigned long points) {
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << micros * 1000.0 / packets << " ns/packet"
+              << std::setprecision(1) << std::setw(10) << points / micros << " Mpoints/s"
+              << std::setw(12) << points / packets << " points/packet" << std::endl;
+}
+
+static void benchGeneric(const std::vector<MSOPPacket>& packets, int iterations) {
+    MSOPParser parser;
+    LidarPoint points[MSOPParser::MAX_POINTS_PER_PACKET];
+    unsigned long total = 0;
+    double start = nowMicros();
+    for (int i = 0; i < iterations; ++i) {
+        const MSOPPacket& packet = packets[i % packets.size()];
+        total += parser.parsePacket(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet),
+                                    points, MSOPParser::MAX_POINTS_PER_PACKET);
+    }
+    report("MSOPParser (runtime gates)", nowMicros() - start, iterations, total);
+}
+
+template <typename Policy, typename Traits>
+static void benchPolicy(const char* name, const std::vector<MSOPPacket>& packets, int iterations) {
+    PolicyParser<Policy, Traits> parser;
+    LidarPoint points[MSOPParser::MAX_POINTS_PER_PACKET];
+    unsigned long total = 0;
+    double start = nowMicros();
+    for (int i = 0; i < iterations; ++i) {
+        const MSOPPacket& packet = packets[i % packets.size()];
+        total += parser.parsePacket(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet), points);
+    }
+    report(name, nowMicros() - start, iterations, total);
+}
+
+// The dual-return LakiBeam1 instantiation must reproduce the generic parser exactly
+static bool checkEquivalence(const std::vector<MSOPPacket>& packets) {
+    MSOPParser generic;
+    PolicyParser<DualReturn, LakiBeam1Traits> specialized;
+    LidarPoint expected[MSOPParser::MAX_POINTS_PER_PACKET];
+    LidarPoint actual[MSOPParser::MAX_POINTS_PER_PACKET];
+
+    for (size_t p = 0; p < packets.size(); ++p) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(&packets[p]);
+        size_t n = generic.parsePacket(data, sizeof(MSOPPacket), expected, MSOPParser::MAX_POINTS_PER_PACKET);
+        if (specialized.parsePacket(data, sizeof(MSOPPacket), actual) != n) {
+            return false;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (memcmp(&expected[i].azimuth, &actual[i].azimuth, sizeof(float)) != 0 ||
+                memcmp(&expected[i].distance, &actual[i].distance, sizeof(float)) != 0 ||
+                expected[i].rssi != actual[i].rssi ||
+                expected[i].is_strongest != actual[i].is_strongest) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_PACKETS;
+    if (iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [packets]" << std::endl;
+        return 1;
+    }
+
+    std::vector<MSOPPacket> packets(PACKET_POOL);
+    fillPackets(packets);
+
+    bool equivalent = checkEquivalence(packets);
+    std::cout << "PolicyParser<DualReturn, LakiBeam1Traits> vs. MSOPParser: "
+              << (equivalent ? "identical output" : "OUTPUT DIFFERS") << std::endl;
+    std::cout << "Parsing " << iterations << " packets per parser\n" << std::endl;
+
+    benchGeneric(packets, iterations);
+    benchPolicy<DualReturn, LakiBeam1Traits>("Dual / LakiBeam1", packets, iterations);
+    benchPolicy<StrongestReturn, LakiBeam1Traits>("Strongest / LakiBeam1", packets, iterations);
+    benchPolicy<LastReturn, LakiBeam1Traits>("Last / LakiBeam1", packets, iterations);
+    benchPolicy<MaxRssiReturn, LakiBeam1Traits>("MaxRssi / LakiBeam1", packets, iterations);
+    benchPolicy<DualReturn, LakiBeam1Fov270Traits>("Dual / LakiBeam1 45-315 FOV", packets, iterations);
+    benchPolicy<StrongestReturn, LakiBeam1Fov270Traits>("Strongest / LakiBeam1 45-315 FOV", packets, iterations);
+
+    return equivalent ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "epoll_reactor.h"
+#include <iostream>
+#include <algorithm>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+LidarEpollReactor::LidarEpollReactor(const std::vector<int>& ports, int batch_size)
+    : ports_(ports), batch_size_(std::max(1, std::min(batch_size, MAX_BATCH_SIZE))), epoll_fd_(-1) {
+}
+
+LidarEpollReactor::~LidarEpollReactor() {
+    for (size_t i = 0; i < sockets_.size(); ++i) {
+        if (sockets_[i] >= 0) {
+            close(sockets_[i]);
+        }
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool LidarEpollReactor::initialize() {
+    if (ports_.empty()) {
+        std::cerr << "Epoll reactor needs at least one port" << std::endl;
+        return false;
+    }
+    // SO_REUSEADDR lets two UDP sockets bind the same port, which would split one
+    // sensor's packets between two parsers
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        if (std::count(ports_.begin(), ports_.end(), ports_[i]) > 1) {
+            std::cerr << "Port " << ports_[i] << " is listed more than once" << std::endl;
+            return false;
+        }
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        std::cerr << "Error creating epoll instance: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Reserved up front: each batch's message headers point into its own storage
+    batches_.reserve(ports_.size());
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        int fd = openSocket(ports_[i]);
+        if (fd < 0) {
+            return false;
+        }
+        sockets_.push_back(fd);
+        batches_.emplace_back(batch_size_);
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;     // Level-triggered: a socket not drained in one batch stays ready
+        event.data.u32 = static_cast<uint32_t>(i);
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            std::cerr << "Error adding port " << ports_[i] << " to epoll: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    events_.resize(ports_.size());
+    sensor_packets_.assign(ports_.size(), 0);
+
+    std::cout << "Epoll reactor initialized on " << ports_.size() << " port(s):";
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        std::cout << " " << ports_[i];
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+int LidarEpollReactor::openSocket(int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Error setting socket options: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        std::cerr << "Error binding socket to port " << port << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int LidarEpollReactor::waitPackets(ReactorPacket* packets, int max_packets, int timeout_ms) {
+    int ready = epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+    if (ready < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        std::cerr << "Error waiting for packets: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    if (ready == 0) {
+        return 0;
+    }
+    stats_.wakeups++;
+
+    int count = 0;
+    for (int e = 0; e < ready && count < max_packets; ++e) {
+        int sensor = static_cast<int>(events_[e].data.u32);
+        PacketBatch& batch = batches_[sensor];
+        int room = std::min(batch.capacity, max_packets - count);
+
+        // Non-blocking socket: takes only what is queued
+        int received = recvmmsg(sockets_[sensor], batch.messages.data(), room, 0, NULL);
+        stats_.receive_calls++;
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                stats_.receive_errors++;
+                std::cerr << "Error receiving from port " << ports_[sensor] << ": " << strerror(errno) << std::endl;
+            }
+            continue;
+        }
+
+        batch.count = received;
+        for (int i = 0; i < received; ++i) {
+            packets[count].sensor = sensor;
+            packets[count].data = batch.packet(i);
+            packets[count].size = batch.packetSize(i);
+            count++;
+        }
+        sensor_packets_[sensor] += received;
+    }
+    stats_.packets += count;
+    return count;
+}
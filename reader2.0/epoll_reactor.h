@@ -0,0 +1,67 @@
+#ifndef EPOLL_REACTOR_H
+#define EPOLL_REACTOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/epoll.h>
+#include "udp_receiver.h"
+
+// One datagram from waitPackets(); data points into the sensor's batch slot and stays
+// valid until the next waitPackets() call
+struct ReactorPacket {
+    int sensor;             // Index into the port list given to the reactor
+    const uint8_t* data;
+    size_t size;
+};
+
+struct ReactorStats {
+    uint64_t wakeups;           // epoll_wait() calls that returned ready sockets
+    uint64_t receive_calls;     // recvmmsg() calls
+    uint64_t packets;
+    uint64_t receive_errors;    // recvmmsg() failures other than EAGAIN
+
+    ReactorStats() : wakeups(0), receive_calls(0), packets(0), receive_errors(0) {}
+};
+
+// Receives MSOP packets from several sensors, one UDP port each, in a single thread.
+// Every socket is non-blocking and registered with one epoll instance; each wakeup
+// drains one recvmmsg() batch from every ready socket, so a busy sensor cannot starve
+// the others and the thread never blocks on a single socket. Packets are tagged with
+// the sensor index so the caller can keep separate parser/assembler state per sensor.
+class LidarEpollReactor {
+public:
+    // batch_size: packets taken from one socket per wakeup (1 to MAX_BATCH_SIZE)
+    explicit LidarEpollReactor(const std::vector<int>& ports, int batch_size = 32);
+    ~LidarEpollReactor();
+
+    bool initialize();
+
+    int getSensorCount() const { return static_cast<int>(ports_.size()); }
+    int getPort(int sensor) const { return ports_[sensor]; }
+
+    // Upper bound on the packets one waitPackets() call can return
+    int getMaxPackets() const { return getSensorCount() * batch_size_; }
+
+    // Wait up to timeout_ms (-1 = forever) for any socket to become readable, then
+    // receive from every ready one. Returns the number of packets stored in packets
+    // (at most max_packets), 0 on timeout or a signal, -1 on error.
+    int waitPackets(ReactorPacket* packets, int max_packets, int timeout_ms = -1);
+
+    const ReactorStats& getStats() const { return stats_; }
+    uint64_t getSensorPackets(int sensor) const { return sensor_packets_[sensor]; }
+
+private:
+    int openSocket(int port);
+
+    std::vector<int> ports_;
+    int batch_size_;
+    int epoll_fd_;
+    std::vector<int> sockets_;                  // One per port
+    std::vector<PacketBatch> batches_;          // One per port, wired once
+    std::vector<struct epoll_event> events_;    // epoll_wait() output, one per port
+    std::vector<uint64_t> sensor_packets_;
+    ReactorStats stats_;
+};
+
+#endif // EPOLL_REACTOR_H
@@ -1,4 +1,7 @@
 #include "msop_parser.h"
+#include "point_cloud_soa.h"
+#include "angle_bin_filter.h"
+#include "msop_packet_view.h"
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -9,8 +12,9 @@
 #include <fstream>
 #include <iomanip>
 #include <cmath>
-#include <map>
 #include <algorithm>
+#include <csignal>
+#include <cstdlib>
 
 class LidarDataCollector {
 public:
@@ -59,6 +63,9 @@ public:
                                          (struct sockaddr*)&client_addr, &client_len);
         
         if (bytes_received < 0) {
+            if (errno == EINTR) {
+                return false;
+            }
             std::cerr << "Error receiving packet: " << strerror(errno) << std::endl;
             return false;
         }
@@ -67,7 +74,7 @@ public:
         return true;
     }
     
-    void savePointsToCSV(const std::vector<LidarPoint>& all_points, const std::string& filename) {
+    void savePointsToCSV(const PointCloudSoA& all_points, const std::string& filename, bool verbose = true) {
         std::ofstream file(filename);
         if (!file.is_open()) {
             std::cerr << "Failed to open file: " << filename << std::endl;
@@ -77,24 +84,38 @@ public:
         // Write CSV header
         file << "x,y,distance,azimuth,rssi,return_type\n";
         
-        // Convert polar to cartesian and save
-        for (const auto& point : all_points) {
-            if (point.is_valid && point.distance > 0.1f && point.distance < 15.0f) {
-                // Convert polar to cartesian coordinates
-                float azimuth_rad = point.azimuth * M_PI / 180.0f;
-                float x = point.distance * cos(azimuth_rad);
-                float y = point.distance * sin(azimuth_rad);
-                
+        // Convert polar to cartesian one column at a time
+        const size_t count = all_points.size();
+        const float* azimuth = all_points.azimuth();
+        const float* distance = all_points.range();
+        const uint8_t* rssi = all_points.rssi();
+        const uint8_t* flags = all_points.flags();
+        
+        std::vector<uint8_t> keep(count);
+        std::vector<float> x(count), y(count);
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] = (flags[i] & POINT_FLAG_VALID) & (distance[i] > 0.1f) & (distance[i] < 15.0f);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            float azimuth_rad = azimuth[i] * M_PI / 180.0f;
+            x[i] = distance[i] * cos(azimuth_rad);
+            y[i] = distance[i] * sin(azimuth_rad);
+        }
+        
+        for (size_t i = 0; i < count; ++i) {
+            if (keep[i]) {
                 file << std::fixed << std::setprecision(3) 
-                     << x << "," << y << "," 
-                     << point.distance << "," << point.azimuth << ","
-                     << (int)point.rssi << ","
-                     << (point.is_strongest ? "strongest" : "last") << "\n";
+                     << x[i] << "," << y[i] << "," 
+                     << distance[i] << "," << azimuth[i] << ","
+                     << (int)rssi[i] << ","
+                     << ((flags[i] & POINT_FLAG_STRONGEST) ? "strongest" : "last") << "\n";
             }
         }
         
         file.close();
-        std::cout << "Saved " << all_points.size() << " points to " << filename << std::endl;
+        if (verbose) {
+            std::cout << "Saved " << all_points.size() << " points to " << filename << std::endl;
+        }
     }
     
     void generatePythonVisualizer(const std::string& csv_filename) {
@@ -177,7 +198,115 @@ private:
     int socket_fd_;
 };
 
-int main() {
+static volatile sig_atomic_t g_stop_requested = 0;
+
+static void requestStop(int) {
+    g_stop_requested = 1;
+}
+
+// Same validity checks as the one-shot collection, applied in place
+static void keepPlausiblePoints(PointCloudSoA& points, std::vector<uint8_t>& keep) {
+    // Branch-free pass over the columns so the compiler can vectorize it
+    const size_t count = points.size();
+    const float* range = points.range();
+    const uint8_t* rssi = points.rssi();
+    const uint8_t* flags = points.flags();
+    keep.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        keep[i] = (flags[i] & POINT_FLAG_VALID) &
+                  (range[i] > 0.1f) & (range[i] < 14.0f) &  // Back to 14m range
+                  (rssi[i] > 15);  // Slightly higher RSSI threshold due to LV3 hardware filtering
+    }
+    points.compact(keep.data());
+}
+
+// Denoise every revolution against the last N until Ctrl+C, rewriting the CSV each time.
+// Memory is fixed by N at startup; the work per revolution does not depend on N.
+static int runContinuous(LidarDataCollector& collector, MSOPParser& parser, int revolutions) {
+    SlidingWindowDenoiser denoiser(revolutions);
+    std::cout << "Continuous mode: denoising each revolution against the last " << denoiser.getWindowSize()
+              << " (Ctrl+C to stop)" << std::endl;
+    // No SA_RESTART, so Ctrl+C also interrupts a recvfrom() waiting on a silent sensor
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    
+    PointCloudSoA packet_points(12 * 16 * 2);
+    PointCloudSoA scan(SlidingWindowDenoiser::BIN_COUNT);
+    std::vector<uint8_t> keep(packet_points.capacity());
+    const std::string csv_filename = "lidar_scan.csv";
+    collector.generatePythonVisualizer(csv_filename);
+    
+    uint8_t buffer[2048];
+    int last_azimuth = -1;
+    bool have_samples = false;
+    uint64_t scans = 0;
+    
+    while (!g_stop_requested) {
+        size_t received_size;
+        if (!collector.receivePacket(buffer, sizeof(buffer), received_size)) {
+            continue;
+        }
+        if (received_size != 1206 && received_size != 1248) {
+            continue;
+        }
+        const uint8_t* data = (received_size == 1248) ? buffer + 42 : buffer;
+        size_t data_size = (received_size == 1248) ? received_size - 42 : received_size;
+        MSOPPacketView packet(data);
+        
+        // A revolution ends with the marker packet, or when the azimuth wraps if the
+        // marker was lost or the field of view leaves no room for one
+        int azimuth = packet.blockFlag(0) == MSOPPacketView::VALID_BLOCK_FLAG ? packet.blockAzimuth(0) : -1;
+        if (azimuth >= 0 && last_azimuth >= 0 && last_azimuth - azimuth > 18000 && have_samples) {
+            AngleBinFilterStats stats;
+            scan.clear();
+            denoiser.finishRevolution(scan, stats);
+            have_samples = false;
+            scans++;
+            collector.savePointsToCSV(scan, csv_filename, false);
+            std::cout << "\rScan " << scans << ": " << scan.size() << " points from "
+                      << stats.total_samples << " samples, " << stats.filtered_bins << " bins filtered ("
+                      << denoiser.getRevolutionsHeld() << "/" << denoiser.getWindowSize()
+                      << " revolutions)    " << std::flush;
+        }
+        if (azimuth >= 0) {
+            last_azimuth = azimuth;
+        }
+        
+        packet_points.clear();
+        if (parser.parsePacket(data, data_size, packet_points)) {
+            keepPlausiblePoints(packet_points, keep);
+            denoiser.addPoints(packet_points);
+            have_samples |= !packet_points.empty();
+        }
+        if (packet.isLastPacket()) {
+            last_azimuth = 36000;   // Whatever comes next starts a revolution
+        }
+    }
+    
+    std::cout << "\nStopped after " << scans << " scans; " << csv_filename << " holds the last one" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int continuous_revolutions = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--continuous") == 0 && i + 1 < argc) {
+            continuous_revolutions = atoi(argv[++i]);
+            if (continuous_revolutions < 1 || continuous_revolutions > SlidingWindowDenoiser::MAX_WINDOW) {
+                std::cerr << "--continuous needs a window of 1 to " << SlidingWindowDenoiser::MAX_WINDOW
+                          << " revolutions" << std::endl;
+                return -1;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--continuous N]" << std::endl;
+            std::cerr << "  --continuous N  Denoise every revolution against the last N (at most "
+                      << SlidingWindowDenoiser::MAX_WINDOW << ") until Ctrl+C" << std::endl;
+            return -1;
+        }
+    }
+    
     LidarDataCollector collector(2368);
     MSOPParser parser;
     
@@ -185,6 +314,10 @@ int main() {
         return -1;
     }
     
+    if (continuous_revolutions > 0) {
+        return runContinuous(collector, parser, continuous_revolutions);
+    }
+    
     std::cout << "Collecting lidar data for visualization..." << std::endl;
     std::cout << "LakiBeam1(L): 10Hz frequency, 0.5° resolution" << std::endl;
     std::cout << "Will collect multiple samples per angle bin for median filtering" << std::endl;
@@ -193,20 +326,16 @@ int main() {
     
     uint8_t buffer[2048];
     
-    // Structure to store multiple samples per angle
-    struct AngleSamples {
-        std::vector<LidarPoint> samples;
-        LidarPoint best_point;
-        bool has_valid_point = false;
-    };
-    
-    // Use a map to store multiple samples per 0.5° angle bin
-    std::map<int, AngleSamples> angle_map;  // Key: angle * 2 (for 0.5° bins)
-    
     int packet_count = 0;
     const int max_packets = 150;  // More packets for better statistical sampling
     const int packets_per_round = 50;  // Collect in rounds for dynamic environments
     
+    // Recent samples of every 0.5° angle bin, filtered as they arrive
+    StreamingAngleFilter filter;
+    
+    PointCloudSoA packet_points(12 * 16 * 2);
+    std::vector<uint8_t> keep(packet_points.capacity());
+    
     while (packet_count < max_packets) {
         size_t received_size;
         if (!collector.receivePacket(buffer, sizeof(buffer), received_size)) {
@@ -218,144 +347,53 @@ int main() {
         int packet_in_round = ((packet_count - 1) % packets_per_round) + 1;
         
         std::cout << "\rRound " << current_round << "/3 - Packet " << packet_in_round 
-                  << "/" << packets_per_round << " (Angles: " << angle_map.size() << ")" << std::flush;
+                  << "/" << packets_per_round << " (Angles: " << filter.getOccupiedBins() << ")" << std::flush;
         
         if (received_size == 1206 || received_size == 1248) {
-            std::vector<LidarPoint> points;
             const uint8_t* data = (received_size == 1248) ? buffer + 42 : buffer;
             size_t data_size = (received_size == 1248) ? received_size - 42 : received_size;
             
-            if (parser.parsePacket(data, data_size, points)) {
-                // Process each point and collect multiple samples per angle bin
-                for (const auto& point : points) {
-                    // More lenient initial filtering - just basic validity checks
-                    // Note: Lidar is set to LV3 filter level, so some weak signals still pass through
-                    if (point.is_valid && 
-                        point.distance > 0.1f && point.distance < 14.0f &&  // Back to 14m range
-                        point.rssi > 15) {  // Slightly higher RSSI threshold due to LV3 hardware filtering
-                        
-                        // Create angle bin key (0.5° resolution)
-                        int angle_bin = static_cast<int>(point.azimuth * 2.0f);
-                        
-                        // Store multiple samples for this angle
-                        angle_map[angle_bin].samples.push_back(point);
-                    }
-                }
+            packet_points.clear();
+            if (parser.parsePacket(data, data_size, packet_points)) {
+                // More lenient initial filtering - just basic validity checks
+                // Note: Lidar is set to LV3 filter level, so some weak signals still pass through
+                keepPlausiblePoints(packet_points, keep);
+                
+                // Store multiple samples per angle bin
+                filter.addPoints(packet_points);
             }
         }
     }
     
-    std::cout << "\nCollected " << angle_map.size() << " unique angle measurements" << std::endl;
+    const int occupied_bins = filter.getOccupiedBins();
+    std::cout << "\nCollected " << occupied_bins << " unique angle measurements" << std::endl;
     std::cout << "Processing samples with median-based filtering..." << std::endl;
     
-    if (!angle_map.empty()) {
-        // Convert map to vector, selecting best point from samples
-        std::vector<LidarPoint> unique_points;
-        unique_points.reserve(angle_map.size());
-        
-        int filtered_bins = 0;
-        int total_samples = 0;
-        
-        for (const auto& pair : angle_map) {
-            const auto& samples = pair.second.samples;
-            total_samples += samples.size();
-            
-            if (samples.size() >= 3) {
-                // Multiple samples: use median-based filtering for robustness
-                std::vector<float> distances, rssi_values;
-                for (const auto& sample : samples) {
-                    distances.push_back(sample.distance);
-                    rssi_values.push_back(sample.rssi);
-                }
-                
-                // Sort for median calculation
-                std::sort(distances.begin(), distances.end());
-                std::sort(rssi_values.begin(), rssi_values.end());
-                
-                // Calculate medians
-                float median_distance = distances[distances.size() / 2];
-                float median_rssi = rssi_values[rssi_values.size() / 2];
-                
-                // Filter out obvious outliers (beyond 50% of median)
-                std::vector<LidarPoint> filtered_samples;
-                for (const auto& sample : samples) {
-                    float distance_deviation = std::abs(sample.distance - median_distance) / median_distance;
-                    if (distance_deviation <= 0.50f && sample.rssi >= median_rssi * 0.7f) {
-                        filtered_samples.push_back(sample);
-                    }
-                }
-                
-                if (!filtered_samples.empty() && median_rssi > 20) {  // Higher threshold for LV3 filtered data
-                    // Select the sample closest to median distance with good RSSI
-                    auto best_sample = *std::min_element(filtered_samples.begin(), filtered_samples.end(),
-                        [median_distance](const LidarPoint& a, const LidarPoint& b) {
-                            float diff_a = std::abs(a.distance - median_distance);
-                            float diff_b = std::abs(b.distance - median_distance);
-                            if (std::abs(diff_a - diff_b) < 0.1f) {
-                                return a.rssi > b.rssi;  // If distances similar, prefer higher RSSI
-                            }
-                            return diff_a < diff_b;
-                        });
-                    
-                    unique_points.push_back(best_sample);
-                } else {
-                    filtered_bins++;
-                }
-                
-            } else if (samples.size() == 2) {
-                // Two samples: check if they're reasonably consistent
-                float distance_diff = std::abs(samples[0].distance - samples[1].distance);
-                float avg_distance = (samples[0].distance + samples[1].distance) / 2.0f;
-                float relative_diff = distance_diff / avg_distance;
-                
-                if (relative_diff <= 0.30f && 
-                    std::min(samples[0].rssi, samples[1].rssi) > 20) {  // Higher threshold for LV3 data
-                    // Use the sample with higher RSSI
-                    auto best_sample = (samples[0].rssi > samples[1].rssi) ? samples[0] : samples[1];
-                    unique_points.push_back(best_sample);
-                } else {
-                    filtered_bins++;
-                }
-                
-            } else if (samples.size() == 1) {
-                // Single sample: be more accepting but require decent RSSI
-                // With LV3 hardware filtering, we can be more confident in single samples
-                if (samples[0].rssi > 25) {  // Higher threshold for single samples with LV3
-                    unique_points.push_back(samples[0]);
-                } else {
-                    filtered_bins++;
-                }
-            }
-        }
-        
-        std::cout << "Total samples collected: " << total_samples << std::endl;
-        std::cout << "Filtered out " << filtered_bins << " unreliable angle bins" << std::endl;
+    if (occupied_bins > 0) {
+        // Select the best sample of each bin
+        PointCloudSoA unique_points(occupied_bins);
+        AngleBinFilterStats filter_stats;
+        filter.writeFiltered(unique_points, filter_stats);
+        
+        std::cout << "Total samples collected: " << filter.getSampleCount() << " ("
+                  << filter_stats.total_samples << " in the filter window)" << std::endl;
+        std::cout << "Filtered out " << filter_stats.filtered_bins << " unreliable angle bins" << std::endl;
         std::cout << "Keeping " << unique_points.size() << " reliable measurements" << std::endl;
         
         // Show some statistics about the filtering
-        int multi_sample_bins = 0, two_sample_bins = 0, single_sample_bins = 0;
-        for (const auto& pair : angle_map) {
-            if (pair.second.samples.size() >= 3) multi_sample_bins++;
-            else if (pair.second.samples.size() == 2) two_sample_bins++;
-            else single_sample_bins++;
-        }
-        
-        std::cout << "Sample distribution: " << multi_sample_bins << " multi-sample, " 
-                  << two_sample_bins << " two-sample, " << single_sample_bins << " single-sample bins" << std::endl;
+        std::cout << "Sample distribution: " << filter_stats.multi_sample_bins << " multi-sample, " 
+                  << filter_stats.two_sample_bins << " two-sample, " << filter_stats.single_sample_bins
+                  << " single-sample bins" << std::endl;
         
-        // Sort by azimuth for cleaner output
-        std::sort(unique_points.begin(), unique_points.end(), 
-                  [](const LidarPoint& a, const LidarPoint& b) {
-                      return a.azimuth < b.azimuth;
-                  });
+        // Bins were visited in increasing order, so unique_points is already sorted by azimuth
         
         std::string csv_filename = "lidar_scan.csv";
         collector.savePointsToCSV(unique_points, csv_filename);
         collector.generatePythonVisualizer(csv_filename);
         
         // Print angle coverage statistics
-        float min_angle = unique_points.front().azimuth;
-        float max_angle = unique_points.back().azimuth;
+        float min_angle = unique_points.empty() ? 0.0f : unique_points.azimuth()[0];
+        float max_angle = unique_points.empty() ? 0.0f : unique_points.azimuth()[unique_points.size() - 1];
         float angle_span = max_angle - min_angle;
         
         std::cout << "\nData collection complete!" << std::endl;
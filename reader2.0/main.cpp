@@ -1,75 +1,38 @@
 #include "msop_parser.h"
+#include "msop_packet_view.h"
+#include "udp_receiver.h"
+#include "packet_ring_receiver.h"
+#include "spsc_ring.h"
+#include "pcap_replay.h"
+#include "scan_log.h"
+#include "point_cloud_soa.h"
+#include "latency_histogram.h"
+#include "continuity_tracker.h"
+#include "epoll_reactor.h"
+#include "realtime.h"
+#ifdef HAVE_IO_URING
+#include "uring_receiver.h"
+#include "pcap_format.h"
+#include <sys/uio.h>
+#endif
 #include <iostream>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
 #include <cstring>
+#include <cstdlib>
 #include <vector>
 #include <iomanip>
-
-class LidarUDPReceiver {
-public:
-    LidarUDPReceiver(int port = 2368) : port_(port), socket_fd_(-1) {
-    }
-    
-    ~LidarUDPReceiver() {
-        if (socket_fd_ >= 0) {
-            close(socket_fd_);
-        }
-    }
-    
-    bool initialize() {
-        // Create UDP socket
-        socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
-        if (socket_fd_ < 0) {
-            std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
-            return false;
-        }
-        
-        // Set socket options to reuse address
-        int opt = 1;
-        if (setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-            std::cerr << "Error setting socket options: " << strerror(errno) << std::endl;
-            return false;
-        }
-        
-        // Bind socket to port
-        struct sockaddr_in server_addr;
-        memset(&server_addr, 0, sizeof(server_addr));
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_addr.s_addr = INADDR_ANY;
-        server_addr.sin_port = htons(port_);
-        
-        if (bind(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            std::cerr << "Error binding socket to port " << port_ << ": " << strerror(errno) << std::endl;
-            return false;
-        }
-        
-        std::cout << "UDP receiver initialized on port " << port_ << std::endl;
-        return true;
-    }
-    
-    bool receivePacket(uint8_t* buffer, size_t buffer_size, size_t& received_size) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        ssize_t bytes_received = recvfrom(socket_fd_, buffer, buffer_size, 0,
-                                         (struct sockaddr*)&client_addr, &client_len);
-        
-        if (bytes_received < 0) {
-            std::cerr << "Error receiving packet: " << strerror(errno) << std::endl;
-            return false;
-        }
-        
-        received_size = bytes_received;
-        return true;
-    }
-    
-private:
-    int port_;
-    int socket_fd_;
-};
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <pthread.h>
 
 void printPacketInfo(const std::vector<LidarPoint>& points, uint32_t timestamp, uint16_t factory_info) {
     std::cout << "Timestamp: " << timestamp << " μs, Factory: 0x" 
@@ -109,78 +72,1114 @@ void printPacketInfo(const std::vector<LidarPoint>& points, uint32_t timestamp,
     }
 }
 
-int main() {
-    LidarUDPReceiver receiver(2368);  // Default MSOP port
-    MSOPParser parser;
+
+void processPacket(MSOPParser& parser, const uint8_t* buffer, size_t received_size,
+                   std::vector<LidarPoint>& points, int packet_count) {
+    std::cout << "\n--- Packet " << packet_count << " ---" << std::endl;
+    std::cout << "Received " << received_size << " bytes" << std::endl;
     
-    if (!receiver.initialize()) {
-        return -1;
+    // Check if this is the expected MSOP packet size
+    if (received_size == 1206) {
+        std::cout << "MSOP packet detected (1206 bytes - UDP header stripped)" << std::endl;
+        
+        if (parser.parsePacket(buffer, received_size, points)) {
+            printPacketInfo(points, parser.getLastTimestamp(), parser.getLastFactoryInfo());
+            
+            // Show range statistics for first few packets
+            if (packet_count <= 5 && !points.empty()) {
+                float min_dist = 999.0f, max_dist = 0.0f;
+                float min_azim = 999.0f, max_azim = 0.0f;
+                
+                for (const auto& point : points) {
+                    min_dist = std::min(min_dist, point.distance);
+                    max_dist = std::max(max_dist, point.distance);
+                    min_azim = std::min(min_azim, point.azimuth);
+                    max_azim = std::max(max_azim, point.azimuth);
+                }
+                
+                std::cout << "  Range stats: Distance " << std::fixed << std::setprecision(2) 
+                          << min_dist << "m to " << max_dist << "m, "
+                          << "Azimuth " << min_azim << "° to " << max_azim << "°" << std::endl;
+            }
+        } else {
+            std::cout << "Failed to parse MSOP packet" << std::endl;
+        }
+    } else if (received_size == 1248) {
+        std::cout << "MSOP packet with UDP header detected (1248 bytes)" << std::endl;
+        
+        // Skip the first 42 bytes (UDP header) and parse the rest
+        if (parser.parsePacket(buffer + 42, received_size - 42, points)) {
+            printPacketInfo(points, parser.getLastTimestamp(), parser.getLastFactoryInfo());
+        } else {
+            std::cout << "Failed to parse MSOP packet" << std::endl;
+        }
+    } else {
+        std::cout << "Unexpected packet size: " << received_size << " bytes" << std::endl;
+        
+        // Print first few bytes in hex for debugging
+        std::cout << "First 16 bytes: ";
+        for (size_t i = 0; i < std::min(received_size, size_t(16)); ++i) {
+            std::cout << std::hex << std::setw(2) << std::setfill('0') 
+                      << (int)buffer[i] << " ";
+        }
+        std::cout << std::dec << std::endl;
+    }
+}
+
+// Packets per second and CPU time per packet, for comparing receive paths
+class ThroughputMeter {
+public:
+    ThroughputMeter() : packets_(0), last_packets_(0) {
+        last_wall_ = wallMicros();
+        last_cpu_ = cpuMicros();
     }
     
-    std::cout << "Listening for MSOP packets on port 2368..." << std::endl;
+    // Returns true when it printed a report
+    bool addPacket() {
+        // Check the clock every 256 packets and report at most once per second
+        if ((++packets_ & 0xFF) != 0) {
+            return false;
+        }
+        double now = wallMicros();
+        if (now - last_wall_ < 1e6) {
+            return false;
+        }
+        double cpu = cpuMicros();
+        uint64_t window = packets_ - last_packets_;
+        std::cout << std::fixed << std::setprecision(0)
+                  << window * 1e6 / (now - last_wall_) << " packets/s, "
+                  << std::setprecision(2) << (cpu - last_cpu_) / window << " us CPU/packet" << std::endl;
+        last_wall_ = now;
+        last_cpu_ = cpu;
+        last_packets_ = packets_;
+        return true;
+    }
+    
+private:
+    static double wallMicros() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+    }
+    
+    static double cpuMicros() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+               usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+    
+    uint64_t packets_;
+    uint64_t last_packets_;
+    double last_wall_;
+    double last_cpu_;
+};
+
+struct ReaderOptions {
+    int batch_size;             // 0 = one recvfrom() per packet
+    std::string ring_interface; // Non-empty = TPACKET_V3 ring capture
+    bool use_uring;
+    bool threaded;              // Separate receive and parse threads
+    bool quiet;                 // Parse only, print throughput instead of packets
+    std::string record_file;    // io_uring mode: record MSOP packets here as pcap
+    std::string replay_file;    // Non-empty = read packets from this pcap instead of the network
+    double speed;               // Replay pacing: 1.0 = capture timing, 0 = as fast as possible
+    std::string log_file;       // Non-empty = also write assembled revolutions to this scan log
+    double latency_interval;    // > 0 = collect stage latency histograms, print every N seconds
+    std::vector<int> ports;     // Non-empty = one sensor per port, multiplexed with epoll
+    RealtimeOptions realtime;   // Socket loop and --threaded only
+    
+    ReaderOptions() : batch_size(0), use_uring(false), threaded(false), quiet(false), speed(1.0),
+                      latency_interval(0.0) {}
+};
+
+// Set by SIGUSR1: print the latency histograms at the next packet
+static volatile sig_atomic_t g_latency_dump_requested = 0;
+
+void requestLatencyDump(int) {
+    g_latency_dump_requested = 1;
+}
+
+// Set by SIGINT/SIGTERM: the live loops finish the packet at hand and return, so the
+// scan log gets its index and the totals are printed. Read by the receive thread as
+// well, so it is a (lock-free) atomic rather than a sig_atomic_t.
+static std::atomic<bool> g_stop_requested(false);
+
+void requestStop(int) {
+    g_stop_requested = true;
+}
+
+// No SA_RESTART, so a signal also interrupts a receive waiting on a silent sensor
+void installStopHandlers() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+// Per-packet work shared by every receive path. In multi-sensor mode each sensor gets
+// its own handler (parser, continuity tracker, revolution assembly), named by label.
+// Labelled handlers leave throughput reports to the caller: CPU time is per process.
+// They also leave SIGUSR1 to the caller, which has to dump every sensor before it
+// clears the request.
+class PacketHandler {
+public:
+    explicit PacketHandler(const ReaderOptions& options, const std::string& label = "")
+        : label_(label), quiet_(options.quiet), packet_count_(0),
+          latency_interval_ns_(static_cast<uint64_t>(options.latency_interval * 1e9)), next_latency_dump_(0),
+          logging_(!options.log_file.empty()), log_(options.log_file),
+          scan_packets_(0), scan_timestamp_(0), last_azimuth_(0), probe_(NULL) {
+        latency_.setEnabled(latency_interval_ns_ > 0);
+    }
+    
+    bool initialize() {
+        if (latency_.isEnabled()) {
+            next_latency_dump_ = PipelineLatency::now() + latency_interval_ns_;
+        }
+        if (!logging_) {
+            return true;
+        }
+        scan_.reserve(LOG_SCAN_POINTS);
+        return log_.initialize();
+    }
+    
+    void handle(const uint8_t* data, size_t size) {
+        ++packet_count_;
+        if (latency_.isEnabled()) {
+            checkLatencyDump();
+        }
+        ContinuityTracker::Verdict verdict = trackContinuity(data, size);
+        // Repeated and late packets would put blocks into a revolution twice or out of order
+        if (logging_ && verdict != ContinuityTracker::DUPLICATE && verdict != ContinuityTracker::OUT_OF_ORDER) {
+            uint64_t assembly_start = latency_.start();
+            logPacket(data, size);
+            latency_.stop(STAGE_ASSEMBLY, assembly_start);
+        }
+        if (!quiet_) {
+            // Verbose mode: parse time would be dwarfed by console output, so it is not recorded
+            if (!label_.empty()) {
+                std::cout << "\n[" << label_ << "]";
+            }
+            processPacket(parser_, data, size, points_, packet_count_);
+            printContinuityEvent(verdict);
+            if (probe_ != NULL && packet_count_ % 1000 == 0) {
+                probe_->print(std::cout);
+            }
+            return;
+        }
+        if (size == 1248) {
+            data += 42;
+            size -= 42;
+        }
+        uint64_t parse_start = latency_.start();
+        parser_.parsePacket(data, size, quiet_points_, MSOPParser::MAX_POINTS_PER_PACKET);
+        latency_.stop(STAGE_PARSE, parse_start);
+        if (label_.empty() && meter_.addPacket()) {
+            printContinuity();
+            if (probe_ != NULL) {
+                probe_->print(std::cout);
+            }
+        }
+    }
+    
+    // Real-time mode: touch the packet and revolution buffers once, so the first
+    // packets do not page-fault
+    void prefault() {
+        points_.reserve(MSOPParser::MAX_POINTS_PER_PACKET);
+        prefaultMemory(points_.data(), points_.capacity() * sizeof(LidarPoint));
+        prefaultMemory(quiet_points_, sizeof(quiet_points_));
+        if (logging_) {
+            prefaultMemory(scan_.azimuth(), scan_.capacity() * sizeof(float));
+            prefaultMemory(scan_.range(), scan_.capacity() * sizeof(float));
+            prefaultMemory(scan_.rssi(), scan_.capacity());
+            prefaultMemory(scan_.flags(), scan_.capacity());
+        }
+    }
+    
+    // Printed with the throughput (quiet) or every 1000 packets (verbose)
+    void setSchedulingProbe(const SchedulingLatencyProbe* probe) { probe_ = probe; }
+    
+    int packetCount() const { return packet_count_; }
+    
+    const ContinuityTracker& continuity() const { return continuity_; }
+    
+    void printContinuity() const {
+        const ContinuityStats& stats = continuity_.getStats();
+        std::cout << "  Continuity";
+        if (!label_.empty()) {
+            std::cout << " (" << label_ << ")";
+        }
+        std::cout << ": " << stats.lost << " lost in " << stats.gaps << " gaps, "
+                  << stats.duplicates << " duplicates, " << stats.out_of_order << " out of order, "
+                  << stats.malformed << " malformed";
+        if (stats.revolutions > 0) {
+            const RevolutionCoverage& last = continuity_.getLastRevolution();
+            std::cout << "; last revolution " << std::fixed << std::setprecision(1)
+                      << last.coverage_percent << "% (" << last.received << "/" << last.expected << " packets)";
+        }
+        std::cout << std::endl;
+    }
+    
+    // Receive paths record socket and handoff stages here too
+    PipelineLatency& latency() { return latency_; }
+    
+    void printLatency() {
+        if (!latency_.isEnabled()) {
+            return;
+        }
+        std::cout << "\n=== Stage latency after " << packet_count_ << " packets";
+        if (!label_.empty()) {
+            std::cout << " from " << label_;
+        }
+        std::cout << " ===" << std::endl;
+        latency_.print(std::cout);
+        std::cout.flush();
+    }
+    
+    // Write the revolution in progress and the log index
+    bool finishLog() {
+        if (!logging_) {
+            return true;
+        }
+        flushScan();
+        std::cout << "Wrote " << log_.getScanCount() << " revolutions to the scan log";
+        if (!label_.empty()) {
+            std::cout << " of " << label_;
+        }
+        std::cout << std::endl;
+        return log_.close();
+    }
+    
+private:
+    // A full revolution at 10 Hz is about 200 packets; reserve for both returns
+    static const size_t LOG_SCAN_POINTS = 256 * MSOPParser::MAX_POINTS_PER_PACKET;
+    
+    ContinuityTracker::Verdict trackContinuity(const uint8_t* data, size_t size) {
+        if (size == 1248) {
+            data += 42;
+            size -= 42;
+        }
+        return continuity_.processPacket(data, size);
+    }
+    
+    void printContinuityEvent(ContinuityTracker::Verdict verdict) const {
+        if (verdict == ContinuityTracker::AFTER_GAP) {
+            std::cout << "  Packets missing before this one (" << continuity_.getStats().lost
+                      << " lost so far)" << std::endl;
+        } else if (verdict == ContinuityTracker::DUPLICATE) {
+            std::cout << "  Duplicate packet" << std::endl;
+        } else if (verdict == ContinuityTracker::OUT_OF_ORDER) {
+            std::cout << "  Out-of-order packet" << std::endl;
+        }
+        if (continuity_.revolutionClosed()) {
+            const RevolutionCoverage& last = continuity_.getLastRevolution();
+            std::cout << "  Revolution " << continuity_.getStats().revolutions << " complete: "
+                      << std::fixed << std::setprecision(1) << last.coverage_percent << "% coverage ("
+                      << last.received << "/" << last.expected << " packets, "
+                      << last.missing << " missing)" << std::endl;
+        }
+    }
+    
+    // Histograms are cumulative: a receive thread may be recording into them, so they are never reset
+    void checkLatencyDump() {
+        if (label_.empty() && g_latency_dump_requested) {
+            g_latency_dump_requested = 0;
+            printLatency();
+        }
+        if ((packet_count_ & 0xFF) != 0) {
+            return;
+        }
+        uint64_t now = PipelineLatency::now();
+        if (now >= next_latency_dump_) {
+            next_latency_dump_ = now + latency_interval_ns_;
+            printLatency();
+        }
+    }
+    
+    // Accumulate packets into revolutions for the scan log. A revolution ends at the
+    // sensor's last-packet marker, or when the first block's azimuth jumps backwards
+    // (a lost marker packet).
+    void logPacket(const uint8_t* data, size_t size) {
+        if (size == 1248) {
+            data += 42;
+            size -= 42;
+        }
+        if (!MSOPPacketView::isPacketSize(size)) {
+            return;
+        }
+        MSOPPacketView packet(data);
+        uint16_t azimuth = packet.blockAzimuth(0);
+        if (scan_packets_ > 0 && azimuth + 18000 < last_azimuth_) {
+            flushScan();
+        }
+        last_azimuth_ = azimuth;
+        
+        if (!log_parser_.parsePacket(data, size, scan_)) {
+            return;
+        }
+        if (scan_packets_++ == 0) {
+            scan_timestamp_ = log_parser_.getLastTimestamp();
+        }
+        if (packet.isLastPacket()) {
+            flushScan();
+        }
+    }
+    
+    void flushScan() {
+        if (scan_packets_ > 0) {
+            log_.writeScan(scan_, scan_timestamp_);
+        }
+        scan_.clear();
+        scan_packets_ = 0;
+    }
+    
+    std::string label_;
+    bool quiet_;
+    int packet_count_;
+    MSOPParser parser_;
+    std::vector<LidarPoint> points_;                            // Verbose output
+    LidarPoint quiet_points_[MSOPParser::MAX_POINTS_PER_PACKET]; // Quiet mode, never reallocated
+    ThroughputMeter meter_;
+    
+    ContinuityTracker continuity_;
+    
+    PipelineLatency latency_;
+    uint64_t latency_interval_ns_;
+    uint64_t next_latency_dump_;    // CLOCK_MONOTONIC ns
+    
+    bool logging_;
+    ScanLogWriter log_;
+    MSOPParser log_parser_;
+    PointCloudSoA scan_;            // Revolution being assembled for the log
+    int scan_packets_;
+    uint32_t scan_timestamp_;       // MSOPTail::timestamp of its first packet
+    uint16_t last_azimuth_;
+    
+    const SchedulingLatencyProbe* probe_;
+};
+
+void printBatchStats(const BatchStats& stats) {
+    std::cout << "\n=== recvmmsg: " << stats.packets << " packets in " << stats.syscalls
+              << " syscalls (" << std::fixed << std::setprecision(2)
+              << stats.packetsPerSyscall() << " packets/syscall) ===" << std::endl;
+    std::cout << "  Packets per call:";
+    for (int n = 1; n <= MAX_BATCH_SIZE; ++n) {
+        if (stats.histogram[n] > 0) {
+            std::cout << " " << n << "x" << stats.histogram[n];
+        }
+    }
+    std::cout << std::endl;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--batch N | --ring IFACE | --uring [--record FILE] | --threaded | --replay FILE [--speed X] | --ports LIST]"
+              << " [--rt PRIORITY] [--cpu RECV[,PARSE]] [--probe-cpu N] [--log FILE] [--latency SECONDS] [--quiet]" << std::endl;
+    std::cerr << "  --batch N      Receive up to N packets per recvmmsg() call (1-"
+              << MAX_BATCH_SIZE << ")" << std::endl;
+    std::cerr << "  --ring IFACE   Capture from a memory-mapped TPACKET_V3 ring on IFACE" << std::endl;
+    std::cerr << "  --uring        Receive MSOP (2368) and DIFOP (2369) through io_uring" << std::endl;
+    std::cerr << "  --record FILE  With --uring, record MSOP packets to a pcap FILE via the same ring" << std::endl;
+    std::cerr << "  --threaded     Receive thread drains the socket into a ring, main thread parses" << std::endl;
+    std::cerr << "  --replay FILE  Parse MSOP packets from a pcap capture instead of the network" << std::endl;
+    std::cerr << "  --speed X      With --replay, X times the captured rate (default 1, 0 = as fast as possible)" << std::endl;
+    std::cerr << "  --ports LIST   One sensor per comma-separated MSOP port (e.g. 2368,2370), all read by one" << std::endl;
+    std::cerr << "                 epoll thread with a parser per sensor; --batch sets packets per socket per wakeup" << std::endl;
+    std::cerr << "  --rt PRIORITY  Receive (and parse) thread at SCHED_FIFO PRIORITY (1-99), memory locked and" << std::endl;
+    std::cerr << "                 pre-faulted; prints scheduling latency. Socket loop and --threaded only" << std::endl;
+    std::cerr << "  --cpu R[,P]    Pin the receive thread to CPU R and, with --threaded, the parse thread to P" << std::endl;
+    std::cerr << "  --probe-cpu N  Probe scheduling latency on CPU N throughout the run instead of on the" << std::endl;
+    std::cerr << "                 receive CPU for 1 s before it; N must not run the receive or parse thread" << std::endl;
+    std::cerr << "  --log FILE     Also write each revolution to FILE as an indexed columnar scan log" << std::endl;
+    std::cerr << "  --latency S    Print per-stage latency histograms every S seconds (and on SIGUSR1)" << std::endl;
+    std::cerr << "  --quiet        Only parse; print packets/s and CPU time per packet" << std::endl;
+}
+
+void printBanner() {
     std::cout << "LakiBeam1(L) - 270° Field of View (45° to 315°)" << std::endl;
     std::cout << "Press Ctrl+C to exit" << std::endl;
+}
+
+// A live loop was stopped by a signal: close the scan log with its index, then the totals
+int finishLiveRun(PacketHandler& handler) {
+    std::cout << "\nStopped after " << handler.packetCount() << " packets" << std::endl;
+    bool logged = handler.finishLog();
+    handler.printLatency();
+    handler.printContinuity();
+    return logged ? 0 : -1;
+}
+
+int runRingCapture(const ReaderOptions& options) {
+    LidarPacketRingReceiver receiver(options.ring_interface, 2368);
+    PacketHandler handler(options);
+    if (!handler.initialize()) {
+        return -1;
+    }
+    
+    if (!receiver.initialize()) {
+        return -1;
+    }
     
-    uint8_t buffer[2048];  // Buffer for received packets
-    std::vector<LidarPoint> points;
-    int packet_count = 0;
+    std::cout << "Capturing MSOP packets from the " << options.ring_interface << " ring..." << std::endl;
+    printBanner();
     
-    while (true) {
-        size_t received_size;
-        if (!receiver.receivePacket(buffer, sizeof(buffer), received_size)) {
+    while (!g_stop_requested) {
+        const uint8_t* payload;
+        size_t size;
+        if (!receiver.nextPacket(payload, size)) {
             continue;
         }
         
-        std::cout << "\n--- Packet " << ++packet_count << " ---" << std::endl;
-        std::cout << "Received " << received_size << " bytes" << std::endl;
+        // Payload is parsed straight out of the ring block
+        handler.handle(payload, size);
         
-        // Check if this is the expected MSOP packet size
-        if (received_size == 1206) {
-            std::cout << "MSOP packet detected (1206 bytes - UDP header stripped)" << std::endl;
-            
-            if (parser.parsePacket(buffer, received_size, points)) {
-                printPacketInfo(points, parser.getLastTimestamp(), parser.getLastFactoryInfo());
-                
-                // Show range statistics for first few packets
-                if (packet_count <= 5 && !points.empty()) {
-                    float min_dist = 999.0f, max_dist = 0.0f;
-                    float min_azim = 999.0f, max_azim = 0.0f;
-                    
-                    for (const auto& point : points) {
-                        min_dist = std::min(min_dist, point.distance);
-                        max_dist = std::max(max_dist, point.distance);
-                        min_azim = std::min(min_azim, point.azimuth);
-                        max_azim = std::max(max_azim, point.azimuth);
+        if (!options.quiet && handler.packetCount() % 1000 == 0) {
+            const RingStats& stats = receiver.getStats();
+            std::cout << "\n=== ring: " << stats.packets << " packets in " << stats.blocks
+                      << " blocks, " << stats.kernel_drops << " kernel drops, "
+                      << stats.skipped_frames << " skipped frames ===" << std::endl;
+        }
+    }
+    
+    return finishLiveRun(handler);
+}
+
+#ifdef HAVE_IO_URING
+// A --record write in flight for one pooled buffer: the pcap record prefix and the
+// payload, gathered by one writev. A short write advances the iovecs and resubmits.
+struct PendingRecord {
+    uint8_t prefix[PCAP_RECORD_PREFIX_SIZE];
+    struct iovec iov[2];
+    uint64_t offset;
+};
+
+static size_t remainingBytes(const PendingRecord& record) {
+    return record.iov[0].iov_len + record.iov[1].iov_len;
+}
+
+static void advanceRecord(PendingRecord& record, size_t written) {
+    record.offset += written;
+    for (int i = 0; i < 2; ++i) {
+        size_t step = std::min(written, record.iov[i].iov_len);
+        record.iov[i].iov_base = static_cast<uint8_t*>(record.iov[i].iov_base) + step;
+        record.iov[i].iov_len -= step;
+        written -= step;
+    }
+}
+
+int runUringLoop(const ReaderOptions& options) {
+    LidarUringReceiver receiver(2368, 2369);  // MSOP and DIFOP ports
+    PacketHandler handler(options);
+    if (!handler.initialize()) {
+        return -1;
+    }
+    
+    if (!receiver.initialize()) {
+        return -1;
+    }
+    
+    // Records are written in the same pcap framing as slam_lidar_cpp's PcapWriter,
+    // so the file replays with --replay, msop_pcap or Wireshark
+    int record_fd = -1;
+    bool recording = false;
+    uint64_t record_offset = 0;
+    uint64_t unrecorded = 0;
+    std::vector<PendingRecord> records;
+    if (!options.record_file.empty()) {
+        record_fd = open(options.record_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (record_fd < 0) {
+            std::cerr << "Failed to open " << options.record_file << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
+        uint8_t header[PCAP_FILE_HEADER_SIZE];
+        buildPcapFileHeader(header);
+        if (write(record_fd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+            std::cerr << "Failed to write " << options.record_file << ": " << strerror(errno) << std::endl;
+            close(record_fd);
+            return -1;
+        }
+        recording = true;
+        record_offset = sizeof(header);
+        records.resize(URING_POOL_BUFFERS);
+        std::cout << "Recording MSOP packets to " << options.record_file << " (pcap)" << std::endl;
+    }
+    
+    std::cout << "Listening for MSOP/DIFOP packets through io_uring..." << std::endl;
+    printBanner();
+    
+    UringEvent events[MAX_BATCH_SIZE];
+    int next_report = 1000;
+    int status = -1;
+    
+    // After a stop request, keep reaping until the record writes in flight are done:
+    // they point into the pooled buffers and the prefixes in records
+    int writes_in_flight = 0;
+    while (!g_stop_requested || writes_in_flight > 0) {
+        int count = receiver.waitEvents(events, MAX_BATCH_SIZE);
+        if (count < 0) {
+            break;
+        }
+        
+        for (int i = 0; i < count; ++i) {
+            const UringEvent& event = events[i];
+            switch (event.type) {
+            case UringEvent::MSOP_PACKET:
+                if (g_stop_requested) {
+                    receiver.releaseBuffer(event.buffer_id);
+                    break;
+                }
+                handler.handle(event.data, event.size);
+                if (recording) {
+                    // Write straight from the pooled buffer; it is recycled on WRITE_DONE
+                    PendingRecord& record = records[event.buffer_id];
+                    struct timespec now;
+                    clock_gettime(CLOCK_REALTIME, &now);
+                    buildPcapRecordPrefix(record.prefix, event.size, now, 2368, NULL);
+                    record.iov[0].iov_base = record.prefix;
+                    record.iov[0].iov_len = PCAP_RECORD_PREFIX_SIZE;
+                    record.iov[1].iov_base = const_cast<uint8_t*>(event.data);
+                    record.iov[1].iov_len = event.size;
+                    record.offset = record_offset;
+                    if (receiver.queueWritev(record_fd, record.iov, 2, record.offset, event.buffer_id)) {
+                        record_offset += remainingBytes(record);
+                        writes_in_flight++;
+                        break;
+                    }
+                    unrecorded++;  // Submission queue full; the file simply lacks this packet
+                }
+                receiver.releaseBuffer(event.buffer_id);
+                break;
+            case UringEvent::DIFOP_PACKET:
+                receiver.releaseBuffer(event.buffer_id);
+                break;
+            case UringEvent::WRITE_DONE: {
+                uint16_t buffer_id = static_cast<uint16_t>(event.cookie);
+                PendingRecord& record = records[buffer_id];
+                if (recording && event.result <= 0) {
+                    // Later records would sit behind a hole; stop rather than write a corrupt file
+                    std::cerr << "Record write failed: "
+                              << (event.result < 0 ? strerror(-event.result) : "nothing written")
+                              << "; recording stopped at " << record.offset << " bytes" << std::endl;
+                    recording = false;
+                } else if (recording && static_cast<size_t>(event.result) < remainingBytes(record)) {
+                    advanceRecord(record, static_cast<size_t>(event.result));
+                    if (receiver.queueWritev(record_fd, record.iov, 2, record.offset, buffer_id)) {
+                        break;  // The buffer stays in use until the rest is written
                     }
-                    
-                    std::cout << "  Range stats: Distance " << std::fixed << std::setprecision(2) 
-                              << min_dist << "m to " << max_dist << "m, "
-                              << "Azimuth " << min_azim << "° to " << max_azim << "°" << std::endl;
+                    std::cerr << "Could not resubmit a short record write; recording stopped at "
+                              << record.offset << " bytes" << std::endl;
+                    recording = false;
                 }
+                writes_in_flight--;
+                receiver.releaseBuffer(buffer_id);
+                break;
+            }
+            case UringEvent::RECEIVE_ERROR:
+                std::cerr << "Error receiving packet: " << strerror(-event.result) << std::endl;
+                break;
+            }
+        }
+        
+        if (!options.quiet && handler.packetCount() >= next_report) {
+            next_report += 1000;
+            const UringStats& stats = receiver.getStats();
+            std::cout << "\n=== io_uring: " << stats.msop_packets << " MSOP, " << stats.difop_packets
+                      << " DIFOP, " << stats.writes << " writes, " << stats.enter_calls
+                      << " io_uring_enter calls, " << stats.buffer_starved << " pool starvations";
+            if (unrecorded > 0) {
+                std::cout << ", " << unrecorded << " packets not recorded";
+            }
+            std::cout << " ===" << std::endl;
+        }
+    }
+    if (g_stop_requested && writes_in_flight == 0) {
+        status = finishLiveRun(handler);
+    }
+    
+    if (record_fd >= 0) {
+        close(record_fd);
+    }
+    return status;
+}
+#endif
+
+// Scheduling latency for --rt/--cpu, before the socket is opened. By default the probe
+// runs for PROBE_SECONDS on the receive CPU at the receive priority, while nothing of
+// this process runs there yet, and prints its summary once. With --probe-cpu it runs
+// on that CPU for the whole run and its line follows the throughput output.
+static const int PROBE_SECONDS = 1;
+
+void startSchedulingProbe(const RealtimeOptions& realtime, PacketHandler& handler, SchedulingLatencyProbe& probe) {
+    if (realtime.probe_cpu >= 0) {
+        probe.start(realtime.probe_cpu, realtime.priority);
+        handler.setSchedulingProbe(&probe);
+        return;
+    }
+    std::cout << "Probing scheduling latency of the receive CPU for " << PROBE_SECONDS << " s..." << std::endl;
+    probe.measure(realtime.receive_cpu, realtime.priority, PROBE_SECONDS * 1000000000ULL);
+    probe.print(std::cout);
+}
+
+// One raw datagram exactly as received (MSOP packet with or without the 42-byte header).
+// Padded from 1264 to 1280 bytes so every slot starts on its own cache line.
+struct alignas(CACHE_LINE_SIZE) RawPacketSlot {
+    uint32_t size;
+    uint64_t received_ns;   // CLOCK_MONOTONIC when published, 0 unless latency stats are on
+    uint8_t data[1248];
+};
+
+typedef SPSCRing<RawPacketSlot, 1024> PacketRing;
+
+static const int PARSE_IDLE_SPINS = 100;          // yields before the parse thread sleeps
+static const long PARSE_WAIT_NS = 10000000;       // longest sleep, so g_stop_requested is polled
+
+// Receive thread: does nothing but move datagrams from the socket into the ring,
+// so a slow consumer costs ring slots instead of socket-buffer overruns
+void receiveIntoRing(LidarUDPReceiver& receiver, PacketRing& ring, const PipelineLatency& latency) {
+    uint8_t scratch[sizeof(RawPacketSlot::data)];
+    
+    while (!g_stop_requested) {
+        RawPacketSlot* slot = ring.acquire();
+        size_t received_size;
+        if (slot == NULL) {
+            // Ring full: still drain the socket, but discard the packet
+            if (receiver.receivePacket(scratch, sizeof(scratch), received_size)) {
+                ring.recordDrop();
+            }
+            continue;
+        }
+        if (receiver.receivePacket(slot->data, sizeof(slot->data), received_size)) {
+            slot->size = static_cast<uint32_t>(received_size);
+            slot->received_ns = latency.start();
+            ring.publish();
+        }
+    }
+}
+
+int runThreaded(const ReaderOptions& options) {
+    LidarUDPReceiver receiver(2368);  // Default MSOP port
+    PacketHandler handler(options);
+    if (!handler.initialize()) {
+        return -1;
+    }
+    
+    const RealtimeOptions& realtime = options.realtime;
+    SchedulingLatencyProbe probe;
+    if (realtime.isEnabled()) {
+        startSchedulingProbe(realtime, handler, probe);
+    }
+    
+    if (!receiver.initialize()) {
+        return -1;
+    }
+    if (handler.latency().isEnabled() && !receiver.enableLatencyStats(&handler.latency())) {
+        return -1;
+    }
+    
+    std::cout << "Listening for MSOP packets on port 2368 (receive thread + parse thread)..." << std::endl;
+    printBanner();
+    
+    PacketRing ring;
+    if (realtime.isEnabled()) {
+        handler.prefault();
+        prefaultMemory(ring.storage(), ring.storageSize());
+    }
+    
+    std::atomic<bool> receive_done(false);
+    std::thread receive_thread([&receiver, &ring, &handler, &realtime, &receive_done]() {
+        if (realtime.isEnabled()) {
+            applyThreadRealtime("Receive", realtime.receive_cpu, realtime.priority);
+        }
+        receiveIntoRing(receiver, ring, handler.latency());
+        receive_done = true;
+    });
+    if (realtime.priority > 0) {
+        lockProcessMemory();    // Every thread exists now, so their stacks are locked too
+    }
+    if (realtime.isEnabled()) {
+        applyThreadRealtime("Parse", realtime.parse_cpu, realtime.priority);
+    }
+    
+    int idle_spins = 0;
+    while (!g_stop_requested) {
+        const RawPacketSlot* slot = ring.front();
+        if (slot == NULL) {
+            // Spin a little for the next packet of a burst, then sleep until the receive
+            // thread publishes one: between bursts the ring is empty most of the time.
+            // A SCHED_FIFO thread sleeps at once, as yielding would keep normal tasks off its CPU.
+            if (realtime.priority == 0 && ++idle_spins < PARSE_IDLE_SPINS) {
+                std::this_thread::yield();
             } else {
-                std::cout << "Failed to parse MSOP packet" << std::endl;
+                ring.waitForData(PARSE_WAIT_NS);   // Bounded, so a stop request is seen
+                idle_spins = 0;
+            }
+            continue;
+        }
+        idle_spins = 0;
+        
+        handler.latency().stop(STAGE_HANDOFF, slot->received_ns);
+        handler.handle(slot->data, slot->size);
+        ring.pop();
+        
+        if (handler.packetCount() % 1000 == 0) {
+            std::cout << "\n=== ring: high-water " << ring.highWaterMark() << "/" << ring.capacity()
+                      << " slots, " << ring.droppedCount() << " packets dropped (ring full) ===" << std::endl;
+        }
+    }
+    
+    // The signal may have gone to this thread while the receive thread sits in recvmsg();
+    // repeat it until the receive thread has seen the flag
+    while (!receive_done) {
+        pthread_kill(receive_thread.native_handle(), SIGTERM);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    receive_thread.join();
+    return finishLiveRun(handler);
+}
+
+int runReplay(const ReaderOptions& options) {
+    LidarPcapReplay replay(options.replay_file, 2368);
+    PacketHandler handler(options);
+    if (!handler.initialize()) {
+        return -1;
+    }
+    
+    if (!replay.initialize()) {
+        return -1;
+    }
+    replay.setSpeed(options.speed);
+    
+    std::cout << "Replaying " << options.replay_file << " at ";
+    if (options.speed == 0.0) {
+        std::cout << "full speed" << std::endl;
+    } else {
+        std::cout << options.speed << "x the captured rate" << std::endl;
+    }
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    const uint8_t* payload;
+    size_t size;
+    while (!g_stop_requested && replay.nextPacket(payload, size)) {
+        handler.handle(payload, size);
+    }
+    handler.finishLog();
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    handler.printLatency();
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    const ReplayStats& stats = replay.getStats();
+    std::cout << "\n=== Replayed " << stats.packets << " packets in " << std::fixed << std::setprecision(3)
+              << elapsed << " s (" << std::setprecision(0)
+              << (elapsed > 0 ? stats.packets / elapsed : 0.0) << " packets/s) ===" << std::endl;
+    std::cout << "  Skipped records: " << stats.skipped_records
+              << ", late packets: " << stats.late_packets << std::endl;
+    handler.printContinuity();
+    return 0;
+}
+
+int runSocketLoop(const ReaderOptions& options) {
+    LidarUDPReceiver receiver(2368);  // Default MSOP port
+    PacketHandler handler(options);
+    if (!handler.initialize()) {
+        return -1;
+    }
+    
+    SchedulingLatencyProbe probe;
+    if (options.realtime.isEnabled()) {
+        startSchedulingProbe(options.realtime, handler, probe);
+    }
+    
+    if (!receiver.initialize()) {
+        return -1;
+    }
+    if (handler.latency().isEnabled() && !receiver.enableLatencyStats(&handler.latency())) {
+        return -1;
+    }
+    
+    std::cout << "Listening for MSOP packets on port 2368..." << std::endl;
+    if (options.batch_size > 0) {
+        std::cout << "Batched receive: up to " << options.batch_size << " packets per recvmmsg() call" << std::endl;
+    }
+    printBanner();
+    
+    // One thread receives and parses, so it takes the receive CPU
+    if (options.realtime.isEnabled()) {
+        handler.prefault();
+        if (options.realtime.priority > 0) {
+            lockProcessMemory();
+        }
+        applyThreadRealtime("Receive", options.realtime.receive_cpu, options.realtime.priority);
+    }
+    
+    if (options.batch_size > 0) {
+        PacketBatch batch(options.batch_size);
+        
+        while (!g_stop_requested) {
+            int received = receiver.receiveBatch(batch);
+            if (received <= 0) {
+                continue;
             }
-        } else if (received_size == 1248) {
-            std::cout << "MSOP packet with UDP header detected (1248 bytes)" << std::endl;
             
-            // Skip the first 42 bytes (UDP header) and parse the rest
-            if (parser.parsePacket(buffer + 42, received_size - 42, points)) {
-                printPacketInfo(points, parser.getLastTimestamp(), parser.getLastFactoryInfo());
-            } else {
-                std::cout << "Failed to parse MSOP packet" << std::endl;
+            for (int i = 0; i < received; ++i) {
+                handler.handle(batch.packet(i), batch.packetSize(i));
             }
-        } else {
-            std::cout << "Unexpected packet size: " << received_size << " bytes" << std::endl;
+            if (options.quiet) {
+                continue;
+            }
+            std::cout << "(" << received << " packet(s) from one recvmmsg() call)" << std::endl;
             
-            // Print first few bytes in hex for debugging
-            std::cout << "First 16 bytes: ";
-            for (size_t i = 0; i < std::min(received_size, size_t(16)); ++i) {
-                std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                          << (int)buffer[i] << " ";
+            // Periodic summary of how many packets each syscall returned
+            if (receiver.getBatchStats().syscalls % 100 == 0) {
+                printBatchStats(receiver.getBatchStats());
             }
-            std::cout << std::dec << std::endl;
         }
+        return finishLiveRun(handler);
     }
     
-    return 0;
+    uint8_t buffer[PACKET_SLOT_SIZE];  // Buffer for received packets
+    
+    while (!g_stop_requested) {
+        size_t received_size;
+        if (!receiver.receivePacket(buffer, sizeof(buffer), received_size)) {
+            continue;
+        }
+        
+        handler.handle(buffer, received_size);
+    }
+    
+    return finishLiveRun(handler);
+}
+
+// Parse "2368,2370,2372"; false on anything that is not a list of ports
+bool parsePortList(const char* text, std::vector<int>& ports) {
+    std::stringstream list(text);
+    std::string item;
+    ports.clear();
+    while (std::getline(list, item, ',')) {
+        char* end = NULL;
+        long port = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || port < 1 || port > 65535) {
+            return false;
+        }
+        ports.push_back(static_cast<int>(port));
+    }
+    return !ports.empty();
+}
+
+// Parse "2" or "2,3": the receive CPU and optionally the parse thread's
+bool parseCpuList(const char* text, RealtimeOptions& realtime) {
+    char* end = NULL;
+    long receive = strtol(text, &end, 10);
+    if (end == text || receive < 0) {
+        return false;
+    }
+    long parse = -1;
+    if (*end == ',') {
+        const char* next = end + 1;
+        parse = strtol(next, &end, 10);
+        if (end == next || parse < 0) {
+            return false;
+        }
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    realtime.receive_cpu = static_cast<int>(receive);
+    realtime.parse_cpu = static_cast<int>(parse);
+    return true;
+}
+
+int runReactor(const ReaderOptions& options) {
+    LidarEpollReactor reactor(options.ports, options.batch_size > 0 ? options.batch_size : 32);
+    
+    // One handler per sensor; each scan log gets the sensor's port appended to its name
+    std::vector<std::unique_ptr<PacketHandler> > handlers;
+    for (size_t i = 0; i < options.ports.size(); ++i) {
+        ReaderOptions sensor_options = options;
+        std::ostringstream label;
+        label << "sensor " << i << ", port " << options.ports[i];
+        if (!options.log_file.empty()) {
+            std::ostringstream log_file;
+            log_file << options.log_file << "." << options.ports[i];
+            sensor_options.log_file = log_file.str();
+        }
+        handlers.push_back(std::unique_ptr<PacketHandler>(new PacketHandler(sensor_options, label.str())));
+        if (!handlers.back()->initialize()) {
+            return -1;
+        }
+    }
+    
+    if (!reactor.initialize()) {
+        return -1;
+    }
+    
+    std::cout << "Listening for MSOP packets from " << reactor.getSensorCount()
+              << " sensors in one epoll thread..." << std::endl;
+    printBanner();
+    
+    std::vector<ReactorPacket> packets(reactor.getMaxPackets());
+    ThroughputMeter meter;          // All sensors together
+    uint64_t next_report = 1000;
+    
+    while (!g_stop_requested) {
+        int received = reactor.waitPackets(packets.data(), static_cast<int>(packets.size()));
+        if (received < 0) {
+            break;
+        }
+        
+        for (int i = 0; i < received; ++i) {
+            handlers[packets[i].sensor]->handle(packets[i].data, packets[i].size);
+            if (options.quiet && meter.addPacket()) {
+                for (size_t h = 0; h < handlers.size(); ++h) {
+                    handlers[h]->printContinuity();
+                }
+            }
+        }
+        if (g_latency_dump_requested) {
+            g_latency_dump_requested = 0;
+            for (size_t h = 0; h < handlers.size(); ++h) {
+                handlers[h]->printLatency();
+            }
+        }
+        
+        const ReactorStats& stats = reactor.getStats();
+        if (!options.quiet && stats.packets >= next_report) {
+            next_report += 1000;
+            std::cout << "\n=== epoll: " << stats.packets << " packets in " << stats.wakeups << " wakeups ("
+                      << std::fixed << std::setprecision(2)
+                      << (stats.wakeups ? double(stats.packets) / stats.wakeups : 0.0) << " packets/wakeup), "
+                      << stats.receive_calls << " recvmmsg calls; per sensor:";
+            for (int s = 0; s < reactor.getSensorCount(); ++s) {
+                std::cout << " " << reactor.getPort(s) << "=" << reactor.getSensorPackets(s);
+            }
+            std::cout << " ===" << std::endl;
+        }
+    }
+    if (!g_stop_requested) {
+        return -1;
+    }
+    int status = 0;
+    for (size_t h = 0; h < handlers.size(); ++h) {
+        if (finishLiveRun(*handlers[h]) != 0) {
+            status = -1;
+        }
+    }
+    return status;
+}
+
+int main(int argc, char** argv) {
+    ReaderOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options.batch_size = atoi(argv[++i]);
+            if (options.batch_size < 1 || options.batch_size > MAX_BATCH_SIZE) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+            options.ring_interface = argv[++i];
+        } else if (strcmp(argv[i], "--uring") == 0) {
+            options.use_uring = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.record_file = argv[++i];
+        } else if (strcmp(argv[i], "--threaded") == 0) {
+            options.threaded = true;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replay_file = argv[++i];
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            options.speed = atof(argv[++i]);
+            if (options.speed < 0.0) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            options.log_file = argv[++i];
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            options.latency_interval = atof(argv[++i]);
+            if (options.latency_interval <= 0.0) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--ports") == 0 && i + 1 < argc) {
+            if (!parsePortList(argv[++i], options.ports)) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--rt") == 0 && i + 1 < argc) {
+            options.realtime.priority = atoi(argv[++i]);
+            if (options.realtime.priority < 1 || options.realtime.priority > 99) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            if (!parseCpuList(argv[++i], options.realtime)) {
+                printUsage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--probe-cpu") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            long cpu = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || cpu < 0) {
+                printUsage(argv[0]);
+                return -1;
+            }
+            options.realtime.probe_cpu = static_cast<int>(cpu);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            options.quiet = true;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    
+    if (options.realtime.isEnabled() && (!options.replay_file.empty() || !options.ports.empty() ||
+                                         !options.ring_interface.empty() || options.use_uring)) {
+        std::cerr << "--rt and --cpu apply to the socket loop and --threaded only" << std::endl;
+        return -1;
+    }
+    if (options.realtime.parse_cpu >= 0 && !options.threaded) {
+        std::cerr << "--cpu RECV,PARSE needs --threaded; the socket loop has a single thread" << std::endl;
+        return -1;
+    }
+    if (options.realtime.probe_cpu >= 0) {
+        const RealtimeOptions& realtime = options.realtime;
+        if (realtime.priority == 0 && realtime.receive_cpu < 0) {
+            std::cerr << "--probe-cpu needs --rt or --cpu" << std::endl;
+            return -1;
+        }
+        if (realtime.probe_cpu == realtime.receive_cpu || realtime.probe_cpu == realtime.parse_cpu) {
+            std::cerr << "--probe-cpu needs a CPU of its own; the probe would delay the thread it measures" << std::endl;
+            return -1;
+        }
+    }
+    
+    if (options.latency_interval > 0.0) {
+        signal(SIGUSR1, requestLatencyDump);
+    }
+    installStopHandlers();
+    
+    if (!options.replay_file.empty()) {
+        return runReplay(options);
+    }
+    if (!options.ports.empty()) {
+        return runReactor(options);
+    }
+    if (!options.ring_interface.empty()) {
+        return runRingCapture(options);
+    }
+    if (options.use_uring) {
+#ifdef HAVE_IO_URING
+        return runUringLoop(options);
+#else
+        std::cerr << "lidar_reader was built without io_uring support" << std::endl;
+        return -1;
+#endif
+    }
+    if (options.threaded) {
+        return runThreaded(options);
+    }
+    return runSocketLoop(options);
 }
@@ -0,0 +1,285 @@
+#include "msop_block_decoder.h"
+#include <arpa/inet.h>  // For ntohs
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MSOP_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define MSOP_NEON_KERNEL 1
+#include <arm_neon.h>
+#endif
+
+// Reference kernel: one measurement at a time, same checks as the original parser
+static void decodeBlockScalar(const DataBlock* block, DecodedBlock* out) {
+    uint16_t strongest_mask = 0;
+    uint16_t last_mask = 0;
+
+    for (int i = 0; i < 16; ++i) {
+        const MeasuringResult& measurement = block->measurements[i];
+        uint16_t strongest = ntohs(measurement.distance_strongest);
+        uint16_t last = ntohs(measurement.distance_last);
+
+        out->distance_strongest[i] = strongest;
+        out->distance_last[i] = last;
+        out->rssi_strongest[i] = measurement.rssi_strongest;
+        out->rssi_last[i] = measurement.rssi_last;
+
+        // 0 and 0xFFFF both fall outside the gate, so no separate test is needed
+        bool strongest_ok = strongest >= MIN_DISTANCE_MM && strongest <= MAX_DISTANCE_MM;
+        bool last_ok = last >= MIN_DISTANCE_MM && last <= MAX_DISTANCE_MM && last != strongest;
+        strongest_mask |= static_cast<uint16_t>(strongest_ok) << i;
+        last_mask |= static_cast<uint16_t>(last_ok) << i;
+    }
+
+    out->strongest_mask = strongest_mask;
+    out->last_mask = last_mask;
+}
+
+#ifdef MSOP_X86_KERNELS
+
+// pshufb controls that pull one field of 8 consecutive 6-byte records out of the
+// three 16-byte registers covering them. Distances are gathered low byte first,
+// which performs the big-endian swap; -128 zeroes the lane.
+alignas(16) static const int8_t FIELD_SHUFFLES[4][3][16] = {
+    {   // Strongest distance (record bytes 0-1)
+        {   1,    0,    7,    6,   13,   12, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128, -128, -128, -128,    3,    2,    9,    8,   15,   14, -128, -128, -128, -128},
+        {-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128,    5,    4,   11,   10},
+    },
+    {   // Last distance (record bytes 3-4)
+        {   4,    3,   10,    9, -128,   15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128, -128,    0, -128,    6,    5,   12,   11, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128, -128, -128, -128, -128, -128, -128, -128,    2,    1,    8,    7,   14,   13},
+    },
+    {   // Strongest RSSI (record byte 2) into the low 8 bytes
+        {   2,    8,   14, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128,    4,   10, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128, -128, -128,    0,    6,   12, -128, -128, -128, -128, -128, -128, -128, -128},
+    },
+    {   // Last RSSI (record byte 5) into the low 8 bytes
+        {   5,   11, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128,    1,    7,   13, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128},
+        {-128, -128, -128, -128, -128,    3,    9,   15, -128, -128, -128, -128, -128, -128, -128, -128},
+    },
+};
+
+__attribute__((target("sse4.1")))
+static inline __m128i gatherField128(const __m128i* regs, int field) {
+    const __m128i* shuffles = reinterpret_cast<const __m128i*>(FIELD_SHUFFLES[field]);
+    __m128i value = _mm_shuffle_epi8(regs[0], _mm_load_si128(&shuffles[0]));
+    value = _mm_or_si128(value, _mm_shuffle_epi8(regs[1], _mm_load_si128(&shuffles[1])));
+    return _mm_or_si128(value, _mm_shuffle_epi8(regs[2], _mm_load_si128(&shuffles[2])));
+}
+
+// All-ones lanes where MIN_DISTANCE_MM <= d <= MAX_DISTANCE_MM (unsigned compare)
+__attribute__((target("sse4.1")))
+static inline __m128i distanceGate128(__m128i distance) {
+    __m128i above = _mm_cmpeq_epi16(_mm_max_epu16(distance, _mm_set1_epi16(MIN_DISTANCE_MM)), distance);
+    __m128i below = _mm_cmpeq_epi16(_mm_min_epu16(distance, _mm_set1_epi16(MAX_DISTANCE_MM)), distance);
+    return _mm_and_si128(above, below);
+}
+
+__attribute__((target("sse4.1")))
+static inline uint16_t laneMask128(__m128i lanes) {
+    return static_cast<uint16_t>(_mm_movemask_epi8(_mm_packs_epi16(lanes, _mm_setzero_si128())));
+}
+
+__attribute__((target("sse4.1")))
+static void decodeBlockSSE41(const DataBlock* block, DecodedBlock* out) {
+    const uint8_t* records = reinterpret_cast<const uint8_t*>(block->measurements);
+    uint16_t strongest_mask = 0;
+    uint16_t last_mask = 0;
+
+    // Two halves of 8 records (48 bytes) each
+    for (int half = 0; half < 2; ++half) {
+        const uint8_t* src = records + half * 48;
+        __m128i regs[3] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32)),
+        };
+
+        __m128i strongest = gatherField128(regs, 0);
+        __m128i last = gatherField128(regs, 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out->distance_strongest + half * 8), strongest);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out->distance_last + half * 8), last);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_strongest + half * 8), gatherField128(regs, 2));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_last + half * 8), gatherField128(regs, 3));
+
+        __m128i strongest_ok = distanceGate128(strongest);
+        __m128i last_ok = _mm_andnot_si128(_mm_cmpeq_epi16(last, strongest), distanceGate128(last));
+        strongest_mask |= laneMask128(strongest_ok) << (half * 8);
+        last_mask |= laneMask128(last_ok) << (half * 8);
+    }
+
+    out->strongest_mask = strongest_mask;
+    out->last_mask = last_mask;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i gatherField256(const __m256i* regs, int field) {
+    const __m128i* shuffles = reinterpret_cast<const __m128i*>(FIELD_SHUFFLES[field]);
+    __m256i value = _mm256_shuffle_epi8(regs[0], _mm256_broadcastsi128_si256(_mm_load_si128(&shuffles[0])));
+    value = _mm256_or_si256(value, _mm256_shuffle_epi8(regs[1], _mm256_broadcastsi128_si256(_mm_load_si128(&shuffles[1]))));
+    return _mm256_or_si256(value, _mm256_shuffle_epi8(regs[2], _mm256_broadcastsi128_si256(_mm_load_si128(&shuffles[2]))));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i distanceGate256(__m256i distance) {
+    __m256i above = _mm256_cmpeq_epi16(_mm256_max_epu16(distance, _mm256_set1_epi16(MIN_DISTANCE_MM)), distance);
+    __m256i below = _mm256_cmpeq_epi16(_mm256_min_epu16(distance, _mm256_set1_epi16(MAX_DISTANCE_MM)), distance);
+    return _mm256_and_si256(above, below);
+}
+
+__attribute__((target("avx2")))
+static inline uint16_t laneMask256(__m256i lanes) {
+    // In-lane pack leaves records 0-7 in bits 0-7 and records 8-15 in bits 16-23
+    uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_packs_epi16(lanes, _mm256_setzero_si256())));
+    return static_cast<uint16_t>((bits & 0xFF) | ((bits >> 8) & 0xFF00));
+}
+
+__attribute__((target("avx2")))
+static void decodeBlockAVX2(const DataBlock* block, DecodedBlock* out) {
+    const uint8_t* records = reinterpret_cast<const uint8_t*>(block->measurements);
+
+    // Lane 0 carries records 0-7, lane 1 records 8-15, so the 128-bit shuffles apply per lane
+    __m256i regs[3];
+    for (int r = 0; r < 3; ++r) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(records + r * 16));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(records + 48 + r * 16));
+        regs[r] = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    }
+
+    __m256i strongest = gatherField256(regs, 0);
+    __m256i last = gatherField256(regs, 1);
+    __m256i rssi_strongest = gatherField256(regs, 2);
+    __m256i rssi_last = gatherField256(regs, 3);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out->distance_strongest), strongest);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out->distance_last), last);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_strongest), _mm256_castsi256_si128(rssi_strongest));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_strongest + 8), _mm256_extracti128_si256(rssi_strongest, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_last), _mm256_castsi256_si128(rssi_last));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out->rssi_last + 8), _mm256_extracti128_si256(rssi_last, 1));
+
+    __m256i strongest_ok = distanceGate256(strongest);
+    __m256i last_ok = _mm256_andnot_si256(_mm256_cmpeq_epi16(last, strongest), distanceGate256(last));
+    out->strongest_mask = laneMask256(strongest_ok);
+    out->last_mask = laneMask256(last_ok);
+}
+
+#endif // MSOP_X86_KERNELS
+
+#ifdef MSOP_NEON_KERNEL
+
+static inline uint16x8_t distanceGateNEON(uint16x8_t distance) {
+    return vandq_u16(vcgeq_u16(distance, vdupq_n_u16(MIN_DISTANCE_MM)),
+                     vcleq_u16(distance, vdupq_n_u16(MAX_DISTANCE_MM)));
+}
+
+static inline uint16_t laneMaskNEON(uint16x8_t lanes) {
+    static const uint16_t LANE_BITS[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    return vaddvq_u16(vandq_u16(lanes, vld1q_u16(LANE_BITS)));
+}
+
+static void decodeBlockNEON(const DataBlock* block, DecodedBlock* out) {
+    const uint8_t* records = reinterpret_cast<const uint8_t*>(block->measurements);
+    uint16_t strongest_mask = 0;
+    uint16_t last_mask = 0;
+
+    for (int half = 0; half < 2; ++half) {
+        // Each record is two 3-byte returns: vld3 splits 16 returns into
+        // high byte / low byte / RSSI, then unzip separates strongest (even) from last (odd)
+        uint8x16x3_t returns = vld3q_u8(records + half * 48);
+        uint8x16x2_t high = vuzpq_u8(returns.val[0], returns.val[0]);
+        uint8x16x2_t low = vuzpq_u8(returns.val[1], returns.val[1]);
+        uint8x16x2_t rssi = vuzpq_u8(returns.val[2], returns.val[2]);
+
+        uint16x8_t strongest = vorrq_u16(vshll_n_u8(vget_low_u8(high.val[0]), 8), vmovl_u8(vget_low_u8(low.val[0])));
+        uint16x8_t last = vorrq_u16(vshll_n_u8(vget_low_u8(high.val[1]), 8), vmovl_u8(vget_low_u8(low.val[1])));
+
+        vst1q_u16(out->distance_strongest + half * 8, strongest);
+        vst1q_u16(out->distance_last + half * 8, last);
+        vst1_u8(out->rssi_strongest + half * 8, vget_low_u8(rssi.val[0]));
+        vst1_u8(out->rssi_last + half * 8, vget_low_u8(rssi.val[1]));
+
+        uint16x8_t strongest_ok = distanceGateNEON(strongest);
+        uint16x8_t last_ok = vandq_u16(distanceGateNEON(last), vmvnq_u16(vceqq_u16(last, strongest)));
+        strongest_mask |= laneMaskNEON(strongest_ok) << (half * 8);
+        last_mask |= laneMaskNEON(last_ok) << (half * 8);
+    }
+
+    out->strongest_mask = strongest_mask;
+    out->last_mask = last_mask;
+}
+
+#endif // MSOP_NEON_KERNEL
+
+bool isBlockDecoderSupported(BlockDecoderKind kind) {
+    switch (kind) {
+    case BLOCK_DECODER_SCALAR:
+        return true;
+#ifdef MSOP_X86_KERNELS
+    case BLOCK_DECODER_SSE41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case BLOCK_DECODER_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef MSOP_NEON_KERNEL
+    case BLOCK_DECODER_NEON:
+        return true;  // Advanced SIMD is mandatory on AArch64
+#endif
+    default:
+        return false;
+    }
+}
+
+BlockDecodeFn getBlockDecoder(BlockDecoderKind kind) {
+    if (!isBlockDecoderSupported(kind)) {
+        return decodeBlockScalar;
+    }
+    switch (kind) {
+#ifdef MSOP_X86_KERNELS
+    case BLOCK_DECODER_SSE41:
+        return decodeBlockSSE41;
+    case BLOCK_DECODER_AVX2:
+        return decodeBlockAVX2;
+#endif
+#ifdef MSOP_NEON_KERNEL
+    case BLOCK_DECODER_NEON:
+        return decodeBlockNEON;
+#endif
+    default:
+        return decodeBlockScalar;
+    }
+}
+
+static BlockDecoderKind detectBestBlockDecoder() {
+    const BlockDecoderKind preference[] = {
+        BLOCK_DECODER_AVX2, BLOCK_DECODER_SSE41, BLOCK_DECODER_NEON
+    };
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); ++i) {
+        if (isBlockDecoderSupported(preference[i])) {
+            return preference[i];
+        }
+    }
+    return BLOCK_DECODER_SCALAR;
+}
+
+BlockDecoderKind bestBlockDecoder() {
+    static const BlockDecoderKind best = detectBestBlockDecoder();
+    return best;
+}
+
+const char* blockDecoderName(BlockDecoderKind kind) {
+    switch (kind) {
+    case BLOCK_DECODER_SSE41: return "sse4.1";
+    case BLOCK_DECODER_AVX2: return "avx2";
+    case BLOCK_DECODER_NEON: return "neon";
+    default: return "scalar";
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef MSOP_BLOCK_DECODER_H
+#define MSOP_BLOCK_DECODER_H
+
+#include <cstdint>
+#include "msop_parser.h"
+
+// Distance gate applied by the parser, in raw millimetres.
+// Equivalent to isValidDistance(mm / 1000.0f) for every 16-bit value.
+static const uint16_t MIN_DISTANCE_MM = 100;
+static const uint16_t MAX_DISTANCE_MM = 15000;
+
+// The 16 measuring results of one data block, de-interleaved into columns
+// and converted to host byte order
+struct DecodedBlock {
+    uint16_t distance_strongest[16];
+    uint16_t distance_last[16];
+    uint8_t rssi_strongest[16];
+    uint8_t rssi_last[16];
+    uint16_t strongest_mask;    // Bit i set: strongest return i is inside the distance gate
+    uint16_t last_mask;         // Bit i set: last return i is inside the gate and differs from strongest
+};
+
+enum BlockDecoderKind {
+    BLOCK_DECODER_SCALAR,
+    BLOCK_DECODER_SSE41,
+    BLOCK_DECODER_AVX2,
+    BLOCK_DECODER_NEON
+};
+
+// True if this build and this CPU can run the given kernel
+bool isBlockDecoderSupported(BlockDecoderKind kind);
+
+// Kernel for a specific instruction set (falls back to scalar if unsupported)
+BlockDecodeFn getBlockDecoder(BlockDecoderKind kind);
+
+// Fastest supported kernel, chosen once at startup
+BlockDecoderKind bestBlockDecoder();
+
+const char* blockDecoderName(BlockDecoderKind kind);
+
+#endif // MSOP_BLOCK_DECODER_H
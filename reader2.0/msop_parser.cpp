@@ -1,81 +1,131 @@
 #include "msop_parser.h"
+#include "msop_block_decoder.h"
+#include "msop_packet_view.h"
+#include "point_cloud_soa.h"
 #include <cstring>
-#include <arpa/inet.h>  // For ntohl, ntohs
 
-MSOPParser::MSOPParser() : last_timestamp_(0), last_factory_info_(0) {
+static_assert(sizeof(MSOPPacket) == MSOPPacketView::PACKET_SIZE, "MSOPPacket layout differs from MSOPPacketView");
+static_assert(sizeof(DataBlock) == MSOPPacketView::BLOCK_SIZE, "DataBlock layout differs from MSOPPacketView");
+
+namespace {
+
+inline void appendPoint(std::vector<LidarPoint>& points, float azimuth, float distance,
+                        uint8_t rssi, bool is_strongest) {
+    LidarPoint point;
+    point.azimuth = azimuth;
+    point.distance = distance;
+    point.rssi = rssi;
+    point.is_valid = true;
+    point.is_strongest = is_strongest;
+    points.push_back(point);
+}
+
+inline void appendPoint(PointCloudSoA& cloud, float azimuth, float distance,
+                        uint8_t rssi, bool is_strongest) {
+    cloud.push_back(azimuth, distance, rssi,
+                    POINT_FLAG_VALID | (is_strongest ? POINT_FLAG_STRONGEST : 0));
+}
+
+// Caller-owned fixed-capacity output
+struct PointSpan {
+    LidarPoint* points;
+    size_t capacity;
+    size_t count;
+};
+
+inline void appendPoint(PointSpan& span, float azimuth, float distance,
+                        uint8_t rssi, bool is_strongest) {
+    if (span.count == span.capacity) {
+        return;
+    }
+    LidarPoint& point = span.points[span.count++];
+    point.azimuth = azimuth;
+    point.distance = distance;
+    point.rssi = rssi;
+    point.is_valid = true;
+    point.is_strongest = is_strongest;
+}
+
+} // namespace
+
+MSOPParser::MSOPParser()
+    : last_timestamp_(0), last_factory_info_(0),
+      decode_block_(getBlockDecoder(bestBlockDecoder())) {
 }
 
 bool MSOPParser::parsePacket(const uint8_t* data, size_t size, std::vector<LidarPoint>& points) {
     // Clear previous points
     points.clear();
-    
+    return parseInto(data, size, points);
+}
+
+bool MSOPParser::parsePacket(const uint8_t* data, size_t size, PointCloudSoA& cloud) {
+    // Room for every return of a full packet, so appending never reallocates mid-packet
+    cloud.reserve(cloud.size() + 12 * 16 * 2);
+    return parseInto(data, size, cloud);
+}
+
+size_t MSOPParser::parsePacket(const uint8_t* data, size_t size, LidarPoint* points, size_t capacity) {
+    PointSpan span = { points, capacity, 0 };
+    if (!parseInto(data, size, span)) {
+        return 0;
+    }
+    return span.count;
+}
+
+template <typename Output>
+bool MSOPParser::parseInto(const uint8_t* data, size_t size, Output& out) {
     // Validate packet size (should be 1206 bytes without UDP header)
-    if (size != sizeof(MSOPPacket)) {
+    if (!MSOPPacketView::isPacketSize(size)) {
         return false;
     }
     
-    // Cast data to MSOP packet structure
-    const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(data);
+    // Read the packet where it lies (receive buffer, ring slot or mmap'd capture)
+    MSOPPacketView packet(data);
     
     // Extract timestamp and factory info
-    last_timestamp_ = be32ToHost(packet->tail.timestamp);
-    last_factory_info_ = be16ToHost(packet->tail.factory_info);
+    last_timestamp_ = packet.timestamp();
+    last_factory_info_ = packet.factoryInfo();
     
     // Parse each data block
     for (int block_idx = 0; block_idx < 12; ++block_idx) {
-        const DataBlock* current_block = &packet->data_blocks[block_idx];
-        
         // Check if this is a valid data block
-        if (!isValidDataBlock(current_block)) {
+        if (!isValidDataBlock(packet, block_idx)) {
             // This might be the last packet with invalid blocks
             continue;
         }
         
-        uint16_t current_azimuth = be16ToHost(current_block->azimuth);
+        uint16_t current_azimuth = packet.blockAzimuth(block_idx);
         
         // Calculate next block azimuth for interpolation
         uint16_t next_azimuth = current_azimuth;
-        if (block_idx < 11) {
-            const DataBlock* next_block = &packet->data_blocks[block_idx + 1];
-            if (isValidDataBlock(next_block)) {
-                next_azimuth = be16ToHost(next_block->azimuth);
-            }
+        if (block_idx < 11 && isValidDataBlock(packet, block_idx + 1)) {
+            next_azimuth = packet.blockAzimuth(block_idx + 1);
         }
         
+        // Byte-swap and range-check all 16 measurements at once
+        DecodedBlock decoded;
+        decode_block_(reinterpret_cast<const DataBlock*>(packet.block(block_idx)), &decoded);
+        
         // Parse each measurement in the block
         for (int meas_idx = 0; meas_idx < 16; ++meas_idx) {
-            const MeasuringResult* measurement = &current_block->measurements[meas_idx];
-            
-            // Parse strongest return
-            uint16_t distance_strongest = be16ToHost(measurement->distance_strongest);
-            if (distance_strongest != 0 && distance_strongest != 0xFFFF) {
-                LidarPoint point;
-                point.azimuth = calculateAzimuth(current_azimuth, next_azimuth, meas_idx);
-                point.distance = distance_strongest / 1000.0f;  // Convert mm to meters
+            // Parse strongest return (distance gate already applied by the decoder)
+            if (decoded.strongest_mask & (1u << meas_idx)) {
+                float azimuth = calculateAzimuth(current_azimuth, next_azimuth, meas_idx);
+                float distance = decoded.distance_strongest[meas_idx] / 1000.0f;  // Convert mm to meters
                 
-                // Validate both azimuth and distance are within realistic ranges
-                if (isValidAzimuth(point.azimuth) && isValidDistance(point.distance)) {
-                    point.rssi = measurement->rssi_strongest;
-                    point.is_valid = true;
-                    point.is_strongest = true;
-                    points.push_back(point);
+                if (isValidAzimuth(azimuth)) {
+                    appendPoint(out, azimuth, distance, decoded.rssi_strongest[meas_idx], true);
                 }
             }
             
-            // Parse last return (if different from strongest)
-            uint16_t distance_last = be16ToHost(measurement->distance_last);
-            if (distance_last != 0 && distance_last != 0xFFFF && 
-                distance_last != distance_strongest) {
-                LidarPoint point;
-                point.azimuth = calculateAzimuth(current_azimuth, next_azimuth, meas_idx);
-                point.distance = distance_last / 1000.0f;  // Convert mm to meters
+            // Parse last return (decoder only sets it if different from strongest)
+            if (decoded.last_mask & (1u << meas_idx)) {
+                float azimuth = calculateAzimuth(current_azimuth, next_azimuth, meas_idx);
+                float distance = decoded.distance_last[meas_idx] / 1000.0f;  // Convert mm to meters
                 
-                // Validate both azimuth and distance are within realistic ranges
-                if (isValidAzimuth(point.azimuth) && isValidDistance(point.distance)) {
-                    point.rssi = measurement->rssi_last;
-                    point.is_valid = true;
-                    point.is_strongest = false;
-                    points.push_back(point);
+                if (isValidAzimuth(azimuth)) {
+                    appendPoint(out, azimuth, distance, decoded.rssi_last[meas_idx], false);
                 }
             }
         }
@@ -86,21 +136,7 @@ bool MSOPParser::parsePacket(const uint8_t* data, size_t size, std::vector<Lidar
 
 bool MSOPParser::isLastPacket(const MSOPPacket* packet) const {
     // Check if blocks 6-11 have invalid flags (0xFFFF)
-    for (int i = 6; i < 12; ++i) {
-        uint16_t flag = be16ToHost(packet->data_blocks[i].flag);
-        if (flag != 0xFFFF) {
-            return false;
-        }
-    }
-    return true;
-}
-
-uint16_t MSOPParser::be16ToHost(uint16_t value) const {
-    return ntohs(value);
-}
-
-uint32_t MSOPParser::be32ToHost(uint32_t value) const {
-    return ntohl(value);
+    return MSOPPacketView(reinterpret_cast<const uint8_t*>(packet)).isLastPacket();
 }
 
 float MSOPParser::calculateAzimuth(uint16_t block_azimuth, uint16_t next_block_azimuth, int measurement_index) const {
@@ -117,23 +153,15 @@ float MSOPParser::calculateAzimuth(uint16_t block_azimuth, uint16_t next_block_a
     // Simple addition: block_azimuth + (resolution * i)
     uint16_t calculated_azimuth = block_azimuth + (resolution * measurement_index);
     
-    // Convert to degrees and return
-    float azimuth_degrees = calculated_azimuth / 100.0f;
-    
-    // Normalize angle to 0-360 range
-    while (azimuth_degrees < 0.0f) azimuth_degrees += 360.0f;
-    while (azimuth_degrees >= 360.0f) azimuth_degrees -= 360.0f;
-    
-    return azimuth_degrees;
+    // Convert to degrees and normalize to the 0-360 range
+    return normalizeAzimuthDegrees(calculated_azimuth / 100.0f);
 }
 
-bool MSOPParser::isValidDataBlock(const DataBlock* block) const {
-    uint16_t flag = be16ToHost(block->flag);
-    uint16_t azimuth = be16ToHost(block->azimuth);
-    
+bool MSOPParser::isValidDataBlock(const MSOPPacketView& packet, int block) const {
     // Valid blocks should have flag 0xFFEE and azimuth != 0xFFFF
     // ROS2 driver doesn't check azimuth range here, so we'll be less strict
-    return (flag == 0xFFEE) && (azimuth != 0xFFFF);
+    return (packet.blockFlag(block) == MSOPPacketView::VALID_BLOCK_FLAG) &&
+           (packet.blockAzimuth(block) != 0xFFFF);
 }
 
 bool MSOPParser::isValidAzimuth(float azimuth) const {
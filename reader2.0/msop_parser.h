@@ -45,13 +45,40 @@ struct LidarPoint {
     bool is_strongest;      // True for strongest return, false for last return
 };
 
+// Fold an interpolated azimuth in degrees into [0, 360). MSOPParser and PolicyParser
+// both use this, so a corrupt block azimuth comes out the same from either parser.
+inline float normalizeAzimuthDegrees(float degrees) {
+    while (degrees < 0.0f) degrees += 360.0f;
+    while (degrees >= 360.0f) degrees -= 360.0f;
+    return degrees;
+}
+
+// Block decode kernel (scalar or SIMD), see msop_block_decoder.h
+struct DecodedBlock;
+typedef void (*BlockDecodeFn)(const DataBlock* block, DecodedBlock* out);
+
+class PointCloudSoA;
+class MSOPPacketView;
+
 class MSOPParser {
 public:
+    // 12 blocks x 16 measurements x 2 returns
+    static const size_t MAX_POINTS_PER_PACKET = 384;
+    
     MSOPParser();
     
     // Parse a single MSOP packet
     bool parsePacket(const uint8_t* data, size_t size, std::vector<LidarPoint>& points);
     
+    // Parse a single MSOP packet straight into columns. Points are appended,
+    // so a whole scan can be accumulated; clear() the cloud for per-packet output.
+    bool parsePacket(const uint8_t* data, size_t size, PointCloudSoA& cloud);
+    
+    // Allocation-free variant: writes into a caller-owned array and returns the number
+    // of points written (0 for a malformed packet). Points beyond capacity are dropped;
+    // a capacity of MAX_POINTS_PER_PACKET always fits a whole packet.
+    size_t parsePacket(const uint8_t* data, size_t size, LidarPoint* points, size_t capacity);
+    
     // Get timestamp from the last parsed packet
     uint32_t getLastTimestamp() const { return last_timestamp_; }
     
@@ -61,16 +88,19 @@ public:
     // Check if this is likely the last packet in a rotation
     bool isLastPacket(const MSOPPacket* packet) const;
     
-private:
-    // Convert big endian to host byte order
-    uint16_t be16ToHost(uint16_t value) const;
-    uint32_t be32ToHost(uint32_t value) const;
+    // Override the block decode kernel picked at startup (for testing and benchmarks)
+    void setBlockDecoder(BlockDecodeFn decoder) { decode_block_ = decoder; }
     
     // Calculate azimuth for a specific measurement within a block
     float calculateAzimuth(uint16_t block_azimuth, uint16_t next_block_azimuth, int measurement_index) const;
     
+private:
+    // Shared block loop; Output is std::vector<LidarPoint>, PointCloudSoA or a fixed span
+    template <typename Output>
+    bool parseInto(const uint8_t* data, size_t size, Output& out);
+    
     // Validate data block
-    bool isValidDataBlock(const DataBlock* block) const;
+    bool isValidDataBlock(const MSOPPacketView& packet, int block) const;
     
     // Check if azimuth is within valid 270° range (45° to 315°)
     bool isValidAzimuth(float azimuth) const;
@@ -80,6 +110,7 @@ private:
     
     uint32_t last_timestamp_;
     uint16_t last_factory_info_;
+    BlockDecodeFn decode_block_;
 };
 
 #endif // MSOP_PARSER_H
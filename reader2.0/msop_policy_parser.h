@@ -0,0 +1,161 @@
+#ifndef MSOP_POLICY_PARSER_H
+#define MSOP_POLICY_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "msop_parser.h"
+#include "msop_packet_view.h"
+
+// Compile-time specialized MSOP parser.
+//
+// MSOPParser decides the return mode, range gate and FOV gate at runtime for
+// every point. Those are fixed per deployment, so PolicyParser takes them as
+// template parameters: the gates become constants, the 16-measurement loop is
+// unrolled, and points are written with branch-free compaction (every
+// candidate is stored, the output index only advances if it passed).
+
+// Sensor traits: range gate in raw millimetres, FOV gate in degrees and the
+// azimuth step (0.01° units) used when the next block cannot be read.
+
+// Same gates as MSOPParser: 0.1-15 m, any azimuth
+struct LakiBeam1Traits {
+    static constexpr uint16_t MIN_RANGE_MM = 100;
+    static constexpr uint16_t MAX_RANGE_MM = 15000;
+    static constexpr float FOV_MIN_DEG = 0.0f;
+    static constexpr float FOV_MAX_DEG = 360.0f;
+    static constexpr int DEFAULT_RESOLUTION = 25;
+};
+
+// Only the 270° window the sensor actually scans (45°-315°)
+struct LakiBeam1Fov270Traits {
+    static constexpr uint16_t MIN_RANGE_MM = 100;
+    static constexpr uint16_t MAX_RANGE_MM = 15000;
+    static constexpr float FOV_MIN_DEG = 45.0f;
+    static constexpr float FOV_MAX_DEG = 315.0f;
+    static constexpr int DEFAULT_RESOLUTION = 25;
+};
+
+// Return policies: emit() stores the candidates for one measurement at
+// out[count] and returns the new count
+
+inline void writePoint(LidarPoint& point, float azimuth, uint16_t distance_mm, uint8_t rssi, bool is_strongest) {
+    point.azimuth = azimuth;
+    point.distance = distance_mm / 1000.0f;  // Convert mm to meters
+    point.rssi = rssi;
+    point.is_valid = true;
+    point.is_strongest = is_strongest;
+}
+
+// Strongest return only
+struct StrongestReturn {
+    static size_t emit(LidarPoint* out, size_t count, float azimuth,
+                       uint16_t strongest_mm, uint8_t strongest_rssi, bool strongest_ok,
+                       uint16_t, uint8_t, bool) {
+        writePoint(out[count], azimuth, strongest_mm, strongest_rssi, true);
+        return count + strongest_ok;
+    }
+};
+
+// Last return only (reported even when equal to the strongest)
+struct LastReturn {
+    static size_t emit(LidarPoint* out, size_t count, float azimuth,
+                       uint16_t, uint8_t, bool,
+                       uint16_t last_mm, uint8_t last_rssi, bool last_ok) {
+        writePoint(out[count], azimuth, last_mm, last_rssi, false);
+        return count + last_ok;
+    }
+};
+
+// Both returns, last suppressed when it repeats the strongest (what MSOPParser does)
+struct DualReturn {
+    static size_t emit(LidarPoint* out, size_t count, float azimuth,
+                       uint16_t strongest_mm, uint8_t strongest_rssi, bool strongest_ok,
+                       uint16_t last_mm, uint8_t last_rssi, bool last_ok) {
+        writePoint(out[count], azimuth, strongest_mm, strongest_rssi, true);
+        count += strongest_ok;
+        writePoint(out[count], azimuth, last_mm, last_rssi, false);
+        return count + (last_ok & (last_mm != strongest_mm));
+    }
+};
+
+// One point per measurement: whichever valid return has the higher RSSI (strongest on ties)
+struct MaxRssiReturn {
+    static size_t emit(LidarPoint* out, size_t count, float azimuth,
+                       uint16_t strongest_mm, uint8_t strongest_rssi, bool strongest_ok,
+                       uint16_t last_mm, uint8_t last_rssi, bool last_ok) {
+        bool use_last = last_ok & (!strongest_ok | (last_rssi > strongest_rssi));
+        writePoint(out[count], azimuth, use_last ? last_mm : strongest_mm,
+                   use_last ? last_rssi : strongest_rssi, !use_last);
+        return count + (strongest_ok | last_ok);
+    }
+};
+
+template <typename ReturnPolicy, typename SensorTraits>
+class PolicyParser {
+public:
+    PolicyParser() : last_timestamp_(0), last_factory_info_(0) {}
+
+    // Parse a single MSOP packet into points, which must hold
+    // MSOPParser::MAX_POINTS_PER_PACKET entries (candidates are written before
+    // they are accepted). Returns the number of points, 0 for a malformed packet.
+    size_t parsePacket(const uint8_t* data, size_t size, LidarPoint* points) {
+        if (!MSOPPacketView::isPacketSize(size)) {
+            return 0;
+        }
+        MSOPPacketView packet(data);
+        last_timestamp_ = packet.timestamp();
+        last_factory_info_ = packet.factoryInfo();
+
+        size_t count = 0;
+        for (int block_idx = 0; block_idx < 12; ++block_idx) {
+            if (!isValidBlock(packet, block_idx)) {
+                continue;
+            }
+
+            int current_azimuth = packet.blockAzimuth(block_idx);
+            int next_azimuth = current_azimuth;
+            if (block_idx < 11 && isValidBlock(packet, block_idx + 1)) {
+                next_azimuth = packet.blockAzimuth(block_idx + 1);
+            }
+            int resolution = (next_azimuth - current_azimuth) > 0
+                ? (next_azimuth - current_azimuth) / 16
+                : SensorTraits::DEFAULT_RESOLUTION;
+
+#pragma GCC unroll 16
+            for (int meas_idx = 0; meas_idx < 16; ++meas_idx) {
+                // Same arithmetic and normalization as MSOPParser::calculateAzimuth
+                uint16_t raw_azimuth = static_cast<uint16_t>(current_azimuth + resolution * meas_idx);
+                float azimuth = normalizeAzimuthDegrees(raw_azimuth / 100.0f);
+                bool fov_ok = (azimuth >= SensorTraits::FOV_MIN_DEG) & (azimuth <= SensorTraits::FOV_MAX_DEG);
+
+                uint16_t strongest_mm = packet.distanceStrongest(block_idx, meas_idx);
+                uint16_t last_mm = packet.distanceLast(block_idx, meas_idx);
+                uint8_t strongest_rssi = packet.rssiStrongest(block_idx, meas_idx);
+                uint8_t last_rssi = packet.rssiLast(block_idx, meas_idx);
+                count = ReturnPolicy::emit(points, count, azimuth,
+                                           strongest_mm, strongest_rssi, fov_ok & inRange(strongest_mm),
+                                           last_mm, last_rssi, fov_ok & inRange(last_mm));
+            }
+        }
+        return count;
+    }
+
+    uint32_t getLastTimestamp() const { return last_timestamp_; }
+    uint16_t getLastFactoryInfo() const { return last_factory_info_; }
+
+private:
+    static bool isValidBlock(const MSOPPacketView& packet, int block) {
+        return packet.blockFlag(block) == MSOPPacketView::VALID_BLOCK_FLAG && packet.blockAzimuth(block) != 0xFFFF;
+    }
+
+    // One unsigned compare covers both ends of the range gate
+    static bool inRange(uint16_t distance_mm) {
+        return static_cast<unsigned>(distance_mm - SensorTraits::MIN_RANGE_MM) <=
+               static_cast<unsigned>(SensorTraits::MAX_RANGE_MM - SensorTraits::MIN_RANGE_MM);
+    }
+
+    uint32_t last_timestamp_;
+    uint16_t last_factory_info_;
+};
+
+#endif // MSOP_POLICY_PARSER_H
@@ -0,0 +1,254 @@
+#include "packet_ring_receiver.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+
+// Ring geometry: 16 blocks of 256 KiB hold roughly 3000 MSOP frames
+static const unsigned int RING_BLOCK_SIZE = 1 << 18;
+static const unsigned int RING_BLOCK_COUNT = 16;
+static const unsigned int RING_FRAME_SIZE = 2048;
+static const unsigned int RING_BLOCK_TIMEOUT_MS = 10;  // Retire partly filled blocks after 10 ms
+
+LidarPacketRingReceiver::LidarPacketRingReceiver(const std::string& interface, int port)
+    : interface_(interface), port_(port), socket_fd_(-1),
+      ring_(NULL), ring_size_(0), ring_mapped_(false), block_size_(RING_BLOCK_SIZE), block_count_(RING_BLOCK_COUNT),
+      current_block_(0), block_open_(false), frames_left_(0), next_frame_(NULL) {
+}
+
+LidarPacketRingReceiver::~LidarPacketRingReceiver() {
+    if (ring_mapped_) {
+        munmap(ring_, ring_size_);
+    }
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+    }
+}
+
+bool LidarPacketRingReceiver::initialize() {
+    socket_fd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_IP));
+    if (socket_fd_ < 0) {
+        std::cerr << "Error creating packet socket (needs CAP_NET_RAW): " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Filter before binding so only MSOP traffic ever reaches the ring
+    if (!attachPortFilter()) {
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(socket_fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        std::cerr << "Error selecting TPACKET_V3: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = block_size_;
+    req.tp_block_nr = block_count_;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (block_size_ / RING_FRAME_SIZE) * block_count_;
+    req.tp_retire_blk_tov = RING_BLOCK_TIMEOUT_MS;
+    if (setsockopt(socket_fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        std::cerr << "Error creating receive ring: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    ring_size_ = static_cast<size_t>(block_size_) * block_count_;
+    void* ring = mmap(NULL, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, socket_fd_, 0);
+    if (ring == MAP_FAILED) {
+        // MAP_LOCKED can fail under RLIMIT_MEMLOCK; the ring still works unlocked
+        ring = mmap(NULL, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED, socket_fd_, 0);
+    }
+    if (ring == MAP_FAILED) {
+        std::cerr << "Error mapping receive ring: " << strerror(errno) << std::endl;
+        return false;
+    }
+    ring_ = static_cast<uint8_t*>(ring);
+    ring_mapped_ = true;
+
+    unsigned int if_index = if_nametoindex(interface_.c_str());
+    if (if_index == 0) {
+        std::cerr << "Unknown interface " << interface_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = if_index;
+    if (bind(socket_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Error binding packet socket to " << interface_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout << "TPACKET_V3 ring initialized on " << interface_ << " (UDP port " << port_ << ", "
+              << block_count_ << " x " << (block_size_ / 1024) << " KiB blocks)" << std::endl;
+    return true;
+}
+
+void LidarPacketRingReceiver::buildPortFilter(int port, struct sock_filter* code) {
+    // Classic BPF for "ip and udp dst port <port>" on Ethernet framing,
+    // skipping non-first IP fragments (they carry no UDP header)
+    const struct sock_filter program[PORT_FILTER_LENGTH] = {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),                     // EtherType
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 8),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),                     // IP protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),                     // Fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),                    // X = IP header length
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),                     // UDP destination port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(port), 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0x40000),                         // Accept whole frame
+        BPF_STMT(BPF_RET | BPF_K, 0),                               // Drop
+    };
+    memcpy(code, program, sizeof(program));
+}
+
+bool LidarPacketRingReceiver::attachPortFilter() {
+    struct sock_filter code[PORT_FILTER_LENGTH];
+    buildPortFilter(port_, code);
+
+    struct sock_fprog program;
+    program.len = PORT_FILTER_LENGTH;
+    program.filter = code;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0) {
+        std::cerr << "Error attaching port filter: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void LidarPacketRingReceiver::useRing(uint8_t* ring, unsigned int block_size, unsigned int block_count) {
+    ring_ = ring;
+    ring_size_ = static_cast<size_t>(block_size) * block_count;
+    ring_mapped_ = false;
+    block_size_ = block_size;
+    block_count_ = block_count;
+    current_block_ = 0;
+    block_open_ = false;
+}
+
+bool LidarPacketRingReceiver::waitForBlock(int timeout_ms) {
+    struct tpacket_block_desc* block =
+        reinterpret_cast<struct tpacket_block_desc*>(ring_ + current_block_ * block_size_);
+
+    while ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+        struct pollfd pfd;
+        pfd.fd = socket_fd_;
+        pfd.events = POLLIN | POLLERR;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                std::cerr << "Error polling receive ring: " << strerror(errno) << std::endl;
+            }
+            return false;  // Error, or a signal the caller may want to act on
+        }
+        if (ready == 0) {
+            return false;  // Timeout
+        }
+    }
+
+    // Pairs with the kernel's write barrier before it flips block_status
+    __sync_synchronize();
+
+    block_open_ = true;
+    frames_left_ = block->hdr.bh1.num_pkts;
+    next_frame_ = reinterpret_cast<const uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+    stats_.blocks++;
+    return true;
+}
+
+void LidarPacketRingReceiver::releaseBlock() {
+    struct tpacket_block_desc* block =
+        reinterpret_cast<struct tpacket_block_desc*>(ring_ + current_block_ * block_size_);
+
+    __sync_synchronize();
+    block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+    block_open_ = false;
+    current_block_ = (current_block_ + 1) % block_count_;
+}
+
+bool LidarPacketRingReceiver::nextPacket(const uint8_t*& payload, size_t& size, int timeout_ms) {
+    while (true) {
+        if (block_open_ && frames_left_ == 0) {
+            // Everything handed out from this block has been consumed; give it back
+            releaseBlock();
+        }
+        if (!block_open_ && !waitForBlock(timeout_ms)) {
+            return false;
+        }
+
+        while (frames_left_ > 0) {
+            const struct tpacket3_hdr* header = reinterpret_cast<const struct tpacket3_hdr*>(next_frame_);
+            const struct sockaddr_ll* link = reinterpret_cast<const struct sockaddr_ll*>(
+                next_frame_ + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+            const uint8_t* frame = next_frame_ + header->tp_mac;
+            size_t length = header->tp_snaplen;
+
+            next_frame_ += header->tp_next_offset;
+            frames_left_--;
+
+            // On loopback every datagram is seen twice: once outgoing, once incoming
+            if (link->sll_pkttype == PACKET_OUTGOING) {
+                continue;
+            }
+            if (extractPayload(frame, length, payload, size)) {
+                stats_.packets++;
+                return true;
+            }
+            stats_.skipped_frames++;
+        }
+    }
+}
+
+bool LidarPacketRingReceiver::extractPayload(const uint8_t* frame, size_t length,
+                                             const uint8_t*& payload, size_t& size) {
+    const size_t eth_header = 14;
+    if (length < eth_header + 20 + 8) {
+        return false;
+    }
+
+    const uint8_t* ip = frame + eth_header;
+    size_t ip_header = (ip[0] & 0x0F) * 4;
+    if ((ip[0] >> 4) != 4 || ip_header < 20 || length < eth_header + ip_header + 8) {
+        return false;
+    }
+
+    const uint8_t* udp = ip + ip_header;
+    size_t udp_length = (udp[4] << 8) | udp[5];
+    if (udp_length < 8 || eth_header + ip_header + udp_length > length) {
+        return false;  // Truncated or malformed frame
+    }
+
+    // For a standard 20-byte IP header this is the same 42-byte skip as the 1248-byte case
+    payload = udp + 8;
+    size = udp_length - 8;
+    return true;
+}
+
+const RingStats& LidarPacketRingReceiver::getStats() {
+    struct tpacket_stats_v3 kernel_stats;
+    socklen_t length = sizeof(kernel_stats);
+    memset(&kernel_stats, 0, sizeof(kernel_stats));
+    // Reading PACKET_STATISTICS resets the kernel counters, so accumulate
+    if (getsockopt(socket_fd_, SOL_PACKET, PACKET_STATISTICS, &kernel_stats, &length) == 0) {
+        stats_.kernel_drops += kernel_stats.tp_drops;
+    }
+    return stats_;
+}
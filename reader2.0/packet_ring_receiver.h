@@ -0,0 +1,75 @@
+#ifndef PACKET_RING_RECEIVER_H
+#define PACKET_RING_RECEIVER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <linux/filter.h>
+
+// Counters for the memory-mapped capture ring
+struct RingStats {
+    uint64_t blocks;            // Ring blocks handed to user space
+    uint64_t packets;           // MSOP payloads delivered
+    uint64_t skipped_frames;    // Frames that were not usable UDP payloads
+    uint64_t kernel_drops;      // Packets the kernel dropped because the ring was full
+
+    RingStats() : blocks(0), packets(0), skipped_frames(0), kernel_drops(0) {}
+};
+
+// Receives MSOP traffic through an AF_PACKET TPACKET_V3 ring instead of a UDP socket.
+// The kernel writes whole frames into a memory-mapped ring, so payloads are read in
+// place: no per-packet copy and no per-packet syscall (one poll() per ring block).
+// Needs CAP_NET_RAW. Works on a real NIC, a veth pair or "lo".
+class LidarPacketRingReceiver {
+public:
+    LidarPacketRingReceiver(const std::string& interface, int port = 2368);
+    ~LidarPacketRingReceiver();
+
+    bool initialize();
+
+    // Get the next UDP payload addressed to the MSOP port, waiting up to timeout_ms
+    // for the kernel to retire a ring block. The pointer refers to ring memory and
+    // stays valid until the next call. Returns false on timeout, a signal or error.
+    bool nextPacket(const uint8_t*& payload, size_t& size, int timeout_ms = 1000);
+
+    // Refresh kernel_drops from PACKET_STATISTICS and return all counters
+    const RingStats& getStats();
+
+    // Walk a ring in ordinary memory, laid out as the kernel lays out a TPACKET_V3
+    // ring, instead of a mapped one (tests). nextPacket() hands blocks back by
+    // setting their status to TP_STATUS_KERNEL, as with the kernel's ring.
+    void useRing(uint8_t* ring, unsigned int block_size, unsigned int block_count);
+
+    // Classic BPF program accepting "ip and udp dst port <port>" on Ethernet
+    // framing; code must hold PORT_FILTER_LENGTH instructions
+    static const unsigned int PORT_FILTER_LENGTH = 11;
+    static void buildPortFilter(int port, struct sock_filter* code);
+
+    // UDP payload of an Ethernet/IPv4 frame; false if truncated or malformed
+    static bool extractPayload(const uint8_t* frame, size_t length,
+                               const uint8_t*& payload, size_t& size);
+
+private:
+    bool attachPortFilter();
+    bool waitForBlock(int timeout_ms);
+    void releaseBlock();
+
+    std::string interface_;
+    int port_;
+    int socket_fd_;
+
+    uint8_t* ring_;             // mmap'ed ring of block_count_ blocks
+    size_t ring_size_;
+    bool ring_mapped_;          // false for a ring given to useRing()
+    unsigned int block_size_;
+    unsigned int block_count_;
+
+    unsigned int current_block_;    // Block currently owned by user space
+    bool block_open_;
+    uint32_t frames_left_;          // Frames not yet visited in the open block
+    const uint8_t* next_frame_;     // Next frame header in the open block
+
+    RingStats stats_;
+};
+
+#endif // PACKET_RING_RECEIVER_H
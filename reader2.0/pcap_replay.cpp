@@ -0,0 +1,105 @@
+#include "pcap_replay.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+LidarPcapReplay::LidarPcapReplay(const std::string& filename, int port)
+    : filename_(filename), port_(port), file_(NULL), file_size_(0),
+      speed_(1.0), first_timestamp_ns_(-1), start_ns_(0) {
+}
+
+LidarPcapReplay::~LidarPcapReplay() {
+    if (file_ != NULL) {
+        munmap(const_cast<uint8_t*>(file_), file_size_);
+    }
+}
+
+bool LidarPcapReplay::initialize() {
+    int fd = open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(PCAP_FILE_HEADER_SIZE)) {
+        std::cerr << filename_ << " is too short to be a pcap file" << std::endl;
+        close(fd);
+        return false;
+    }
+    file_size_ = st.st_size;
+
+    void* mapping = mmap(NULL, file_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    file_ = static_cast<const uint8_t*>(mapping);
+    madvise(mapping, file_size_, MADV_SEQUENTIAL);
+
+    std::string error;
+    if (!parser_.open(file_, file_size_, error)) {
+        std::cerr << filename_ << ": " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void LidarPcapReplay::setSpeed(double speed) {
+    speed_ = speed < 0.0 ? 0.0 : speed;
+    first_timestamp_ns_ = -1;  // Re-anchor the schedule at the next packet
+}
+
+bool LidarPcapReplay::nextPacket(const uint8_t*& payload, size_t& size, int64_t* timestamp_ns) {
+    const uint8_t* frame;
+    size_t length;
+    int64_t captured_ns;
+    while (parser_.nextRecord(frame, length, captured_ns)) {
+        if (!parser_.udpPayload(frame, length, static_cast<uint16_t>(port_), payload, size)) {
+            stats_.skipped_records++;
+            continue;
+        }
+        waitUntilDue(captured_ns);
+        if (timestamp_ns != NULL) {
+            *timestamp_ns = captured_ns;
+        }
+        stats_.packets++;
+        return true;
+    }
+    return false;
+}
+
+void LidarPcapReplay::waitUntilDue(int64_t timestamp_ns) {
+    if (speed_ == 0.0) {
+        return;
+    }
+    if (first_timestamp_ns_ < 0) {
+        first_timestamp_ns_ = timestamp_ns;
+        start_ns_ = monotonicNanos();
+        return;
+    }
+
+    int64_t due = start_ns_ + static_cast<int64_t>((timestamp_ns - first_timestamp_ns_) / speed_);
+    int64_t now = monotonicNanos();
+    if (due > now) {
+        struct timespec wake;
+        wake.tv_sec = due / 1000000000;
+        wake.tv_nsec = due % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {
+        }
+    } else if (now - due > 1000000) {
+        stats_.late_packets++;
+    }
+}
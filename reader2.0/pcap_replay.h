@@ -0,0 +1,58 @@
+#ifndef PCAP_REPLAY_H
+#define PCAP_REPLAY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "pcap_format.h"
+
+// Counters for a pcap replay
+struct ReplayStats {
+    uint64_t packets;           // MSOP payloads delivered
+    uint64_t skipped_records;   // Records that were not UDP to the MSOP port
+    uint64_t late_packets;      // Delivered more than 1 ms behind the capture's schedule
+
+    ReplayStats() : packets(0), skipped_records(0), late_packets(0) {}
+};
+
+// Replays MSOP traffic from a pcap file instead of a socket, so the parser can be
+// benchmarked and regression-tested offline on real captures.
+// The file is memory-mapped and payloads are handed out in place. Records are read
+// by the PcapParser shared with slam_lidar_cpp (classic pcap, microsecond or
+// nanosecond, either byte order, Ethernet, raw IP or Linux cooked framing), e.g.
+// files from tcpdump -w, --uring --record or slam_lidar_cpp's msop_pcap.
+class LidarPcapReplay {
+public:
+    LidarPcapReplay(const std::string& filename, int port = 2368);
+    ~LidarPcapReplay();
+
+    bool initialize();
+
+    // 1.0 = original timing, N = N times faster, 0 = as fast as possible
+    void setSpeed(double speed);
+
+    // Get the next UDP payload addressed to the MSOP port, sleeping until it is due.
+    // The pointer refers to the mapped file. Returns false at the end of the capture.
+    // timestamp_ns, if given, receives the capture time (ns since the epoch).
+    bool nextPacket(const uint8_t*& payload, size_t& size, int64_t* timestamp_ns = NULL);
+
+    const ReplayStats& getStats() const { return stats_; }
+
+private:
+    void waitUntilDue(int64_t timestamp_ns);
+
+    std::string filename_;
+    int port_;
+
+    const uint8_t* file_;       // mmap'ed capture
+    size_t file_size_;
+    PcapParser parser_;
+
+    double speed_;
+    int64_t first_timestamp_ns_;    // Capture time of the first delivered packet, -1 before
+    int64_t start_ns_;              // CLOCK_MONOTONIC when it was delivered
+
+    ReplayStats stats_;
+};
+
+#endif // PCAP_REPLAY_H
@@ -0,0 +1,108 @@
+#include "point_cloud_soa.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+void* alignedAlloc(size_t bytes) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, PointCloudSoA::ALIGNMENT, bytes ? bytes : PointCloudSoA::ALIGNMENT) != 0) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+template <typename T>
+void growColumn(T*& column, size_t size, size_t capacity) {
+    T* grown = static_cast<T*>(alignedAlloc(sizeof(T) * capacity));
+    if (column) {
+        memcpy(grown, column, sizeof(T) * size);
+        free(column);
+    }
+    column = grown;
+}
+
+} // namespace
+
+PointCloudSoA::PointCloudSoA()
+    : azimuth_(NULL), range_(NULL), rssi_(NULL), flags_(NULL), size_(0), capacity_(0) {
+}
+
+PointCloudSoA::PointCloudSoA(size_t capacity)
+    : azimuth_(NULL), range_(NULL), rssi_(NULL), flags_(NULL), size_(0), capacity_(0) {
+    reserve(capacity);
+}
+
+PointCloudSoA::~PointCloudSoA() {
+    release();
+}
+
+PointCloudSoA::PointCloudSoA(const PointCloudSoA& other)
+    : azimuth_(NULL), range_(NULL), rssi_(NULL), flags_(NULL), size_(0), capacity_(0) {
+    *this = other;
+}
+
+PointCloudSoA& PointCloudSoA::operator=(const PointCloudSoA& other) {
+    if (this != &other) {
+        clear();
+        reserve(other.size_);
+        memcpy(azimuth_, other.azimuth_, sizeof(float) * other.size_);
+        memcpy(range_, other.range_, sizeof(float) * other.size_);
+        memcpy(rssi_, other.rssi_, other.size_);
+        memcpy(flags_, other.flags_, other.size_);
+        size_ = other.size_;
+    }
+    return *this;
+}
+
+void PointCloudSoA::reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+        return;
+    }
+    growColumn(azimuth_, size_, capacity);
+    growColumn(range_, size_, capacity);
+    growColumn(rssi_, size_, capacity);
+    growColumn(flags_, size_, capacity);
+    capacity_ = capacity;
+}
+
+void PointCloudSoA::push_back(const LidarPoint& point) {
+    uint8_t flags = (point.is_valid ? POINT_FLAG_VALID : 0) | (point.is_strongest ? POINT_FLAG_STRONGEST : 0);
+    push_back(point.azimuth, point.distance, point.rssi, flags);
+}
+
+LidarPoint PointCloudSoA::point(size_t i) const {
+    LidarPoint point;
+    point.azimuth = azimuth_[i];
+    point.distance = range_[i];
+    point.rssi = rssi_[i];
+    point.is_valid = (flags_[i] & POINT_FLAG_VALID) != 0;
+    point.is_strongest = (flags_[i] & POINT_FLAG_STRONGEST) != 0;
+    return point;
+}
+
+size_t PointCloudSoA::compact(const uint8_t* keep) {
+    size_t out = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (keep[i]) {
+            azimuth_[out] = azimuth_[i];
+            range_[out] = range_[i];
+            rssi_[out] = rssi_[i];
+            flags_[out] = flags_[i];
+            out++;
+        }
+    }
+    size_ = out;
+    return size_;
+}
+
+void PointCloudSoA::release() {
+    free(azimuth_);
+    free(range_);
+    free(rssi_);
+    free(flags_);
+    azimuth_ = range_ = NULL;
+    rssi_ = flags_ = NULL;
+    size_ = capacity_ = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef POINT_CLOUD_SOA_H
+#define POINT_CLOUD_SOA_H
+
+#include <cstddef>
+#include <cstdint>
+#include "msop_parser.h"
+
+// Bits of PointCloudSoA::flags()
+static const uint8_t POINT_FLAG_VALID = 0x01;      // Point contains valid data
+static const uint8_t POINT_FLAG_STRONGEST = 0x02;  // Strongest return (clear: last return)
+
+// Point cloud stored as one column per field (structure of arrays).
+// Each column is a separate 64-byte aligned buffer, so a loop over azimuth or
+// range only touches that column and compiles to packed SIMD loads.
+class PointCloudSoA {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    PointCloudSoA();
+    explicit PointCloudSoA(size_t capacity);
+    ~PointCloudSoA();
+
+    PointCloudSoA(const PointCloudSoA& other);
+    PointCloudSoA& operator=(const PointCloudSoA& other);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    // Keeps the allocation so refilling the cloud does not touch the heap
+    void clear() { size_ = 0; }
+    void reserve(size_t capacity);
+
+    void push_back(float azimuth, float range, uint8_t rssi, uint8_t flags) {
+        if (size_ == capacity_) {
+            reserve(capacity_ ? capacity_ * 2 : 1024);
+        }
+        azimuth_[size_] = azimuth;
+        range_[size_] = range;
+        rssi_[size_] = rssi;
+        flags_[size_] = flags;
+        size_++;
+    }
+    void push_back(const LidarPoint& point);
+
+    // Append point i of another cloud
+    void push_back(const PointCloudSoA& other, size_t i) {
+        push_back(other.azimuth_[i], other.range_[i], other.rssi_[i], other.flags_[i]);
+    }
+
+    // Contiguous columns, valid for size() elements
+    float* azimuth() { return azimuth_; }          // Degrees
+    float* range() { return range_; }              // Meters
+    uint8_t* rssi() { return rssi_; }
+    uint8_t* flags() { return flags_; }            // POINT_FLAG_* bits
+    const float* azimuth() const { return azimuth_; }
+    const float* range() const { return range_; }
+    const uint8_t* rssi() const { return rssi_; }
+    const uint8_t* flags() const { return flags_; }
+
+    // Gather one point back into the array-of-structs form
+    LidarPoint point(size_t i) const;
+
+    // Drop every point whose keep[i] is zero, preserving order; returns the new size
+    size_t compact(const uint8_t* keep);
+
+private:
+    void release();
+
+    float* azimuth_;
+    float* range_;
+    uint8_t* rssi_;
+    uint8_t* flags_;
+    size_t size_;
+    size_t capacity_;
+};
+
+#endif // POINT_CLOUD_SOA_H
@@ -0,0 +1,205 @@
+#include "realtime.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+bool pinCurrentThread(const char* thread_name, int cpu) {
+    if (cpu < 0) {
+        return true;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpu >= CPU_SETSIZE || (cpus > 0 && cpu >= cpus)) {
+        std::cerr << thread_name << " thread: CPU " << cpu << " does not exist (" << cpus
+                  << " configured), leaving it unpinned" << std::endl;
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        // EINVAL here usually means the CPU is outside this process's cpuset
+        std::cerr << thread_name << " thread: cannot pin to CPU " << cpu << ": " << strerror(result)
+                  << ", leaving it unpinned" << std::endl;
+        return false;
+    }
+    std::cout << thread_name << " thread pinned to CPU " << cpu << std::endl;
+    return true;
+}
+
+bool setCurrentThreadFifo(const char* thread_name, int priority) {
+    if (priority <= 0) {
+        return true;
+    }
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        std::cerr << thread_name << " thread: cannot set SCHED_FIFO priority " << priority << ": "
+                  << strerror(result);
+        if (result == EPERM) {
+            std::cerr << " (needs CAP_SYS_NICE or RLIMIT_RTPRIO >= " << priority << ", e.g. ulimit -r "
+                      << priority << ")";
+        }
+        std::cerr << ", keeping the normal scheduler" << std::endl;
+        return false;
+    }
+    std::cout << thread_name << " thread running SCHED_FIFO priority " << priority << std::endl;
+    return true;
+}
+
+bool lockProcessMemory() {
+    // MCL_FUTURE also locks pages mapped later, but under a finite RLIMIT_MEMLOCK it
+    // turns allocations past the limit into failures; without root, lock only what exists
+    struct rlimit limit;
+    bool bounded = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && geteuid() != 0;
+    if (mlockall(bounded ? MCL_CURRENT : MCL_CURRENT | MCL_FUTURE) != 0) {
+        int error = errno;
+        std::cerr << "Cannot lock memory: " << strerror(error);
+        if (error == EPERM || error == ENOMEM) {
+            std::cerr << " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK, e.g. ulimit -l unlimited)";
+        }
+        std::cerr << ", pages may be swapped out" << std::endl;
+        return false;
+    }
+    if (bounded) {
+        std::cout << "Process memory locked; RLIMIT_MEMLOCK is finite, so later allocations are not" << std::endl;
+    } else {
+        std::cout << "Process memory locked" << std::endl;
+    }
+    return true;
+}
+
+void applyThreadRealtime(const char* thread_name, int cpu, int priority) {
+    pinCurrentThread(thread_name, cpu);
+    setCurrentThreadFifo(thread_name, priority);
+    prefaultStack();
+}
+
+void prefaultMemory(void* data, size_t size) {
+    if (data == NULL || size == 0) {
+        return;
+    }
+    // Write rather than read: a read of an untouched anonymous page maps the shared
+    // zero page and the first write still faults
+    static const size_t PAGE = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile char* bytes = static_cast<volatile char*>(data);
+    for (size_t offset = 0; offset < size; offset += PAGE) {
+        bytes[offset] = bytes[offset];
+    }
+    bytes[size - 1] = bytes[size - 1];
+}
+
+void prefaultStack() {
+    char stack[STACK_PREFAULT_SIZE];
+    memset(stack, 0, sizeof(stack));
+    // Keep the compiler from dropping the unused buffer
+    __asm__ __volatile__("" : : "r"(stack) : "memory");
+}
+
+SchedulingLatencyProbe::SchedulingLatencyProbe()
+    : running_(false), count_(0), p50_ns_(0), p99_ns_(0), p999_ns_(0), max_ns_(0) {
+}
+
+SchedulingLatencyProbe::~SchedulingLatencyProbe() {
+    stop();
+}
+
+void SchedulingLatencyProbe::start(int cpu, int priority, uint64_t period_ns) {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&SchedulingLatencyProbe::run, this, cpu, priority, period_ns);
+}
+
+void SchedulingLatencyProbe::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SchedulingLatencyProbe::measure(int cpu, int priority, uint64_t duration_ns, uint64_t period_ns) {
+    start(cpu, priority, period_ns);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(duration_ns));
+    stop();
+}
+
+void SchedulingLatencyProbe::run(int cpu, int priority, uint64_t period_ns) {
+    applyThreadRealtime("Latency probe", cpu, priority);
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running_) {
+        next.tv_nsec += static_cast<long>(period_ns);
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        // A signal interrupts the sleep; the deadline is absolute, so sleep again until the
+        // same one rather than skipping ahead a period
+        int result;
+        do {
+            result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        } while (result == EINTR && running_);
+        if (result != 0) {
+            break;      // Stopped while interrupted, or the clock cannot be used
+        }
+
+        uint64_t woke = PipelineLatency::now();
+        uint64_t target = static_cast<uint64_t>(next.tv_sec) * 1000000000ULL + next.tv_nsec;
+        histogram_.record(woke > target ? woke - target : 0);
+        if (histogram_.getCount() % SUMMARY_INTERVAL == 0) {
+            publish();
+        }
+
+        // After a long stall, restart from now instead of firing a burst of late wakeups
+        if (woke > target + 100 * period_ns) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+    }
+    publish();
+}
+
+void SchedulingLatencyProbe::publish() {
+    p50_ns_.store(histogram_.getPercentile(50.0), std::memory_order_relaxed);
+    p99_ns_.store(histogram_.getPercentile(99.0), std::memory_order_relaxed);
+    p999_ns_.store(histogram_.getPercentile(99.9), std::memory_order_relaxed);
+    max_ns_.store(histogram_.getMax(), std::memory_order_relaxed);
+    count_.store(histogram_.getCount(), std::memory_order_release);
+}
+
+SchedulingLatencyProbe::Summary SchedulingLatencyProbe::getSummary() const {
+    // Fields may come from neighbouring publishes; close enough for a status line
+    Summary summary;
+    summary.count = count_.load(std::memory_order_acquire);
+    summary.p50_ns = p50_ns_.load(std::memory_order_relaxed);
+    summary.p99_ns = p99_ns_.load(std::memory_order_relaxed);
+    summary.p999_ns = p999_ns_.load(std::memory_order_relaxed);
+    summary.max_ns = max_ns_.load(std::memory_order_relaxed);
+    return summary;
+}
+
+void SchedulingLatencyProbe::print(std::ostream& out) const {
+    Summary summary = getSummary();
+    if (summary.count == 0) {
+        return;
+    }
+    char line[160];
+    snprintf(line, sizeof(line),
+             "Scheduling latency (us): %llu wakeups, p50 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+             static_cast<unsigned long long>(summary.count),
+             summary.p50_ns / 1000.0, summary.p99_ns / 1000.0,
+             summary.p999_ns / 1000.0, summary.max_ns / 1000.0);
+    out << line;
+}
@@ -0,0 +1,86 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <thread>
+#include "latency_histogram.h"
+
+// Opt-in real-time settings for the receive and parse threads (--rt, --cpu)
+struct RealtimeOptions {
+    int priority;       // SCHED_FIFO priority 1-99; 0 = keep the normal scheduler
+    int receive_cpu;    // -1 = not pinned
+    int parse_cpu;      // -1 = not pinned; --threaded only
+    int probe_cpu;      // -1 = probe the receive CPU before receiving; else probe this CPU throughout
+
+    RealtimeOptions() : priority(0), receive_cpu(-1), parse_cpu(-1), probe_cpu(-1) {}
+    bool isEnabled() const { return priority > 0 || receive_cpu >= 0 || parse_cpu >= 0; }
+};
+
+// Each call applies one setting and prints the outcome. If a privilege or resource
+// limit is missing it prints what is needed and returns false; the caller carries on
+// without that setting.
+bool pinCurrentThread(const char* thread_name, int cpu);
+bool setCurrentThreadFifo(const char* thread_name, int priority);
+bool lockProcessMemory();           // Call once every thread exists, so their stacks are locked too
+
+// Pin and raise the calling thread as configured, then pre-fault its stack
+void applyThreadRealtime(const char* thread_name, int cpu, int priority);
+
+// Write every page so the first real use does not take a page fault
+void prefaultMemory(void* data, size_t size);
+void prefaultStack();               // STACK_PREFAULT_SIZE of the calling thread's stack
+
+static const size_t STACK_PREFAULT_SIZE = 256 * 1024;
+
+// Scheduling latency as cyclictest measures it: a thread sleeps to absolute
+// CLOCK_MONOTONIC deadlines and records how late it wakes. It must not share a CPU
+// with the receive or parse thread while they run, or it measures the wait it causes
+// them and they cause it. The probe thread owns the histogram and publishes a summary
+// every SUMMARY_INTERVAL samples, so other threads can read it without locking.
+class SchedulingLatencyProbe {
+public:
+    static const uint64_t DEFAULT_PERIOD_NS = 1000000;     // 1 kHz
+    static const uint64_t SUMMARY_INTERVAL = 1000;
+
+    struct Summary {
+        uint64_t count;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t max_ns;
+    };
+
+    SchedulingLatencyProbe();
+    ~SchedulingLatencyProbe();
+
+    // Runs until stop() or destruction; cpu -1 = unpinned, priority 0 = normal scheduler
+    void start(int cpu, int priority, uint64_t period_ns = DEFAULT_PERIOD_NS);
+    void stop();
+    // Probe for duration_ns on the calling thread's behalf and return once stopped
+    void measure(int cpu, int priority, uint64_t duration_ns, uint64_t period_ns = DEFAULT_PERIOD_NS);
+
+    Summary getSummary() const;
+    void print(std::ostream& out) const;
+
+private:
+    SchedulingLatencyProbe(const SchedulingLatencyProbe&);
+    SchedulingLatencyProbe& operator=(const SchedulingLatencyProbe&);
+
+    void run(int cpu, int priority, uint64_t period_ns);
+    void publish();
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+    LatencyHistogram histogram_;    // Probe thread only
+
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> p50_ns_;
+    std::atomic<uint64_t> p99_ns_;
+    std::atomic<uint64_t> p999_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+#endif // REALTIME_H
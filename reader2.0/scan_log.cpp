@@ -0,0 +1,234 @@
+#include "scan_log.h"
+#include "point_cloud_soa.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char FILE_MAGIC[8] = { 'M', 'S', 'O', 'P', 'S', 'C', 'A', 'N' };
+static const char INDEX_MAGIC[8] = { 'S', 'C', 'A', 'N', 'I', 'D', 'X', '1' };
+static const size_t CHUNK_ALIGNMENT = 16;
+
+// Bytes of a chunk with n points, including the header and tail padding
+static uint64_t chunkSize(uint64_t points) {
+    uint64_t size = sizeof(ScanLogChunkHeader) + points * (2 * sizeof(float) + 2);
+    return (size + CHUNK_ALIGNMENT - 1) & ~uint64_t(CHUNK_ALIGNMENT - 1);
+}
+
+static bool entryBefore(uint64_t timestamp_us, const ScanLogIndexEntry& entry) {
+    return timestamp_us < entry.timestamp_us;
+}
+
+ScanLogWriter::ScanLogWriter(const std::string& filename)
+    : filename_(filename), file_(NULL), offset_(0), last_timestamp_(0) {
+}
+
+ScanLogWriter::~ScanLogWriter() {
+    close();
+}
+
+bool ScanLogWriter::initialize() {
+    file_ = fopen(filename_.c_str(), "wb");
+    if (file_ == NULL) {
+        std::cerr << "Error creating " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    // Whole revolutions are written at once; a large buffer keeps that to a few write() calls
+    setvbuf(file_, NULL, _IOFBF, 1 << 20);
+
+    ScanLogFileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = SCAN_LOG_VERSION;
+    header.header_size = sizeof(header);
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::cerr << "Error writing " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    offset_ = sizeof(header);
+    return true;
+}
+
+bool ScanLogWriter::writeScan(const PointCloudSoA& scan, uint32_t timestamp) {
+    if (file_ == NULL) {
+        return false;
+    }
+
+    // The sensor's microsecond counter wraps every 2^32 us; carry the epoch across wraps
+    uint64_t epoch = last_timestamp_ & ~uint64_t(0xFFFFFFFF);
+    uint64_t unwrapped = epoch | timestamp;
+    if (!index_.empty() && unwrapped + 0x80000000ULL < last_timestamp_) {
+        unwrapped += 0x100000000ULL;
+    }
+    last_timestamp_ = unwrapped;
+
+    const size_t count = scan.size();
+    ScanLogChunkHeader header;
+    header.magic = SCAN_LOG_CHUNK_MAGIC;
+    header.point_count = static_cast<uint32_t>(count);
+    header.timestamp_us = unwrapped;
+
+    static const uint8_t padding[CHUNK_ALIGNMENT] = { 0 };
+    const uint64_t size = chunkSize(count);
+    const size_t used = sizeof(header) + count * (2 * sizeof(float) + 2);
+
+    if (fwrite(&header, sizeof(header), 1, file_) != 1 ||
+        fwrite(scan.azimuth(), sizeof(float), count, file_) != count ||
+        fwrite(scan.range(), sizeof(float), count, file_) != count ||
+        fwrite(scan.rssi(), 1, count, file_) != count ||
+        fwrite(scan.flags(), 1, count, file_) != count ||
+        fwrite(padding, 1, size - used, file_) != size - used) {
+        std::cerr << "Error writing " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    ScanLogIndexEntry entry;
+    entry.timestamp_us = unwrapped;
+    entry.offset = offset_;
+    index_.push_back(entry);
+    offset_ += size;
+    return true;
+}
+
+bool ScanLogWriter::close() {
+    if (file_ == NULL) {
+        return true;
+    }
+
+    ScanLogTrailer trailer;
+    trailer.index_offset = offset_;
+    trailer.scan_count = index_.size();
+    memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+
+    bool ok = (index_.empty() ||
+               fwrite(&index_[0], sizeof(ScanLogIndexEntry), index_.size(), file_) == index_.size()) &&
+              fwrite(&trailer, sizeof(trailer), 1, file_) == 1;
+    ok = (fclose(file_) == 0) && ok;
+    file_ = NULL;
+    if (!ok) {
+        std::cerr << "Error finishing " << filename_ << ": " << strerror(errno) << std::endl;
+    }
+    return ok;
+}
+
+ScanLogReader::ScanLogReader(const std::string& filename)
+    : filename_(filename), file_(NULL), file_size_(0), index_(NULL), scan_count_(0) {
+}
+
+ScanLogReader::~ScanLogReader() {
+    if (file_ != NULL) {
+        munmap(const_cast<uint8_t*>(file_), file_size_);
+    }
+}
+
+bool ScanLogReader::initialize() {
+    int fd = open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(ScanLogFileHeader))) {
+        std::cerr << filename_ << " is too short to be a scan log" << std::endl;
+        close(fd);
+        return false;
+    }
+    file_size_ = st.st_size;
+
+    void* mapping = mmap(NULL, file_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping " << filename_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    file_ = static_cast<const uint8_t*>(mapping);
+
+    const ScanLogFileHeader* header = reinterpret_cast<const ScanLogFileHeader*>(file_);
+    if (memcmp(header->magic, FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SCAN_LOG_VERSION) {
+        std::cerr << filename_ << " is not a version " << SCAN_LOG_VERSION << " scan log" << std::endl;
+        return false;
+    }
+
+    // Only the trailer and the index are read here; chunks are paged in when accessed
+    if (file_size_ >= sizeof(ScanLogFileHeader) + sizeof(ScanLogTrailer)) {
+        const ScanLogTrailer* trailer =
+            reinterpret_cast<const ScanLogTrailer*>(file_ + file_size_ - sizeof(ScanLogTrailer));
+        if (memcmp(trailer->magic, INDEX_MAGIC, sizeof(trailer->magic)) == 0 &&
+            trailer->index_offset + trailer->scan_count * sizeof(ScanLogIndexEntry) ==
+                file_size_ - sizeof(ScanLogTrailer)) {
+            index_ = reinterpret_cast<const ScanLogIndexEntry*>(file_ + trailer->index_offset);
+            scan_count_ = trailer->scan_count;
+            return true;
+        }
+    }
+
+    std::cerr << filename_ << " has no index (recording was interrupted), rebuilding it" << std::endl;
+    return rebuildIndex();
+}
+
+bool ScanLogReader::rebuildIndex() {
+    uint64_t offset = sizeof(ScanLogFileHeader);
+    while (offset + sizeof(ScanLogChunkHeader) <= file_size_) {
+        const ScanLogChunkHeader* chunk = reinterpret_cast<const ScanLogChunkHeader*>(file_ + offset);
+        if (chunk->magic != SCAN_LOG_CHUNK_MAGIC || offset + chunkSize(chunk->point_count) > file_size_) {
+            break;  // Truncated last chunk
+        }
+        ScanLogIndexEntry entry;
+        entry.timestamp_us = chunk->timestamp_us;
+        entry.offset = offset;
+        rebuilt_index_.push_back(entry);
+        offset += chunkSize(chunk->point_count);
+    }
+
+    index_ = rebuilt_index_.empty() ? NULL : &rebuilt_index_[0];
+    scan_count_ = rebuilt_index_.size();
+    return true;
+}
+
+size_t ScanLogReader::findScan(uint64_t timestamp_us) const {
+    const ScanLogIndexEntry* after = std::upper_bound(index_, index_ + scan_count_, timestamp_us, entryBefore);
+    return after == index_ ? 0 : static_cast<size_t>(after - index_) - 1;
+}
+
+bool ScanLogReader::getScan(size_t scan, ScanLogScan& out) const {
+    if (scan >= scan_count_) {
+        return false;
+    }
+    const uint64_t offset = index_[scan].offset;
+    if (offset + sizeof(ScanLogChunkHeader) > file_size_) {
+        return false;
+    }
+    const ScanLogChunkHeader* chunk = reinterpret_cast<const ScanLogChunkHeader*>(file_ + offset);
+    if (chunk->magic != SCAN_LOG_CHUNK_MAGIC || offset + chunkSize(chunk->point_count) > file_size_) {
+        std::cerr << filename_ << ": corrupt revolution " << scan << std::endl;
+        return false;
+    }
+
+    const size_t count = chunk->point_count;
+    const uint8_t* columns = file_ + offset + sizeof(ScanLogChunkHeader);
+    out.timestamp_us = chunk->timestamp_us;
+    out.size = count;
+    out.azimuth = reinterpret_cast<const float*>(columns);
+    out.range = reinterpret_cast<const float*>(columns + count * sizeof(float));
+    out.rssi = columns + 2 * count * sizeof(float);
+    out.flags = out.rssi + count;
+    return true;
+}
+
+bool ScanLogReader::loadScan(size_t scan, PointCloudSoA& cloud) const {
+    ScanLogScan view;
+    if (!getScan(scan, view)) {
+        return false;
+    }
+    cloud.clear();
+    cloud.reserve(view.size);
+    for (size_t i = 0; i < view.size; ++i) {
+        cloud.push_back(view.azimuth[i], view.range[i], view.rssi[i], view.flags[i]);
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef SCAN_LOG_H
+#define SCAN_LOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class PointCloudSoA;
+
+// Binary log of assembled revolutions, a compact replacement for CSV on long runs.
+//
+// File layout (host byte order, little-endian on every supported target):
+//   ScanLogFileHeader
+//   per revolution: ScanLogChunkHeader, then the columns
+//                   float azimuth[n], float range[n], uint8 rssi[n], uint8 flags[n],
+//                   zero-padded to a multiple of 16 bytes
+//   ScanLogIndexEntry[scan_count], sorted by timestamp
+//   ScanLogTrailer
+//
+// Timestamps are the MSOPTail::timestamp of each revolution's first packet, unwrapped
+// to 64 bits so a run longer than the sensor's 71-minute counter period stays ordered.
+
+struct ScanLogFileHeader {
+    char magic[8];              // "MSOPSCAN"
+    uint32_t version;
+    uint32_t header_size;
+};
+
+struct ScanLogChunkHeader {
+    uint32_t magic;             // SCAN_LOG_CHUNK_MAGIC
+    uint32_t point_count;
+    uint64_t timestamp_us;
+};
+
+struct ScanLogIndexEntry {
+    uint64_t timestamp_us;
+    uint64_t offset;            // File offset of the ScanLogChunkHeader
+};
+
+struct ScanLogTrailer {
+    uint64_t index_offset;
+    uint64_t scan_count;
+    char magic[8];              // "SCANIDX1"
+};
+
+static const uint32_t SCAN_LOG_VERSION = 1;
+static const uint32_t SCAN_LOG_CHUNK_MAGIC = 0x4E414353;  // "SCAN"
+
+// One revolution as pointers into the mapped log, valid while the reader lives
+struct ScanLogScan {
+    uint64_t timestamp_us;
+    size_t size;
+    const float* azimuth;       // Degrees
+    const float* range;         // Meters
+    const uint8_t* rssi;
+    const uint8_t* flags;       // POINT_FLAG_* bits
+};
+
+// Appends revolutions to a scan log. Each column is written straight from the
+// PointCloudSoA buffers; the index is written by close() (or the destructor).
+class ScanLogWriter {
+public:
+    ScanLogWriter(const std::string& filename);
+    ~ScanLogWriter();
+
+    bool initialize();
+
+    // timestamp is the raw MSOPTail::timestamp of the revolution's first packet
+    bool writeScan(const PointCloudSoA& scan, uint32_t timestamp);
+
+    // Write the index and trailer and close the file
+    bool close();
+
+    size_t getScanCount() const { return index_.size(); }
+
+private:
+    std::string filename_;
+    FILE* file_;
+    uint64_t offset_;
+    uint64_t last_timestamp_;   // Unwrapped timestamp of the previous revolution
+    std::vector<ScanLogIndexEntry> index_;
+};
+
+// Memory-maps a scan log and finds revolutions by timestamp in O(log n) through the
+// footer index, without touching the data in front of them. A log whose writer was
+// killed before close() has no index; it is rebuilt by walking the chunk headers.
+class ScanLogReader {
+public:
+    ScanLogReader(const std::string& filename);
+    ~ScanLogReader();
+
+    bool initialize();
+
+    size_t getScanCount() const { return scan_count_; }
+    uint64_t getTimestamp(size_t scan) const { return index_[scan].timestamp_us; }
+
+    // Revolution in progress at timestamp_us: the last one starting at or before it
+    // (0 if the time precedes the log). Only valid when getScanCount() > 0.
+    size_t findScan(uint64_t timestamp_us) const;
+
+    // Zero-copy view of a revolution
+    bool getScan(size_t scan, ScanLogScan& out) const;
+
+    // Copy a revolution into a point cloud (replacing its contents)
+    bool loadScan(size_t scan, PointCloudSoA& cloud) const;
+
+    bool isIndexRebuilt() const { return !rebuilt_index_.empty(); }
+
+private:
+    bool rebuildIndex();
+
+    std::string filename_;
+    const uint8_t* file_;       // mmap'ed log
+    size_t file_size_;
+    const ScanLogIndexEntry* index_;
+    size_t scan_count_;
+    std::vector<ScanLogIndexEntry> rebuilt_index_;
+};
+
+#endif // SCAN_LOG_H
@@ -0,0 +1,147 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const size_t CACHE_LINE_SIZE = 64;
+
+// Fixed-capacity, lock-free ring for exactly one producer thread and one consumer thread.
+// The producer fills slots in place (acquire/publish) so packets go straight from the
+// socket into the ring; the consumer reads them in place (front/pop).
+// Head and tail live on separate cache lines so the two threads never share one.
+// An idle consumer can block in waitForData(); the producer then pays one futex
+// wake per publish() until the consumer is back, and otherwise only a fence.
+template <typename T, size_t Capacity>
+class SPSCRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    // Otherwise the slot being filled and the slot being read can share a cache line
+    static_assert(sizeof(T) % CACHE_LINE_SIZE == 0, "Slot size must be a multiple of CACHE_LINE_SIZE; use alignas");
+
+public:
+    SPSCRing()
+        : head_(0), cached_tail_(0), tail_(0), cached_head_(0), high_water_(0), dropped_(0),
+          consumer_waiting_(0), wake_sequence_(0) {
+        void* memory = NULL;
+        if (posix_memalign(&memory, CACHE_LINE_SIZE, sizeof(T) * Capacity) != 0) {
+            throw std::bad_alloc();
+        }
+        slots_ = static_cast<T*>(memory);
+    }
+
+    ~SPSCRing() {
+        free(slots_);
+    }
+
+    // Producer: slot to fill next, or NULL when the ring is full
+    T* acquire() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == Capacity) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == Capacity) {
+                return NULL;
+            }
+        }
+        return &slots_[head & (Capacity - 1)];
+    }
+
+    // Producer: make the slot returned by acquire() visible to the consumer
+    void publish() {
+        size_t head = head_.load(std::memory_order_relaxed) + 1;
+        head_.store(head, std::memory_order_release);
+
+        // Orders the head store before the waiting check; waitForData() fences the other way
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_waiting_.load(std::memory_order_relaxed) != 0) {
+            wake_sequence_.fetch_add(1, std::memory_order_release);
+            syscall(SYS_futex, &wake_sequence_, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        }
+
+        // cached_tail_ may be stale, so only refresh it when a new maximum seems likely
+        size_t used = head - cached_tail_;
+        if (used > high_water_.load(std::memory_order_relaxed)) {
+            used = head - tail_.load(std::memory_order_relaxed);
+            if (used > high_water_.load(std::memory_order_relaxed)) {
+                high_water_.store(used, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Producer: count a packet that was discarded because acquire() found the ring full
+    void recordDrop() {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Consumer: oldest published slot, or NULL when the ring is empty
+    const T* front() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) {
+                return NULL;
+            }
+        }
+        return &slots_[tail & (Capacity - 1)];
+    }
+
+    // Consumer: block until a slot is published or timeout_ns passes (signals and
+    // spurious wakeups also return early); true if the ring is no longer empty
+    bool waitForData(long timeout_ns) {
+        uint32_t sequence = wake_sequence_.load(std::memory_order_acquire);
+        consumer_waiting_.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (front() == NULL) {
+            struct timespec timeout;
+            timeout.tv_sec = timeout_ns / 1000000000L;
+            timeout.tv_nsec = timeout_ns % 1000000000L;
+            syscall(SYS_futex, &wake_sequence_, FUTEX_WAIT_PRIVATE, sequence, &timeout, NULL, 0);
+        }
+        consumer_waiting_.store(0, std::memory_order_relaxed);
+        return front() != NULL;
+    }
+
+    // Consumer: hand the slot returned by front() back to the producer
+    void pop() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Statistics, safe to read from either thread
+    size_t capacity() const { return Capacity; }
+    size_t highWaterMark() const { return high_water_.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Slot memory, for pre-faulting before either thread starts
+    void* storage() { return slots_; }
+    size_t storageSize() const { return sizeof(T) * Capacity; }
+
+private:
+    SPSCRing(const SPSCRing&);
+    SPSCRing& operator=(const SPSCRing&);
+
+    // Producer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+    size_t cached_tail_;
+
+    // Consumer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+    size_t cached_head_;
+
+    // Producer-written counters, read by the consumer for reporting
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> high_water_;
+    std::atomic<uint64_t> dropped_;
+
+    // Consumer sets the flag before it sleeps on the sequence, the producer bumps it to wake it
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> consumer_waiting_;
+    std::atomic<uint32_t> wake_sequence_;
+
+    alignas(CACHE_LINE_SIZE) T* slots_;
+};
+
+#endif // SPSC_RING_H
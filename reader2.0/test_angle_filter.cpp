@@ -0,0 +1,237 @@
+#include "angle_bin_filter.h"
+#include "point_cloud_soa.h"
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Random samples clustered per bin: mostly near a per-bin range, with outliers and
+// weak returns, so every branch of the filter rules is taken
+static void makeSamples(PointCloudSoA& samples, int count) {
+    std::vector<float> base(StreamingAngleFilter::BIN_COUNT);
+    for (size_t i = 0; i < base.size(); ++i) {
+        base[i] = 0.5f + (rand() % 1300) / 100.0f;
+    }
+    for (int i = 0; i < count; ++i) {
+        int bin = rand() % StreamingAngleFilter::BIN_COUNT;
+        float azimuth = bin / 2.0f + (rand() % 50) / 100.0f;
+        float range = base[bin] * (0.9f + (rand() % 20) / 100.0f);
+        if (rand() % 8 == 0) {
+            range = 0.2f + (rand() % 1300) / 100.0f;
+        }
+        uint8_t rssi = static_cast<uint8_t>(16 + rand() % 60);
+        samples.push_back(azimuth, range, rssi, POINT_FLAG_VALID | (rand() % 2 ? POINT_FLAG_STRONGEST : 0));
+    }
+}
+
+static bool sameCloud(const PointCloudSoA& a, const PointCloudSoA& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.azimuth()[i] != b.azimuth()[i] || a.range()[i] != b.range()[i] ||
+            a.rssi()[i] != b.rssi()[i] || a.flags()[i] != b.flags()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batch filter over the newest WINDOW samples of each bin, which is what the
+// streaming filter should hold
+static void batchOverWindow(const PointCloudSoA& samples, PointCloudSoA& out, AngleBinFilterStats& stats) {
+    std::vector<int> seen(StreamingAngleFilter::BIN_COUNT, 0);
+    std::vector<uint8_t> keep(samples.size(), 0);
+    for (size_t i = samples.size(); i-- > 0;) {
+        int bin = static_cast<int>(samples.azimuth()[i] * 2.0f);
+        if (seen[bin]++ < StreamingAngleFilter::WINDOW) {
+            keep[i] = 1;
+        }
+    }
+    PointCloudSoA recent(samples);
+    recent.compact(&keep[0]);
+    std::vector<uint16_t> bins(recent.size());
+    for (size_t i = 0; i < recent.size(); ++i) {
+        bins[i] = static_cast<uint16_t>(recent.azimuth()[i] * 2.0f);
+    }
+    filterAngleBins(recent, bins.empty() ? NULL : &bins[0], out, stats);
+}
+
+static bool check(const char* name, StreamingAngleFilter& filter, const PointCloudSoA& samples) {
+    PointCloudSoA expected, actual;
+    AngleBinFilterStats expected_stats, actual_stats;
+    batchOverWindow(samples, expected, expected_stats);
+    filter.writeFiltered(actual, actual_stats);
+
+    bool ok = sameCloud(expected, actual) &&
+              expected_stats.total_samples == actual_stats.total_samples &&
+              expected_stats.filtered_bins == actual_stats.filtered_bins &&
+              expected_stats.multi_sample_bins == actual_stats.multi_sample_bins &&
+              expected_stats.two_sample_bins == actual_stats.two_sample_bins &&
+              expected_stats.single_sample_bins == actual_stats.single_sample_bins;
+    std::cout << name << ": " << samples.size() << " samples, " << actual.size() << " points, "
+              << actual_stats.filtered_bins << " bins filtered - " << (ok ? "match" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+// Reference for SlidingWindowDenoiser: keep the last N revolutions as plain sample
+// lists and sort each bin's window afresh, with the same 2 cm range quantization
+static void referenceDenoise(const std::deque<PointCloudSoA>& window, PointCloudSoA& out,
+                             AngleBinFilterStats& stats) {
+    const int bins = SlidingWindowDenoiser::BIN_COUNT;
+    const float bucket_m = SlidingWindowDenoiser::RANGE_BUCKET_MM / 1000.0f;
+    std::vector<std::vector<uint16_t> > ranges(bins), rssi(bins);
+    std::vector<std::vector<size_t> > current(bins);
+    for (size_t r = 0; r < window.size(); ++r) {
+        const PointCloudSoA& revolution = window[r];
+        std::vector<int> per_bin(bins, 0);
+        for (size_t i = 0; i < revolution.size(); ++i) {
+            int bin = static_cast<int>(revolution.azimuth()[i] * 2.0f) % bins;
+            if (per_bin[bin]++ >= SlidingWindowDenoiser::MAX_SAMPLES_PER_BIN) {
+                continue;
+            }
+            int bucket = static_cast<int>(revolution.range()[i] * (1000.0f / SlidingWindowDenoiser::RANGE_BUCKET_MM));
+            ranges[bin].push_back(static_cast<uint16_t>(std::min(bucket, SlidingWindowDenoiser::RANGE_BUCKETS - 1)));
+            rssi[bin].push_back(revolution.rssi()[i]);
+            if (r + 1 == window.size()) {
+                current[bin].push_back(i);
+            }
+        }
+    }
+
+    const PointCloudSoA& now = window.back();
+    stats = AngleBinFilterStats();
+    for (int bin = 0; bin < bins; ++bin) {
+        const std::vector<size_t>& samples = current[bin];
+        if (samples.empty()) {
+            continue;
+        }
+        stats.total_samples += samples.size();
+        size_t count = ranges[bin].size();
+        long best = -1;
+        if (count >= 3) {
+            stats.multi_sample_bins++;
+            std::sort(ranges[bin].begin(), ranges[bin].end());
+            std::sort(rssi[bin].begin(), rssi[bin].end());
+            float median_distance = (ranges[bin][count / 2] + 0.5f) * bucket_m;
+            float median_rssi = rssi[bin][count / 2];
+            float best_diff = 0.0f;
+            for (size_t k = 0; k < samples.size() && median_rssi > 20; ++k) {
+                size_t i = samples[k];
+                float diff = std::abs(now.range()[i] - median_distance);
+                if (diff / median_distance > 0.50f || now.rssi()[i] < median_rssi * 0.7f) {
+                    continue;
+                }
+                bool better = best < 0 ||
+                              (std::abs(diff - best_diff) < 0.1f ? now.rssi()[i] > now.rssi()[best] : diff < best_diff);
+                if (better) {
+                    best = static_cast<long>(i);
+                    best_diff = diff;
+                }
+            }
+        } else if (count == 2) {
+            stats.two_sample_bins++;
+            if (samples.size() == 2) {
+                size_t a = samples[0], b = samples[1];
+                float average = (now.range()[a] + now.range()[b]) / 2.0f;
+                if (std::abs(now.range()[a] - now.range()[b]) / average <= 0.30f &&
+                    std::min(now.rssi()[a], now.rssi()[b]) > 20) {
+                    best = static_cast<long>(now.rssi()[a] > now.rssi()[b] ? a : b);
+                }
+            } else if (now.rssi()[samples[0]] > 25) {
+                best = static_cast<long>(samples[0]);
+            }
+        } else {
+            stats.single_sample_bins++;
+            if (now.rssi()[samples[0]] > 25) {
+                best = static_cast<long>(samples[0]);
+            }
+        }
+        if (best >= 0) {
+            out.push_back(now, best);
+        } else {
+            stats.filtered_bins++;
+        }
+    }
+}
+
+static bool checkDenoiser(int revolutions, int samples_per_revolution, int rounds) {
+    SlidingWindowDenoiser denoiser(revolutions);
+    std::deque<PointCloudSoA> window;
+    int mismatches = 0;
+    size_t points = 0;
+    for (int round = 0; round < rounds; ++round) {
+        PointCloudSoA revolution;
+        makeSamples(revolution, samples_per_revolution);
+        denoiser.addPoints(revolution);
+        window.push_back(revolution);
+        if (static_cast<int>(window.size()) > revolutions) {
+            window.pop_front();
+        }
+
+        PointCloudSoA expected, actual;
+        AngleBinFilterStats expected_stats, actual_stats;
+        referenceDenoise(window, expected, expected_stats);
+        denoiser.finishRevolution(actual, actual_stats);
+        points += actual.size();
+        if (!sameCloud(expected, actual) ||
+            expected_stats.total_samples != actual_stats.total_samples ||
+            expected_stats.filtered_bins != actual_stats.filtered_bins ||
+            expected_stats.multi_sample_bins != actual_stats.multi_sample_bins ||
+            expected_stats.two_sample_bins != actual_stats.two_sample_bins ||
+            expected_stats.single_sample_bins != actual_stats.single_sample_bins) {
+            mismatches++;
+        }
+    }
+    std::cout << "Denoiser N=" << revolutions << ": " << rounds << " revolutions of " << samples_per_revolution
+              << " samples, " << points / rounds << " points each - "
+              << (mismatches ? "MISMATCH" : "match") << std::endl;
+    return mismatches == 0;
+}
+
+int main() {
+    srand(5);
+    bool ok = true;
+
+    // Few samples per bin: nothing leaves the window, so this is filterAngleBins() exactly
+    StreamingAngleFilter filter;
+    PointCloudSoA samples;
+    makeSamples(samples, 2000);
+    filter.addPoints(samples);
+    ok &= check("Sparse (1-3 per bin)", filter, samples);
+
+    // Keep adding past the window size, taking output along the way
+    for (int round = 0; round < 8; ++round) {
+        PointCloudSoA more;
+        makeSamples(more, 5000);
+        filter.addPoints(more);
+        for (size_t i = 0; i < more.size(); ++i) {
+            samples.push_back(more, i);
+        }
+        if (round % 3 == 2) {
+            ok &= check("Window overflowing", filter, samples);
+        }
+    }
+    ok &= check("Window overflowing", filter, samples);
+
+    filter.reset();
+    PointCloudSoA none;
+    ok &= check("After reset", filter, none);
+
+    // Sliding-window denoiser against sorting the whole window every revolution:
+    // sparse revolutions reach the pair and single-sample rules, and the window wraps
+    ok &= checkDenoiser(1, 1500, 6);
+    ok &= checkDenoiser(5, 800, 20);
+    ok &= checkDenoiser(12, 1500, 40);
+    ok &= checkDenoiser(3, 20000, 8);   // Over MAX_SAMPLES_PER_BIN in some bins
+
+    if (!ok) {
+        std::cout << "Angle filter FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "Streaming angle filter matches filterAngleBins over each bin's window." << std::endl;
+    std::cout << "Sliding-window denoiser matches sorting the last N revolutions." << std::endl;
+    return 0;
+}
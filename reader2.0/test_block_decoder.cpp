@@ -0,0 +1,154 @@
+#include "msop_parser.h"
+#include "msop_block_decoder.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <arpa/inet.h>
+
+// The per-point parse loop as it was before the block decoders, kept as the reference
+static void referenceParse(const MSOPPacket* packet, std::vector<LidarPoint>& points) {
+    points.clear();
+    for (int block_idx = 0; block_idx < 12; ++block_idx) {
+        const DataBlock* current_block = &packet->data_blocks[block_idx];
+        if (ntohs(current_block->flag) != 0xFFEE || ntohs(current_block->azimuth) == 0xFFFF) {
+            continue;
+        }
+        uint16_t current_azimuth = ntohs(current_block->azimuth);
+        uint16_t next_azimuth = current_azimuth;
+        if (block_idx < 11) {
+            const DataBlock* next_block = &packet->data_blocks[block_idx + 1];
+            if (ntohs(next_block->flag) == 0xFFEE && ntohs(next_block->azimuth) != 0xFFFF) {
+                next_azimuth = ntohs(next_block->azimuth);
+            }
+        }
+        int resolution = (next_azimuth - current_azimuth) > 0 ? (next_azimuth - current_azimuth) / 16 : 25;
+
+        for (int meas_idx = 0; meas_idx < 16; ++meas_idx) {
+            const MeasuringResult* measurement = &current_block->measurements[meas_idx];
+            uint16_t raw_azimuth = current_azimuth + (resolution * meas_idx);
+            float azimuth = raw_azimuth / 100.0f;
+            while (azimuth >= 360.0f) azimuth -= 360.0f;
+
+            uint16_t distance_strongest = ntohs(measurement->distance_strongest);
+            if (distance_strongest != 0 && distance_strongest != 0xFFFF) {
+                float distance = distance_strongest / 1000.0f;
+                if (distance >= 0.1f && distance <= 15.0f) {
+                    LidarPoint point = { azimuth, distance, measurement->rssi_strongest, true, true };
+                    points.push_back(point);
+                }
+            }
+
+            uint16_t distance_last = ntohs(measurement->distance_last);
+            if (distance_last != 0 && distance_last != 0xFFFF && distance_last != distance_strongest) {
+                float distance = distance_last / 1000.0f;
+                if (distance >= 0.1f && distance <= 15.0f) {
+                    LidarPoint point = { azimuth, distance, measurement->rssi_last, true, false };
+                    points.push_back(point);
+                }
+            }
+        }
+    }
+}
+
+// Distances biased towards the edge cases: 0, 0xFFFF, both sides of the gate, equal returns
+static uint16_t randomDistance() {
+    static const uint16_t edges[] = { 0, 0xFFFF, 99, 100, 101, 14999, 15000, 15001, 0x8000, 0x7FFF };
+    if (rand() % 4 == 0) {
+        return edges[rand() % (sizeof(edges) / sizeof(edges[0]))];
+    }
+    return static_cast<uint16_t>(rand() % 20000);
+}
+
+static void randomPacket(MSOPPacket* packet) {
+    uint16_t azimuth = static_cast<uint16_t>(rand() % 36000);
+    for (int b = 0; b < 12; ++b) {
+        DataBlock& block = packet->data_blocks[b];
+        block.flag = htons(rand() % 10 == 0 ? 0xFFFF : 0xFFEE);
+        block.azimuth = htons(azimuth);
+        azimuth = static_cast<uint16_t>((azimuth + 400) % 36000);
+        for (int m = 0; m < 16; ++m) {
+            uint16_t strongest = randomDistance();
+            uint16_t last = (rand() % 5 == 0) ? strongest : randomDistance();
+            block.measurements[m].distance_strongest = htons(strongest);
+            block.measurements[m].distance_last = htons(last);
+            block.measurements[m].rssi_strongest = static_cast<uint8_t>(rand());
+            block.measurements[m].rssi_last = static_cast<uint8_t>(rand());
+        }
+    }
+    packet->tail.timestamp = htonl(rand());
+    packet->tail.factory_info = htons(0x3740);
+}
+
+static bool samePoints(const std::vector<LidarPoint>& a, const std::vector<LidarPoint>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (memcmp(&a[i].azimuth, &b[i].azimuth, sizeof(float)) != 0 ||
+            memcmp(&a[i].distance, &b[i].distance, sizeof(float)) != 0 ||
+            a[i].rssi != b[i].rssi || a[i].is_valid != b[i].is_valid ||
+            a[i].is_strongest != b[i].is_strongest) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    int failures = 0;
+
+    std::cout << "Testing MSOP block decoders against the reference parser..." << std::endl;
+    std::cout << "Startup selection: " << blockDecoderName(bestBlockDecoder()) << std::endl;
+
+    // The integer gate must agree with the float check for every possible distance
+    int gate_mismatches = 0;
+    for (uint32_t mm = 0; mm <= 0xFFFF; ++mm) {
+        float distance = mm / 1000.0f;
+        bool float_ok = mm != 0 && mm != 0xFFFF && distance >= 0.1f && distance <= 15.0f;
+        bool gate_ok = mm >= MIN_DISTANCE_MM && mm <= MAX_DISTANCE_MM;
+        if (float_ok != gate_ok) {
+            gate_mismatches++;
+        }
+    }
+    std::cout << "\nDistance gate vs. float check over all 65536 values: "
+              << (gate_mismatches == 0 ? "PASS" : "FAIL") << std::endl;
+    failures += gate_mismatches;
+
+    const BlockDecoderKind kinds[] = {
+        BLOCK_DECODER_SCALAR, BLOCK_DECODER_SSE41, BLOCK_DECODER_AVX2, BLOCK_DECODER_NEON
+    };
+    const int packet_count = 20000;
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+        std::cout << "Decoder " << blockDecoderName(kinds[k]) << ": ";
+        if (!isBlockDecoderSupported(kinds[k])) {
+            std::cout << "not supported here, skipped" << std::endl;
+            continue;
+        }
+
+        MSOPParser parser;
+        parser.setBlockDecoder(getBlockDecoder(kinds[k]));
+        std::vector<LidarPoint> expected, actual;
+        MSOPPacket packet;
+        int mismatches = 0;
+
+        srand(12345);
+        for (int i = 0; i < packet_count; ++i) {
+            randomPacket(&packet);
+            referenceParse(&packet, expected);
+            parser.parsePacket(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet), actual);
+            if (!samePoints(expected, actual)) {
+                mismatches++;
+            }
+        }
+
+        std::cout << (mismatches == 0 ? "PASS" : "FAIL") << " (" << packet_count << " packets, "
+                  << mismatches << " mismatches)" << std::endl;
+        failures += mismatches;
+    }
+
+    std::cout << "\n" << (failures == 0 ? "All decoders are bit-identical to the reference."
+                                        : "Decoder output differs from the reference!") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
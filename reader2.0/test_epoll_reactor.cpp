@@ -0,0 +1,128 @@
+#include "epoll_reactor.h"
+#include "msop_parser.h"
+#include "msop_packet_view.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const int FIRST_PORT = 23690;
+static const int SENSOR_COUNT = 3;
+static const int ROUNDS = 20;
+
+// Each round sends a different number of packets per sensor, interleaved, so one
+// sensor's burst has to share wakeups with the others
+static int packetsFor(int sensor, int round) {
+    return 1 + (sensor * 7 + round * 3) % 24;
+}
+
+// Packets carry their sensor in the factory field and a per-sensor sequence number
+// in the timestamp, so the receiving side can check the tag and the order
+static void sendRound(int socket_fd, int round, std::vector<uint32_t>& next_sequence) {
+    MSOPPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    for (int b = 0; b < 12; ++b) {
+        packet.data_blocks[b].flag = htons(0xFFEE);
+        packet.data_blocks[b].azimuth = htons(4500 + b * 400);
+    }
+
+    int most = 0;
+    for (int s = 0; s < SENSOR_COUNT; ++s) {
+        most = std::max(most, packetsFor(s, round));
+    }
+    for (int i = 0; i < most; ++i) {
+        for (int s = 0; s < SENSOR_COUNT; ++s) {
+            if (i >= packetsFor(s, round)) {
+                continue;
+            }
+            struct sockaddr_in dest;
+            memset(&dest, 0, sizeof(dest));
+            dest.sin_family = AF_INET;
+            dest.sin_port = htons(FIRST_PORT + s);
+            dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            packet.tail.factory_info = htons(static_cast<uint16_t>(s));
+            packet.tail.timestamp = htonl(next_sequence[s]++);
+            sendto(socket_fd, &packet, sizeof(packet), 0, (struct sockaddr*)&dest, sizeof(dest));
+        }
+    }
+}
+
+int main() {
+    std::vector<int> ports;
+    for (int s = 0; s < SENSOR_COUNT; ++s) {
+        ports.push_back(FIRST_PORT + s);
+    }
+    bool ok = true;
+
+    // The same port twice would split one sensor between two sockets
+    std::vector<int> repeated(ports);
+    repeated.push_back(FIRST_PORT);
+    LidarEpollReactor bad(repeated);
+    if (bad.initialize()) {
+        std::cout << "Repeated port was accepted" << std::endl;
+        ok = false;
+    }
+
+    LidarEpollReactor reactor(ports, 8);
+    if (!reactor.initialize()) {
+        return 1;
+    }
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+
+    std::vector<uint32_t> sent(SENSOR_COUNT, 0), expected(SENSOR_COUNT, 0);
+    std::vector<ReactorPacket> packets(reactor.getMaxPackets());
+    uint64_t mistagged = 0, out_of_order = 0, bad_size = 0;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        sendRound(sender, round, sent);
+        while (true) {
+            int received = reactor.waitPackets(packets.data(), static_cast<int>(packets.size()), 100);
+            if (received <= 0) {
+                break;
+            }
+            for (int i = 0; i < received; ++i) {
+                const ReactorPacket& packet = packets[i];
+                if (packet.size != sizeof(MSOPPacket)) {
+                    bad_size++;
+                    continue;
+                }
+                MSOPPacketView view(packet.data);
+                if (view.factoryInfo() != packet.sensor) {
+                    mistagged++;
+                }
+                if (view.timestamp() != expected[packet.sensor]) {
+                    out_of_order++;
+                }
+                expected[packet.sensor] = view.timestamp() + 1;
+            }
+        }
+    }
+    close(sender);
+
+    const ReactorStats& stats = reactor.getStats();
+    std::cout << stats.packets << " packets from " << SENSOR_COUNT << " sensors in " << stats.wakeups
+              << " wakeups, " << stats.receive_calls << " recvmmsg calls" << std::endl;
+    for (int s = 0; s < SENSOR_COUNT; ++s) {
+        std::cout << "  port " << reactor.getPort(s) << ": " << reactor.getSensorPackets(s) << "/" << sent[s]
+                  << " packets" << std::endl;
+        if (reactor.getSensorPackets(s) != sent[s] || expected[s] != sent[s]) {
+            ok = false;
+        }
+    }
+    if (mistagged || out_of_order || bad_size || stats.receive_errors) {
+        std::cout << "  " << mistagged << " mistagged, " << out_of_order << " out of order, " << bad_size
+                  << " wrong size, " << stats.receive_errors << " receive errors" << std::endl;
+        ok = false;
+    }
+
+    if (!ok) {
+        std::cout << "Epoll reactor FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "Every packet arrived once, in order, tagged with its sensor." << std::endl;
+    return 0;
+}
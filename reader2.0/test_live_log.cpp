@@ -0,0 +1,179 @@
+#include "scan_log.h"
+#include "msop_parser.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Runs lidar_reader --log on the live receive paths, sends it whole revolutions and
+// half of one over loopback, stops it with SIGINT or SIGTERM the way an operator
+// would, and checks the log was closed with its index and seeks to every revolution.
+
+static const char* LOG_FILE = "/tmp/test_live_log.bin";
+static const int REVOLUTIONS = 20;
+static const int PACKETS_PER_REVOLUTION = 8;     // 96 blocks, 3.75 degrees apart
+static const uint32_t FIRST_TIMESTAMP_US = 1000000;
+static const uint32_t SCAN_PERIOD_US = 100000;
+
+// Every point of revolution r is (1000 + 10 r) mm away, so a logged revolution can
+// be traced back to the one sent
+static void sendRevolution(int socket_fd, int revolution, int packets) {
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(2368);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    MSOPPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    for (int p = 0; p < packets; ++p) {
+        bool last = (p == PACKETS_PER_REVOLUTION - 1);
+        for (int b = 0; b < 12; ++b) {
+            DataBlock& block = packet.data_blocks[b];
+            block.flag = htons(last && b >= 6 ? 0x0000 : 0xFFEE);   // Last-packet marker
+            block.azimuth = htons(static_cast<uint16_t>((p * 12 + b) * 375));
+            for (int m = 0; m < 16; ++m) {
+                block.measurements[m].distance_strongest = htons(static_cast<uint16_t>(1000 + 10 * revolution));
+                block.measurements[m].distance_last = block.measurements[m].distance_strongest;
+                block.measurements[m].rssi_strongest = 100;
+                block.measurements[m].rssi_last = 100;
+            }
+        }
+        packet.tail.timestamp = htonl(FIRST_TIMESTAMP_US + revolution * SCAN_PERIOD_US + p * 1000);
+        sendto(socket_fd, &packet, sizeof(packet), 0, (struct sockaddr*)&dest, sizeof(dest));
+        usleep(200);
+    }
+}
+
+static bool portBound() {
+    std::ifstream table("/proc/net/udp");
+    std::string line;
+    while (std::getline(table, line)) {
+        if (line.find(":0940 ") != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// lidar_reader has bound the MSOP port once it shows up in /proc/net/udp
+static bool waitForPort() {
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        if (portBound()) {
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static bool checkLog(int expected_scans) {
+    ScanLogReader reader(LOG_FILE);
+    if (!reader.initialize()) {
+        return false;
+    }
+    bool ok = true;
+    if (reader.isIndexRebuilt()) {
+        std::cout << "  log has no index: lidar_reader did not close it" << std::endl;
+        ok = false;
+    }
+    if (reader.getScanCount() != static_cast<size_t>(expected_scans)) {
+        std::cout << "  " << reader.getScanCount() << " revolutions logged, expected " << expected_scans << std::endl;
+        return false;
+    }
+
+    int wrong = 0;
+    for (int r = 0; r < expected_scans; ++r) {
+        uint64_t start = FIRST_TIMESTAMP_US + r * SCAN_PERIOD_US;
+        size_t found = reader.findScan(start + SCAN_PERIOD_US / 2);
+        ScanLogScan view;
+        if (found != static_cast<size_t>(r) || !reader.getScan(found, view) || view.timestamp_us != start ||
+            view.size == 0) {
+            wrong++;
+            continue;
+        }
+        float range = (1000 + 10 * r) / 1000.0f;
+        for (size_t i = 0; i < view.size; ++i) {
+            if (view.range[i] != range) {
+                wrong++;
+                break;
+            }
+        }
+    }
+    std::cout << "  " << reader.getScanCount() << " revolutions, " << wrong
+              << " found at the wrong time or with another revolution's points" << std::endl;
+    return ok && wrong == 0;
+}
+
+// Fork lidar_reader with the given mode, feed it, stop it with the signal
+static bool runLive(const std::string& reader_path, const char* mode, int signal_number) {
+    unlink(LOG_FILE);
+    if (portBound()) {
+        // Another reader (SO_REUSEADDR) would take part of the packets
+        std::cout << "  port 2368 is already in use; stop the other receiver first" << std::endl;
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        if (mode[0] != '\0') {
+            execl(reader_path.c_str(), "lidar_reader", mode, "--log", LOG_FILE, "--quiet", (char*)NULL);
+        } else {
+            execl(reader_path.c_str(), "lidar_reader", "--log", LOG_FILE, "--quiet", (char*)NULL);
+        }
+        _exit(127);
+    }
+    if (pid < 0 || !waitForPort()) {
+        std::cout << "  lidar_reader did not start" << std::endl;
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+        }
+        return false;
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    for (int r = 0; r < REVOLUTIONS; ++r) {
+        sendRevolution(sender, r, PACKETS_PER_REVOLUTION);
+    }
+    sendRevolution(sender, REVOLUTIONS, PACKETS_PER_REVOLUTION / 2);   // Still in progress at the signal
+    close(sender);
+    usleep(200000);
+
+    kill(pid, signal_number);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cout << "  lidar_reader did not exit cleanly (status " << status << ")" << std::endl;
+        return false;
+    }
+    return checkLog(REVOLUTIONS + 1);
+}
+
+int main(int, char** argv) {
+    std::string dir(argv[0]);
+    size_t slash = dir.rfind('/');
+    std::string reader_path = (slash == std::string::npos ? std::string(".") : dir.substr(0, slash)) + "/lidar_reader";
+
+    bool ok = true;
+    std::cout << "Socket loop, stopped with SIGINT:" << std::endl;
+    ok &= runLive(reader_path, "", SIGINT);
+    std::cout << "Receive thread + parse thread, stopped with SIGTERM:" << std::endl;
+    ok &= runLive(reader_path, "--threaded", SIGTERM);
+
+    unlink(LOG_FILE);
+    if (!ok) {
+        std::cout << "Live scan log FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "Stopped live runs leave an indexed scan log that seeks to every revolution." << std::endl;
+    return 0;
+}
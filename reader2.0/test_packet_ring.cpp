@@ -0,0 +1,257 @@
+#include "packet_ring_receiver.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <netinet/in.h>
+
+static const unsigned int BLOCK_SIZE = 8192;
+static const unsigned int BLOCK_COUNT = 3;
+static const int MSOP_PORT = 2368;
+
+// Ethernet + IPv4 + UDP frame carrying `payload_size` bytes numbered from `seed`.
+// `ip_options` extra 32-bit words lengthen the IP header.
+static std::vector<uint8_t> udpFrame(int port, size_t payload_size, uint8_t seed, int ip_options = 0,
+                                     uint8_t protocol = IPPROTO_UDP, uint16_t fragment = 0) {
+    size_t ip_header = 20 + ip_options * 4;
+    std::vector<uint8_t> frame(14 + ip_header + 8 + payload_size, 0);
+    frame[12] = ETH_P_IP >> 8;
+    frame[13] = ETH_P_IP & 0xFF;
+    uint8_t* ip = &frame[14];
+    ip[0] = 0x40 | static_cast<uint8_t>(ip_header / 4);
+    ip[6] = fragment >> 8;
+    ip[7] = fragment & 0xFF;
+    ip[9] = protocol;
+    uint8_t* udp = ip + ip_header;
+    udp[2] = static_cast<uint8_t>(port >> 8);
+    udp[3] = static_cast<uint8_t>(port & 0xFF);
+    udp[4] = static_cast<uint8_t>((8 + payload_size) >> 8);
+    udp[5] = static_cast<uint8_t>((8 + payload_size) & 0xFF);
+    for (size_t i = 0; i < payload_size; ++i) {
+        udp[8 + i] = static_cast<uint8_t>(seed + i);
+    }
+    return frame;
+}
+
+// Lays frames out in one ring block the way the kernel does for TPACKET_V3:
+// block descriptor, then per frame a tpacket3_hdr, the sockaddr_ll and the
+// packet at tp_mac, each frame starting on a TPACKET_ALIGNMENT boundary
+class BlockWriter {
+public:
+    explicit BlockWriter(uint8_t* block) : block_(block), offset_(0), last_(NULL) {
+        memset(block_, 0, BLOCK_SIZE);
+        offset_ = TPACKET_ALIGN(sizeof(struct tpacket_block_desc));
+        desc()->version = TPACKET_V3;
+        desc()->hdr.bh1.offset_to_first_pkt = offset_;
+    }
+
+    void add(const std::vector<uint8_t>& frame, unsigned char pkttype = PACKET_HOST) {
+        struct tpacket3_hdr* header = reinterpret_cast<struct tpacket3_hdr*>(block_ + offset_);
+        struct sockaddr_ll* link = reinterpret_cast<struct sockaddr_ll*>(
+            block_ + offset_ + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        unsigned int mac = TPACKET_ALIGN(TPACKET_ALIGN(sizeof(struct tpacket3_hdr)) + sizeof(struct sockaddr_ll));
+        header->tp_mac = mac;
+        header->tp_snaplen = static_cast<uint32_t>(frame.size());
+        header->tp_len = static_cast<uint32_t>(frame.size());
+        link->sll_pkttype = pkttype;
+        memcpy(block_ + offset_ + mac, &frame[0], frame.size());
+
+        if (last_ != NULL) {
+            last_->tp_next_offset = static_cast<uint32_t>(block_ + offset_ - reinterpret_cast<uint8_t*>(last_));
+        }
+        last_ = header;
+        offset_ = TPACKET_ALIGN(offset_ + mac + frame.size());
+        desc()->hdr.bh1.num_pkts++;
+    }
+
+    // Hand the block to user space, as the kernel does when it retires it
+    void retire() {
+        desc()->hdr.bh1.block_status = TP_STATUS_USER;
+    }
+
+private:
+    struct tpacket_block_desc* desc() {
+        return reinterpret_cast<struct tpacket_block_desc*>(block_);
+    }
+
+    uint8_t* block_;
+    size_t offset_;
+    struct tpacket3_hdr* last_;
+};
+
+static uint32_t blockStatus(const uint8_t* ring, unsigned int block) {
+    return reinterpret_cast<const struct tpacket_block_desc*>(ring + block * BLOCK_SIZE)->hdr.bh1.block_status;
+}
+
+// Classic BPF interpreter for the instructions the port filter uses; returns
+// the number of bytes the program accepts (0: dropped)
+static uint32_t runFilter(const struct sock_filter* code, unsigned int length, const std::vector<uint8_t>& packet) {
+    uint32_t a = 0;
+    uint32_t x = 0;
+    for (unsigned int pc = 0; pc < length; ++pc) {
+        const struct sock_filter& op = code[pc];
+        uint32_t at = op.k;
+        switch (op.code) {
+        case BPF_LD | BPF_H | BPF_IND:
+            at += x;
+            // fall through
+        case BPF_LD | BPF_H | BPF_ABS:
+            if (at + 2 > packet.size()) {
+                return 0;
+            }
+            a = (packet[at] << 8) | packet[at + 1];
+            break;
+        case BPF_LD | BPF_B | BPF_ABS:
+            if (at >= packet.size()) {
+                return 0;
+            }
+            a = packet[at];
+            break;
+        case BPF_LDX | BPF_B | BPF_MSH:
+            if (at >= packet.size()) {
+                return 0;
+            }
+            x = (packet[at] & 0x0F) * 4;
+            break;
+        case BPF_JMP | BPF_JEQ | BPF_K:
+            pc += (a == op.k) ? op.jt : op.jf;
+            break;
+        case BPF_JMP | BPF_JSET | BPF_K:
+            pc += (a & op.k) ? op.jt : op.jf;
+            break;
+        case BPF_RET | BPF_K:
+            return op.k;
+        default:
+            std::cout << "  unexpected BPF instruction 0x" << std::hex << op.code << std::dec << std::endl;
+            return 0;
+        }
+    }
+    return 0;
+}
+
+int main() {
+    bool ok = true;
+
+    // Ring walker: block 0 holds an MSOP frame, the loopback duplicate of the
+    // next one, a truncated frame and a frame whose IP header carries options;
+    // block 1 holds one more MSOP frame; block 2 is still the kernel's
+    std::vector<uint8_t> ring(BLOCK_SIZE * BLOCK_COUNT);
+    BlockWriter first(&ring[0]);
+    std::vector<uint8_t> msop = udpFrame(MSOP_PORT, 1206, 1);
+    first.add(msop);
+    first.add(udpFrame(MSOP_PORT, 1206, 2), PACKET_OUTGOING);
+    std::vector<uint8_t> truncated = udpFrame(MSOP_PORT, 1206, 3);
+    truncated.resize(600);
+    first.add(truncated);
+    first.add(udpFrame(MSOP_PORT, 1206, 4, 1));
+    first.retire();
+    BlockWriter second(&ring[BLOCK_SIZE]);
+    second.add(udpFrame(MSOP_PORT, 1206, 5));
+    second.retire();
+    BlockWriter third(&ring[2 * BLOCK_SIZE]);
+    third.add(udpFrame(MSOP_PORT, 1206, 6));
+
+    LidarPacketRingReceiver receiver("synthetic", MSOP_PORT);
+    receiver.useRing(&ring[0], BLOCK_SIZE, BLOCK_COUNT);
+
+    const uint8_t* payload = NULL;
+    size_t size = 0;
+    if (!receiver.nextPacket(payload, size, 0) || size != 1206 || payload[0] != 1) {
+        std::cout << "  first MSOP frame not delivered" << std::endl;
+        ok = false;
+    } else {
+        std::cout << "1248-byte frame: " << size << "-byte payload" << std::endl;
+        if (msop.size() != 1248 || memcmp(payload, &msop[42], 1206) != 0) {
+            std::cout << "  payload does not start 42 bytes into the frame" << std::endl;
+            ok = false;
+        }
+    }
+
+    // The outgoing duplicate and the truncated frame are skipped; the next payload
+    // starts after the longer IP header
+    if (!receiver.nextPacket(payload, size, 0) || size != 1206 || payload[0] != 4) {
+        std::cout << "  frame with IP options not delivered" << std::endl;
+        ok = false;
+    } else if (payload[-8 - 24] != 0x46) {
+        std::cout << "  payload does not follow the 24-byte IP header" << std::endl;
+        ok = false;
+    }
+    if (blockStatus(&ring[0], 0) != TP_STATUS_USER) {
+        std::cout << "  block 0 released while its last payload is still in use" << std::endl;
+        ok = false;
+    }
+
+    // Asking for the next packet retires block 0 and moves on to block 1
+    if (!receiver.nextPacket(payload, size, 0) || size != 1206 || payload[0] != 5) {
+        std::cout << "  frame in block 1 not delivered" << std::endl;
+        ok = false;
+    }
+    if (blockStatus(&ring[0], 0) != TP_STATUS_KERNEL) {
+        std::cout << "  block 0 not handed back to the kernel" << std::endl;
+        ok = false;
+    }
+
+    // Block 2 has not been retired: nothing more until it is, then the walker
+    // continues there and wraps round to block 0
+    if (receiver.nextPacket(payload, size, 0)) {
+        std::cout << "  read a block the kernel still owns" << std::endl;
+        ok = false;
+    }
+    if (blockStatus(&ring[0], 1) != TP_STATUS_KERNEL) {
+        std::cout << "  block 1 not handed back to the kernel" << std::endl;
+        ok = false;
+    }
+    third.retire();
+    BlockWriter wrapped(&ring[0]);
+    wrapped.add(udpFrame(MSOP_PORT, 1206, 7));
+    wrapped.retire();
+    bool in_order = receiver.nextPacket(payload, size, 0) && payload[0] == 6;
+    in_order = in_order && receiver.nextPacket(payload, size, 0) && payload[0] == 7;
+    if (!in_order) {
+        std::cout << "  walker did not continue in block 2 and wrap to block 0" << std::endl;
+        ok = false;
+    }
+
+    RingStats stats = receiver.getStats();
+    std::cout << stats.packets << " packets, " << stats.skipped_frames << " skipped frames" << std::endl;
+    if (stats.packets != 5 || stats.skipped_frames != 1) {
+        std::cout << "  expected 5 packets and 1 skipped frame" << std::endl;
+        ok = false;
+    }
+
+    // Port filter
+    struct sock_filter code[LidarPacketRingReceiver::PORT_FILTER_LENGTH];
+    LidarPacketRingReceiver::buildPortFilter(MSOP_PORT, code);
+    std::vector<uint8_t> arp = udpFrame(MSOP_PORT, 28, 0);
+    arp[12] = ETH_P_ARP >> 8;
+    arp[13] = ETH_P_ARP & 0xFF;
+    struct FilterCase {
+        const char* name;
+        std::vector<uint8_t> frame;
+        bool accepted;
+    };
+    const FilterCase cases[] = {
+        {"MSOP frame", udpFrame(MSOP_PORT, 1206, 0), true},
+        {"MSOP frame with IP options", udpFrame(MSOP_PORT, 1206, 0, 2), true},
+        {"DIFOP port", udpFrame(7788, 1206, 0), false},
+        {"TCP to the MSOP port", udpFrame(MSOP_PORT, 1206, 0, 0, IPPROTO_TCP), false},
+        {"non-first fragment", udpFrame(MSOP_PORT, 1206, 0, 0, IPPROTO_UDP, 0x00B9), false},
+        {"ARP", arp, false},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        bool accepted = runFilter(code, LidarPacketRingReceiver::PORT_FILTER_LENGTH, cases[i].frame) != 0;
+        std::cout << "  filter " << cases[i].name << ": " << (accepted ? "accepted" : "dropped") << std::endl;
+        if (accepted != cases[i].accepted) {
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        std::cout << "Packet ring FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "Ring blocks walked in order and retired; the filter keeps only MSOP traffic." << std::endl;
+    return 0;
+}
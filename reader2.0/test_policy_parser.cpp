@@ -0,0 +1,102 @@
+#include "msop_parser.h"
+#include "msop_policy_parser.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <arpa/inet.h>
+
+// Packet whose block azimuths start at first_azimuth and step by `step`, wrapping
+// at 16 bits like the sensor's field; 0xFFFF is skipped because it marks a missing block.
+// Azimuths of 36000 and above are what a corrupt packet would carry.
+static void fillPacket(MSOPPacket* packet, uint32_t first_azimuth, uint32_t step) {
+    for (int b = 0; b < 12; ++b) {
+        DataBlock& block = packet->data_blocks[b];
+        uint16_t azimuth = static_cast<uint16_t>(first_azimuth + b * step);
+        if (azimuth == 0xFFFF) {
+            azimuth = 0xFFFE;
+        }
+        block.flag = htons(0xFFEE);
+        block.azimuth = htons(azimuth);
+        for (int m = 0; m < 16; ++m) {
+            uint16_t strongest = static_cast<uint16_t>(100 + rand() % 14900);
+            block.measurements[m].distance_strongest = htons(strongest);
+            block.measurements[m].distance_last = htons(rand() % 3 == 0 ? strongest : static_cast<uint16_t>(100 + rand() % 14900));
+            block.measurements[m].rssi_strongest = static_cast<uint8_t>(rand());
+            block.measurements[m].rssi_last = static_cast<uint8_t>(rand());
+        }
+    }
+    packet->tail.timestamp = htonl(first_azimuth);
+    packet->tail.factory_info = htons(0x3740);
+}
+
+int main() {
+    bool ok = true;
+    MSOPParser generic;
+    PolicyParser<DualReturn, LakiBeam1Traits> specialized;
+    LidarPoint expected[MSOPParser::MAX_POINTS_PER_PACKET];
+    LidarPoint actual[MSOPParser::MAX_POINTS_PER_PACKET];
+    MSOPPacket packet;
+
+    // Every 16-bit block azimuth, in range or not, with steps that interpolate
+    // normally (400), collapse to the default resolution (0) or jump far (30000)
+    const uint32_t steps[] = { 400, 0, 30000 };
+    srand(7);
+    int packets = 0;
+    int differing = 0;
+    int out_of_range = 0;
+    int outside_turn = 0;
+    for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); ++s) {
+        for (uint32_t azimuth = 0; azimuth < 0xFFFF; azimuth += 3) {
+            fillPacket(&packet, azimuth, steps[s]);
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(&packet);
+            size_t n = generic.parsePacket(data, sizeof(packet), expected, MSOPParser::MAX_POINTS_PER_PACKET);
+            size_t m = specialized.parsePacket(data, sizeof(packet), actual);
+            packets++;
+            out_of_range += azimuth >= 36000;
+
+            bool same = (n == m);
+            for (size_t i = 0; same && i < n; ++i) {
+                same = memcmp(&expected[i].azimuth, &actual[i].azimuth, sizeof(float)) == 0 &&
+                       memcmp(&expected[i].distance, &actual[i].distance, sizeof(float)) == 0 &&
+                       expected[i].rssi == actual[i].rssi &&
+                       expected[i].is_strongest == actual[i].is_strongest;
+            }
+            for (size_t i = 0; i < m; ++i) {
+                if (actual[i].azimuth < 0.0f || actual[i].azimuth >= 360.0f) {
+                    outside_turn++;
+                }
+            }
+            if (!same) {
+                if (differing < 5) {
+                    std::cout << "  block azimuth " << azimuth << ", step " << steps[s]
+                              << ": parsers disagree" << std::endl;
+                }
+                differing++;
+            }
+        }
+    }
+    std::cout << packets << " packets (" << out_of_range << " starting at an azimuth of 360 degrees or more): "
+              << differing << " differ, " << outside_turn << " points outside [0, 360)" << std::endl;
+    if (differing > 0 || outside_turn > 0) {
+        ok = false;
+    }
+
+    // The shared normalization itself, for values past one and two turns
+    const float inputs[] = { -725.5f, -0.25f, 0.0f, 359.99f, 360.0f, 655.34f, 720.0f, 1000.5f };
+    const float outputs[] = { 354.5f, 359.75f, 0.0f, 359.99f, 0.0f, 295.34f, 0.0f, 280.5f };
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+        float degrees = normalizeAzimuthDegrees(inputs[i]);
+        if (degrees < 0.0f || degrees >= 360.0f || degrees - outputs[i] > 1e-3f || outputs[i] - degrees > 1e-3f) {
+            std::cout << "  normalizeAzimuthDegrees(" << inputs[i] << ") = " << degrees
+                      << ", expected " << outputs[i] << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        std::cout << "Policy parser FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PolicyParser and MSOPParser agree on every block azimuth." << std::endl;
+    return 0;
+}
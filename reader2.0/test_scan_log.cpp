@@ -0,0 +1,150 @@
+#include "scan_log.h"
+#include "point_cloud_soa.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char* LOG_FILE = "/tmp/test_scan_log.bin";
+static const int SCAN_COUNT = 3000;
+static const uint32_t SCAN_PERIOD_US = 100000;  // 10 Hz
+
+// Deterministic contents for revolution n, so the reader side can regenerate them
+static void makeScan(int n, PointCloudSoA& scan) {
+    scan.clear();
+    srand(n);
+    size_t points = 500 + rand() % 1500;
+    for (size_t i = 0; i < points; ++i) {
+        float azimuth = 45.0f + 270.0f * i / points;
+        float range = 0.1f + (rand() % 14900) / 1000.0f;
+        uint8_t rssi = static_cast<uint8_t>(rand());
+        uint8_t flags = POINT_FLAG_VALID | ((i & 1) ? 0 : POINT_FLAG_STRONGEST);
+        scan.push_back(azimuth, range, rssi, flags);
+    }
+}
+
+// Start just before the sensor's 32-bit microsecond counter wraps
+static uint32_t rawTimestamp(int n) {
+    return 0xFFFFFFFFu - 50 * SCAN_PERIOD_US + static_cast<uint32_t>(n) * SCAN_PERIOD_US;
+}
+
+static uint64_t unwrappedTimestamp(int n) {
+    return 0xFFFFFFFFull - 50 * SCAN_PERIOD_US + static_cast<uint64_t>(n) * SCAN_PERIOD_US;
+}
+
+static bool sameScan(const ScanLogScan& view, const PointCloudSoA& expected) {
+    return view.size == expected.size() &&
+           memcmp(view.azimuth, expected.azimuth(), view.size * sizeof(float)) == 0 &&
+           memcmp(view.range, expected.range(), view.size * sizeof(float)) == 0 &&
+           memcmp(view.rssi, expected.rssi(), view.size) == 0 &&
+           memcmp(view.flags, expected.flags(), view.size) == 0;
+}
+
+static double nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Every revolution round-trips, and findScan() lands on the right one for any time
+static int checkLog(ScanLogReader& reader, int scan_count) {
+    int failures = 0;
+    if (reader.getScanCount() != static_cast<size_t>(scan_count)) {
+        std::cout << "  scan count " << reader.getScanCount() << ", expected " << scan_count << std::endl;
+        return 1;
+    }
+
+    PointCloudSoA expected;
+    ScanLogScan view;
+    for (int n = 0; n < scan_count; ++n) {
+        makeScan(n, expected);
+        if (!reader.getScan(n, view) || view.timestamp_us != unwrappedTimestamp(n) ||
+            !sameScan(view, expected)) {
+            failures++;
+        }
+    }
+    std::cout << "  Round trip: " << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+
+    int seek_failures = 0;
+    for (int n = 0; n < scan_count; ++n) {
+        uint64_t t = unwrappedTimestamp(n);
+        if (reader.findScan(t) != static_cast<size_t>(n) ||
+            reader.findScan(t + SCAN_PERIOD_US - 1) != static_cast<size_t>(n)) {
+            seek_failures++;
+        }
+    }
+    if (reader.findScan(0) != 0 || reader.findScan(~0ull) != static_cast<size_t>(scan_count - 1)) {
+        seek_failures++;
+    }
+    std::cout << "  Timestamp seek across the counter wrap: "
+              << (seek_failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures + seek_failures;
+}
+
+int main() {
+    int failures = 0;
+
+    std::cout << "Writing " << SCAN_COUNT << " revolutions to " << LOG_FILE << std::endl;
+    {
+        ScanLogWriter writer(LOG_FILE);
+        if (!writer.initialize()) {
+            return 1;
+        }
+        PointCloudSoA scan;
+        double start = nowMicros();
+        for (int n = 0; n < SCAN_COUNT; ++n) {
+            makeScan(n, scan);
+            writer.writeScan(scan, rawTimestamp(n));
+        }
+        if (!writer.close()) {
+            return 1;
+        }
+        std::cout << "  " << std::fixed << std::setprecision(1)
+                  << (nowMicros() - start) / SCAN_COUNT << " us per revolution (including generation)" << std::endl;
+    }
+
+    std::cout << "Reading through the footer index:" << std::endl;
+    {
+        ScanLogReader reader(LOG_FILE);
+        if (!reader.initialize()) {
+            return 1;
+        }
+        failures += checkLog(reader, SCAN_COUNT);
+
+        const int seeks = 1000000;
+        size_t sum = 0;
+        double start = nowMicros();
+        for (int i = 0; i < seeks; ++i) {
+            sum += reader.findScan(unwrappedTimestamp(0) + (static_cast<uint64_t>(i) * 7919 % SCAN_COUNT) * SCAN_PERIOD_US);
+        }
+        std::cout << "  findScan: " << std::setprecision(1) << (nowMicros() - start) * 1000.0 / seeks
+                  << " ns per lookup (checksum " << sum << ")" << std::endl;
+    }
+
+    // Simulate a writer killed before close(): no index or trailer, and a partial last chunk
+    std::cout << "Reading a log without its index:" << std::endl;
+    {
+        struct stat st;
+        stat(LOG_FILE, &st);
+        off_t chunks_end = st.st_size - sizeof(ScanLogTrailer) - SCAN_COUNT * sizeof(ScanLogIndexEntry);
+        if (truncate(LOG_FILE, chunks_end - 100) != 0) {
+            return 1;
+        }
+
+        ScanLogReader reader(LOG_FILE);
+        if (!reader.initialize()) {
+            return 1;
+        }
+        failures += reader.isIndexRebuilt() ? 0 : 1;
+        failures += checkLog(reader, SCAN_COUNT - 1);
+    }
+
+    unlink(LOG_FILE);
+    std::cout << "\n" << (failures == 0 ? "Scan log round trip and seek are correct."
+                                        : "Scan log test FAILED!") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
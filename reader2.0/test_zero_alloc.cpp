@@ -0,0 +1,215 @@
+#include "msop_parser.h"
+#include "point_cloud_soa.h"
+#include "udp_receiver.h"
+#include "spsc_ring.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// Every heap allocation in the process goes through here
+static unsigned long allocation_count = 0;
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+static const int TEST_PORT = 23680;
+static const int PACKETS_PER_ROUND = 32;
+static const int WARMUP_ROUNDS = 4;
+static const int MEASURED_ROUNDS = 100;
+
+// Loopback sender feeding the receiver under test
+class PacketSender {
+public:
+    PacketSender() : socket_fd_(socket(AF_INET, SOCK_DGRAM, 0)) {
+        memset(&dest_, 0, sizeof(dest_));
+        dest_.sin_family = AF_INET;
+        dest_.sin_port = htons(TEST_PORT);
+        dest_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        // 12 valid blocks, 4° apart, distances across the whole gate
+        memset(&packet_, 0, sizeof(packet_));
+        for (int b = 0; b < 12; ++b) {
+            packet_.data_blocks[b].flag = htons(0xFFEE);
+            packet_.data_blocks[b].azimuth = htons(4500 + b * 400);
+            for (int m = 0; m < 16; ++m) {
+                packet_.data_blocks[b].measurements[m].distance_strongest = htons(500 + b * 1000 + m);
+                packet_.data_blocks[b].measurements[m].rssi_strongest = 40;
+                packet_.data_blocks[b].measurements[m].distance_last = htons(600 + b * 1000 + m);
+                packet_.data_blocks[b].measurements[m].rssi_last = 30;
+            }
+        }
+    }
+
+    ~PacketSender() {
+        close(socket_fd_);
+    }
+
+    void sendRound() {
+        for (int i = 0; i < PACKETS_PER_ROUND; ++i) {
+            sendto(socket_fd_, &packet_, sizeof(packet_), 0, (struct sockaddr*)&dest_, sizeof(dest_));
+        }
+    }
+
+private:
+    int socket_fd_;
+    struct sockaddr_in dest_;
+    MSOPPacket packet_;
+};
+
+// Runs one receive->parse path for warm-up plus measured rounds and reports
+// the heap allocations seen during the measured rounds
+template <typename Path>
+static bool runPath(const char* name, PacketSender& sender, Path& path) {
+    unsigned long points = 0;
+    for (int round = 0; round < WARMUP_ROUNDS; ++round) {
+        sender.sendRound();
+        points += path.receiveRound();
+    }
+
+    unsigned long before = allocation_count;
+    for (int round = 0; round < MEASURED_ROUNDS; ++round) {
+        sender.sendRound();
+        points += path.receiveRound();
+    }
+    unsigned long allocations = allocation_count - before;
+
+    bool ok = allocations == 0 && points > 0;
+    std::cout << name << ": " << allocations << " allocations over "
+              << MEASURED_ROUNDS * PACKETS_PER_ROUND << " packets (" << points << " points) - "
+              << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok;
+}
+
+// recvfrom() into a stack buffer, parse into a caller-owned array
+struct SingleSpanPath {
+    LidarUDPReceiver& receiver;
+    MSOPParser parser;
+    LidarPoint points[MSOPParser::MAX_POINTS_PER_PACKET];
+
+    explicit SingleSpanPath(LidarUDPReceiver& r) : receiver(r) {}
+
+    unsigned long receiveRound() {
+        unsigned long total = 0;
+        uint8_t buffer[2048];
+        for (int i = 0; i < PACKETS_PER_ROUND; ++i) {
+            size_t received = 0;
+            if (receiver.receivePacket(buffer, sizeof(buffer), received)) {
+                total += parser.parsePacket(buffer, received, points, MSOPParser::MAX_POINTS_PER_PACKET);
+            }
+        }
+        return total;
+    }
+};
+
+// recvmmsg() into a preallocated batch, parse into a caller-owned array
+struct BatchSpanPath {
+    LidarUDPReceiver& receiver;
+    PacketBatch batch;
+    MSOPParser parser;
+    LidarPoint points[MSOPParser::MAX_POINTS_PER_PACKET];
+
+    explicit BatchSpanPath(LidarUDPReceiver& r) : receiver(r), batch(PACKETS_PER_ROUND) {}
+
+    unsigned long receiveRound() {
+        unsigned long total = 0;
+        int remaining = PACKETS_PER_ROUND;
+        while (remaining > 0) {
+            int received = receiver.receiveBatch(batch);
+            if (received <= 0) {
+                break;
+            }
+            for (int i = 0; i < received; ++i) {
+                total += parser.parsePacket(batch.packet(i), batch.packetSize(i),
+                                            points, MSOPParser::MAX_POINTS_PER_PACKET);
+            }
+            remaining -= received;
+        }
+        return total;
+    }
+};
+
+// recvfrom() through the SPSC ring into a reused PointCloudSoA
+struct RingCloudPath {
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        uint32_t size;
+        uint8_t data[1248];
+    };
+
+    LidarUDPReceiver& receiver;
+    SPSCRing<Slot, 64> ring;
+    MSOPParser parser;
+    PointCloudSoA cloud;
+
+    explicit RingCloudPath(LidarUDPReceiver& r) : receiver(r), cloud(MSOPParser::MAX_POINTS_PER_PACKET) {}
+
+    unsigned long receiveRound() {
+        for (int i = 0; i < PACKETS_PER_ROUND; ++i) {
+            Slot* slot = ring.acquire();
+            size_t received = 0;
+            if (slot && receiver.receivePacket(slot->data, sizeof(slot->data), received)) {
+                slot->size = static_cast<uint32_t>(received);
+                ring.publish();
+            }
+        }
+        unsigned long total = 0;
+        while (const Slot* slot = ring.front()) {
+            cloud.clear();
+            parser.parsePacket(slot->data, slot->size, cloud);
+            total += cloud.size();
+            ring.pop();
+        }
+        return total;
+    }
+};
+
+int main() {
+    std::cout << "Testing steady-state heap allocations on the receive->parse path..." << std::endl;
+
+    LidarUDPReceiver receiver(TEST_PORT);
+    if (!receiver.initialize()) {
+        return 1;
+    }
+    PacketSender sender;
+
+    bool ok = true;
+    SingleSpanPath single(receiver);
+    ok &= runPath("recvfrom + span parse", sender, single);
+    BatchSpanPath batch(receiver);
+    ok &= runPath("recvmmsg + span parse", sender, batch);
+    RingCloudPath ring(receiver);
+    ok &= runPath("SPSC ring + PointCloudSoA parse", sender, ring);
+
+    std::cout << "\n" << (ok ? "No heap allocations per packet." : "Heap allocations found per packet!") << std::endl;
+    return ok ? 0 : 1;
+}
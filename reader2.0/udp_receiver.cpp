@@ -0,0 +1,188 @@
+#include "udp_receiver.h"
+#include <iostream>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <time.h>
+
+// Room for one SCM_TIMESTAMPNS message per packet
+static const size_t CONTROL_SLOT_SIZE = CMSG_SPACE(sizeof(struct timespec));
+
+PacketBatch::PacketBatch(int capacity)
+    : capacity(capacity), count(0),
+      storage(capacity * PACKET_SLOT_SIZE),
+      iovecs(capacity), messages(capacity),
+      control(capacity * CONTROL_SLOT_SIZE) {
+    // Wire every message header to its slot once, so receiving needs no setup
+    memset(messages.data(), 0, messages.size() * sizeof(struct mmsghdr));
+    for (int i = 0; i < capacity; ++i) {
+        iovecs[i].iov_base = &storage[i * PACKET_SLOT_SIZE];
+        iovecs[i].iov_len = PACKET_SLOT_SIZE;
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = &control[i * CONTROL_SLOT_SIZE];
+    }
+}
+
+BatchStats::BatchStats() : syscalls(0), packets(0) {
+    memset(histogram, 0, sizeof(histogram));
+}
+
+LidarUDPReceiver::LidarUDPReceiver(int port) : port_(port), socket_fd_(-1), latency_(NULL) {
+}
+
+LidarUDPReceiver::~LidarUDPReceiver() {
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+    }
+}
+
+bool LidarUDPReceiver::initialize() {
+    // Create UDP socket
+    socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_fd_ < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Set socket options to reuse address
+    int opt = 1;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Error setting socket options: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Bind socket to port
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port_);
+
+    if (bind(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        std::cerr << "Error binding socket to port " << port_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout << "UDP receiver initialized on port " << port_ << std::endl;
+    return true;
+}
+
+bool LidarUDPReceiver::enableLatencyStats(PipelineLatency* latency) {
+    int opt = latency ? 1 : 0;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPNS, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Error enabling receive timestamps: " << strerror(errno) << std::endl;
+        return false;
+    }
+    latency_ = latency;
+    return true;
+}
+
+void LidarUDPReceiver::recordKernelLatency(const struct msghdr& message, const struct timespec& now) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(const_cast<struct msghdr*>(&message)); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&message), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec stamp;
+            memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+            int64_t ns = int64_t(now.tv_sec - stamp.tv_sec) * 1000000000LL + (now.tv_nsec - stamp.tv_nsec);
+            // Both sides are CLOCK_REALTIME; a clock step can make this negative
+            if (ns >= 0) {
+                latency_->record(STAGE_KERNEL_TO_USER, uint64_t(ns));
+            }
+            return;
+        }
+    }
+}
+
+bool LidarUDPReceiver::receivePacket(uint8_t* buffer, size_t buffer_size, size_t& received_size) {
+    if (latency_ && latency_->isEnabled()) {
+        // recvmsg() instead of recvfrom() so the kernel timestamp comes along
+        struct iovec iov;
+        iov.iov_base = buffer;
+        iov.iov_len = buffer_size;
+        uint8_t control[CONTROL_SLOT_SIZE];
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        uint64_t wait_start = latency_->start();
+        ssize_t bytes_received = recvmsg(socket_fd_, &message, 0);
+        latency_->stop(STAGE_SOCKET_WAIT, wait_start);
+        if (bytes_received < 0) {
+            if (errno != EINTR) {
+                std::cerr << "Error receiving packet: " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+
+        // The kernel stamps packets with CLOCK_REALTIME, so compare against that
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        recordKernelLatency(message, now);
+
+        received_size = bytes_received;
+        return true;
+    }
+
+    struct sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+
+    ssize_t bytes_received = recvfrom(socket_fd_, buffer, buffer_size, 0,
+                                     (struct sockaddr*)&client_addr, &client_len);
+
+    if (bytes_received < 0) {
+        if (errno != EINTR) {
+            std::cerr << "Error receiving packet: " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+
+    received_size = bytes_received;
+    return true;
+}
+
+int LidarUDPReceiver::receiveBatch(PacketBatch& batch) {
+    batch.count = 0;
+
+    // The kernel shrinks msg_controllen to what it wrote; give every slot its full buffer back
+    bool timed = latency_ && latency_->isEnabled();
+    if (timed) {
+        for (int i = 0; i < batch.capacity; ++i) {
+            batch.messages[i].msg_hdr.msg_controllen = CONTROL_SLOT_SIZE;
+        }
+    }
+
+    // MSG_WAITFORONE: block for the first packet, then take only what is already queued
+    uint64_t wait_start = timed ? latency_->start() : 0;
+    int received = recvmmsg(socket_fd_, batch.messages.data(), batch.capacity,
+                            MSG_WAITFORONE, NULL);
+    if (received < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        std::cerr << "Error receiving packet batch: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    if (timed) {
+        latency_->stop(STAGE_SOCKET_WAIT, wait_start);
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);    // Kernel timestamps are CLOCK_REALTIME
+        for (int i = 0; i < received; ++i) {
+            recordKernelLatency(batch.messages[i].msg_hdr, now);
+        }
+    }
+
+    batch.count = received;
+    batch_stats_.syscalls++;
+    batch_stats_.packets += received;
+    if (received <= MAX_BATCH_SIZE) {
+        batch_stats_.histogram[received]++;
+    }
+    return received;
+}
@@ -0,0 +1,72 @@
+#ifndef UDP_RECEIVER_H
+#define UDP_RECEIVER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include "latency_histogram.h"
+
+// Largest datagram we expect (1248-byte "with header" MSOP packets fit easily)
+static const size_t PACKET_SLOT_SIZE = 2048;
+
+// Upper bound on packets pulled by a single recvmmsg() call
+static const int MAX_BATCH_SIZE = 64;
+
+// Preallocated array of packet slots filled by one recvmmsg() call
+struct PacketBatch {
+    explicit PacketBatch(int capacity);
+
+    const uint8_t* packet(int index) const { return &storage[index * PACKET_SLOT_SIZE]; }
+    size_t packetSize(int index) const { return messages[index].msg_len; }
+
+    int capacity;                           // Number of slots
+    int count;                              // Packets received by the last call
+    std::vector<uint8_t> storage;           // capacity * PACKET_SLOT_SIZE bytes
+    std::vector<struct iovec> iovecs;       // One iovec per slot, points into storage
+    std::vector<struct mmsghdr> messages;   // One message header per slot
+    std::vector<uint8_t> control;           // Per-slot ancillary data (kernel receive timestamps)
+};
+
+// Running totals showing how well recvmmsg() amortizes the syscall cost
+struct BatchStats {
+    uint64_t syscalls;                      // recvmmsg() calls that returned packets
+    uint64_t packets;                       // Packets returned by those calls
+    uint64_t histogram[MAX_BATCH_SIZE + 1]; // histogram[n] = calls that returned n packets
+
+    BatchStats();
+    double packetsPerSyscall() const { return syscalls ? double(packets) / syscalls : 0.0; }
+};
+
+class LidarUDPReceiver {
+public:
+    LidarUDPReceiver(int port = 2368);
+    ~LidarUDPReceiver();
+
+    bool initialize();
+
+    // Receive a single packet with one recvfrom() call
+    bool receivePacket(uint8_t* buffer, size_t buffer_size, size_t& received_size);
+
+    // Receive up to batch.capacity packets with one recvmmsg() call.
+    // Blocks until at least one packet arrives, then returns whatever is queued.
+    // Returns the number of packets received, 0 if a signal interrupted the wait,
+    // or -1 on error.
+    int receiveBatch(PacketBatch& batch);
+
+    const BatchStats& getBatchStats() const { return batch_stats_; }
+
+    // Record socket wait and kernel-to-user latency into `latency` from now on.
+    // Turns on SO_TIMESTAMPNS; call after initialize(). Pass NULL to stop.
+    bool enableLatencyStats(PipelineLatency* latency);
+
+private:
+    void recordKernelLatency(const struct msghdr& message, const struct timespec& now);
+
+    int port_;
+    int socket_fd_;
+    BatchStats batch_stats_;
+    PipelineLatency* latency_;
+};
+
+#endif // UDP_RECEIVER_H
@@ -0,0 +1,437 @@
+#include "uring_receiver.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+// Queue depth (the pool size, URING_POOL_BUFFERS, must be a power of two)
+static const unsigned int URING_QUEUE_DEPTH = 256;
+static const unsigned short URING_BUFFER_GROUP = 0;
+
+// user_data layout: low two bits = completion tag, upper bits = write cookie
+static const uint64_t TAG_MSOP = 0;
+static const uint64_t TAG_DIFOP = 1;
+static const uint64_t TAG_WRITE = 2;
+
+static int sysUringSetup(unsigned int entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sysUringEnter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0));
+}
+
+static int sysUringRegister(int fd, unsigned int opcode, void* arg, unsigned int nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+LidarUringReceiver::LidarUringReceiver(int port, int difop_port)
+    : port_(port), difop_port_(difop_port), ring_fd_(-1),
+      sq_ptr_(MAP_FAILED), sq_size_(0), sq_head_(NULL), sq_tail_(NULL), sq_mask_(NULL),
+      sq_array_(NULL), sqes_(NULL), sqes_size_(0), sq_entries_(0), sq_local_tail_(0), sq_pending_(0),
+      cq_ptr_(MAP_FAILED), cq_size_(0), cq_head_(NULL), cq_tail_(NULL), cq_mask_(NULL), cqes_(NULL),
+      buf_ring_(NULL), buf_ring_size_(0), buf_tail_(0) {
+    sockets_[0] = sockets_[1] = -1;
+    rearm_[0] = rearm_[1] = false;
+}
+
+LidarUringReceiver::~LidarUringReceiver() {
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);  // Cancels outstanding requests and unregisters the pool
+    }
+    if (buf_ring_ != NULL) {
+        munmap(buf_ring_, buf_ring_size_);
+    }
+    if (sqes_ != NULL) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+        munmap(sq_ptr_, sq_size_);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (sockets_[i] >= 0) {
+            close(sockets_[i]);
+        }
+    }
+}
+
+bool LidarUringReceiver::initialize() {
+    sockets_[0] = openSocket(port_);
+    if (sockets_[0] < 0) {
+        return false;
+    }
+    if (difop_port_ > 0) {
+        sockets_[1] = openSocket(difop_port_);
+        if (sockets_[1] < 0) {
+            return false;
+        }
+    }
+
+    if (!setupRing() || !registerBufferPool()) {
+        return false;
+    }
+
+    postReceive(0);
+    if (sockets_[1] >= 0) {
+        postReceive(1);
+    }
+    if (submitAndWait(0) < 0) {
+        return false;
+    }
+
+    std::cout << "io_uring receiver initialized on port " << port_;
+    if (sockets_[1] >= 0) {
+        std::cout << " (DIFOP on port " << difop_port_ << ")";
+    }
+    std::cout << ", " << URING_POOL_BUFFERS << " pooled buffers" << std::endl;
+    return true;
+}
+
+int LidarUringReceiver::openSocket(int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Error setting socket options: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        std::cerr << "Error binding socket to port " << port << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool LidarUringReceiver::setupRing() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd_ = sysUringSetup(URING_QUEUE_DEPTH, &params);
+    if (ring_fd_ < 0) {
+        std::cerr << "Error creating io_uring: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(NULL, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        std::cerr << "Error mapping submission queue: " << strerror(errno) << std::endl;
+        return false;
+    }
+    cq_ptr_ = single_mmap ? sq_ptr_
+                          : mmap(NULL, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                 ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+        std::cerr << "Error mapping completion queue: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::cerr << "Error mapping submission entries: " << strerror(errno) << std::endl;
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+
+    uint8_t* cq = static_cast<uint8_t*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+    return true;
+}
+
+bool LidarUringReceiver::registerBufferPool() {
+    pool_.resize(static_cast<size_t>(URING_POOL_BUFFERS) * PACKET_SLOT_SIZE);
+
+    // The buffer ring itself must be page aligned, so map it rather than allocate it
+    buf_ring_size_ = URING_POOL_BUFFERS * sizeof(struct io_uring_buf);
+    void* ring = mmap(NULL, buf_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED) {
+        std::cerr << "Error allocating buffer ring: " << strerror(errno) << std::endl;
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+    // Fault the pages in before the kernel pins them, or it may pin the shared zero page
+    memset(ring, 0, buf_ring_size_);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = URING_POOL_BUFFERS;
+    reg.bgid = URING_BUFFER_GROUP;
+    if (sysUringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        std::cerr << "Error registering buffer pool (needs Linux 5.19+): " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (unsigned int i = 0; i < URING_POOL_BUFFERS; ++i) {
+        releaseBuffer(static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+void LidarUringReceiver::releaseBuffer(uint16_t buffer_id) {
+    // Index from the ring base: in C++ the header's flexible "bufs" member is
+    // preceded by an empty struct and does not start at offset 0
+    struct io_uring_buf* bufs = reinterpret_cast<struct io_uring_buf*>(buf_ring_);
+    struct io_uring_buf* buf = &bufs[buf_tail_ & (URING_POOL_BUFFERS - 1)];
+    buf->addr = reinterpret_cast<uint64_t>(&pool_[buffer_id * PACKET_SLOT_SIZE]);
+    buf->len = PACKET_SLOT_SIZE;
+    buf->bid = buffer_id;
+    buf_tail_++;
+    __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* LidarUringReceiver::getSqe() {
+    unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sq_local_tail_ - head >= sq_entries_) {
+        // Queue full: hand what we have to the kernel first
+        submitAndWait(0);
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= sq_entries_) {
+            return NULL;
+        }
+    }
+
+    unsigned int index = sq_local_tail_ & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    sq_local_tail_++;
+    sq_pending_++;
+    return sqe;
+}
+
+void LidarUringReceiver::postReceive(int socket_index) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == NULL) {
+        rearm_[socket_index] = true;  // Retry on the next wait
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sockets_[socket_index];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    sqe->user_data = (socket_index == 0) ? TAG_MSOP : TAG_DIFOP;
+    rearm_[socket_index] = false;
+}
+
+bool LidarUringReceiver::queueWrite(int fd, const void* data, size_t size, uint64_t offset, uint64_t cookie) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == NULL) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->off = offset;
+    sqe->user_data = (cookie << 2) | TAG_WRITE;
+    return true;
+}
+
+bool LidarUringReceiver::queueWritev(int fd, const struct iovec* iov, int count, uint64_t offset, uint64_t cookie) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == NULL) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = static_cast<uint32_t>(count);
+    sqe->off = offset;
+    sqe->user_data = (cookie << 2) | TAG_WRITE;
+    return true;
+}
+
+int LidarUringReceiver::submitAndWait(unsigned int wait_for) {
+    // Publish filled SQEs, then submit and wait in a single syscall
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+    unsigned int to_submit = sq_pending_;
+    int ret;
+    do {
+        ret = sysUringEnter(ring_fd_, to_submit, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret < 0 && errno == EINTR && wait_for == 0);
+    stats_.enter_calls++;
+
+    if (ret < 0 && errno == EINTR) {
+        return 0;   // A signal ended the wait; nothing was submitted, so the next call retries
+    }
+    if (ret < 0) {
+        std::cerr << "Error in io_uring_enter: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    sq_pending_ -= std::min(sq_pending_, static_cast<unsigned int>(ret));
+    return ret;
+}
+
+int LidarUringReceiver::waitEvents(UringEvent* events, int max_events) {
+    for (int i = 0; i < 2; ++i) {
+        if (rearm_[i] && sockets_[i] >= 0) {
+            postReceive(i);
+        }
+    }
+
+    unsigned int head = *cq_head_;
+    unsigned int tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail || sq_pending_ > 0) {
+        // Only enter the kernel when there is nothing to reap or something to submit
+        if (submitAndWait(head == tail ? 1 : 0) < 0) {
+            return -1;
+        }
+        tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    }
+
+    int count = 0;
+    const struct io_uring_cqe* cqes = static_cast<const struct io_uring_cqe*>(cqes_);
+    while (head != tail && count < max_events) {
+        const struct io_uring_cqe& cqe = cqes[head & *cq_mask_];
+        head++;
+        stats_.completions++;
+
+        UringEvent& event = events[count];
+        uint64_t tag = cqe.user_data & 3;
+        event.cookie = cqe.user_data >> 2;
+        event.result = cqe.res;
+        event.data = NULL;
+        event.size = 0;
+        event.buffer_id = 0;
+
+        if (tag == TAG_WRITE) {
+            event.type = UringEvent::WRITE_DONE;
+            stats_.writes++;
+            count++;
+            continue;
+        }
+
+        int socket_index = (tag == TAG_MSOP) ? 0 : 1;
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            // The multishot receive was terminated (e.g. pool ran dry); post it again
+            rearm_[socket_index] = true;
+            stats_.rearms++;
+        }
+
+        if (cqe.res < 0) {
+            if (cqe.res == -ENOBUFS) {
+                stats_.buffer_starved++;
+                continue;
+            }
+            event.type = UringEvent::RECEIVE_ERROR;
+            count++;
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+            continue;
+        }
+
+        event.buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        event.data = &pool_[event.buffer_id * PACKET_SLOT_SIZE];
+        event.size = static_cast<size_t>(cqe.res);
+        if (socket_index == 0) {
+            event.type = UringEvent::MSOP_PACKET;
+            stats_.msop_packets++;
+        } else {
+            event.type = UringEvent::DIFOP_PACKET;
+            stats_.difop_packets++;
+        }
+        count++;
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+bool LidarUringReceiver::receivePacket(uint8_t* buffer, size_t buffer_size, size_t& received_size) {
+    UringEvent event;
+    while (true) {
+        int count = waitEvents(&event, 1);
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            continue;
+        }
+        if (event.type == UringEvent::RECEIVE_ERROR) {
+            std::cerr << "Error receiving packet: " << strerror(-event.result) << std::endl;
+            return false;
+        }
+        if (event.type == UringEvent::MSOP_PACKET) {
+            received_size = std::min(event.size, buffer_size);
+            memcpy(buffer, event.data, received_size);
+            releaseBuffer(event.buffer_id);
+            return true;
+        }
+        if (event.type == UringEvent::DIFOP_PACKET) {
+            releaseBuffer(event.buffer_id);
+        }
+    }
+}
+
+int LidarUringReceiver::receiveBatch(PacketBatch& batch) {
+    UringEvent events[MAX_BATCH_SIZE];
+    batch.count = 0;
+
+    while (batch.count == 0) {
+        int count = waitEvents(events, std::min(batch.capacity, MAX_BATCH_SIZE));
+        if (count < 0) {
+            return -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (events[i].type == UringEvent::MSOP_PACKET) {
+                size_t size = std::min(events[i].size, PACKET_SLOT_SIZE);
+                memcpy(&batch.storage[batch.count * PACKET_SLOT_SIZE], events[i].data, size);
+                batch.messages[batch.count].msg_len = static_cast<unsigned int>(size);
+                batch.count++;
+            }
+            if (events[i].type == UringEvent::MSOP_PACKET || events[i].type == UringEvent::DIFOP_PACKET) {
+                releaseBuffer(events[i].buffer_id);
+            }
+        }
+    }
+    return batch.count;
+}
@@ -0,0 +1,121 @@
+#ifndef URING_RECEIVER_H
+#define URING_RECEIVER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "udp_receiver.h"
+
+struct io_uring_sqe;
+struct io_uring_buf_ring;
+struct iovec;
+
+// Packet buffers in the provided pool; buffer ids run from 0 to URING_POOL_BUFFERS - 1
+static const unsigned int URING_POOL_BUFFERS = 512;
+
+// One completion taken from the io_uring completion queue
+struct UringEvent {
+    enum Type {
+        MSOP_PACKET,        // data/size point into a pooled buffer; call releaseBuffer()
+        DIFOP_PACKET,       // Same, for the DIFOP socket
+        WRITE_DONE,         // A queueWrite()/queueWritev() finished; result = bytes written or -errno
+        RECEIVE_ERROR       // A receive failed; result = -errno
+    };
+
+    Type type;
+    const uint8_t* data;
+    size_t size;
+    uint16_t buffer_id;
+    int result;
+    uint64_t cookie;        // Caller value passed to queueWrite()
+};
+
+struct UringStats {
+    uint64_t enter_calls;       // io_uring_enter() syscalls
+    uint64_t completions;       // CQEs reaped
+    uint64_t msop_packets;
+    uint64_t difop_packets;
+    uint64_t writes;            // Completed disk writes
+    uint64_t rearms;            // Multishot receives that had to be posted again
+    uint64_t buffer_starved;    // Times the buffer pool ran dry (-ENOBUFS)
+
+    UringStats() : enter_calls(0), completions(0), msop_packets(0), difop_packets(0),
+                   writes(0), rearms(0), buffer_starved(0) {}
+};
+
+// Asynchronous receiver on io_uring. Multishot receives stay posted on the MSOP
+// and (optionally) DIFOP sockets and pick buffers from a kernel-registered pool,
+// so packets land without a blocking recvfrom(). Disk writes go through the same
+// ring, letting one thread service both sockets and a recording file.
+// Requires Linux 6.0+ (provided buffer rings and multishot recv).
+class LidarUringReceiver {
+public:
+    LidarUringReceiver(int port = 2368, int difop_port = -1);
+    ~LidarUringReceiver();
+
+    bool initialize();
+
+    // Same calls as LidarUDPReceiver; packets are copied out of the pool
+    bool receivePacket(uint8_t* buffer, size_t buffer_size, size_t& received_size);
+    int receiveBatch(PacketBatch& batch);
+
+    // Block until at least one completion is available, then return up to max_events.
+    // Returns 0 if a signal interrupted the wait, -1 on error.
+    int waitEvents(UringEvent* events, int max_events);
+
+    // Return a packet buffer to the pool once its data is no longer needed
+    void releaseBuffer(uint16_t buffer_id);
+
+    // Queue an asynchronous write; data must stay valid until the WRITE_DONE event
+    bool queueWrite(int fd, const void* data, size_t size, uint64_t offset, uint64_t cookie);
+
+    // Same, gathering from count buffers; iov and the data must stay valid until WRITE_DONE
+    bool queueWritev(int fd, const struct iovec* iov, int count, uint64_t offset, uint64_t cookie);
+
+    const UringStats& getStats() const { return stats_; }
+
+private:
+    bool setupRing();
+    bool registerBufferPool();
+    int openSocket(int port);
+    io_uring_sqe* getSqe();
+    void postReceive(int socket_index);
+    int submitAndWait(unsigned int wait_for);
+
+    int port_;
+    int difop_port_;
+    int sockets_[2];            // [0] = MSOP, [1] = DIFOP (or -1)
+    int ring_fd_;
+
+    // Submission queue
+    void* sq_ptr_;
+    size_t sq_size_;
+    unsigned int* sq_head_;
+    unsigned int* sq_tail_;
+    unsigned int* sq_mask_;
+    unsigned int* sq_array_;
+    io_uring_sqe* sqes_;
+    size_t sqes_size_;
+    unsigned int sq_entries_;
+    unsigned int sq_local_tail_;    // SQEs filled but not yet published
+    unsigned int sq_pending_;
+
+    // Completion queue
+    void* cq_ptr_;
+    size_t cq_size_;
+    unsigned int* cq_head_;
+    unsigned int* cq_tail_;
+    unsigned int* cq_mask_;
+    void* cqes_;
+
+    // Provided buffer pool
+    io_uring_buf_ring* buf_ring_;
+    size_t buf_ring_size_;
+    std::vector<uint8_t> pool_;
+    unsigned short buf_tail_;
+
+    bool rearm_[2];
+    UringStats stats_;
+};
+
+#endif // URING_RECEIVER_H
@@ -5,14 +5,11 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <opencv2/opencv.hpp>
+#include "src/azimuth_table.hpp"
+#include "../common/msop_packet_view.h"
 
 #define PORT 2368
 #define BUFLEN 2048
-#define HEADER_FLAG 0xFFEE
-
-uint16_t read_be16(const uint8_t* data) {
-    return (data[0] << 8) | data[1];
-}
 
 int main() {
     int sockfd;
@@ -32,36 +29,39 @@ int main() {
     const float scale = 100.0f; // 1 meter = 100 pixels
 
     cv::Mat canvas(img_size, img_size, CV_8UC3, cv::Scalar(0, 0, 0));
+    AzimuthTable azimuth_table;
 
     while (true) {
         ssize_t len = recv(sockfd, buffer, BUFLEN, 0);
-        if (len < 100) continue;
+        if (len != static_cast<ssize_t>(MSOPPacketView::PACKET_SIZE)) continue;
 
-        uint16_t flag = read_be16(buffer);
-        if (flag != HEADER_FLAG) continue;
+        // Decode the packet straight out of the receive buffer
+        MSOPPacketView packet(buffer);
+        for (int b = 0; b < MSOPPacketView::BLOCK_COUNT; ++b) {
+            if (packet.blockFlag(b) != MSOPPacketView::VALID_BLOCK_FLAG) continue;
 
-        uint16_t az_raw = read_be16(buffer + 2);
-        if (az_raw == 0xFFFF) continue;
+            uint16_t az_raw = packet.blockAzimuth(b);
+            if (az_raw >= AzimuthTable::SIZE) continue;
 
-        float az_deg = az_raw / 100.0f;
-        float az_rad = az_deg * M_PI / 180.0f;
+            float az_cos = azimuth_table.cos(az_raw);
+            float az_sin = azimuth_table.sin(az_raw);
 
-        for (int i = 0; i < 16; ++i) {
-            const uint8_t* p = buffer + 4 + i * 6;
-            uint16_t dist_mm = read_be16(p);
-            uint8_t rssi = p[2];
+            for (int i = 0; i < MSOPPacketView::MEASUREMENTS_PER_BLOCK; ++i) {
+                uint16_t dist_mm = packet.distanceStrongest(b, i);
+                uint8_t rssi = packet.rssiStrongest(b, i);
 
-            if (dist_mm == 0xFFFF || dist_mm == 0 || rssi == 0) continue;
+                if (dist_mm == 0xFFFF || dist_mm == 0 || rssi == 0) continue;
 
-            float r = dist_mm / 1000.0f; // convert mm to meters
-            float x = r * cos(az_rad);
-            float y = r * sin(az_rad);
+                float r = dist_mm / 1000.0f; // convert mm to meters
+                float x = r * az_cos;
+                float y = r * az_sin;
 
-            int px = center + static_cast<int>(x * scale);
-            int py = center - static_cast<int>(y * scale);
+                int px = center + static_cast<int>(x * scale);
+                int py = center - static_cast<int>(y * scale);
 
-            if (px >= 0 && px < img_size && py >= 0 && py < img_size)
-                cv::circle(canvas, cv::Point(px, py), 1, cv::Scalar(255, 255, 255), -1);
+                if (px >= 0 && px < img_size && py >= 0 && py < img_size)
+                    cv::circle(canvas, cv::Point(px, py), 1, cv::Scalar(255, 255, 255), -1);
+            }
         }
 
         // Show and clear
@@ -0,0 +1,80 @@
+// azimuth_table.cpp
+
+#include "azimuth_table.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AZIMUTH_TABLE_X86 1
+#endif
+
+namespace {
+
+constexpr double CENTIDEG_TO_RAD = 3.14159265358979323846 / 18000.0;
+
+void toCartesianScalar(const float* cos_tab, const float* sin_tab,
+                       const uint16_t* raw, const float* range, size_t n,
+                       float* x, float* y) {
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = range[i] * cos_tab[raw[i]];
+    y[i] = range[i] * sin_tab[raw[i]];
+  }
+}
+
+#ifdef AZIMUTH_TABLE_X86
+__attribute__((target("avx2")))
+void toCartesianAvx2(const float* cos_tab, const float* sin_tab,
+                     const uint16_t* raw, const float* range, size_t n,
+                     float* x, float* y) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i idx = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i)));
+    __m256 r = _mm256_loadu_ps(range + i);
+    __m256 c = _mm256_i32gather_ps(cos_tab, idx, 4);
+    __m256 s = _mm256_i32gather_ps(sin_tab, idx, 4);
+    _mm256_storeu_ps(x + i, _mm256_mul_ps(r, c));
+    _mm256_storeu_ps(y + i, _mm256_mul_ps(r, s));
+  }
+  toCartesianScalar(cos_tab, sin_tab, raw + i, range + i, n - i, x + i, y + i);
+}
+
+bool haveAvx2() {
+  static const bool avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return avx2;
+}
+#endif
+
+} // namespace
+
+AzimuthTable::AzimuthTable(int angle_offset, bool inverted)
+  : offset_centideg_((angle_offset % 360) * 100),
+    inverted_(inverted),
+    cos_(SIZE),
+    sin_(SIZE)
+{
+  for (int raw = 0; raw < SIZE; ++raw) {
+    double rad = mountedCentideg(static_cast<uint16_t>(raw)) * CENTIDEG_TO_RAD;
+    cos_[raw] = static_cast<float>(std::cos(rad));
+    sin_[raw] = static_cast<float>(std::sin(rad));
+  }
+}
+
+double AzimuthTable::angle(uint16_t raw) const {
+  return mountedCentideg(raw) * CENTIDEG_TO_RAD;
+}
+
+void AzimuthTable::toCartesian(const uint16_t* raw, const float* range, size_t n,
+                               float* x, float* y) const {
+#ifdef AZIMUTH_TABLE_X86
+  if (haveAvx2()) {
+    toCartesianAvx2(cos_.data(), sin_.data(), raw, range, n, x, y);
+    return;
+  }
+#endif
+  toCartesianScalar(cos_.data(), sin_.data(), raw, range, n, x, y);
+}
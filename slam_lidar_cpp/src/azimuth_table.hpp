@@ -0,0 +1,48 @@
+// src/azimuth_table.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Precomputed cos/sin for every azimuth the sensor can report.
+///
+/// MSOP azimuths are quantized to 0.01°, so 36000 entries cover every angle.
+/// The table is indexed by the raw centidegree value from the packet and has the
+/// mounting transform (angle offset, upside-down mirror) already applied, so a
+/// Cartesian conversion is two loads and two multiplies per point.
+class AzimuthTable {
+public:
+  static constexpr int SIZE = 36000;  // 0.01° steps over a full turn
+
+  /// angle_offset is the mounting yaw in degrees; inverted mirrors the scan
+  /// direction for a sensor mounted upside down.
+  explicit AzimuthTable(int angle_offset = 0, bool inverted = false);
+
+  /// Mounted angle in centidegrees [0, 36000) for a raw centidegree azimuth.
+  int mountedCentideg(uint16_t raw) const {
+    int m = (inverted_ ? -static_cast<int>(raw % SIZE) : static_cast<int>(raw % SIZE)) + offset_centideg_;
+    m %= SIZE;
+    return m < 0 ? m + SIZE : m;
+  }
+
+  /// Mounted angle in radians [0, 2π).
+  double angle(uint16_t raw) const;
+
+  float cos(uint16_t raw) const { return cos_[raw % SIZE]; }
+  float sin(uint16_t raw) const { return sin_[raw % SIZE]; }
+
+  /// Convert n polar points to x/y. raw holds centidegree azimuths (< 36000),
+  /// range is in meters. Uses AVX2 gathers when the CPU has them.
+  void toCartesian(const uint16_t* raw, const float* range, size_t n,
+                   float* x, float* y) const;
+
+  int angleOffset() const { return offset_centideg_ / 100; }
+  bool inverted() const { return inverted_; }
+
+private:
+  int  offset_centideg_;
+  bool inverted_;
+  std::vector<float> cos_;
+  std::vector<float> sin_;
+};
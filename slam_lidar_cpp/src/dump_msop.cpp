@@ -1,10 +1,10 @@
-#include "data_type.h"
+#include "msop_packet_view.h"
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <iostream>
 #include <iomanip>
-#include <cstring>
+#include <cstdlib>
 
 int main(int argc, char** argv) {
   if (argc < 2) {
@@ -25,25 +25,31 @@ int main(int argc, char** argv) {
   }
 
   // 2) Receive one MSOP packet
-  MSOP_Data_t pkt;
-  ssize_t n = recvfrom(sock, &pkt, sizeof(pkt), 0, nullptr, nullptr);
+  uint8_t buf[MSOPPacketView::PACKET_SIZE];
+  ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, nullptr, nullptr);
   if (n < 0) { perror("recvfrom"); return 1; }
   std::cout << "Got " << n << " bytes:\n";
+  if (n != static_cast<ssize_t>(MSOPPacketView::PACKET_SIZE)) {
+    std::cerr << "Not an MSOP packet (expected " << MSOPPacketView::PACKET_SIZE << " bytes)\n";
+    return 1;
+  }
 
   // 3) For each of the 12 blocks, print flag, azimuth, first 4 distances+RSSI
-  for (int b = 0; b < 12; ++b) {
-    auto blk = pkt.BlockID[b];
-    uint16_t flag = ntohs(blk.DataFlag);
-    uint16_t az   = ntohs(blk.Azimuth);
+  MSOPPacketView pkt(buf);
+  for (int b = 0; b < MSOPPacketView::BLOCK_COUNT; ++b) {
+    uint16_t flag = pkt.blockFlag(b);
+    uint16_t az   = pkt.blockAzimuth(b);
     std::cout << "Block " << std::setw(2) << b
               << " | flag=0x" << std::hex << flag
               << " | az=" << std::dec << (az/100.0) << "°\n";
     for (int i = 0; i < 4; ++i) {
-      uint16_t d = ntohs(blk.Result[i].Dist_1);
-      uint8_t  r = blk.Result[i].RSSI_1;
+      uint16_t d = pkt.distanceStrongest(b, i);
+      uint8_t  r = pkt.rssiStrongest(b, i);
       std::cout << "    ["<<i<<"] dist="<<d<<" mm, rssi="<<(int)r<<"\n";
     }
   }
+  std::cout << "timestamp=" << pkt.timestamp() << " us, factory=0x"
+            << std::hex << pkt.factoryInfo() << std::dec << "\n";
 
   close(sock);
   return 0;
@@ -4,28 +4,37 @@
 #include "data_type.h"
 
 #include <unistd.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstring>
 #include <stdexcept>
-#include <limits>
-#include <cmath>
 #include <vector>
 
-#ifndef M_PI
-static constexpr double M_PI = 3.14159265358979323846;
-#endif
+// Control buffer for one SCM_TIMESTAMPNS message, in uint64_t units
+static constexpr size_t CTRL_WORDS = (CMSG_SPACE(sizeof(timespec)) + 7) / 8;
 
-static constexpr int   BLOCKS_PER_SCAN   = 12;
-static constexpr int   POINTS_PER_BLOCK  = 16;
-static constexpr double INF_DIST         = std::numeric_limits<double>::infinity();
+/// Kernel receive time (CLOCK_REALTIME) from the SCM_TIMESTAMPNS cmsg, if present.
+static bool kernelTimestamp(msghdr& hdr, timespec& ts) {
+  for (cmsghdr* c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+      std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+      return true;
+    }
+  }
+  return false;
+}
 
 LiDARReader::LiDARReader(const std::string& /*host_ip*/,
                          int port,
                          int angle_offset,
                          bool inverted)
-  : angle_offset_(angle_offset),
-    inverted_(inverted)
+  : port_(port),
+    angle_offset_(angle_offset),
+    inverted_(inverted),
+    azimuth_table_(angle_offset, inverted),
+    assembler_(azimuth_table_)
 {
   sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
   if (sockfd_ < 0) throw std::runtime_error("socket() failed");
@@ -42,76 +51,319 @@ LiDARReader::LiDARReader(const std::string& /*host_ip*/,
            reinterpret_cast<sockaddr*>(&addr),
            sizeof(addr)) < 0)
     throw std::runtime_error("bind() failed");
+
+  setBatchSize(1);
+}
+
+LiDARReader::LiDARReader(std::unique_ptr<PcapReplay> replay,
+                         int angle_offset,
+                         bool inverted)
+  : sockfd_(-1),
+    angle_offset_(angle_offset),
+    inverted_(inverted),
+    azimuth_table_(angle_offset, inverted),
+    assembler_(azimuth_table_),
+    replay_(std::move(replay))
+{
+  if (!replay_) throw std::invalid_argument("null pcap replay");
+  setBatchSize(1);
 }
 
 LiDARReader::~LiDARReader() {
   if (sockfd_ >= 0) close(sockfd_);
 }
 
-void LiDARReader::recvPacket(MSOP_Data_t& buf) {
+int LiDARReader::recvPacket(MSOP_Data_t& buf, int flags) {
   sockaddr_in client{};
   socklen_t   len = sizeof(client);
-  ssize_t     n   = recvfrom(sockfd_, &buf, sizeof(buf), 0,
+  uint64_t    t0  = latency_.start();
+  // MSG_TRUNC: report the real length of an oversized datagram
+  ssize_t     n   = recvfrom(sockfd_, &buf, sizeof(buf), MSG_TRUNC | flags,
                              reinterpret_cast<sockaddr*>(&client), &len);
-  if (n < 0 || static_cast<size_t>(n) != sizeof(buf))
-    throw std::runtime_error("recvfrom error or incomplete packet");
+  if (n < 0) return -1;
+  if (!(flags & MSG_DONTWAIT)) latency_.stop(STAGE_SOCKET_WAIT, t0);
+  batch_msgs_[0].msg_len = static_cast<unsigned>(n);  // checked by classify()
+  batch_stats_.syscalls++;
+  batch_stats_.packets++;
+  return 1;
 }
 
-std::vector<ScanPoint> LiDARReader::readScan() {
-  // 1) Read exactly one MSOP packet (all 12 blocks)
-  MSOP_Data_t packet;
-  recvPacket(packet);
-
-  // 2) Byte-swap and stash each block
-  Data_block blocks[BLOCKS_PER_SCAN];
-  for (int b = 0; b < BLOCKS_PER_SCAN; ++b) {
-    Data_block blk = packet.BlockID[b];
-    blk.DataFlag = ntohs(blk.DataFlag);
-    blk.Azimuth  = ntohs(blk.Azimuth);
-    for (int i = 0; i < POINTS_PER_BLOCK; ++i)
-      blk.Result[i].Dist_1 = ntohs(blk.Result[i].Dist_1);
-    blocks[b] = blk;
-  }
-
-  // 3) Compute azimuth increment (in degrees) across a block,
-  //    accounting for wrap at 36000 (hundredths of a degree).
-  int raw0    = blocks[0].Azimuth;
-  int raw1    = blocks[1].Azimuth;
-  int diff100 = (raw1 - raw0 + 36000) % 36000;      // in hundredths
-  double step_deg = (diff100 / 100.0) / POINTS_PER_BLOCK;  // degrees
-
-  // 4) Allocate output (12×16 = 192 points)
-  std::vector<ScanPoint> scan(BLOCKS_PER_SCAN * POINTS_PER_BLOCK);
-
-  // 5) Fill in each beam
-  for (int b = 0; b < BLOCKS_PER_SCAN; ++b) {
-    const auto &blk = blocks[b];
-    double base_deg = (blk.Azimuth / 100.0) + angle_offset_;
-
-    for (int i = 0; i < POINTS_PER_BLOCK; ++i) {
-      // angle in degrees, wrapped to [0,360)
-      double raw_deg = base_deg + step_deg * i;
-      raw_deg = std::fmod(raw_deg, 360.0);
-      if (raw_deg < 0) raw_deg += 360.0;
-      double ang_rad = raw_deg * M_PI / 180.0;
-
-      // distance in meters
-      double dist_m   = blk.Result[i].Dist_1 / 1000.0;
-      double intensity = blk.Result[i].RSSI_1;
-
-      // mark invalid if flag wrong or zero‐distance
-      if (blk.DataFlag != 0xFFEE || dist_m <= 0) {
-        dist_m    = INF_DIST;
-        intensity = 0;
-      }
+void LiDARReader::setBatchSize(int batch_size) {
+  if (batch_size < 1 || batch_size > MAX_BATCH_SIZE)
+    throw std::invalid_argument("batch size out of range");
+
+  // Preallocate the packet array and point each message header at its slot
+  batch_.assign(batch_size, MSOP_Data_t{});
+  batch_iov_.assign(batch_size, iovec{});
+  batch_msgs_.assign(batch_size, mmsghdr{});
+  batch_addrs_.assign(batch_size, sockaddr_in{});
+  batch_ctrl_.assign(batch_size * CTRL_WORDS, 0);
+  for (int i = 0; i < batch_size; ++i) {
+    batch_iov_[i].iov_base = &batch_[i];
+    batch_iov_[i].iov_len  = sizeof(MSOP_Data_t);
+    batch_msgs_[i].msg_hdr.msg_iov    = &batch_iov_[i];
+    batch_msgs_[i].msg_hdr.msg_iovlen = 1;
+    batch_msgs_[i].msg_hdr.msg_name    = &batch_addrs_[i];
+    batch_msgs_[i].msg_hdr.msg_control = &batch_ctrl_[i * CTRL_WORDS];
+  }
+  batch_count_ = 0;
+  batch_pos_   = 0;
+}
+
+void LiDARReader::recordTo(const std::string& pcap_path) {
+  if (replay_) throw std::logic_error("cannot record while replaying a capture");
+
+  int yes = 1;
+  if (setsockopt(sockfd_, SOL_SOCKET, SO_TIMESTAMPNS, &yes, sizeof(yes)) < 0)
+    throw std::runtime_error("setsockopt(SO_TIMESTAMPNS) failed");
+  recorder_.reset(new PcapWriter(pcap_path, static_cast<uint16_t>(port_)));
+}
+
+void LiDARReader::enableLatencyStats(bool enable) {
+  if (sockfd_ >= 0 && !recorder_) {
+    int on = enable ? 1 : 0;
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+      throw std::runtime_error("setsockopt(SO_TIMESTAMPNS) failed");
+  }
+  latency_.setEnabled(enable);
+  assembler_.setLatency(enable ? &latency_ : nullptr);
+}
+
+int LiDARReader::recvBatch(int flags) {
+  // The kernel overwrites these lengths on every call
+  for (auto& msg : batch_msgs_) {
+    msg.msg_hdr.msg_namelen    = sizeof(sockaddr_in);
+    msg.msg_hdr.msg_controllen = wantTimestamps() ? CTRL_WORDS * sizeof(uint64_t) : 0;
+  }
+
+  // Block for the first packet, then take whatever else is already queued
+  uint64_t t0 = latency_.start();
+  int n = recvmmsg(sockfd_, batch_msgs_.data(), batch_msgs_.size(),
+                   MSG_WAITFORONE | flags, nullptr);
+  if (n <= 0) return -1;
+  if (!(flags & MSG_DONTWAIT)) latency_.stop(STAGE_SOCKET_WAIT, t0);
+  for (int i = 0; i < n; ++i) {
+    // An oversized datagram fills the slot exactly; mark it longer so
+    // classify() does not take it for a packet
+    if (batch_msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) batch_msgs_[i].msg_len = sizeof(MSOP_Data_t) + 1;
+  }
+  batch_count_ = n;
+  batch_pos_   = 0;
+  batch_stats_.syscalls++;
+  batch_stats_.packets += n;
 
-      int idx = b * POINTS_PER_BLOCK + i;
-      if (inverted_) {
-        idx = BLOCKS_PER_SCAN * POINTS_PER_BLOCK - 1 - idx;
+  if (latency_.isEnabled()) {
+    // Kernel timestamps are CLOCK_REALTIME, so measure against the same clock
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (int i = 0; i < n; ++i) {
+      timespec ts;
+      if (!kernelTimestamp(batch_msgs_[i].msg_hdr, ts)) continue;
+      int64_t ns = int64_t(now.tv_sec - ts.tv_sec) * 1000000000 + (now.tv_nsec - ts.tv_nsec);
+      if (ns >= 0) latency_.record(STAGE_KERNEL_TO_USER, uint64_t(ns));  // < 0: clock stepped
+    }
+  }
+
+  if (recorder_) {
+    for (int i = 0; i < n; ++i) {
+      if (batch_msgs_[i].msg_len > sizeof(MSOP_Data_t)) continue;  // oversized
+      timespec ts{};
+      if (!kernelTimestamp(batch_msgs_[i].msg_hdr, ts)) clock_gettime(CLOCK_REALTIME, &ts);
+      recorder_->write(reinterpret_cast<const uint8_t*>(&batch_[i]), batch_msgs_[i].msg_len,
+                       ts, &batch_addrs_[i]);
+    }
+  }
+  return n;
+}
+
+const char* LiDARReader::statusName(ReadStatus status) {
+  switch (status) {
+    case ReadStatus::Ok:           return "ok";
+    case ReadStatus::Timeout:      return "timeout";
+    case ReadStatus::Truncated:    return "truncated packet";
+    case ReadStatus::Foreign:      return "foreign packet";
+    case ReadStatus::EndOfCapture: return "end of capture";
+    case ReadStatus::Interrupted:  return "interrupted";
+    case ReadStatus::SocketError:  return "socket error";
+  }
+  return "unknown";
+}
+
+LiDARReader::ReadStatus LiDARReader::socketFailure(int error) {
+  receive_counters_.last_errno = error;
+  if (error == EINTR) return ReadStatus::Interrupted;
+  receive_counters_.socket_errors++;
+  return ReadStatus::SocketError;
+}
+
+LiDARReader::ReadStatus LiDARReader::waitReadable(Clock::time_point deadline) {
+  Clock::time_point now = Clock::now();
+  if (now >= deadline) {
+    receive_counters_.timeouts++;
+    return ReadStatus::Timeout;
+  }
+  auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+  timespec timeout;
+  timeout.tv_sec  = remaining / 1000000000;
+  timeout.tv_nsec = remaining % 1000000000;
+  pollfd pfd{sockfd_, POLLIN, 0};
+
+  uint64_t t0 = latency_.start();
+  int ready = ppoll(&pfd, 1, &timeout, nullptr);
+  latency_.stop(STAGE_SOCKET_WAIT, t0);
+  if (ready < 0) return socketFailure(errno);
+  if (ready == 0) {
+    receive_counters_.timeouts++;
+    return ReadStatus::Timeout;
+  }
+  return ReadStatus::Ok;
+}
+
+LiDARReader::ReadStatus LiDARReader::receive(Clock::time_point deadline) {
+  // No deadline: one blocking receive, as cheap as before deadlines existed.
+  // Otherwise take what is queued and poll only when there is nothing.
+  const int flags = deadline == Clock::time_point::max() ? 0 : MSG_DONTWAIT;
+  if (flags) {
+    // Past the deadline, queued packets are still taken (tryReadScan() relies
+    // on it), but only so many: a flood of bad datagrams must not hold the
+    // call forever
+    if (Clock::now() >= deadline) {
+      if (overdue_budget_ <= 0) {
+        receive_counters_.timeouts++;
+        return ReadStatus::Timeout;
       }
-      scan[idx] = { ang_rad, dist_m, intensity };
+      overdue_budget_ -= static_cast<int>(batch_.size());
+    }
+  }
+  while (true) {
+    // Timestamps need recvmmsg() for the cmsg, even one packet at a time
+    int n = batch_.size() == 1 && !wantTimestamps() ? recvPacket(batch_[0], flags) : recvBatch(flags);
+    if (n > 0) {
+      batch_count_ = n;
+      batch_pos_   = 0;
+      return ReadStatus::Ok;
     }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) return socketFailure(errno);
+
+    ReadStatus waited = waitReadable(deadline);
+    if (waited != ReadStatus::Ok) return waited;
   }
+}
 
+LiDARReader::ReadStatus LiDARReader::classify(const uint8_t* data, size_t size,
+                                              MSOPPacketView& packet) {
+  if (size < MSOPPacketView::PACKET_SIZE) {
+    receive_counters_.truncated++;
+    continuity_.countMalformed();
+    return ReadStatus::Truncated;
+  }
+  MSOPPacketView view(data);
+  uint16_t flag = view.blockFlag(0);
+  if (size > MSOPPacketView::PACKET_SIZE ||
+      (flag != MSOPPacketView::VALID_BLOCK_FLAG && flag != MSOPPacketView::INVALID_BLOCK_FLAG)) {
+    receive_counters_.foreign++;
+    continuity_.countMalformed();
+    return ReadStatus::Foreign;
+  }
+  packet = view;
+  return ReadStatus::Ok;
+}
+
+LiDARReader::ReadStatus LiDARReader::nextPacket(MSOPPacketView& packet, Clock::time_point deadline) {
+  if (replay_) {
+    // The payload is decoded where it lies in the mapping
+    const uint8_t* data;
+    size_t size;
+    if (!replay_->next(data, size)) return ReadStatus::EndOfCapture;
+    return classify(data, size, packet);
+  }
+
+  if (batch_pos_ == batch_count_) {
+    ReadStatus status = receive(deadline);
+    if (status != ReadStatus::Ok) return status;
+  }
+  int i = batch_pos_++;
+  return classify(reinterpret_cast<const uint8_t*>(&batch_[i]), batch_msgs_[i].msg_len, packet);
+}
+
+bool LiDARReader::addPacket(MSOPPacketView packet) {
+  // A repeat would put its blocks in the revolution twice, and a late packet
+  // would step the azimuth back into a revolution that has moved on
+  ContinuityTracker::Verdict verdict = continuity_.addPacket(packet);
+  if (verdict == ContinuityTracker::DUPLICATE ||
+      verdict == ContinuityTracker::OUT_OF_ORDER) {
+    return false;
+  }
+  return assembler_.addPacket(packet);
+}
+
+LiDARReader::ReadStatus LiDARReader::assemble(Clock::time_point deadline) {
+  // Feed packets (from the batch if one is pending) until a revolution closes
+  MSOPPacketView packet(nullptr);
+  while (true) {
+    ReadStatus status = nextPacket(packet, deadline);
+    if (status == ReadStatus::Ok) {
+      if (addPacket(packet)) return ReadStatus::Ok;
+    } else if (status != ReadStatus::Truncated && status != ReadStatus::Foreign) {
+      return status;
+    }
+    // Bad datagrams are counted by classify(); keep receiving
+  }
+}
+
+LiDARReader::ReadStatus LiDARReader::readScan(std::vector<ScanPoint>& scan, Clock::time_point deadline) {
+  overdue_budget_ = MAX_OVERDUE_PACKETS;
+  ReadStatus status = assemble(deadline);
+  if (status != ReadStatus::Ok) return status;
+  uint64_t t0 = latency_.start();
+  scan.assign(assembler_.completed().begin(), assembler_.completed().end());
+  latency_.stop(STAGE_HANDOFF, t0);
+  return ReadStatus::Ok;
+}
+
+LiDARReader::ReadStatus LiDARReader::tryReadScan(std::vector<ScanPoint>& scan) {
+  return readScan(scan, Clock::time_point::min());
+}
+
+LiDARReader::ReadStatus LiDARReader::readPacket(Clock::time_point deadline, bool& completed) {
+  completed = false;
+  overdue_budget_ = MAX_OVERDUE_PACKETS;
+  MSOPPacketView packet(nullptr);
+  ReadStatus status = nextPacket(packet, deadline);
+  if (status == ReadStatus::Ok) completed = addPacket(packet);
+  return status;
+}
+
+std::vector<ScanPoint> LiDARReader::readScan() {
+  const std::vector<ScanPoint>& revolution = readRevolution();
+  uint64_t t0 = latency_.start();
+  std::vector<ScanPoint> scan(revolution);
+  latency_.stop(STAGE_HANDOFF, t0);
   return scan;
 }
+
+const std::vector<ScanPoint>& LiDARReader::readRevolution() {
+  switch (assemble(Clock::time_point::max())) {
+    case ReadStatus::Ok:
+      return assembler_.completed();
+    case ReadStatus::EndOfCapture:
+      throw EndOfCapture();
+    default:
+      throw std::runtime_error(std::string("receive failed: ") +
+                               std::strerror(receive_counters_.last_errno));
+  }
+}
+
+void LiDARReader::toCartesian(const std::vector<ScanPoint>& scan,
+                              std::vector<float>& x, std::vector<float>& y) {
+  const size_t n = scan.size();
+  cart_raw_.resize(n);
+  cart_range_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    cart_raw_[i]   = scan[i].raw_azimuth;
+    cart_range_[i] = static_cast<float>(scan[i].range);
+  }
+  x.resize(n);
+  y.resize(n);
+  azimuth_table_.toCartesian(cart_raw_.data(), cart_range_.data(), n, x.data(), y.data());
+}
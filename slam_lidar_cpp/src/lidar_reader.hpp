@@ -3,32 +3,180 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+#include <chrono>
 #include <cstdint>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include "data_type.h"
-
-struct ScanPoint {
-  double angle;     // radians
-  double range;     // meters
-  double intensity; // RSSI units
-};
+#include "azimuth_table.hpp"
+#include "scan_assembler.hpp"
+#include "msop_packet_view.h"
+#include "pcap_io.hpp"
+#include "latency_histogram.h"
+#include "continuity_tracker.h"
 
 class LiDARReader {
 public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Outcome of the non-throwing receive calls.
+  enum class ReadStatus {
+    Ok,            // a revolution (readScan) or an MSOP packet (readPacket) is ready
+    Timeout,       // the deadline passed first; a partial revolution is kept
+    Truncated,     // readPacket only: datagram shorter than an MSOP packet
+    Foreign,       // readPacket only: oversized, or not framed in MSOP data blocks
+    EndOfCapture,  // replay only: no packets left
+    Interrupted,   // a signal arrived while waiting (EINTR); call again to go on
+    SocketError,   // the receive failed; errno in receiveCounters().last_errno
+  };
+  static const char* statusName(ReadStatus status);
+
+  struct ReceiveCounters {
+    uint64_t truncated     = 0;  // datagrams shorter than an MSOP packet
+    uint64_t foreign       = 0;  // oversized, or without MSOP block flags
+    uint64_t timeouts      = 0;  // calls that returned Timeout
+    uint64_t socket_errors = 0;
+    int      last_errno    = 0;  // of the last SocketError or Interrupted
+  };
+
   LiDARReader(const std::string& host_ip,  // unused, kept for API compatibility
               int port,
               int angle_offset = 0,
               bool inverted    = false);
+
+  /// Replay a capture instead of listening on a socket; pacing is set on the
+  /// PcapReplay. readScan()/readRevolution() throw EndOfCapture at the end.
+  explicit LiDARReader(std::unique_ptr<PcapReplay> replay,
+                       int angle_offset = 0,
+                       bool inverted    = false);
   ~LiDARReader();
 
-  /// Blocks until one full scan (12×16 points) is read.
+  /// Receive until a revolution is assembled or `deadline` passes, then copy
+  /// it into `scan` (its capacity is reused). Truncated and foreign datagrams
+  /// are skipped and counted, so this returns Ok, Timeout, EndOfCapture,
+  /// Interrupted or SocketError and never throws. The deadline bounds socket
+  /// waits; a paced replay may sleep past it.
+  ReadStatus readScan(std::vector<ScanPoint>& scan, Clock::time_point deadline);
+
+  /// readScan() over only the packets already queued (at most 256 per call):
+  /// never waits, and returns Timeout when they do not finish a revolution.
+  ReadStatus tryReadScan(std::vector<ScanPoint>& scan);
+
+  /// Receive one datagram and, if it is an MSOP packet, assemble it. Unlike
+  /// readScan() this reports Truncated and Foreign datagrams to the caller.
+  /// Duplicated and late packets return Ok but are not assembled.
+  /// `completed` is set when the packet closed a revolution, now in
+  /// lastRevolution().
+  ReadStatus readPacket(Clock::time_point deadline, bool& completed);
+
+  /// Revolution last completed by any of the read calls.
+  const std::vector<ScanPoint>& lastRevolution() const { return assembler_.completed(); }
+
+  const ReceiveCounters& receiveCounters() const { return receive_counters_; }
+
+  /// Socket to poll in an external event loop (-1 when replaying).
+  int fd() const { return sockfd_; }
+
+  /// Blocks until one full revolution has been assembled and returns a copy.
+  /// Throws EndOfCapture at the end of a replay and std::runtime_error if the
+  /// receive fails.
   std::vector<ScanPoint> readScan();
 
+  /// Same as readScan() without the copy. The reference stays valid until
+  /// the next readScan()/readRevolution() call.
+  const std::vector<ScanPoint>& readRevolution();
+
+  /// Pull up to `batch_size` packets per recvmmsg() call (1 = plain recvfrom).
+  void setBatchSize(int batch_size);
+
+  struct BatchStats {
+    uint64_t syscalls = 0;  // receive syscalls issued
+    uint64_t packets  = 0;  // packets returned by them
+  };
+  const BatchStats& batchStats() const { return batch_stats_; }
+
+  static constexpr int MAX_BATCH_SIZE = 64;
+
+  /// Write every received packet with its kernel receive timestamp to a pcap file.
+  void recordTo(const std::string& pcap_path);
+  uint64_t recordedPackets() const { return recorder_ ? recorder_->packets() : 0; }
+
+  /// Lost, duplicated, late and malformed packets seen so far. Duplicated and
+  /// late packets are left out of the revolutions.
+  const ContinuityStats& continuity() const { return continuity_.getStats(); }
+
+  /// Packet coverage of the revolution last returned by readScan()/readRevolution().
+  const RevolutionCoverage& lastCoverage() const { return continuity_.getLastRevolution(); }
+
+  /// Time every stage from socket to readScan() into latency histograms.
+  /// On a live socket this turns on kernel receive timestamps and, like
+  /// recording, always receives through recvmmsg(). Parse is each packet's
+  /// block decode; assembly is each revolution close, once per revolution.
+  void enableLatencyStats(bool enable = true);
+  const PipelineLatency& latency() const { return latency_; }
+  void resetLatency() { latency_.reset(); }
+
+  /// cos/sin table with this reader's angle offset and inversion applied.
+  const AzimuthTable& azimuthTable() const { return azimuth_table_; }
+
+  /// Packet and revolution-boundary counters of the scan assembler.
+  const ScanAssembler::Stats& assemblerStats() const { return assembler_.stats(); }
+
+  /// Convert a scan from readScan() to x/y in meters with the batch table kernel.
+  /// Invalid points (infinite range) come out non-finite.
+  void toCartesian(const std::vector<ScanPoint>& scan,
+                   std::vector<float>& x, std::vector<float>& y);
+
 private:
   int sockfd_;
+  int port_ = 0;
   int angle_offset_;
   bool inverted_;
+  AzimuthTable azimuth_table_;
+  ScanAssembler assembler_;
+  std::vector<uint16_t> cart_raw_;   // scratch columns for toCartesian()
+  std::vector<float>    cart_range_;
+
+  // Batched receive state: packets [batch_pos_, batch_count_) are not yet decoded
+  std::vector<MSOP_Data_t> batch_;
+  std::vector<iovec>       batch_iov_;
+  std::vector<mmsghdr>     batch_msgs_;
+  std::vector<sockaddr_in> batch_addrs_;   // sender of each message
+  std::vector<uint64_t>    batch_ctrl_;    // cmsg space for SCM_TIMESTAMPNS, 8-byte aligned
+  int batch_count_ = 0;
+  int batch_pos_   = 0;
+  BatchStats batch_stats_;
+
+  std::unique_ptr<PcapReplay> replay_;    // set: packets come from a capture
+  std::unique_ptr<PcapWriter> recorder_;  // set: received packets are recorded
+  PipelineLatency latency_;
+  ContinuityTracker continuity_;
+  ReceiveCounters receive_counters_;
+
+  /// Packets one call may still take from the queue once its deadline has
+  /// passed: a revolution at 10 Hz is about 200.
+  static constexpr int MAX_OVERDUE_PACKETS = 256;
+  int overdue_budget_ = 0;
 
   /// Bind UDP socket on all local interfaces, port only.
   void setupSocket(int port);
-  void recvPacket(MSOP_Data_t& buf);
+  /// Both return packets received, or -1 with errno set (EAGAIN if `flags`
+  /// has MSG_DONTWAIT and nothing is queued).
+  int recvPacket(MSOP_Data_t& buf, int flags);
+  int recvBatch(int flags);
+  bool wantTimestamps() const { return recorder_ || latency_.isEnabled(); }
+  /// Refill the batch, waiting for the socket until `deadline` at most.
+  ReadStatus receive(Clock::time_point deadline);
+  ReadStatus waitReadable(Clock::time_point deadline);
+  ReadStatus socketFailure(int error);
+  /// Next datagram from the batch buffer or the capture mapping. Ok: `packet`
+  /// views a well-formed MSOP packet in place.
+  ReadStatus nextPacket(MSOPPacketView& packet, Clock::time_point deadline);
+  ReadStatus classify(const uint8_t* data, size_t size, MSOPPacketView& packet);
+  /// Feed packets until a revolution is in assembler_.completed().
+  ReadStatus assemble(Clock::time_point deadline);
+  /// Track and assemble one packet; true if it completed a revolution.
+  /// Duplicated and late packets are counted by continuity_ and dropped.
+  bool addPacket(MSOPPacketView packet);
 };
@@ -1,12 +1,73 @@
 #include "lidar_reader.hpp"
+#include "scan_shm.hpp"
+#include <csignal>
 #include <iostream>
 #include <thread>
 
+// Set by SIGUSR1: print the latency histograms after the current scan
+static volatile std::sig_atomic_t latency_dump_requested = 0;
+
+static void printScan(const std::vector<ScanPoint>& scan,
+                      const RevolutionCoverage& coverage,
+                      const ContinuityStats& continuity,
+                      const LiDARReader::ReceiveCounters& received) {
+  std::cout << "Scan (" << scan.size() << " points):\n";
+  std::printf(" coverage %.1f%% (%u/%u packets) | lost %llu, duplicate %llu, out of order %llu,"
+              " truncated %llu, foreign %llu\n",
+              coverage.coverage_percent, coverage.received, coverage.expected,
+              (unsigned long long)continuity.lost, (unsigned long long)continuity.duplicates,
+              (unsigned long long)continuity.out_of_order, (unsigned long long)received.truncated,
+              (unsigned long long)received.foreign);
+  for (int i = 0; i < 5 && i < (int)scan.size(); ++i) {
+    auto &p = scan[i];
+    std::printf(" %2d | ang=%.3f rad | r=%.3f m | inten=%.0f\n",
+                i, p.angle, p.range, p.intensity);
+  }
+}
+
+// Scans from a scan_publisher process instead of a socket of our own
+static int runSubscriber(const std::string& ring) {
+  ScanSubscriber subscriber(ring);
+  std::vector<ScanPoint> scan;
+  while (true) {
+    auto deadline = ScanSubscriber::Clock::now() + std::chrono::seconds(1);
+    ScanSubscriber::ReadStatus status = subscriber.readScan(scan, deadline);
+    if (status != ScanSubscriber::ReadStatus::Ok) {
+      // Closed: the publisher stopped; a restarted one takes the ring over
+      std::cout << "No revolution in " << ring << " within 1 s ("
+                << ScanSubscriber::statusName(status) << ")\n";
+      continue;
+    }
+    const ScanInfo& info = subscriber.lastInfo();
+    printScan(scan, info.coverage, info.continuity, info.receive);
+    auto age = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(info.published_ns);
+    std::printf(" revolution %llu, published %.2f ms ago, %llu skipped by this reader\n",
+                (unsigned long long)info.number,
+                std::chrono::duration<double, std::milli>(age).count(),
+                (unsigned long long)subscriber.skipped());
+    std::cout << "----------------------\n";
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+}
+
 int main(int argc, char** argv) {
+  if (argc >= 2 && std::string(argv[1]) == "--shm") {
+    try {
+      return runSubscriber(argc >= 3 ? argv[2] : DEFAULT_SCAN_RING);
+    } catch (const std::exception& e) {
+      std::cerr << "Error: " << e.what() << "\n";
+      return 1;
+    }
+  }
   if (argc < 3) {
     std::cerr << "Usage: " << argv[0]
               << " <host_ip> <udp_port>"
-              << " [angle_offset] [inverted]\n";
+              << " [angle_offset] [inverted] [batch_size] [latency_seconds]\n"
+              << "       " << argv[0] << " --shm [ring_name]\n"
+              << "  latency_seconds > 0 prints per-stage latency histograms that often"
+              << " (and on SIGUSR1)\n"
+              << "  --shm reads the revolutions a scan_publisher process shares"
+              << " (default " << DEFAULT_SCAN_RING << ")\n";
     return 1;
   }
 
@@ -14,16 +75,47 @@ int main(int argc, char** argv) {
   int         port      = std::atoi(argv[2]);
   int         offset    = (argc>=4 ? std::atoi(argv[3]) : 0);
   bool        inverted  = (argc>=5 && std::atoi(argv[4])!=0);
+  int         batch     = (argc>=6 ? std::atoi(argv[5]) : 1);
+  double      latency_s = (argc>=7 ? std::atof(argv[6]) : 0);
 
   LiDARReader reader(host_ip, port, offset, inverted);
+  reader.setBatchSize(batch);
 
+  uint64_t latency_interval = 0, next_latency_dump = 0;
+  if (latency_s > 0) {
+    reader.enableLatencyStats();
+    std::signal(SIGUSR1, [](int) { latency_dump_requested = 1; });
+    latency_interval  = uint64_t(latency_s * 1e9);
+    next_latency_dump = PipelineLatency::now() + latency_interval;
+  }
+
+  // A revolution takes 100 ms at 10 Hz; a second without one means the sensor
+  // has stopped or been unplugged, which is reported instead of hanging
+  std::vector<ScanPoint> scan;
   while (true) {
-    auto scan = reader.readScan();
-    std::cout << "Scan (" << scan.size() << " points):\n";
-    for (int i = 0; i < 5 && i < (int)scan.size(); ++i) {
-      auto &p = scan[i];
-      std::printf(" %2d | ang=%.3f rad | r=%.3f m | inten=%.0f\n",
-                  i, p.angle, p.range, p.intensity);
+    auto deadline = LiDARReader::Clock::now() + std::chrono::seconds(1);
+    LiDARReader::ReadStatus status = reader.readScan(scan, deadline);
+    if (status == LiDARReader::ReadStatus::Timeout) {
+      std::cout << "No revolution from port " << port << " within 1 s\n";
+      continue;
+    }
+    if (status != LiDARReader::ReadStatus::Ok) {
+      std::cerr << "Receive failed: " << LiDARReader::statusName(status) << "\n";
+      return 1;
+    }
+    printScan(scan, reader.lastCoverage(), reader.continuity(), reader.receiveCounters());
+    if (batch > 1) {
+      auto &stats = reader.batchStats();
+      std::printf(" recvmmsg: %llu packets / %llu syscalls\n",
+                  (unsigned long long)stats.packets,
+                  (unsigned long long)stats.syscalls);
+    }
+    if (latency_interval &&
+        (latency_dump_requested || PipelineLatency::now() >= next_latency_dump)) {
+      latency_dump_requested = 0;
+      next_latency_dump = PipelineLatency::now() + latency_interval;
+      std::cout << "Stage latency since start:\n";
+      reader.latency().print(std::cout);
     }
     std::cout << "----------------------\n";
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
@@ -0,0 +1,386 @@
+// msop_emulator.cpp -- synthesize LakiBeam1(L) MSOP traffic for load tests without hardware
+
+#include "data_type.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void onSignal(int) { g_stop = 1; }
+
+static int64_t monotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct EmulatorOptions {
+  std::string host    = "127.0.0.1";
+  int      port       = 2368;
+  int      sensors    = 1;       // streams to port, port+1, ...
+  double   rotation_hz = 10.0;
+  double   resolution = 0.25;    // degrees between points
+  double   fov        = 360.0;   // degrees, centred on 180° (270 = LakiBeam1L's 45°-315°)
+  double   dual       = 0.3;     // fraction of measurements with a distinct last return
+  double   speed      = 1.0;     // multiple of the real packet rate, 0 = as fast as possible
+  double   loss       = 0.0;     // probability a packet is dropped
+  double   reorder    = 0.0;     // probability a packet is held back and sent after the next one
+  double   duplicate  = 0.0;     // probability a packet is sent twice
+  uint64_t count      = 0;       // packets per sensor, 0 = until Ctrl+C
+  double   duration   = 0.0;     // seconds, 0 = no limit
+  uint32_t seed       = 1;
+};
+
+/// xorshift64*: cheap and reproducible across platforms.
+class Rng {
+public:
+  explicit Rng(uint64_t seed) : state_(0x9E3779B97F4A7C15ull ^ seed) {}
+  uint64_t next() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 0x2545F4914F6CDD1Dull;
+  }
+  double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+  bool chance(double p) { return p > 0 && uniform() < p; }
+
+private:
+  uint64_t state_;
+};
+
+/// One emulated sensor: a rotating head in a rectangular room.
+///
+/// Blocks advance by 16 points' worth of azimuth and wrap at 360°. Blocks
+/// outside the field of view are not sent, but their time still passes. The
+/// last packet of each revolution is padded with invalid blocks (flag and
+/// azimuth 0xFFFF). With 6 or fewer valid blocks left over, as at the default
+/// 0.25°, that is the sensor's last-packet marker (blocks 6-11 invalid).
+class SensorModel {
+public:
+  SensorModel(const EmulatorOptions& options, int index)
+    : rng_(options.seed * 7919ull + index),
+      dual_(options.dual),
+      block_step_(int(std::lround(options.resolution * 100 * POINTS_PER_BLOCK))),
+      fov_start_(int(std::lround((180.0 - options.fov / 2) * 100))),
+      fov_end_(int(std::lround((180.0 + options.fov / 2) * 100))),
+      us_per_block_(1e6 / options.rotation_hz * block_step_ / 36000.0),
+      room_x_(4.0 + index), room_y_(3.0 + 0.5 * index)
+  {
+    if (block_step_ <= 0 || block_step_ > 36000)
+      throw std::invalid_argument("angular resolution out of range");
+    seekToFov();
+  }
+
+  /// Nominal packets per second at 1x speed.
+  double packetRate(double rotation_hz) const {
+    int blocks_per_rev = 0;
+    for (int az = 0; az < 36000; az += block_step_)
+      if (inFov(az)) blocks_per_rev++;
+    double packets_per_rev = std::ceil(blocks_per_rev / double(BLOCKS_PER_PACKET));
+    return packets_per_rev * rotation_hz;
+  }
+
+  void nextPacket(MSOP_Data_t& packet) {
+    packet.timestamp = htonl(uint32_t(uint64_t(time_us_)));
+    packet.factory   = htons(0x3740);
+
+    bool revolution_done = false;
+    for (int b = 0; b < BLOCKS_PER_PACKET; ++b) {
+      Data_block& block = packet.blocks[b];
+      if (revolution_done) {
+        block.flag    = htons(INVALID_FLAG);
+        block.azimuth = htons(0xFFFF);
+        std::memset(block.results, 0, sizeof(block.results));
+        continue;
+      }
+      fillBlock(block);
+      advance();
+      // Hitting 360° or leaving the field of view ends the revolution's packets
+      revolution_done = azimuth_ == 0 || !inFov(azimuth_);
+    }
+    if (revolution_done) seekToFov();
+  }
+
+private:
+  bool inFov(int az) const { return az >= fov_start_ && az < fov_end_; }
+
+  void advance() {
+    azimuth_ += block_step_;
+    time_us_ += us_per_block_;
+    if (azimuth_ >= 36000) azimuth_ = 0;
+  }
+
+  /// Skip (in azimuth and time) to the next block inside the field of view.
+  void seekToFov() {
+    for (int guard = 0; !inFov(azimuth_) && guard < 36000; ++guard) advance();
+  }
+
+  double wallDistance(double azimuth_deg) const {
+    double a = azimuth_deg * M_PI / 180.0;
+    double c = std::cos(a), s = std::sin(a);
+    double tx = std::fabs(c) > 1e-9 ? room_x_ / std::fabs(c) : 1e9;
+    double ty = std::fabs(s) > 1e-9 ? room_y_ / std::fabs(s) : 1e9;
+    return std::min(std::min(tx, ty), 14.0);
+  }
+
+  void fillBlock(Data_block& block) {
+    block.flag    = htons(VALID_FLAG);
+    block.azimuth = htons(uint16_t(azimuth_));
+    for (int i = 0; i < POINTS_PER_BLOCK; ++i) {
+      MeasuringResult& m = block.results[i];
+      double az_deg = (azimuth_ + double(block_step_) * i / POINTS_PER_BLOCK) / 100.0;
+      double range_mm = wallDistance(az_deg) * 1000.0 + (rng_.uniform() - 0.5) * 20.0;
+      uint8_t rssi = uint8_t(30 + rng_.next() % 50);
+
+      m.strongest_return.distance = htons(uint16_t(range_mm));
+      m.strongest_return.rssi     = rssi;
+      m.last_return               = m.strongest_return;
+      if (rng_.chance(dual_)) {
+        // Partial hit on something nearer, the wall behind it as the last return
+        double near_mm = std::max(150.0, range_mm * (0.2 + 0.7 * rng_.uniform()));
+        m.strongest_return.distance = htons(uint16_t(near_mm));
+        m.last_return.rssi          = uint8_t(10 + rng_.next() % 30);
+      }
+    }
+  }
+
+  Rng    rng_;
+  double dual_;
+  int    block_step_;
+  int    fov_start_, fov_end_;  // 0.01° units
+  double us_per_block_;
+  double room_x_, room_y_;      // meters from the sensor to the walls
+  int    azimuth_ = 0;
+  double time_us_ = 0;          // sensor clock, wraps when sent as 32 bits
+};
+
+/// Loss, reordering and duplication applied between a sensor and the socket.
+struct Impairment {
+  Rng         rng;
+  MSOP_Data_t held;
+  bool        holding = false;
+
+  explicit Impairment(uint64_t seed) : rng(seed) {}
+};
+
+struct EmulatorStats {
+  uint64_t generated  = 0;
+  uint64_t sent       = 0;  // datagrams accepted by the kernel
+  uint64_t dropped    = 0;  // injected loss
+  uint64_t reordered  = 0;
+  uint64_t duplicated = 0;
+  uint64_t send_errors = 0;
+  uint64_t late       = 0;  // batches sent more than 1 ms behind schedule
+};
+
+static constexpr int MAX_BATCH = 64;
+
+static int usage(const char* prog) {
+  std::cerr
+    << "Usage: " << prog << " [options]\n"
+    << "  --host ADDR        destination (default 127.0.0.1)\n"
+    << "  --port N           MSOP port of the first sensor (default 2368)\n"
+    << "  --sensors N        independent sensors on ports N, N+1, ... (default 1)\n"
+    << "  --rotation HZ      rotation rate (default 10)\n"
+    << "  --resolution DEG   angle between points (default 0.25)\n"
+    << "  --fov DEG          field of view centred on 180 deg (default 360, 270 = LakiBeam1L)\n"
+    << "  --dual FRACTION    measurements with a distinct last return (default 0.3)\n"
+    << "  --speed X          X times the real packet rate, 0 = as fast as possible (default 1)\n"
+    << "  --loss P           drop each packet with probability P\n"
+    << "  --reorder P        send a packet after its successor with probability P\n"
+    << "  --duplicate P      send a packet twice with probability P\n"
+    << "  --count N          stop after N packets per sensor\n"
+    << "  --duration S       stop after S seconds\n"
+    << "  --seed N           random seed (default 1)\n";
+  return 1;
+}
+
+static bool parseArgs(int argc, char** argv, EmulatorOptions& o) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+    if      (arg == "--host")       o.host = v;
+    else if (arg == "--port")       o.port = std::atoi(v);
+    else if (arg == "--sensors")    o.sensors = std::atoi(v);
+    else if (arg == "--rotation")   o.rotation_hz = std::atof(v);
+    else if (arg == "--resolution") o.resolution = std::atof(v);
+    else if (arg == "--fov")        o.fov = std::atof(v);
+    else if (arg == "--dual")       o.dual = std::atof(v);
+    else if (arg == "--speed")      o.speed = std::atof(v);
+    else if (arg == "--loss")       o.loss = std::atof(v);
+    else if (arg == "--reorder")    o.reorder = std::atof(v);
+    else if (arg == "--duplicate")  o.duplicate = std::atof(v);
+    else if (arg == "--count")      o.count = std::strtoull(v, nullptr, 10);
+    else if (arg == "--duration")   o.duration = std::atof(v);
+    else if (arg == "--seed")       o.seed = uint32_t(std::strtoul(v, nullptr, 10));
+    else return false;
+  }
+  return o.sensors >= 1 && o.rotation_hz > 0 && o.resolution > 0 &&
+         o.fov > 0 && o.fov <= 360 && o.speed >= 0;
+}
+
+static void printStats(const EmulatorStats& s, double seconds) {
+  std::printf("%llu sent (%.0f packets/s), %llu dropped, %llu reordered, %llu duplicated, "
+              "%llu send errors, %llu late batches\n",
+              (unsigned long long)s.sent, seconds > 0 ? s.sent / seconds : 0.0,
+              (unsigned long long)s.dropped, (unsigned long long)s.reordered,
+              (unsigned long long)s.duplicated, (unsigned long long)s.send_errors,
+              (unsigned long long)s.late);
+}
+
+int main(int argc, char** argv) {
+  EmulatorOptions options;
+  if (!parseArgs(argc, argv, options)) return usage(argv[0]);
+
+  try {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    int sndbuf = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    std::vector<SensorModel> sensors;
+    std::vector<Impairment> impairments;
+    std::vector<sockaddr_in> dests(options.sensors);
+    for (int s = 0; s < options.sensors; ++s) {
+      sensors.emplace_back(options, s);
+      impairments.emplace_back(options.seed * 104729ull + s);
+      dests[s] = sockaddr_in{};
+      dests[s].sin_family = AF_INET;
+      dests[s].sin_port   = htons(uint16_t(options.port + s));
+      if (inet_pton(AF_INET, options.host.c_str(), &dests[s].sin_addr) != 1)
+        throw std::invalid_argument("bad IPv4 address: " + options.host);
+    }
+
+    // Packets of all sensors interleave on one schedule
+    const double real_rate = sensors[0].packetRate(options.rotation_hz) * options.sensors;
+    const double period_ns = options.speed > 0 ? 1e9 / (real_rate * options.speed) : 0.0;
+
+    std::printf("Emulating %d sensor(s) -> %s:%d", options.sensors, options.host.c_str(), options.port);
+    if (options.sensors > 1) std::printf("-%d", options.port + options.sensors - 1);
+    std::printf(", %.1f Hz, %.2f deg, %.0f deg FOV, %.0f packets/s real rate, ",
+                options.rotation_hz, options.resolution, options.fov, real_rate);
+    if (options.speed > 0) std::printf("sending at %.1fx\n", options.speed);
+    else std::printf("sending as fast as possible\n");
+
+    struct sigaction sa{};
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    // Each generated packet yields 0-3 datagrams (drop, duplicate, released reorder)
+    std::vector<MSOP_Data_t> out(MAX_BATCH * 3);
+    std::vector<iovec>       iov(out.size());
+    std::vector<mmsghdr>     msgs(out.size());
+
+    EmulatorStats stats;
+    const uint64_t total = options.count ? options.count * options.sensors : 0;
+    const int64_t start = monotonicNs();
+    int64_t last_report = start;
+    uint64_t report_sent = 0;
+
+    while (!g_stop && (total == 0 || stats.generated < total)) {
+      int64_t now = monotonicNs();
+      if (options.duration > 0 && now - start >= int64_t(options.duration * 1e9)) break;
+
+      // Packets due by now, at most one batch
+      uint64_t due = MAX_BATCH;
+      if (period_ns > 0) {
+        uint64_t scheduled = uint64_t((now - start) / period_ns) + 1;
+        due = scheduled > stats.generated ? std::min<uint64_t>(scheduled - stats.generated, MAX_BATCH) : 0;
+        if (due == 0) {
+          int64_t wake = start + int64_t(stats.generated * period_ns);
+          timespec t{ time_t(wake / 1000000000), long(wake % 1000000000) };
+          clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, nullptr);
+          continue;
+        }
+        if (now - (start + int64_t((stats.generated + due - 1) * period_ns)) > 1000000) stats.late++;
+      }
+      if (total) due = std::min<uint64_t>(due, total - stats.generated);
+
+      int n = 0;
+      auto emit = [&](const MSOP_Data_t& packet, int sensor) {
+        out[n] = packet;
+        iov[n] = { &out[n], sizeof(MSOP_Data_t) };
+        msgs[n] = mmsghdr{};
+        msgs[n].msg_hdr.msg_name    = &dests[sensor];
+        msgs[n].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msgs[n].msg_hdr.msg_iov     = &iov[n];
+        msgs[n].msg_hdr.msg_iovlen  = 1;
+        n++;
+      };
+
+      for (uint64_t k = 0; k < due; ++k) {
+        int s = int(stats.generated++ % options.sensors);
+        MSOP_Data_t packet;
+        sensors[s].nextPacket(packet);
+
+        Impairment& imp = impairments[s];
+        if (imp.rng.chance(options.loss)) {
+          stats.dropped++;
+          continue;
+        }
+        if (!imp.holding && imp.rng.chance(options.reorder)) {
+          imp.held = packet;
+          imp.holding = true;
+          continue;
+        }
+        emit(packet, s);
+        if (imp.rng.chance(options.duplicate)) {
+          emit(packet, s);
+          stats.duplicated++;
+        }
+        if (imp.holding) {
+          emit(imp.held, s);
+          imp.holding = false;
+          stats.reordered++;
+        }
+      }
+
+      for (int done = 0; done < n;) {
+        int r = sendmmsg(fd, &msgs[done], unsigned(n - done), 0);
+        if (r < 0) {
+          if (errno == EINTR) continue;
+          stats.send_errors += n - done;  // e.g. ECONNREFUSED from an earlier ICMP, ENOBUFS
+          break;
+        }
+        done += r;
+        stats.sent += r;
+      }
+
+      if (now - last_report >= 1000000000) {
+        std::printf("\r%.0f packets/s, %llu sent, %llu dropped, %llu reordered, %llu duplicated   ",
+                    (stats.sent - report_sent) * 1e9 / (now - last_report),
+                    (unsigned long long)stats.sent, (unsigned long long)stats.dropped,
+                    (unsigned long long)stats.reordered, (unsigned long long)stats.duplicated);
+        std::fflush(stdout);
+        last_report = now;
+        report_sent = stats.sent;
+      }
+    }
+
+    std::printf("\n");
+    printStats(stats, (monotonicNs() - start) / 1e9);
+    close(fd);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -2,7 +2,7 @@
 #include <vector>
 #include <iostream>
 #include <cstring>
-#include <arpa/inet.h>
+#include "msop_packet_view.h"
 
 // MSOP Packet Structure - 1206 bytes (without UDP header)
 #pragma pack(push, 1)
@@ -31,6 +31,8 @@ struct MSOPPacket {
 
 #pragma pack(pop)
 
+static_assert(sizeof(MSOPPacket) == MSOPPacketView::PACKET_SIZE, "MSOPPacket layout differs from MSOPPacketView");
+
 // Parsed point structure
 struct ParsedPoint {
     double azimuth_degrees;
@@ -42,34 +44,21 @@ struct ParsedPoint {
 
 class MSOPParser {
 private:
-    static constexpr uint16_t VALID_FLAG = 0xEEFF;    // Note: appears as 0xFFEE in documentation but stored as little-endian
-    static constexpr uint16_t INVALID_FLAG = 0xFFFF;
-    static constexpr int BLOCKS_PER_PACKET = 12;
-    static constexpr int POINTS_PER_BLOCK = 16;
+    static constexpr int BLOCKS_PER_PACKET = MSOPPacketView::BLOCK_COUNT;
+    static constexpr int POINTS_PER_BLOCK = MSOPPacketView::MEASUREMENTS_PER_BLOCK;
 
-    // Convert big-endian to host byte order
-    uint16_t ntoh16(uint16_t value) {
-        return ntohs(value);
-    }
-    
-    uint32_t ntoh32(uint32_t value) {
-        return ntohl(value);
-    }
-
-    // Check if a data block is valid
-    bool isValidBlock(const DataBlock& block) {
-        return block.flag == VALID_FLAG;
+    // Check if a data block is valid (flag 0xFFEE; 0xFFFF marks an unused block)
+    bool isValidBlock(const MSOPPacketView& packet, int block) {
+        return packet.blockFlag(block) == MSOPPacketView::VALID_BLOCK_FLAG;
     }
 
     // Get azimuth in degrees from data block
-    double getAzimuthDegrees(const DataBlock& block) {
-        uint16_t azimuth_raw = ntoh16(block.azimuth);
-        return azimuth_raw / 100.0;  // Convert from 0.01 degree units
+    double getAzimuthDegrees(const MSOPPacketView& packet, int block) {
+        return packet.blockAzimuth(block) / 100.0;  // Convert from 0.01 degree units
     }
 
-    // Get distance in meters from return data
-    double getDistanceMeters(const ReturnData& return_data) {
-        uint16_t distance_raw = ntoh16(return_data.distance);
+    // Get distance in meters from a raw distance (host order)
+    double getDistanceMeters(uint16_t distance_raw) {
         if (distance_raw == 0 || distance_raw == 0xFFFF) {
             return 0.0;  // Invalid distance
         }
@@ -101,44 +90,51 @@ private:
     }
 
 public:
+    // 12 blocks x 16 points x 2 returns
+    static constexpr size_t MAX_POINTS_PER_PACKET = BLOCKS_PER_PACKET * POINTS_PER_BLOCK * 2;
+
     // Parse a complete MSOP packet
     std::vector<ParsedPoint> parsePacket(const uint8_t* raw_data, size_t data_size) {
-        std::vector<ParsedPoint> points;
+        std::vector<ParsedPoint> points(MAX_POINTS_PER_PACKET);
+        points.resize(parsePacket(raw_data, data_size, points.data(), points.size()));
+        return points;
+    }
+
+    // Parse into a caller-owned array without allocating; returns the number of
+    // points written. Points beyond capacity are dropped, so pass
+    // MAX_POINTS_PER_PACKET to always fit a whole packet.
+    size_t parsePacket(const uint8_t* raw_data, size_t data_size,
+                       ParsedPoint* points, size_t capacity) {
+        size_t count = 0;
         
-        if (data_size != sizeof(MSOPPacket)) {
-            std::cerr << "Invalid packet size: " << data_size << " expected: " << sizeof(MSOPPacket) << std::endl;
-            return points;
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
+            std::cerr << "Invalid packet size: " << data_size << " expected: " << MSOPPacketView::PACKET_SIZE << std::endl;
+            return 0;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
-        
-        // Reserve space for all possible points
-        points.reserve(BLOCKS_PER_PACKET * POINTS_PER_BLOCK * 2); // *2 for both returns
+        // Decode in place; raw_data may be a receive buffer, ring slot or mapped capture
+        MSOPPacketView packet(raw_data);
         
         // Process each data block
         for (int block_idx = 0; block_idx < BLOCKS_PER_PACKET; block_idx++) {
-            const DataBlock& current_block = packet->blocks[block_idx];
-            
             // Skip invalid blocks
-            if (!isValidBlock(current_block)) {
+            if (!isValidBlock(packet, block_idx)) {
                 continue;
             }
             
-            double current_azimuth = getAzimuthDegrees(current_block);
+            double current_azimuth = getAzimuthDegrees(packet, block_idx);
             double next_azimuth = current_azimuth;
             
             // Get next block azimuth for interpolation
             if (block_idx < BLOCKS_PER_PACKET - 1) {
-                const DataBlock& next_block = packet->blocks[block_idx + 1];
-                if (isValidBlock(next_block)) {
-                    next_azimuth = getAzimuthDegrees(next_block);
+                if (isValidBlock(packet, block_idx + 1)) {
+                    next_azimuth = getAzimuthDegrees(packet, block_idx + 1);
                 }
             } else {
                 // For last block, estimate next azimuth
                 if (block_idx > 0) {
-                    const DataBlock& prev_block = packet->blocks[block_idx - 1];
-                    if (isValidBlock(prev_block)) {
-                        double prev_azimuth = getAzimuthDegrees(prev_block);
+                    if (isValidBlock(packet, block_idx - 1)) {
+                        double prev_azimuth = getAzimuthDegrees(packet, block_idx - 1);
                         double increment = current_azimuth - prev_azimuth;
                         if (increment < -180.0) increment += 360.0;
                         else if (increment > 180.0) increment -= 360.0;
@@ -148,72 +144,66 @@ public:
             }
             
             // Process each point in the block
-            for (int point_idx = 0; point_idx < POINTS_PER_BLOCK; point_idx++) {
-                const MeasuringResult& result = current_block.results[point_idx];
-                
+            for (int point_idx = 0; point_idx < POINTS_PER_BLOCK && count < capacity; point_idx++) {
                 double point_azimuth = calculatePointAzimuth(current_azimuth, next_azimuth, point_idx);
                 
                 // Process strongest return
-                double strongest_distance = getDistanceMeters(result.strongest_return);
+                double strongest_distance = getDistanceMeters(packet.distanceStrongest(block_idx, point_idx));
                 if (strongest_distance > 0.0) {
-                    ParsedPoint point;
+                    ParsedPoint& point = points[count++];
                     point.azimuth_degrees = point_azimuth;
                     point.distance_meters = strongest_distance;
-                    point.rssi = result.strongest_return.rssi;
+                    point.rssi = packet.rssiStrongest(block_idx, point_idx);
                     point.is_valid = true;
                     point.use_strongest_return = true;
-                    points.push_back(point);
                 }
                 
                 // Process last return (if different from strongest)
-                double last_distance = getDistanceMeters(result.last_return);
-                if (last_distance > 0.0 && last_distance != strongest_distance) {
-                    ParsedPoint point;
+                double last_distance = getDistanceMeters(packet.distanceLast(block_idx, point_idx));
+                if (last_distance > 0.0 && last_distance != strongest_distance && count < capacity) {
+                    ParsedPoint& point = points[count++];
                     point.azimuth_degrees = point_azimuth;
                     point.distance_meters = last_distance;
-                    point.rssi = result.last_return.rssi;
+                    point.rssi = packet.rssiLast(block_idx, point_idx);
                     point.is_valid = true;
                     point.use_strongest_return = false;
-                    points.push_back(point);
                 }
             }
         }
         
-        return points;
+        return count;
     }
     
     // Get timestamp from packet
     uint32_t getTimestamp(const uint8_t* raw_data, size_t data_size) {
-        if (data_size != sizeof(MSOPPacket)) {
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
             return 0;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
-        return ntoh32(packet->timestamp);
+        return MSOPPacketView(raw_data).timestamp();
     }
     
     // Get factory information from packet
     uint16_t getFactoryInfo(const uint8_t* raw_data, size_t data_size) {
-        if (data_size != sizeof(MSOPPacket)) {
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
             return 0;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
-        return ntoh16(packet->factory);
+        return MSOPPacketView(raw_data).factoryInfo();
     }
     
     // Check if this is the last packet in a rotation (has invalid blocks at the end)
     bool isLastPacket(const uint8_t* raw_data, size_t data_size) {
-        if (data_size != sizeof(MSOPPacket)) {
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
             return false;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
+        MSOPPacketView packet(raw_data);
         
         // Check if blocks 6-11 are invalid (as mentioned in documentation)
         int invalid_count = 0;
         for (int i = 6; i < BLOCKS_PER_PACKET; i++) {
-            if (!isValidBlock(packet->blocks[i])) {
+            if (!isValidBlock(packet, i)) {
                 invalid_count++;
             }
         }
@@ -223,15 +213,15 @@ public:
     
     // Validate packet structure
     bool validatePacket(const uint8_t* raw_data, size_t data_size) {
-        if (data_size != sizeof(MSOPPacket)) {
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
             return false;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
+        MSOPPacketView packet(raw_data);
         
         // Check if at least one block is valid
         for (int i = 0; i < BLOCKS_PER_PACKET; i++) {
-            if (isValidBlock(packet->blocks[i])) {
+            if (isValidBlock(packet, i)) {
                 return true;
             }
         }
@@ -241,12 +231,12 @@ public:
     
     // Print packet information for debugging
     void printPacketInfo(const uint8_t* raw_data, size_t data_size) {
-        if (data_size != sizeof(MSOPPacket)) {
+        if (data_size != MSOPPacketView::PACKET_SIZE) {
             std::cout << "Invalid packet size: " << data_size << std::endl;
             return;
         }
         
-        const MSOPPacket* packet = reinterpret_cast<const MSOPPacket*>(raw_data);
+        MSOPPacketView packet(raw_data);
         
         std::cout << "MSOP Packet Info:" << std::endl;
         std::cout << "Timestamp: " << getTimestamp(raw_data, data_size) << " us" << std::endl;
@@ -255,8 +245,8 @@ public:
         
         std::cout << "Valid blocks: ";
         for (int i = 0; i < BLOCKS_PER_PACKET; i++) {
-            if (isValidBlock(packet->blocks[i])) {
-                double azimuth = getAzimuthDegrees(packet->blocks[i]);
+            if (isValidBlock(packet, i)) {
+                double azimuth = getAzimuthDegrees(packet, i);
                 std::cout << i << "(" << azimuth << "°) ";
             }
         }
@@ -0,0 +1,360 @@
+// occupancy_grid.cpp
+
+#include "occupancy_grid.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const OccupancyGrid::Options& checkOptions(const OccupancyGrid::Options& o) {
+  if (!(o.resolution > 0)) throw std::invalid_argument("grid resolution must be positive");
+  if (!(o.hit_probability > 0.5 && o.hit_probability < 1) ||
+      !(o.miss_probability > 0 && o.miss_probability < 0.5) ||
+      !(o.clamp_probability > o.hit_probability && o.clamp_probability < 1)) {
+    throw std::invalid_argument("grid probabilities out of range");
+  }
+  if (o.threads < 1 || o.threads > 64) throw std::invalid_argument("grid thread count out of range");
+  return o;
+}
+
+int16_t toLogOdds(double p) {
+  return int16_t(std::lround(std::log(p / (1 - p)) * OccupancyGrid::LOG_ODDS_SCALE));
+}
+
+/// Visit the cells of the 8-connected Bresenham line from (x0, y0) toward
+/// (x1, y1), the end cell excluded.
+template <typename Visit>
+inline void traceLine(int x0, int y0, int x1, int y1, Visit&& visit) {
+  const int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+  const int sx = x0 < x1 ? 1 : -1,  sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  while (x0 != x1 || y0 != y1) {
+    visit(x0, y0);
+    int e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+}  // namespace
+
+/// Workers 1 .. threads - 1 are started once and sleep between jobs; thread 0
+/// is the caller of run(). Waits spin briefly, yielding, before they block, so
+/// a barrier between two short phases rarely costs a futex round trip.
+/// Nothing here allocates after construction.
+class OccupancyGrid::WorkerPool {
+public:
+  explicit WorkerPool(int threads) : threads_(threads) {
+    workers_.reserve(size_t(threads - 1));
+    for (int t = 1; t < threads; ++t) workers_.emplace_back(&WorkerPool::work, this, t);
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      generation_++;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  /// job(0) .. job(threads - 1) at once, job(0) on the calling thread.
+  /// Returns when every thread has finished.
+  template <typename F>
+  void run(F& job) {
+    job_  = &job;
+    call_ = [](void* f, int t) { (*static_cast<F*>(f))(t); };
+    finished_.store(0, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      generation_++;
+    }
+    wake_.notify_all();
+    job(0);
+    waitUntil([&] { return finished_.load(std::memory_order_acquire) == threads_ - 1; });
+  }
+
+  /// Barrier for the threads of the current job: returns once all have called it.
+  void sync() {
+    uint32_t phase = phase_.load(std::memory_order_acquire);
+    if (arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == threads_) {
+      arrived_.store(0, std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        phase_.store(phase + 1, std::memory_order_release);
+      }
+      wake_.notify_all();
+    } else {
+      waitUntil([&] { return phase_.load(std::memory_order_acquire) != phase; });
+    }
+  }
+
+private:
+  static constexpr int SPINS = 200;
+
+  const int                threads_;
+  std::vector<std::thread> workers_;
+  std::mutex               mutex_;
+  std::condition_variable  wake_;     // any of the counters below changed
+  std::atomic<uint32_t>    generation_{0};
+  std::atomic<int>         finished_{0};
+  std::atomic<int>         arrived_{0};
+  std::atomic<uint32_t>    phase_{0};
+  std::atomic<bool>        stopping_{false};
+  void*                    job_  = nullptr;
+  void                   (*call_)(void*, int) = nullptr;
+
+  template <typename Ready>
+  void waitUntil(Ready ready) {
+    for (int spin = 0; spin < SPINS; ++spin) {
+      if (ready()) return;
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, ready);
+  }
+
+  void work(int t) {
+    uint32_t seen = 0;
+    while (true) {
+      waitUntil([&] { return generation_.load(std::memory_order_acquire) != seen; });
+      seen = generation_.load(std::memory_order_acquire);
+      if (stopping_) return;
+      call_(job_, t);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.fetch_add(1, std::memory_order_release);
+      }
+      wake_.notify_all();
+    }
+  }
+};
+
+/// Saturating log-odds updates to one shard, remembering the last tile:
+/// consecutive cells of a beam are mostly in the same one.
+class OccupancyGrid::ShardWriter {
+public:
+  ShardWriter(TileMap& tiles, int16_t clamp) : tiles_(tiles), clamp_(clamp) {}
+
+  void add(int cx, int cy, int16_t delta) {
+    // Arithmetic shifts: floor division for negative cells too
+    int tx = cx >> TILE_BITS, ty = cy >> TILE_BITS;
+    if (!tile_ || tx != tx_ || ty != ty_) {
+      std::unique_ptr<Tile>& slot = tiles_[tileKey(tx, ty)];
+      if (!slot) slot.reset(new Tile);
+      tile_ = slot.get();
+      tx_ = tx;
+      ty_ = ty;
+    }
+    int16_t& cell = tile_->cells[(cy & (TILE_SIZE - 1)) * TILE_SIZE + (cx & (TILE_SIZE - 1))];
+    int value = cell + delta;
+    cell = int16_t(std::max(-int(clamp_), std::min(int(clamp_), value)));
+  }
+
+private:
+  TileMap& tiles_;
+  int16_t  clamp_;
+  Tile*    tile_ = nullptr;
+  int      tx_ = 0, ty_ = 0;
+};
+
+OccupancyGrid::OccupancyGrid(const Options& options)
+  : options_(checkOptions(options)),
+    inv_resolution_(1.0 / options.resolution),
+    hit_(toLogOdds(options.hit_probability)),
+    miss_(toLogOdds(options.miss_probability)),
+    clamp_(toLogOdds(options.clamp_probability)),
+    shards_(size_t(options.threads))
+{
+  if (options.threads > 1) {
+    misses_.resize(size_t(options.threads * options.threads));
+    hits_.resize(misses_.size());
+    pool_.reset(new WorkerPool(options.threads));
+  }
+}
+
+OccupancyGrid::~OccupancyGrid() = default;
+
+size_t OccupancyGrid::shardOf(int tx, int ty) const {
+  uint32_t h = uint32_t(tx) * 0x9E3779B1u ^ uint32_t(ty) * 0x85EBCA77u;
+  return (h ^ (h >> 16)) % shards_.size();
+}
+
+void OccupancyGrid::cellOf(double x, double y, int& cx, int& cy) const {
+  cx = int(std::floor(x * inv_resolution_));
+  cy = int(std::floor(y * inv_resolution_));
+}
+
+const OccupancyGrid::Tile* OccupancyGrid::findTile(int cx, int cy) const {
+  int tx = cx >> TILE_BITS, ty = cy >> TILE_BITS;
+  const TileMap& tiles = shards_[shardOf(tx, ty)];
+  auto it = tiles.find(tileKey(tx, ty));
+  return it == tiles.end() ? nullptr : it->second.get();
+}
+
+int16_t OccupancyGrid::logOdds(int cx, int cy) const {
+  const Tile* tile = findTile(cx, cy);
+  return tile ? tile->cells[(cy & (TILE_SIZE - 1)) * TILE_SIZE + (cx & (TILE_SIZE - 1))] : 0;
+}
+
+double OccupancyGrid::probability(int cx, int cy) const {
+  return 1.0 / (1.0 + std::exp(-logOdds(cx, cy) / double(LOG_ODDS_SCALE)));
+}
+
+size_t OccupancyGrid::tileCount() const {
+  size_t count = 0;
+  for (const TileMap& tiles : shards_) count += tiles.size();
+  return count;
+}
+
+size_t OccupancyGrid::memoryBytes() const {
+  size_t bytes = tileCount() * sizeof(Tile) + beams_.capacity() * sizeof(Beam);
+  for (const auto& buffer : misses_) bytes += buffer.capacity() * sizeof(CellUpdate);
+  for (const auto& buffer : hits_) bytes += buffer.capacity() * sizeof(CellUpdate);
+  return bytes;
+}
+
+bool OccupancyGrid::bounds(int& min_cx, int& min_cy, int& max_cx, int& max_cy) const {
+  bool any = false;
+  min_cx = min_cy = std::numeric_limits<int>::max();
+  max_cx = max_cy = std::numeric_limits<int>::min();
+  for (const TileMap& tiles : shards_) {
+    for (const auto& entry : tiles) {
+      int tx = int32_t(uint32_t(entry.first >> 32)), ty = int32_t(uint32_t(entry.first));
+      min_cx = std::min(min_cx, tx * TILE_SIZE);
+      min_cy = std::min(min_cy, ty * TILE_SIZE);
+      max_cx = std::max(max_cx, tx * TILE_SIZE + TILE_SIZE - 1);
+      max_cy = std::max(max_cy, ty * TILE_SIZE + TILE_SIZE - 1);
+      any = true;
+    }
+  }
+  return any;
+}
+
+void OccupancyGrid::prepareBeams(const std::vector<ScanPoint>& scan, const Pose2D& pose) {
+  beams_.clear();
+  for (const ScanPoint& p : scan) {
+    double range = p.range;
+    if (!std::isfinite(range) || range < options_.min_range) continue;
+    bool hit = range <= options_.max_range;
+    if (!hit) range = options_.max_range;
+    double angle = pose.theta + p.angle;
+    Beam beam;
+    cellOf(pose.x + range * std::cos(angle), pose.y + range * std::sin(angle), beam.end_x, beam.end_y);
+    beam.hit = hit;
+    beams_.push_back(beam);
+  }
+}
+
+void OccupancyGrid::integrate(const std::vector<ScanPoint>& scan, const Pose2D& pose) {
+  prepareBeams(scan, pose);
+  int origin_x, origin_y;
+  cellOf(pose.x, pose.y, origin_x, origin_y);
+  if (shards_.size() == 1) {
+    integrateSerial(origin_x, origin_y);
+  } else {
+    integrateParallel(origin_x, origin_y);
+  }
+  stats_.scans++;
+  stats_.beams += beams_.size();
+}
+
+void OccupancyGrid::integrateSerial(int origin_x, int origin_y) {
+  ShardWriter writer(shards_[0], clamp_);
+  uint64_t cells = 0;
+  for (const Beam& beam : beams_) {
+    traceLine(origin_x, origin_y, beam.end_x, beam.end_y, [&](int x, int y) {
+      writer.add(x, y, miss_);
+      cells++;
+    });
+  }
+  for (const Beam& beam : beams_) {
+    if (!beam.hit) continue;
+    writer.add(beam.end_x, beam.end_y, hit_);
+    cells++;
+  }
+  stats_.cells += cells;
+}
+
+void OccupancyGrid::integrateParallel(int origin_x, int origin_y) {
+  const int threads = int(shards_.size());
+
+  // Trace: thread s takes a contiguous share of the beams and sorts the cells
+  // it crosses into the buffers of their shards. Only its own buffers are written.
+  auto trace = [&](int s) {
+    std::vector<CellUpdate>* misses = &misses_[size_t(s * threads)];
+    std::vector<CellUpdate>* hits   = &hits_[size_t(s * threads)];
+    for (int d = 0; d < threads; ++d) {
+      misses[d].clear();
+      hits[d].clear();
+    }
+    size_t begin = beams_.size() * size_t(s) / size_t(threads);
+    size_t end   = beams_.size() * size_t(s + 1) / size_t(threads);
+    int tile_x = std::numeric_limits<int>::min(), tile_y = tile_x;
+    std::vector<CellUpdate>* bucket = nullptr;
+    for (size_t b = begin; b < end; ++b) {
+      const Beam& beam = beams_[b];
+      traceLine(origin_x, origin_y, beam.end_x, beam.end_y, [&](int x, int y) {
+        int tx = x >> TILE_BITS, ty = y >> TILE_BITS;
+        if (tx != tile_x || ty != tile_y) {
+          tile_x = tx;
+          tile_y = ty;
+          bucket = &misses[shardOf(tx, ty)];
+        }
+        bucket->push_back({x, y});
+      });
+      if (beam.hit) {
+        hits[shardOf(beam.end_x >> TILE_BITS, beam.end_y >> TILE_BITS)].push_back({beam.end_x, beam.end_y});
+      }
+    }
+  };
+
+  // Apply: thread d owns shard d and takes its updates from every tracer,
+  // misses first as in serial mode
+  auto apply = [&](int d) {
+    ShardWriter writer(shards_[size_t(d)], clamp_);
+    for (int s = 0; s < threads; ++s) {
+      for (const CellUpdate& u : misses_[size_t(s * threads + d)]) writer.add(u.x, u.y, miss_);
+    }
+    for (int s = 0; s < threads; ++s) {
+      for (const CellUpdate& u : hits_[size_t(s * threads + d)]) writer.add(u.x, u.y, hit_);
+    }
+  };
+
+  auto job = [&](int t) {
+    trace(t);
+    pool_->sync();  // no shard is applied before every tracer is done
+    apply(t);
+  };
+  pool_->run(job);
+
+  for (size_t i = 0; i < misses_.size(); ++i) stats_.cells += misses_[i].size() + hits_[i].size();
+}
+
+void OccupancyGrid::writePgm(const std::string& path) const {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) throw std::runtime_error("cannot write " + path);
+  int min_cx = 0, min_cy = 0, max_cx = -1, max_cy = -1;
+  bounds(min_cx, min_cy, max_cx, max_cy);
+  int width = max_cx - min_cx + 1, height = max_cy - min_cy + 1;
+  out << "P5\n" << width << " " << height << "\n255\n";
+
+  std::vector<uint8_t> row(size_t(std::max(width, 0)));
+  for (int cy = max_cy; cy >= min_cy; --cy) {
+    for (int cx = min_cx; cx <= max_cx; ++cx) {
+      int16_t l = logOdds(cx, cy);
+      row[size_t(cx - min_cx)] = l == 0 ? 205 : uint8_t(255.0 * (1.0 - probability(cx, cy)));
+    }
+    out.write(reinterpret_cast<const char*>(row.data()), std::streamsize(row.size()));
+  }
+  if (!out) throw std::runtime_error("cannot write " + path);
+}
@@ -0,0 +1,130 @@
+// src/occupancy_grid.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "pose2d.hpp"
+#include "scan_assembler.hpp"
+
+/// 2D occupancy grid built incrementally from ScanPoint revolutions.
+///
+/// Each beam is traced from the sensor cell to its end cell with an integer
+/// Bresenham walk: cells it passes get the log-odds of a miss, the end cell
+/// the log-odds of a hit. Log-odds are int16 fixed point, saturating at the
+/// clamp, so repeated observations cannot make a cell unchangeable forever.
+///
+/// Cells live in TILE_SIZE x TILE_SIZE tiles allocated on first touch, so
+/// memory grows with the explored area, not with its bounding box. Tiles are
+/// sharded by a hash of their coordinates, one shard per thread. With
+/// threads > 1, each thread traces its share of the beams into per-shard
+/// update buffers, then each thread applies one shard's updates; no tile or
+/// shard map is written by two threads. The worker threads are started with
+/// the grid and wait between scans, so integrate() creates no threads and,
+/// once the buffers have grown, allocates only for new tiles. Within a scan all misses are applied
+/// before all hits, in both modes, so the map does not depend on the thread
+/// count.
+class OccupancyGrid {
+public:
+  static constexpr int TILE_BITS  = 6;
+  static constexpr int TILE_SIZE  = 1 << TILE_BITS;        // cells per tile side
+  static constexpr int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+  /// Stored log-odds are the real ones times this.
+  static constexpr float LOG_ODDS_SCALE = 100.0f;
+
+  struct Options {
+    double resolution       = 0.05;   // meters per cell side
+    double hit_probability  = 0.7;    // P(occupied | beam ended in the cell)
+    double miss_probability = 0.4;    // P(occupied | beam passed through)
+    double clamp_probability = 0.99;  // log-odds saturate at ±logit(this)
+    double min_range        = 0.1;    // shorter returns are dropped
+    double max_range        = 15.0;   // longer ones clear to here, without a hit
+    int    threads          = 1;
+  };
+
+  struct Stats {
+    uint64_t scans = 0;
+    uint64_t beams = 0;   // beams traced
+    uint64_t cells = 0;   // cell updates, hits and misses
+  };
+
+  OccupancyGrid() : OccupancyGrid(Options()) {}
+  /// Throws std::invalid_argument for a non-positive resolution, probabilities
+  /// on the wrong side of 0.5 or a thread count outside 1..64.
+  explicit OccupancyGrid(const Options& options);
+  ~OccupancyGrid();
+
+  OccupancyGrid(const OccupancyGrid&) = delete;
+  OccupancyGrid& operator=(const OccupancyGrid&) = delete;
+
+  /// Integrate one revolution seen from `pose`. Points with a non-finite or
+  /// too short range are skipped.
+  void integrate(const std::vector<ScanPoint>& scan, const Pose2D& pose);
+
+  /// Cell containing a map-frame point.
+  void cellOf(double x, double y, int& cx, int& cy) const;
+
+  /// Stored log-odds of a cell (see LOG_ODDS_SCALE); 0 if never observed.
+  int16_t logOdds(int cx, int cy) const;
+  /// Occupancy probability of a cell; 0.5 if never observed.
+  double probability(int cx, int cy) const;
+
+  /// Cell bounds of all allocated tiles; false if the grid is empty.
+  bool bounds(int& min_cx, int& min_cy, int& max_cx, int& max_cy) const;
+
+  size_t tileCount() const;
+  /// Tile storage plus the multi-threaded update buffers.
+  size_t memoryBytes() const;
+
+  /// Write the allocated area as an 8-bit PGM (white free, black occupied,
+  /// grey unknown), +y up. Throws std::runtime_error if the file cannot be written.
+  void writePgm(const std::string& path) const;
+
+  const Options& options() const { return options_; }
+  const Stats& stats() const { return stats_; }
+
+private:
+  struct Tile {
+    int16_t cells[TILE_CELLS] = {};
+  };
+  using TileMap = std::unordered_map<uint64_t, std::unique_ptr<Tile>>;
+
+  /// A beam in cells: traced from the origin to (end_x, end_y); hit says
+  /// whether the end cell is an obstacle.
+  struct Beam {
+    int32_t end_x, end_y;
+    bool hit;
+  };
+  struct CellUpdate {
+    int32_t x, y;
+  };
+
+  /// One shard's view while applying updates: caches the last tile.
+  class ShardWriter;
+  /// threads - 1 persistent workers plus the caller, with a barrier.
+  class WorkerPool;
+
+  Options options_;
+  double  inv_resolution_;
+  int16_t hit_, miss_, clamp_;
+  std::vector<TileMap> shards_;   // one per thread
+  Stats   stats_;
+
+  std::vector<Beam> beams_;       // this scan's beams, reused
+  // Multi-threaded mode: [source thread * threads + shard], reused
+  std::vector<std::vector<CellUpdate>> misses_, hits_;
+  std::unique_ptr<WorkerPool> pool_;
+
+  static uint64_t tileKey(int tx, int ty) {
+    return (uint64_t(uint32_t(tx)) << 32) | uint32_t(ty);
+  }
+  size_t shardOf(int tx, int ty) const;
+  const Tile* findTile(int cx, int cy) const;
+
+  void prepareBeams(const std::vector<ScanPoint>& scan, const Pose2D& pose);
+  void integrateSerial(int origin_x, int origin_y);
+  void integrateParallel(int origin_x, int origin_y);
+};
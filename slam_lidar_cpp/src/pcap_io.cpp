@@ -0,0 +1,167 @@
+// pcap_io.cpp
+
+#include "pcap_io.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+
+static constexpr size_t WRITE_CHUNK = 64 << 20;  // file grows 64 MiB at a time
+
+static std::runtime_error sysError(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+static int64_t monotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// PcapWriter
+
+PcapWriter::PcapWriter(const std::string& path, uint16_t dst_port)
+  : dst_port_(dst_port)
+{
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) throw sysError("open " + path);
+
+  uint8_t header[PCAP_FILE_HEADER_SIZE];
+  buildPcapFileHeader(header);
+  try {
+    append(header, sizeof(header));
+  } catch (...) {
+    close(fd_);
+    throw;
+  }
+}
+
+PcapWriter::~PcapWriter() {
+  if (map_) munmap(map_, map_size_);
+  if (ftruncate(fd_, file_size_) < 0) {
+    // nothing sensible to do in a destructor; the tail is zero padding
+  }
+  close(fd_);
+}
+
+void PcapWriter::ensureSpace(size_t bytes) {
+  if (map_ && file_size_ + bytes <= map_offset_ + map_size_) return;
+
+  if (map_) munmap(map_, map_size_);
+  map_ = nullptr;
+
+  // New window starts at the page holding the write position
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  map_offset_ = file_size_ & ~(page - 1);
+  map_size_   = WRITE_CHUNK;
+  if (ftruncate(fd_, map_offset_ + map_size_) < 0) throw sysError("ftruncate pcap");
+
+  void* m = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, map_offset_);
+  if (m == MAP_FAILED) throw sysError("mmap pcap");
+  map_ = static_cast<uint8_t*>(m);
+}
+
+void PcapWriter::append(const void* data, size_t bytes) {
+  ensureSpace(bytes);
+  std::memcpy(map_ + (file_size_ - map_offset_), data, bytes);
+  file_size_ += bytes;
+}
+
+void PcapWriter::write(const uint8_t* payload, size_t size, const timespec& ts,
+                       const sockaddr_in* src) {
+  ensureSpace(PCAP_RECORD_PREFIX_SIZE + size);
+  uint8_t prefix[PCAP_RECORD_PREFIX_SIZE];
+  buildPcapRecordPrefix(prefix, size, ts, dst_port_, src);
+  append(prefix, sizeof(prefix));
+  append(payload, size);
+  packets_++;
+}
+
+// ---------------------------------------------------------------------------
+// PcapReplay
+
+PcapReplay::PcapReplay(const std::string& path, uint16_t port)
+  : port_(port)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw sysError("open " + path);
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    throw sysError("stat " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ < PCAP_FILE_HEADER_SIZE) {
+    close(fd);
+    throw std::runtime_error(path + ": too short for a pcap file");
+  }
+
+  void* m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) throw sysError("mmap " + path);
+  data_ = static_cast<const uint8_t*>(m);
+  madvise(m, size_, MADV_SEQUENTIAL);
+
+  std::string error;
+  if (!parser_.open(data_, size_, error)) {
+    munmap(m, size_);
+    throw std::runtime_error(path + ": " + error);
+  }
+}
+
+PcapReplay::~PcapReplay() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+void PcapReplay::setSpeed(double speed) {
+  if (speed < 0) throw std::invalid_argument("replay speed must be >= 0");
+  speed_ = speed;
+  first_ts_ns_ = -1;  // re-anchor the schedule at the next packet
+}
+
+void PcapReplay::rewind() {
+  parser_.rewind();
+  first_ts_ns_ = -1;
+}
+
+bool PcapReplay::next(const uint8_t*& data, size_t& size, uint64_t* timestamp_ns) {
+  const uint8_t* frame;
+  size_t len;
+  int64_t ts_ns;
+  while (parser_.nextRecord(frame, len, ts_ns)) {
+    if (!parser_.udpPayload(frame, len, port_, data, size)) {
+      stats_.skipped++;
+      continue;
+    }
+    pace(ts_ns);
+    if (timestamp_ns) *timestamp_ns = uint64_t(ts_ns);
+    stats_.packets++;
+    return true;
+  }
+  return false;
+}
+
+void PcapReplay::pace(int64_t ts_ns) {
+  if (speed_ == 0) return;
+
+  if (first_ts_ns_ < 0) {
+    first_ts_ns_ = ts_ns;
+    start_ns_    = monotonicNs();
+    return;
+  }
+
+  int64_t due = start_ns_ + int64_t((ts_ns - first_ts_ns_) / speed_);
+  int64_t now = monotonicNs();
+  if (due > now) {
+    timespec t{ time_t(due / 1000000000), long(due % 1000000000) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, nullptr) == EINTR) {
+    }
+  } else if (now - due > 1000000) {
+    stats_.late++;
+  }
+}
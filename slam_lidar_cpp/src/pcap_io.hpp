@@ -0,0 +1,98 @@
+// src/pcap_io.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <time.h>
+#include <netinet/in.h>
+#include "pcap_format.h"
+
+/// Thrown by a replaying LiDARReader when the capture has no more packets.
+struct EndOfCapture : std::runtime_error {
+  EndOfCapture() : std::runtime_error("end of pcap capture") {}
+};
+
+/// Writes received MSOP payloads to a nanosecond pcap file.
+///
+/// Each payload is wrapped in synthesized Ethernet/IPv4/UDP headers so the file
+/// opens in Wireshark and tcpdump like a live capture. The file is grown in
+/// large chunks and written through a memory mapping, so recording costs no
+/// syscall per packet. The destructor trims the file to the bytes written.
+class PcapWriter {
+public:
+  explicit PcapWriter(const std::string& path, uint16_t dst_port = 2368);
+  ~PcapWriter();
+
+  PcapWriter(const PcapWriter&) = delete;
+  PcapWriter& operator=(const PcapWriter&) = delete;
+
+  /// Append one UDP payload received at ts (CLOCK_REALTIME). src is the
+  /// sender address if known.
+  void write(const uint8_t* payload, size_t size, const timespec& ts,
+             const sockaddr_in* src = nullptr);
+
+  uint64_t packets() const { return packets_; }
+  uint64_t bytes() const { return file_size_; }
+
+private:
+  int      fd_;
+  uint16_t dst_port_;
+  uint8_t* map_       = nullptr;  // window [map_offset_, map_offset_ + map_size_)
+  size_t   map_offset_ = 0;
+  size_t   map_size_   = 0;
+  size_t   file_size_  = 0;       // bytes of valid pcap data
+  uint64_t packets_    = 0;
+
+  void ensureSpace(size_t bytes);
+  void append(const void* data, size_t bytes);
+};
+
+/// Memory-mapped pcap reader that hands out MSOP payloads on the capture's
+/// own schedule.
+///
+/// Records are read by the PcapParser shared with reader2.0 (common/), which
+/// understands Ethernet (with 802.1Q tags), raw IP and Linux cooked (SLL,
+/// SLL2) captures, in microsecond or nanosecond resolution and either byte
+/// order, so `tcpdump -w` files replay as well as PcapWriter output.
+/// Only unfragmented IPv4/UDP packets to the configured port are returned.
+class PcapReplay {
+public:
+  /// port 0 accepts UDP packets to any port.
+  explicit PcapReplay(const std::string& path, uint16_t port = 2368);
+  ~PcapReplay();
+
+  PcapReplay(const PcapReplay&) = delete;
+  PcapReplay& operator=(const PcapReplay&) = delete;
+
+  /// 1 = original timing, N = N× faster, 0 = as fast as possible.
+  void setSpeed(double speed);
+  double speed() const { return speed_; }
+
+  /// Next payload, pointing into the mapping (valid while the replay lives).
+  /// Sleeps until the packet is due. Returns false at the end of the capture.
+  bool next(const uint8_t*& data, size_t& size, uint64_t* timestamp_ns = nullptr);
+
+  /// Start over from the first packet; the pacing clock restarts too.
+  void rewind();
+
+  struct Stats {
+    uint64_t packets = 0;  // payloads returned
+    uint64_t skipped = 0;  // records that were not UDP to the port
+    uint64_t late    = 0;  // payloads returned more than 1 ms behind schedule
+  };
+  const Stats& stats() const { return stats_; }
+
+private:
+  const uint8_t* data_ = nullptr;
+  size_t   size_       = 0;
+  PcapParser parser_;
+  uint16_t port_;
+  double   speed_      = 1.0;
+  int64_t  first_ts_ns_ = -1;    // capture time of the first returned packet
+  int64_t  start_ns_    = 0;     // CLOCK_MONOTONIC when it was returned
+  Stats    stats_;
+
+  void pace(int64_t ts_ns);
+};
@@ -0,0 +1,20 @@
+// src/pose2d.hpp
+
+#pragma once
+#include <cmath>
+
+/// Planar pose of the sensor in the map frame: position in meters, heading
+/// in radians (counter-clockwise from +x). ScanPoint angles are measured
+/// from the heading, so a point lands at (x + r cos(θ + a), y + r sin(θ + a)).
+struct Pose2D {
+  double x     = 0;
+  double y     = 0;
+  double theta = 0;
+
+  /// Map a point from the sensor frame into the map frame.
+  void transform(double px, double py, double& mx, double& my) const {
+    double c = std::cos(theta), s = std::sin(theta);
+    mx = x + c * px - s * py;
+    my = y + s * px + c * py;
+  }
+};
@@ -1,13 +1,14 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <cstdlib>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
-#include "data_type.h"
+#include "msop_packet_view.h"
 
 int main(int argc, char** argv){
-  if(argc < 3){
+  if(argc < 2){
     std::cerr << "Usage: " << argv[0] << " <local_udp_port>\n";
     return 1;
   }
@@ -37,27 +38,34 @@ int main(int argc, char** argv){
   std::cout << "Listening on UDP port " << port << "...\n";
 
   // 2) receive one packet
-  MSOP_Data_t packet;
+  uint8_t packet[MSOPPacketView::PACKET_SIZE];
   socklen_t len = sizeof(addr);
-  ssize_t n = recvfrom(sockfd, &packet, sizeof(packet), 0,
+  ssize_t n = recvfrom(sockfd, packet, sizeof(packet), 0,
                        (sockaddr*)&addr, &len);
   if(n < 0){
     perror("recvfrom");
     return 1;
   }
   std::cout << "Received " << n << " bytes\n";
+  if(n != static_cast<ssize_t>(MSOPPacketView::PACKET_SIZE)){
+    std::cerr << "Not an MSOP packet\n";
+    return 1;
+  }
 
-  // 3) print some raw fields (no byte-swapping)
+  // 3) print some fields of block 0, as sent (big-endian) and decoded
+  MSOPPacketView view(packet);
   std::cout << std::hex << std::showbase;
-  std::cout << "Block0.DataFlag = " << packet.BlockID[0].DataFlag << "\n";
-  std::cout << "Block0.Azimuth  = " << packet.BlockID[0].Azimuth  << "\n";
+  std::cout << "Block0 bytes    = ";
+  for(int i=0;i<16;i++) std::cout << int(packet[i]) << " ";
+  std::cout << "\n";
+  std::cout << "Block0.flag     = " << view.blockFlag(0)    << "\n";
+  std::cout << "Block0.azimuth  = " << view.blockAzimuth(0) << "\n";
   std::cout << std::dec << std::noshowbase;
 
-  // print first 4 distances and RSSIs raw
+  // print first 4 distances and RSSIs
   for(int i=0;i<4;i++){
-    auto &res = packet.BlockID[0].Result[i];
-    std::cout << "  Result["<<i<<"].Dist_1= " << res.Dist_1
-              << "  RSSI_1= " << int(res.RSSI_1) << "\n";
+    std::cout << "  result["<<i<<"].distance= " << view.distanceStrongest(0, i)
+              << "  rssi= " << int(view.rssiStrongest(0, i)) << "\n";
   }
 
   close(sockfd);
@@ -0,0 +1,126 @@
+// scan_assembler.cpp
+
+#include "scan_assembler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+static_assert(sizeof(MSOP_Data_t) == MSOPPacketView::PACKET_SIZE, "MSOP_Data_t layout changed");
+static_assert(sizeof(Data_block) == MSOPPacketView::BLOCK_SIZE, "Data_block layout changed");
+
+static constexpr double INF_DIST = std::numeric_limits<double>::infinity();
+
+// Coarsest plausible spacing between blocks: 16 points at 1° each
+static constexpr int MAX_BLOCK_STEP = 1600;
+
+ScanAssembler::ScanAssembler(const AzimuthTable& table, size_t max_points)
+  : table_(&table),
+    max_points_(max_points)
+{
+  if (max_points_ < static_cast<size_t>(POINTS_PER_BLOCK))
+    throw std::invalid_argument("revolution buffer smaller than one block");
+  buffers_[0].reserve(max_points_);
+  buffers_[1].reserve(max_points_);
+}
+
+bool ScanAssembler::addPacket(MSOPPacketView packet) {
+  stats_.packets++;
+  bool completed = false;
+  uint64_t start = latency_ ? latency_->start() : 0;
+  close_ns_ = 0;
+
+  // Host-order azimuths; blocks with a bad flag or azimuth are skipped
+  int  azimuth[BLOCKS_PER_PACKET];
+  bool valid[BLOCKS_PER_PACKET];
+  for (int b = 0; b < BLOCKS_PER_PACKET; ++b) {
+    azimuth[b] = packet.blockAzimuth(b);
+    valid[b]   = packet.blockFlag(b) == VALID_FLAG && azimuth[b] < AzimuthTable::SIZE;
+  }
+
+  for (int b = 0; b < BLOCKS_PER_PACKET; ++b) {
+    if (!valid[b]) continue;
+
+    // Wrap: azimuth jumped back by more than half a turn (small steps back
+    // are treated as jitter, not a new revolution)
+    if (last_azimuth_ >= 0 && last_azimuth_ - azimuth[b] > AzimuthTable::SIZE / 2) {
+      closeAt(stats_.wraps, completed);
+    }
+    last_azimuth_ = azimuth[b];
+
+    // Spacing to the next block, in hundredths of a degree, wrap-aware.
+    // A larger jump is the gap outside the field of view, not a block step.
+    if (b + 1 < BLOCKS_PER_PACKET && valid[b + 1]) {
+      int step = (azimuth[b + 1] - azimuth[b] + AzimuthTable::SIZE) % AzimuthTable::SIZE;
+      if (step > 0 && step <= MAX_BLOCK_STEP)
+        last_step_ = step;
+    }
+
+    if (buffers_[filling_].size() + POINTS_PER_BLOCK > max_points_) {
+      closeAt(stats_.overflows, completed);
+    }
+
+    std::vector<ScanPoint>& out = buffers_[filling_];
+    for (int i = 0; i < POINTS_PER_BLOCK; ++i) {
+      uint16_t raw = static_cast<uint16_t>(
+          ((azimuth[b] * POINTS_PER_BLOCK + last_step_ * i + POINTS_PER_BLOCK / 2)
+           / POINTS_PER_BLOCK) % AzimuthTable::SIZE);
+
+      double dist_m    = packet.distanceStrongest(b, i) / 1000.0;
+      double intensity = packet.rssiStrongest(b, i);
+      if (dist_m <= 0) {
+        dist_m    = INF_DIST;
+        intensity = 0;
+      }
+      out.push_back({ table_->angle(raw), dist_m, intensity, raw });
+    }
+  }
+
+  if (isLastPacket(packet)) {
+    closeAt(stats_.markers, completed);
+    last_azimuth_ = -1;
+  }
+
+  if (start != 0) latency_->record(STAGE_PARSE, PipelineLatency::now() - start - close_ns_);
+  return completed;
+}
+
+void ScanAssembler::reset() {
+  buffers_[filling_].clear();
+  last_azimuth_ = -1;
+}
+
+void ScanAssembler::closeAt(uint64_t& reason, bool& completed) {
+  if (completed) {
+    // A second swap would clear the revolution the caller is about to read
+    if (!buffers_[filling_].empty()) {
+      buffers_[filling_].clear();
+      stats_.fragments++;
+    }
+    return;
+  }
+  uint64_t start = latency_ ? latency_->start() : 0;
+  if (finishRevolution()) {
+    reason++;
+    completed = true;
+  }
+  if (start != 0) {
+    uint64_t elapsed = PipelineLatency::now() - start;
+    latency_->record(STAGE_ASSEMBLY, elapsed);
+    close_ns_ += elapsed;
+  }
+}
+
+bool ScanAssembler::finishRevolution() {
+  std::vector<ScanPoint>& buf = buffers_[filling_];
+  if (buf.empty()) return false;
+
+  // An upside-down sensor sweeps the other way; keep angles ascending
+  if (table_->inverted())
+    std::reverse(buf.begin(), buf.end());
+
+  filling_ = 1 - filling_;
+  buffers_[filling_].clear();
+  stats_.revolutions++;
+  return true;
+}
@@ -0,0 +1,90 @@
+// src/scan_assembler.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data_type.h"
+#include "azimuth_table.hpp"
+#include "msop_packet_view.h"
+#include "latency_histogram.h"
+
+struct ScanPoint {
+  double angle;     // radians
+  double range;     // meters
+  double intensity; // RSSI units
+  uint16_t raw_azimuth = 0;  // 0.01° units before mounting, index into AzimuthTable
+};
+
+/// Accumulates MSOP packets into whole revolutions.
+///
+/// Points go into a preallocated fill buffer. A revolution ends when the block
+/// azimuth wraps around, or after a packet whose blocks 6-11 are marked
+/// invalid (the sensor's last-packet marker). The finished revolution is then
+/// swapped into the second buffer, where the consumer reads it while the next
+/// one fills. Both buffers are sized up front, so steady state never allocates.
+///
+/// At most one revolution is completed per packet, so completed() always holds
+/// the one addPacket() reported. Should a second boundary follow in the same
+/// packet (an overflow then a wrap, or a wrap then the marker), the points
+/// between the two are a fragment and are dropped.
+class ScanAssembler {
+public:
+  /// Enough for 64 packets (12288 points), well above one 360° revolution.
+  static constexpr size_t DEFAULT_MAX_POINTS = 64 * BLOCKS_PER_PACKET * POINTS_PER_BLOCK;
+
+  struct Stats {
+    uint64_t packets      = 0;  // packets fed to addPacket()
+    uint64_t revolutions  = 0;  // revolutions completed
+    uint64_t wraps        = 0;  // ...closed by an azimuth wrap
+    uint64_t markers      = 0;  // ...closed by the last-packet marker
+    uint64_t overflows    = 0;  // ...closed early because the buffer filled up
+    uint64_t fragments    = 0;  // partial revolutions dropped at a second boundary in one packet
+  };
+
+  explicit ScanAssembler(const AzimuthTable& table,
+                         size_t max_points = DEFAULT_MAX_POINTS);
+
+  /// Decode one packet in place. Returns true if a revolution was completed
+  /// by this packet and is now available from completed().
+  bool addPacket(MSOPPacketView packet);
+
+  /// Most recently completed revolution. Stays valid until the next time
+  /// addPacket() returns true.
+  const std::vector<ScanPoint>& completed() const { return buffers_[1 - filling_]; }
+
+  /// Points collected so far for the revolution in progress.
+  size_t pendingPoints() const { return buffers_[filling_].size(); }
+
+  /// Record each packet's block decode under STAGE_PARSE and each revolution
+  /// close (reorder and buffer swap) under STAGE_ASSEMBLY; nullptr to stop.
+  /// Only recorded while `latency` is enabled.
+  void setLatency(PipelineLatency* latency) { latency_ = latency; }
+
+  /// Drop the revolution in progress (e.g. after a gap in the stream).
+  void reset();
+
+  size_t maxPoints() const { return max_points_; }
+  const Stats& stats() const { return stats_; }
+
+  /// True if blocks 6-11 carry the invalid flag, which the sensor sends in the
+  /// last packet of a revolution.
+  static bool isLastPacket(MSOPPacketView packet) { return packet.isLastPacket(); }
+
+private:
+  const AzimuthTable* table_;
+  size_t max_points_;
+  std::vector<ScanPoint> buffers_[2];
+  int filling_ = 0;
+  int last_azimuth_ = -1;   // raw azimuth of the previous valid block, -1 if none
+  int last_step_ = 400;     // centidegrees between blocks, reused when a neighbour is invalid
+  Stats stats_;
+  PipelineLatency* latency_ = nullptr;
+  uint64_t close_ns_ = 0;   // time spent closing within the current addPacket()
+
+  /// Close the revolution in the fill buffer if it has any points.
+  bool finishRevolution();
+  /// finishRevolution() for a boundary found in the packet being added, counted
+  /// under `reason`; drops the fill buffer instead if `completed` is already set.
+  void closeAt(uint64_t& reason, bool& completed);
+};
@@ -0,0 +1,415 @@
+// scan_matcher.cpp
+
+#include "scan_matcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_MATCHER_X86 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define SCAN_MATCHER_NEON 1
+#endif
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+/// atan2 within about 1e-5 rad, for binning bearings. Target and source go
+/// through the same function, so its error shifts both alike.
+inline double fastAtan2(double y, double x) {
+  double ax = std::fabs(x), ay = std::fabs(y);
+  double hi = ax > ay ? ax : ay;
+  if (hi == 0) return 0;
+  double z = (ax > ay ? ay : ax) / hi;
+  double z2 = z * z;
+  double a = z * (0.9998660 + z2 * (-0.3302995 + z2 * (0.1801410 + z2 * (-0.0851330 + z2 * 0.0208351))));
+  if (ay > ax) a = PI / 2 - a;
+  if (x < 0) a = PI - a;
+  return y < 0 ? -a : a;
+}
+
+/// Sums of JᵀJ (upper triangle), Jᵀr and r² over one step's correspondences,
+/// with J = (nx, ny, ny·rx - nx·ry) for the rotated source point (rx, ry).
+struct NormalEquations {
+  double h00 = 0, h01 = 0, h02 = 0, h11 = 0, h12 = 0, h22 = 0;
+  double g0 = 0, g1 = 0, g2 = 0;
+  double rr = 0;
+};
+
+struct Correspondences {
+  const double *sx, *sy, *qx, *qy, *nx, *ny;
+  size_t size;
+};
+
+void accumulateScalar(const Correspondences& m, size_t begin, double c, double s,
+                      double tx, double ty, NormalEquations& e) {
+  for (size_t i = begin; i < m.size; ++i) {
+    double rx = c * m.sx[i] - s * m.sy[i];
+    double ry = s * m.sx[i] + c * m.sy[i];
+    double nx = m.nx[i], ny = m.ny[i];
+    double r  = nx * (rx + tx - m.qx[i]) + ny * (ry + ty - m.qy[i]);
+    double j2 = ny * rx - nx * ry;
+    e.h00 += nx * nx;  e.h01 += nx * ny;  e.h02 += nx * j2;
+    e.h11 += ny * ny;  e.h12 += ny * j2;  e.h22 += j2 * j2;
+    e.g0  += nx * r;   e.g1  += ny * r;   e.g2  += j2 * r;
+    e.rr  += r * r;
+  }
+}
+
+#ifdef SCAN_MATCHER_X86
+__attribute__((target("avx2,fma")))
+inline double horizontalSum(__m256d v) {
+  __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+__attribute__((target("avx2,fma")))
+void accumulateAvx2(const Correspondences& m, double c, double s, double tx, double ty,
+                    NormalEquations& e) {
+  const __m256d vc = _mm256_set1_pd(c), vs = _mm256_set1_pd(s);
+  const __m256d vtx = _mm256_set1_pd(tx), vty = _mm256_set1_pd(ty);
+  __m256d h00 = _mm256_setzero_pd(), h01 = h00, h02 = h00, h11 = h00, h12 = h00, h22 = h00;
+  __m256d g0 = h00, g1 = h00, g2 = h00, rr = h00;
+  size_t i = 0;
+  for (; i + 4 <= m.size; i += 4) {
+    __m256d sx = _mm256_loadu_pd(m.sx + i), sy = _mm256_loadu_pd(m.sy + i);
+    __m256d nx = _mm256_loadu_pd(m.nx + i), ny = _mm256_loadu_pd(m.ny + i);
+    __m256d rx = _mm256_fmsub_pd(vc, sx, _mm256_mul_pd(vs, sy));
+    __m256d ry = _mm256_fmadd_pd(vs, sx, _mm256_mul_pd(vc, sy));
+    __m256d dx = _mm256_sub_pd(_mm256_add_pd(rx, vtx), _mm256_loadu_pd(m.qx + i));
+    __m256d dy = _mm256_sub_pd(_mm256_add_pd(ry, vty), _mm256_loadu_pd(m.qy + i));
+    __m256d r  = _mm256_fmadd_pd(nx, dx, _mm256_mul_pd(ny, dy));
+    __m256d j2 = _mm256_fmsub_pd(ny, rx, _mm256_mul_pd(nx, ry));
+    h00 = _mm256_fmadd_pd(nx, nx, h00);
+    h01 = _mm256_fmadd_pd(nx, ny, h01);
+    h02 = _mm256_fmadd_pd(nx, j2, h02);
+    h11 = _mm256_fmadd_pd(ny, ny, h11);
+    h12 = _mm256_fmadd_pd(ny, j2, h12);
+    h22 = _mm256_fmadd_pd(j2, j2, h22);
+    g0  = _mm256_fmadd_pd(nx, r, g0);
+    g1  = _mm256_fmadd_pd(ny, r, g1);
+    g2  = _mm256_fmadd_pd(j2, r, g2);
+    rr  = _mm256_fmadd_pd(r, r, rr);
+  }
+  e.h00 = horizontalSum(h00);  e.h01 = horizontalSum(h01);  e.h02 = horizontalSum(h02);
+  e.h11 = horizontalSum(h11);  e.h12 = horizontalSum(h12);  e.h22 = horizontalSum(h22);
+  e.g0  = horizontalSum(g0);   e.g1  = horizontalSum(g1);   e.g2  = horizontalSum(g2);
+  e.rr  = horizontalSum(rr);
+  // The tail runs as SSE code: leaving the upper halves dirty would slow it
+  // and everything after it down
+  _mm256_zeroupper();
+  accumulateScalar(m, i, c, s, tx, ty, e);
+}
+
+bool haveAvx2Fma() {
+  static const bool avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0 && __builtin_cpu_supports("fma") != 0;
+  }();
+  return avx2;
+}
+#endif
+
+#ifdef SCAN_MATCHER_NEON
+// Two doubles per register; Advanced SIMD and FMA are mandatory on AArch64
+void accumulateNeon(const Correspondences& m, double c, double s, double tx, double ty,
+                    NormalEquations& e) {
+  const float64x2_t vc = vdupq_n_f64(c), vs = vdupq_n_f64(s);
+  const float64x2_t vtx = vdupq_n_f64(tx), vty = vdupq_n_f64(ty);
+  float64x2_t h00 = vdupq_n_f64(0), h01 = h00, h02 = h00, h11 = h00, h12 = h00, h22 = h00;
+  float64x2_t g0 = h00, g1 = h00, g2 = h00, rr = h00;
+  size_t i = 0;
+  for (; i + 2 <= m.size; i += 2) {
+    float64x2_t sx = vld1q_f64(m.sx + i), sy = vld1q_f64(m.sy + i);
+    float64x2_t nx = vld1q_f64(m.nx + i), ny = vld1q_f64(m.ny + i);
+    float64x2_t rx = vfmsq_f64(vmulq_f64(vc, sx), vs, sy);
+    float64x2_t ry = vfmaq_f64(vmulq_f64(vc, sy), vs, sx);
+    float64x2_t dx = vsubq_f64(vaddq_f64(rx, vtx), vld1q_f64(m.qx + i));
+    float64x2_t dy = vsubq_f64(vaddq_f64(ry, vty), vld1q_f64(m.qy + i));
+    float64x2_t r  = vfmaq_f64(vmulq_f64(ny, dy), nx, dx);
+    float64x2_t j2 = vfmsq_f64(vmulq_f64(ny, rx), nx, ry);
+    h00 = vfmaq_f64(h00, nx, nx);
+    h01 = vfmaq_f64(h01, nx, ny);
+    h02 = vfmaq_f64(h02, nx, j2);
+    h11 = vfmaq_f64(h11, ny, ny);
+    h12 = vfmaq_f64(h12, ny, j2);
+    h22 = vfmaq_f64(h22, j2, j2);
+    g0  = vfmaq_f64(g0, nx, r);
+    g1  = vfmaq_f64(g1, ny, r);
+    g2  = vfmaq_f64(g2, j2, r);
+    rr  = vfmaq_f64(rr, r, r);
+  }
+  e.h00 = vaddvq_f64(h00);  e.h01 = vaddvq_f64(h01);  e.h02 = vaddvq_f64(h02);
+  e.h11 = vaddvq_f64(h11);  e.h12 = vaddvq_f64(h12);  e.h22 = vaddvq_f64(h22);
+  e.g0  = vaddvq_f64(g0);   e.g1  = vaddvq_f64(g1);   e.g2  = vaddvq_f64(g2);
+  e.rr  = vaddvq_f64(rr);
+  accumulateScalar(m, i, c, s, tx, ty, e);
+}
+#endif
+
+NormalEquations accumulate(const Correspondences& m, double c, double s, double tx, double ty) {
+  NormalEquations e;
+#ifdef SCAN_MATCHER_X86
+  if (haveAvx2Fma()) {
+    accumulateAvx2(m, c, s, tx, ty, e);
+    return e;
+  }
+#endif
+#ifdef SCAN_MATCHER_NEON
+  accumulateNeon(m, c, s, tx, ty, e);
+  return e;
+#endif
+  accumulateScalar(m, 0, c, s, tx, ty, e);
+  return e;
+}
+
+/// Gauss-Newton step H·d = -g. False if H is singular, or if the weakest
+/// translation direction gets less than `min_constraint` of the normals'
+/// weight (unit normals: the translation block's trace is the correspondence
+/// count), as along a featureless corridor.
+bool solveStep(const NormalEquations& e, double min_constraint, double& dx, double& dy, double& dtheta) {
+  double half_trace = (e.h00 + e.h11) / 2;
+  double spread = std::sqrt(std::max(0.0, half_trace * half_trace - (e.h00 * e.h11 - e.h01 * e.h01)));
+  if (half_trace - spread < min_constraint * 2 * half_trace) return false;
+  double a = e.h11 * e.h22 - e.h12 * e.h12;
+  double b = e.h02 * e.h12 - e.h01 * e.h22;
+  double c = e.h01 * e.h12 - e.h02 * e.h11;
+  double det = e.h00 * a + e.h01 * b + e.h02 * c;
+  if (!(det > 0)) return false;
+  double d = e.h00 * e.h22 - e.h02 * e.h02;
+  double f = e.h01 * e.h02 - e.h00 * e.h12;
+  double g = e.h00 * e.h11 - e.h01 * e.h01;
+  dx     = -(a * e.g0 + b * e.g1 + c * e.g2) / det;
+  dy     = -(b * e.g0 + d * e.g1 + f * e.g2) / det;
+  dtheta = -(c * e.g0 + f * e.g1 + g * e.g2) / det;
+  return true;
+}
+
+}  // namespace
+
+ScanMatcher::ScanMatcher(const Options& options)
+  : options_(options),
+    bins_per_radian_(options.bearing_bins / (2 * PI))
+{
+  if (options.bearing_bins <= 0 || options.search_window <= 0 || options.normal_window <= 0 ||
+      options.max_iterations <= 0 || !(options.max_distance > 0) || !(options.neighbour_gap > 0)) {
+    throw std::invalid_argument("scan matcher windows, bins and distances must be positive");
+  }
+  bin_x_.resize(size_t(options.bearing_bins));
+  bin_y_.resize(bin_x_.size());
+  bin_range2_.assign(bin_x_.size(), std::numeric_limits<double>::infinity());
+  bin_first_.resize(bin_x_.size() + 1);
+  // A target never holds more than one point per bin
+  for (auto* buffer : {&filled_x_, &filled_y_, &target_x_, &target_y_, &target_nx_, &target_ny_}) {
+    buffer->reserve(bin_x_.size());
+  }
+  filled_bin_.reserve(bin_x_.size());
+  target_bin_.reserve(bin_x_.size());
+}
+
+int ScanMatcher::binOf(double x, double y) const {
+  int bin = int((fastAtan2(y - viewpoint_y_, x - viewpoint_x_) + PI) * bins_per_radian_);
+  return bin < 0 ? 0 : bin >= options_.bearing_bins ? options_.bearing_bins - 1 : bin;
+}
+
+void ScanMatcher::setTarget(const std::vector<ScanPoint>& scan, const Pose2D& pose) {
+  clearTarget(pose);
+  addToTarget(scan, pose);
+}
+
+void ScanMatcher::clearTarget(const Pose2D& viewpoint) {
+  viewpoint_x_ = viewpoint.x;
+  viewpoint_y_ = viewpoint.y;
+  std::fill(bin_range2_.begin(), bin_range2_.end(), std::numeric_limits<double>::infinity());
+  target_dirty_ = true;
+}
+
+void ScanMatcher::addToTarget(const std::vector<ScanPoint>& scan, const Pose2D& pose) {
+  const double c = std::cos(pose.theta), s = std::sin(pose.theta);
+  for (const ScanPoint& p : scan) {
+    if (!std::isfinite(p.range) || p.range < options_.min_range) continue;
+    double px = p.range * std::cos(p.angle), py = p.range * std::sin(p.angle);
+    double x = pose.x + c * px - s * py, y = pose.y + s * px + c * py;
+    double dx = x - viewpoint_x_, dy = y - viewpoint_y_;
+    double range2 = dx * dx + dy * dy;
+    size_t bin = size_t(binOf(x, y));
+    if (range2 < bin_range2_[bin]) {
+      bin_x_[bin] = x;
+      bin_y_[bin] = y;
+      bin_range2_[bin] = range2;
+    }
+  }
+  target_dirty_ = true;
+}
+
+bool ScanMatcher::fitNormal(size_t i, double& nx, double& ny) const {
+  const double gap2 = options_.neighbour_gap * options_.neighbour_gap;
+  const size_t window = size_t(options_.normal_window);
+  size_t first = i > window ? i - window : 0;
+  size_t last  = std::min(filled_x_.size() - 1, i + window);
+
+  // Line through the neighbours on the same surface: the normal is the
+  // eigenvector of their scatter matrix with the smaller eigenvalue
+  double sum_x = 0, sum_y = 0;
+  int count = 0;
+  for (size_t j = first; j <= last; ++j) {
+    double dx = filled_x_[j] - filled_x_[i], dy = filled_y_[j] - filled_y_[i];
+    if (dx * dx + dy * dy > gap2) continue;
+    sum_x += dx;
+    sum_y += dy;
+    count++;
+  }
+  if (count < 3) return false;
+  double mean_x = sum_x / count, mean_y = sum_y / count;
+  double sxx = 0, sxy = 0, syy = 0;
+  for (size_t j = first; j <= last; ++j) {
+    double dx = filled_x_[j] - filled_x_[i], dy = filled_y_[j] - filled_y_[i];
+    if (dx * dx + dy * dy > gap2) continue;
+    dx -= mean_x;
+    dy -= mean_y;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+  }
+  double half_trace = (sxx + syy) / 2;
+  double spread = std::sqrt(std::max(0.0, half_trace * half_trace - (sxx * syy - sxy * sxy)));
+  double large = half_trace + spread, small = half_trace - spread;
+  if (!(large > 0) || small > options_.max_line_spread * large) return false;
+
+  double ax = sxy, ay = small - sxx;   // two forms of the eigenvector; take the
+  double bx = small - syy, by = sxy;   // better conditioned one
+  double a2 = ax * ax + ay * ay, b2 = bx * bx + by * by;
+  double norm = std::sqrt(std::max(a2, b2));
+  nx = (a2 >= b2 ? ax : bx) / norm;
+  ny = (a2 >= b2 ? ay : by) / norm;
+  return true;
+}
+
+void ScanMatcher::prepareTarget() {
+  filled_x_.clear();
+  filled_y_.clear();
+  filled_bin_.clear();
+  for (size_t bin = 0; bin < bin_range2_.size(); ++bin) {
+    if (!std::isfinite(bin_range2_[bin])) continue;
+    filled_x_.push_back(bin_x_[bin]);
+    filled_y_.push_back(bin_y_[bin]);
+    filled_bin_.push_back(uint32_t(bin));
+  }
+
+  target_x_.clear();
+  target_y_.clear();
+  target_nx_.clear();
+  target_ny_.clear();
+  target_bin_.clear();
+  for (size_t i = 0; i < filled_x_.size(); ++i) {
+    double nx, ny;
+    if (!fitNormal(i, nx, ny)) continue;
+    target_x_.push_back(filled_x_[i]);
+    target_y_.push_back(filled_y_[i]);
+    target_nx_.push_back(nx);
+    target_ny_.push_back(ny);
+    target_bin_.push_back(filled_bin_[i]);
+  }
+
+  size_t k = 0;
+  for (size_t bin = 0; bin < bin_first_.size(); ++bin) {
+    while (k < target_bin_.size() && target_bin_[k] < bin) k++;
+    bin_first_[bin] = uint32_t(k);
+  }
+  target_dirty_ = false;
+}
+
+size_t ScanMatcher::targetSize() {
+  if (target_dirty_) prepareTarget();
+  return target_x_.size();
+}
+
+size_t ScanMatcher::findCorrespondences(const Pose2D& pose) {
+  const double c = std::cos(pose.theta), s = std::sin(pose.theta);
+  const double max_distance2 = options_.max_distance * options_.max_distance;
+  const int n = int(target_x_.size()), window = options_.search_window;
+  size_t count = 0;
+
+  for (size_t i = 0; i < source_x_.size(); ++i) {
+    double px = pose.x + c * source_x_[i] - s * source_y_[i];
+    double py = pose.y + s * source_x_[i] + c * source_y_[i];
+    // The target points nearest in bearing are bin_first_ - 1 and bin_first_;
+    // try `window` either side, wrapping round the turn
+    int k = int(bin_first_[size_t(binOf(px, py))]);
+    double best = max_distance2;
+    int best_j = -1;
+    for (int d = -window; d < window; ++d) {
+      int j = k + d;
+      if (j < 0) j += n;
+      else if (j >= n) j -= n;
+      double dx = target_x_[size_t(j)] - px, dy = target_y_[size_t(j)] - py;
+      double distance2 = dx * dx + dy * dy;
+      if (distance2 < best) {
+        best = distance2;
+        best_j = j;
+      }
+    }
+    if (best_j < 0) continue;
+    match_sx_[count] = source_x_[i];
+    match_sy_[count] = source_y_[i];
+    match_qx_[count] = target_x_[size_t(best_j)];
+    match_qy_[count] = target_y_[size_t(best_j)];
+    match_nx_[count] = target_nx_[size_t(best_j)];
+    match_ny_[count] = target_ny_[size_t(best_j)];
+    count++;
+  }
+  return count;
+}
+
+ScanMatcher::Result ScanMatcher::match(const std::vector<ScanPoint>& scan, const Pose2D& guess) {
+  if (target_dirty_) prepareTarget();
+  Result result;
+  result.pose = guess;
+  // The bearing search wraps once, so the target must outnumber its window
+  if (target_x_.size() < std::max(options_.min_correspondences, size_t(2 * options_.search_window))) {
+    return result;
+  }
+
+  source_x_.clear();
+  source_y_.clear();
+  for (const ScanPoint& p : scan) {
+    if (!std::isfinite(p.range) || p.range < options_.min_range) continue;
+    source_x_.push_back(p.range * std::cos(p.angle));
+    source_y_.push_back(p.range * std::sin(p.angle));
+  }
+  for (auto* buffer : {&match_sx_, &match_sy_, &match_qx_, &match_qy_, &match_nx_, &match_ny_}) {
+    buffer->resize(source_x_.size());
+  }
+
+  Pose2D pose = guess;
+  for (int iteration = 1; iteration <= options_.max_iterations; ++iteration) {
+    result.correspondences = findCorrespondences(pose);
+    if (result.correspondences < options_.min_correspondences) break;
+
+    Correspondences m = {match_sx_.data(), match_sy_.data(), match_qx_.data(),
+                         match_qy_.data(), match_nx_.data(), match_ny_.data(), result.correspondences};
+    NormalEquations e = accumulate(m, std::cos(pose.theta), std::sin(pose.theta), pose.x, pose.y);
+    result.iterations = iteration;
+    result.rms = std::sqrt(e.rr / double(m.size));
+
+    double dx, dy, dtheta;
+    if (!solveStep(e, options_.min_constraint, dx, dy, dtheta)) break;
+    pose.x += dx;
+    pose.y += dy;
+    pose.theta = std::remainder(pose.theta + dtheta, 2 * PI);
+    result.pose = pose;
+    if (std::sqrt(dx * dx + dy * dy) < options_.converged_translation &&
+        std::fabs(dtheta) < options_.converged_rotation) {
+      result.converged = true;
+      break;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,102 @@
+// src/scan_matcher.hpp
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pose2d.hpp"
+#include "scan_assembler.hpp"
+
+/// Point-to-line ICP between ScanPoint revolutions, scan to scan or scan to
+/// submap.
+///
+/// The target is kept as a virtual scan seen from a viewpoint: its points are
+/// binned by bearing, the nearest one per bin, and stored in bearing order.
+/// Neighbours in that order lie on the same surface, so a line fit over a few
+/// of them gives each target point its normal, and a source point finds its
+/// correspondence by looking up its bearing and trying a few target points on
+/// either side. No k-d tree is built.
+///
+/// Each iteration takes one Gauss-Newton step on the residuals n·(R s + t - q).
+/// The normal equations are accumulated with AVX2 when the CPU has it, and
+/// with NEON on AArch64.
+/// Matching stops as soon as a step falls below the convergence thresholds.
+/// Every buffer is a member that is cleared and refilled, so once they have
+/// grown to the largest scan, matching does not allocate.
+class ScanMatcher {
+public:
+  struct Options {
+    int    max_iterations        = 30;
+    double max_distance          = 0.5;    // m; farther correspondences are dropped
+    double converged_translation = 1e-4;   // m; a smaller step ends the match...
+    double converged_rotation    = 1e-4;   // rad; ...if it also turns less than this
+    int    bearing_bins          = 3600;   // target bins per turn (0.1°)
+    int    search_window         = 3;      // target points tried either side of a bearing
+    int    normal_window         = 2;      // neighbours either side in the line fit
+    double neighbour_gap         = 0.3;    // m; farther neighbours belong to another surface
+    double max_line_spread       = 0.05;   // eigenvalue ratio above which a fit is not a line
+    double min_constraint        = 0.05;   // weakest translation direction's share of the normals; less is degenerate
+    double min_range             = 0.1;    // m; shorter returns are ignored
+    size_t min_correspondences   = 20;
+  };
+
+  struct Result {
+    Pose2D pose;                   // source pose in the map frame
+    int    iterations = 0;         // Gauss-Newton steps taken
+    size_t correspondences = 0;    // in the last step
+    double rms = 0;                // point-to-line residual of the last step, m
+    bool   converged = false;      // false: out of iterations, too few correspondences or degenerate geometry
+  };
+
+  ScanMatcher() : ScanMatcher(Options()) {}
+  /// Throws std::invalid_argument for non-positive windows, bins or distances.
+  explicit ScanMatcher(const Options& options);
+
+  /// Make `scan`, taken at `pose`, the whole target. With the default pose,
+  /// match() returns the source pose relative to this scan.
+  void setTarget(const std::vector<ScanPoint>& scan, const Pose2D& pose = Pose2D());
+
+  /// Start an empty submap seen from `viewpoint`, usually the newest pose.
+  /// Only its position is used.
+  void clearTarget(const Pose2D& viewpoint);
+  /// Add a scan taken at `pose` to the submap. Of the points falling in one
+  /// bearing bin, the one nearest the viewpoint is kept.
+  void addToTarget(const std::vector<ScanPoint>& scan, const Pose2D& pose);
+
+  /// Align `scan` with the target, starting from `guess`, its pose in the map frame.
+  Result match(const std::vector<ScanPoint>& scan, const Pose2D& guess);
+
+  /// Target points with a usable normal; prepares the target if it changed.
+  size_t targetSize();
+
+  const Options& options() const { return options_; }
+
+private:
+  Options options_;
+  double  bins_per_radian_;
+
+  // Submap being collected: the nearest point per bearing bin
+  double viewpoint_x_ = 0, viewpoint_y_ = 0;
+  std::vector<double> bin_x_, bin_y_, bin_range2_;
+  bool target_dirty_ = false;
+
+  // Prepared target, in bearing order: points with a normal, their bins, and
+  // for every bin the index of the first point at or after it
+  std::vector<double>   target_x_, target_y_, target_nx_, target_ny_;
+  std::vector<uint32_t> target_bin_, bin_first_;
+  std::vector<double>   filled_x_, filled_y_;
+  std::vector<uint32_t> filled_bin_;
+
+  // Source scan in its sensor frame
+  std::vector<double> source_x_, source_y_;
+
+  // One step's correspondences: source point, target point, target normal;
+  // sized to the source
+  std::vector<double> match_sx_, match_sy_, match_qx_, match_qy_, match_nx_, match_ny_;
+
+  int  binOf(double x, double y) const;
+  void prepareTarget();
+  bool fitNormal(size_t i, double& nx, double& ny) const;
+  /// Fill the match_ buffers for the source at `pose`; returns how many.
+  size_t findCorrespondences(const Pose2D& pose);
+};
@@ -0,0 +1,112 @@
+// scan_publisher.cpp -- receive one sensor and publish its revolutions to a shared-memory ring
+
+#include "lidar_reader.hpp"
+#include "scan_shm.hpp"
+
+#include <csignal>
+#include <signal.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <grp.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void onSignal(int) { g_stop = 1; }
+
+static int usage(const char* prog) {
+  std::cerr << "Usage:\n"
+            << "  " << prog << " [access] <udp_port> [ring_name] [batch_size] [slots]\n"
+            << "  " << prog << " [access] --replay <file.pcap> [speed] [ring_name]\n"
+            << "\n"
+            << "access:\n"
+            << "  --group NAME   give the ring to this group, so its members can attach\n"
+            << "  --mode OCTAL   permissions of the ring (default 0660)\n"
+            << "\n"
+            << "Readers attach with ScanSubscriber, e.g. main_app --shm [ring_name]. They need\n"
+            << "read and write access to the ring.\n"
+            << "ring_name defaults to " << DEFAULT_SCAN_RING << " (/dev/shm" << DEFAULT_SCAN_RING << ").\n";
+  return 1;
+}
+
+static int run(LiDARReader& reader, ScanPublisher& publisher) {
+  // No SA_RESTART: a waiting receive returns Interrupted, so Ctrl+C closes the
+  // ring and wakes its readers instead of leaving them waiting
+  struct sigaction sa{};
+  sa.sa_handler = onSignal;
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+  std::printf("Publishing revolutions to %s (Ctrl+C to stop)\n", publisher.name().c_str());
+
+  std::vector<ScanPoint> scan;
+  while (!g_stop) {
+    auto status = reader.readScan(scan, LiDARReader::Clock::now() + std::chrono::seconds(1));
+    if (status == LiDARReader::ReadStatus::Timeout || status == LiDARReader::ReadStatus::Interrupted) {
+      continue;
+    }
+    if (status == LiDARReader::ReadStatus::EndOfCapture) break;
+    if (status != LiDARReader::ReadStatus::Ok) {
+      std::cerr << "Receive failed: " << LiDARReader::statusName(status) << "\n";
+      return 1;
+    }
+    uint64_t number = publisher.publish(scan, reader);
+    if (number % 50 == 0) {
+      std::printf("%llu revolutions published, last %zu points\n", (unsigned long long)number, scan.size());
+      std::fflush(stdout);
+    }
+  }
+  std::printf("Last revolution published: %llu\n", (unsigned long long)publisher.published());
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const char* prog = argv[0];
+  mode_t mode = ScanPublisher::DEFAULT_MODE;
+  gid_t group = gid_t(-1);
+  while (argc >= 3 && (std::strcmp(argv[1], "--group") == 0 || std::strcmp(argv[1], "--mode") == 0)) {
+    if (std::strcmp(argv[1], "--group") == 0) {
+      struct group* entry = getgrnam(argv[2]);
+      if (!entry) {
+        std::cerr << "Unknown group: " << argv[2] << "\n";
+        return 1;
+      }
+      group = entry->gr_gid;
+    } else {
+      char* end = nullptr;
+      unsigned long value = std::strtoul(argv[2], &end, 8);
+      if (*argv[2] == '\0' || *end != '\0' || value > 0777) return usage(prog);
+      mode = mode_t(value);
+    }
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc < 2) return usage(prog);
+  std::string first = argv[1];
+
+  try {
+    if (first == "--replay") {
+      if (argc < 3) return usage(prog);
+      std::unique_ptr<PcapReplay> source(new PcapReplay(argv[2]));
+      source->setSpeed(argc >= 4 ? std::atof(argv[3]) : 1.0);
+      LiDARReader reader(std::move(source));
+      ScanPublisher publisher(argc >= 5 ? argv[4] : DEFAULT_SCAN_RING, ScanPublisher::DEFAULT_SLOTS,
+                              ScanAssembler::DEFAULT_MAX_POINTS, mode, group);
+      return run(reader, publisher);
+    }
+
+    int port = std::atoi(argv[1]);
+    if (port <= 0) return usage(prog);
+    LiDARReader reader("", port);
+    reader.setBatchSize(argc >= 4 ? std::atoi(argv[3]) : 16);
+    ScanPublisher publisher(argc >= 3 ? argv[2] : DEFAULT_SCAN_RING,
+                            argc >= 5 ? uint32_t(std::atoi(argv[4])) : ScanPublisher::DEFAULT_SLOTS,
+                            ScanAssembler::DEFAULT_MAX_POINTS, mode, group);
+    return run(reader, publisher);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+}
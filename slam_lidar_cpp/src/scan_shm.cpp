@@ -0,0 +1,338 @@
+// scan_shm.cpp
+
+#include "scan_shm.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+static constexpr uint64_t RING_MAGIC   = 0x4c44525343414e31ULL;  // "LDRSCAN1"
+static constexpr uint32_t RING_VERSION = 1;
+
+static_assert(std::is_trivially_copyable<ScanInfo>::value, "ScanInfo is copied with memcpy");
+static_assert(std::is_trivially_copyable<ScanPoint>::value, "ScanPoint is copied with memcpy");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && ATOMIC_INT_LOCK_FREE == 2,
+              "the futex word must be a plain lock-free 32-bit integer");
+
+static std::runtime_error sysError(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/// Give a ring its group and mode. fchmod() is not subject to the umask,
+/// which would otherwise strip the group's write bit.
+static void setAccess(int fd, const std::string& name, mode_t mode, gid_t group) {
+  if (group != gid_t(-1) && fchown(fd, uid_t(-1), group) < 0) {
+    throw sysError("fchown " + name + " to group " + std::to_string(group));
+  }
+  if (fchmod(fd, mode) < 0) throw sysError("fchmod " + name);
+}
+
+/// shm_open() wants one leading slash.
+static std::string shmName(const std::string& name) {
+  return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+/// The header gets whole pages, so the slots can be mapped separately.
+static size_t headerBytes() {
+  size_t page = size_t(sysconf(_SC_PAGESIZE));
+  return (sizeof(ScanRingHeader) + page - 1) / page * page;
+}
+
+static uint64_t slotBytes(uint32_t max_points) {
+  return (sizeof(ScanRingSlot) + uint64_t(max_points) * sizeof(ScanPoint) + 63) / 64 * 64;
+}
+
+/// Shared (not private) futex ops: the word is in memory mapped by several processes.
+static long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+static bool sameLayout(const ScanRingHeader& header, uint32_t slots, uint32_t max_points) {
+  return header.magic == RING_MAGIC && header.version == RING_VERSION &&
+         header.slot_count == slots && header.max_points == max_points &&
+         header.point_size == sizeof(ScanPoint) && header.slot_bytes == slotBytes(max_points);
+}
+
+// ---------------------------------------------------------------------------
+// ScanPublisher
+
+ScanPublisher::ScanPublisher(const std::string& name, uint32_t slots, uint32_t max_points,
+                             mode_t mode, gid_t group)
+  : name_(shmName(name))
+{
+  if (slots < 2) throw std::invalid_argument("a scan ring needs at least 2 slots");
+  if (max_points == 0) throw std::invalid_argument("scan slots need room for points");
+  map_size_ = headerBytes() + slots * slotBytes(max_points);
+
+  // A ring left by an earlier publisher with the same layout is taken over, so
+  // its readers carry on; anything else is unlinked and replaced
+  int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT, mode);
+  if (fd < 0) throw sysError("shm_open " + name_);
+  void* m = MAP_FAILED;
+  bool reuse = false;
+  struct stat st{};
+  if (fstat(fd, &st) == 0 && size_t(st.st_size) == map_size_) {
+    m = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    reuse = m != MAP_FAILED && sameLayout(*static_cast<ScanRingHeader*>(m), slots, max_points);
+    if (!reuse && m != MAP_FAILED) munmap(m, map_size_);
+  }
+  try {
+    if (reuse) {
+      if (st.st_uid == geteuid()) setAccess(fd, name_, mode, group);
+    } else {
+      close(fd);
+      shm_unlink(name_.c_str());
+      fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+      if (fd < 0) throw sysError("shm_open " + name_);
+      setAccess(fd, name_, mode, group);
+      if (ftruncate(fd, off_t(map_size_)) < 0) throw sysError("ftruncate " + name_);
+      m = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+  } catch (...) {
+    if (reuse) munmap(m, map_size_);
+    if (fd >= 0) close(fd);
+    throw;
+  }
+  close(fd);
+  if (m == MAP_FAILED) throw sysError("mmap " + name_);
+  header_ = static_cast<ScanRingHeader*>(m);
+  slots_  = static_cast<uint8_t*>(m) + headerBytes();
+
+  if (reuse) {
+    published_ = header_->latest.load(std::memory_order_relaxed);
+    // A publisher that died mid-write left that slot odd; it is rewritten
+    // before it becomes the newest again
+    for (uint32_t i = 0; i < slots; ++i) {
+      auto* s = reinterpret_cast<ScanRingSlot*>(slots_ + i * header_->slot_bytes);
+      uint64_t sequence = s->sequence.load(std::memory_order_relaxed);
+      if (sequence & 1) s->sequence.store(sequence + 1, std::memory_order_relaxed);
+    }
+  } else {
+    // Fresh zero-filled pages
+    for (uint32_t i = 0; i < slots; ++i) {
+      new (slots_ + i * slotBytes(max_points)) ScanRingSlot{};
+    }
+    header_->version    = RING_VERSION;
+    header_->slot_count = slots;
+    header_->max_points = max_points;
+    header_->point_size = sizeof(ScanPoint);
+    header_->slot_bytes = slotBytes(max_points);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = RING_MAGIC;   // Last: readers check it first
+  }
+  header_->closed.store(0, std::memory_order_release);
+}
+
+ScanPublisher::~ScanPublisher() {
+  if (!header_) return;
+  header_->closed.store(1, std::memory_order_release);
+  header_->futex.fetch_add(1);
+  futex(&header_->futex, FUTEX_WAKE, INT_MAX, nullptr);
+  munmap(header_, map_size_);
+}
+
+ScanRingSlot* ScanPublisher::slot(uint64_t number) const {
+  return reinterpret_cast<ScanRingSlot*>(slots_ + (number % header_->slot_count) * header_->slot_bytes);
+}
+
+uint64_t ScanPublisher::publish(const std::vector<ScanPoint>& scan, ScanInfo info) {
+  uint64_t number = ++published_;
+  size_t points = std::min(scan.size(), size_t(header_->max_points));
+  info.number       = number;
+  info.published_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+  info.size         = uint32_t(points);
+  info.dropped      = uint32_t(scan.size() - points);
+
+  // Seqlock write: odd, fence, data, even (release)
+  ScanRingSlot* s = slot(number);
+  uint64_t sequence = s->sequence.load(std::memory_order_relaxed);
+  s->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&s->info, &info, sizeof(info));
+  std::memcpy(reinterpret_cast<uint8_t*>(s) + sizeof(ScanRingSlot), scan.data(), points * sizeof(ScanPoint));
+  s->sequence.store(sequence + 2, std::memory_order_release);
+  header_->latest.store(number, std::memory_order_release);
+
+  // A reader that counted itself a waiter after this bump sees the new futex
+  // value and does not sleep, so skipping the wake is safe
+  header_->futex.fetch_add(1);
+  if (header_->waiters.load() > 0) futex(&header_->futex, FUTEX_WAKE, INT_MAX, nullptr);
+  return number;
+}
+
+uint64_t ScanPublisher::publish(const std::vector<ScanPoint>& scan, const LiDARReader& reader) {
+  ScanInfo info;
+  info.coverage   = reader.lastCoverage();
+  info.continuity = reader.continuity();
+  info.receive    = reader.receiveCounters();
+  return publish(scan, info);
+}
+
+// ---------------------------------------------------------------------------
+// ScanSubscriber
+
+const char* ScanSubscriber::statusName(ReadStatus status) {
+  switch (status) {
+    case ReadStatus::Ok:      return "ok";
+    case ReadStatus::Timeout: return "timeout";
+    case ReadStatus::Closed:  return "closed";
+  }
+  return "unknown";
+}
+
+ScanSubscriber::ScanSubscriber(const std::string& name) {
+  std::string path = shmName(name);
+  int fd = shm_open(path.c_str(), O_RDWR, 0);
+  if (fd < 0 && errno == EACCES) {
+    throw std::runtime_error(path + ": permission denied; readers need read and write access, so run as "
+                             "the publisher's user or in the group it gave the ring (scan_publisher --group)");
+  }
+  if (fd < 0) throw sysError("shm_open " + path);
+  struct stat st{};
+  if (fstat(fd, &st) < 0 || size_t(st.st_size) < headerBytes()) {
+    close(fd);
+    throw std::runtime_error(path + ": not a scan ring");
+  }
+
+  void* m = mmap(nullptr, headerBytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED) {
+    close(fd);
+    throw sysError("mmap " + path);
+  }
+  header_ = static_cast<ScanRingHeader*>(m);
+  auto reject = [&](const std::string& why) {
+    close(fd);
+    munmap(header_, headerBytes());
+    header_ = nullptr;
+    return std::runtime_error(path + ": " + why);
+  };
+  if (header_->magic != RING_MAGIC) throw reject("not a scan ring, or its publisher is still creating it");
+  std::atomic_thread_fence(std::memory_order_acquire);
+  slot_count_ = header_->slot_count;
+  max_points_ = header_->max_points;
+  slot_bytes_ = header_->slot_bytes;
+  slots_size_ = slot_count_ * slot_bytes_;
+  if (!sameLayout(*header_, slot_count_, max_points_) ||
+      size_t(st.st_size) != headerBytes() + slots_size_) {
+    throw reject("scan ring from an incompatible build");
+  }
+
+  m = mmap(nullptr, slots_size_, PROT_READ, MAP_SHARED, fd, off_t(headerBytes()));
+  if (m == MAP_FAILED) throw reject(std::string("mmap: ") + std::strerror(errno));
+  close(fd);
+  slots_ = static_cast<const uint8_t*>(m);
+}
+
+ScanSubscriber::~ScanSubscriber() {
+  if (slots_) munmap(const_cast<uint8_t*>(slots_), slots_size_);
+  if (header_) munmap(header_, headerBytes());
+}
+
+const ScanRingSlot* ScanSubscriber::slot(uint64_t number) const {
+  return reinterpret_cast<const ScanRingSlot*>(slots_ + (number % slot_count_) * slot_bytes_);
+}
+
+bool ScanSubscriber::latest(ScanView& view) const {
+  while (true) {
+    uint64_t number = header_->latest.load(std::memory_order_acquire);
+    if (number == 0) return false;
+    const ScanRingSlot* s = slot(number);
+    uint64_t sequence = s->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) continue;   // Lapped while we looked: there is a newer one
+    ScanInfo info;
+    std::memcpy(&info, &s->info, sizeof(info));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s->sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+    view.points   = reinterpret_cast<const ScanPoint*>(reinterpret_cast<const uint8_t*>(s) + sizeof(ScanRingSlot));
+    view.info     = info;
+    view.info.size = std::min(info.size, max_points_);
+    view.slot     = s;
+    view.sequence = sequence;
+    return true;
+  }
+}
+
+bool ScanSubscriber::stillValid(const ScanView& view) const {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return view.slot && view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+bool ScanSubscriber::copyLatest(std::vector<ScanPoint>& scan) {
+  while (true) {
+    uint64_t number = header_->latest.load(std::memory_order_acquire);
+    if (number <= last_info_.number) return false;
+    const ScanRingSlot* s = slot(number);
+    uint64_t sequence = s->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      retries_++;
+      continue;
+    }
+
+    // Seqlock read: copy, then keep the copy only if the sequence did not move
+    ScanInfo info;
+    std::memcpy(&info, &s->info, sizeof(info));
+    size_t points = std::min(info.size, max_points_);
+    scan.resize(points);
+    std::memcpy(scan.data(), reinterpret_cast<const uint8_t*>(s) + sizeof(ScanRingSlot),
+                points * sizeof(ScanPoint));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s->sequence.load(std::memory_order_relaxed) != sequence) {
+      retries_++;
+      continue;
+    }
+
+    if (last_info_.number > 0 && info.number > last_info_.number + 1) {
+      skipped_ += info.number - last_info_.number - 1;
+    }
+    info.size  = uint32_t(points);
+    last_info_ = info;
+    return true;
+  }
+}
+
+void ScanSubscriber::wait(uint32_t seen, Clock::time_point deadline) {
+  timespec timeout{};
+  const timespec* timeout_ptr = nullptr;
+  if (deadline != Clock::time_point::max()) {
+    auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()).count();
+    if (remaining <= 0) return;
+    timeout.tv_sec  = time_t(remaining / 1000000000);
+    timeout.tv_nsec = long(remaining % 1000000000);
+    timeout_ptr = &timeout;
+  }
+  header_->waiters.fetch_add(1);
+  futex(&header_->futex, FUTEX_WAIT, seen, timeout_ptr);   // EAGAIN if it already moved on
+  header_->waiters.fetch_sub(1);
+}
+
+ScanSubscriber::ReadStatus ScanSubscriber::readScan(std::vector<ScanPoint>& scan,
+                                                    Clock::time_point deadline) {
+  while (true) {
+    // Sampled before looking, so a publish in between makes the wait return at once
+    uint32_t seen = header_->futex.load(std::memory_order_acquire);
+    if (copyLatest(scan)) return ReadStatus::Ok;
+    if (header_->closed.load(std::memory_order_acquire)) return ReadStatus::Closed;
+    if (Clock::now() >= deadline) return ReadStatus::Timeout;
+    wait(seen, deadline);
+  }
+}
+
+std::vector<ScanPoint> ScanSubscriber::readScan() {
+  std::vector<ScanPoint> scan;
+  if (readScan(scan, Clock::time_point::max()) == ReadStatus::Closed) {
+    throw std::runtime_error("scan publisher closed the ring");
+  }
+  return scan;
+}
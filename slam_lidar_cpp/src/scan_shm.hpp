@@ -0,0 +1,183 @@
+// src/scan_shm.hpp
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "lidar_reader.hpp"
+
+/// Name of the shared-memory object when none is given.
+static constexpr const char* DEFAULT_SCAN_RING = "/lidar_scans";
+
+/// What came with one published revolution, besides its points.
+struct ScanInfo {
+  uint64_t number       = 0;  // 1 for the first revolution published to the ring
+  int64_t  published_ns = 0;  // steady_clock (CLOCK_MONOTONIC) when published
+  uint32_t size         = 0;  // points in the slot
+  uint32_t dropped      = 0;  // points cut off because the slot was full
+  RevolutionCoverage coverage;              // of this revolution
+  ContinuityStats continuity;               // publisher's totals so far
+  LiDARReader::ReceiveCounters receive;     // publisher's totals so far
+};
+
+/// Start of the shared-memory object, on its own page: the only part readers
+/// write to (the futex waiter count).
+struct ScanRingHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t max_points;
+  uint32_t point_size;        // sizeof(ScanPoint) of the publisher's build
+  uint64_t slot_bytes;        // ScanRingSlot plus max_points points, cache-line padded
+  alignas(64) std::atomic<uint64_t> latest;   // number of the newest complete revolution, 0 = none
+  std::atomic<uint32_t> closed;               // set when the publisher shuts down
+  alignas(64) std::atomic<uint32_t> futex;    // bumped on every publish, waited on by readers
+  std::atomic<uint32_t> waiters;              // readers asleep on futex
+};
+
+/// One revolution; max_points ScanPoints follow it. sequence is the slot's
+/// seqlock: odd while the publisher writes, +2 per publish.
+struct ScanRingSlot {
+  alignas(64) std::atomic<uint64_t> sequence;
+  ScanInfo info;
+};
+
+/// Publishes completed revolutions into a POSIX shared-memory ring, so any
+/// number of processes can read the scans of one receiving process.
+///
+/// Slots are filled round robin and each is guarded by a seqlock; the
+/// publisher never waits for readers and cannot be slowed down by them.
+/// Waiting readers sleep on a futex in the header, which the publisher wakes
+/// only while someone is waiting.
+class ScanPublisher {
+public:
+  static constexpr uint32_t DEFAULT_SLOTS = 8;
+  /// Readers write the waiter count in the header, so they need write access:
+  /// by default the publisher's user and group can attach.
+  static constexpr mode_t DEFAULT_MODE = 0660;
+
+  /// Create the shared-memory object `name`. A ring left by an earlier
+  /// publisher with the same layout is taken over, numbering and readers
+  /// included; any other object of that name is replaced. The object gets
+  /// `mode` regardless of the umask, and `group` unless that is gid_t(-1), so
+  /// readers running as another user can be let in through a shared group; a
+  /// ring taken over is updated only if this user owns it. Throws
+  /// std::runtime_error if it cannot be created, mapped or given the group.
+  explicit ScanPublisher(const std::string& name = DEFAULT_SCAN_RING,
+                         uint32_t slots = DEFAULT_SLOTS,
+                         uint32_t max_points = ScanAssembler::DEFAULT_MAX_POINTS,
+                         mode_t mode = DEFAULT_MODE,
+                         gid_t group = gid_t(-1));
+  /// Marks the ring closed and wakes waiting readers. The object stays in
+  /// /dev/shm for the next publisher.
+  ~ScanPublisher();
+
+  ScanPublisher(const ScanPublisher&) = delete;
+  ScanPublisher& operator=(const ScanPublisher&) = delete;
+
+  /// Copy a revolution into the next slot and make it the newest. `info`
+  /// supplies coverage and counters; number, time and size are filled in.
+  /// Returns the revolution's number.
+  uint64_t publish(const std::vector<ScanPoint>& scan, ScanInfo info = ScanInfo());
+
+  /// publish() with the reader's coverage and counters.
+  uint64_t publish(const std::vector<ScanPoint>& scan, const LiDARReader& reader);
+
+  /// Number of the last revolution published; carries on from a ring taken over.
+  uint64_t published() const { return published_; }
+  const std::string& name() const { return name_; }
+
+private:
+  std::string     name_;
+  ScanRingHeader* header_ = nullptr;
+  uint8_t*        slots_  = nullptr;
+  size_t          map_size_ = 0;
+  uint64_t        published_ = 0;
+
+  ScanRingSlot* slot(uint64_t number) const;
+};
+
+/// Reads the newest revolution from a ScanPublisher's ring.
+///
+/// Reading takes no lock and no syscall; only waiting for a revolution that
+/// has not been published yet sleeps in the kernel. Scan slots are mapped
+/// read-only.
+class ScanSubscriber {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class ReadStatus {
+    Ok,
+    Timeout,   // nothing newer was published before the deadline
+    Closed,    // the publisher has shut down and nothing newer is left; a restarted one reopens it
+  };
+  static const char* statusName(ReadStatus status);
+
+  /// A published revolution, read in place.
+  struct ScanView {
+    const ScanPoint* points = nullptr;
+    ScanInfo info;
+    const ScanRingSlot* slot = nullptr;
+    uint64_t sequence = 0;
+  };
+
+  /// Map the ring `name`. Throws std::runtime_error if it does not exist,
+  /// was created by a build with a different layout, or this process may not
+  /// both read and write it (see ScanPublisher::DEFAULT_MODE).
+  explicit ScanSubscriber(const std::string& name = DEFAULT_SCAN_RING);
+  ~ScanSubscriber();
+
+  ScanSubscriber(const ScanSubscriber&) = delete;
+  ScanSubscriber& operator=(const ScanSubscriber&) = delete;
+
+  /// Newest revolution without copying its points. False if none has been
+  /// published yet. The points stay intact until the publisher comes round to
+  /// the slot again, slotCount() - 1 revolutions later; call stillValid()
+  /// after using them.
+  bool latest(ScanView& view) const;
+
+  /// True if the publisher has not started overwriting the view's slot.
+  bool stillValid(const ScanView& view) const;
+
+  /// Copy the newest revolution newer than the last one returned, waiting
+  /// for the publisher until `deadline`. Revolutions published in between are
+  /// skipped and counted.
+  ReadStatus readScan(std::vector<ScanPoint>& scan, Clock::time_point deadline);
+
+  /// Blocks until a newer revolution is published and returns a copy, like
+  /// LiDARReader::readScan(). Throws std::runtime_error once the publisher
+  /// has closed the ring.
+  std::vector<ScanPoint> readScan();
+
+  /// Info of the revolution last returned by readScan().
+  const ScanInfo& lastInfo() const { return last_info_; }
+
+  /// Revolutions published but never returned, because a newer one was there.
+  uint64_t skipped() const { return skipped_; }
+  /// Copies thrown away because the publisher overwrote the slot meanwhile.
+  uint64_t retries() const { return retries_; }
+
+  uint32_t slotCount() const { return slot_count_; }
+  uint32_t maxPoints() const { return max_points_; }
+
+private:
+  ScanRingHeader* header_ = nullptr;      // read-write: the waiter count
+  const uint8_t*  slots_  = nullptr;      // read-only
+  size_t          slots_size_ = 0;
+  uint32_t        slot_count_ = 0;
+  uint32_t        max_points_ = 0;
+  uint64_t        slot_bytes_ = 0;
+  ScanInfo        last_info_;
+  uint64_t        skipped_ = 0;
+  uint64_t        retries_ = 0;
+
+  const ScanRingSlot* slot(uint64_t number) const;
+  /// Copy the newest revolution if it is newer than the last one returned.
+  bool copyLatest(std::vector<ScanPoint>& scan);
+  /// Sleep until the publisher bumps the futex word from `seen` or `deadline`.
+  void wait(uint32_t seen, Clock::time_point deadline);
+};
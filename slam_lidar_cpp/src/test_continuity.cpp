@@ -0,0 +1,243 @@
+// src/test_continuity.cpp
+//
+// ContinuityTracker on synthetic streams: drops, duplicates, swapped packets
+// and an outage of whole revolutions must be counted exactly, across the
+// sensor's 32-bit timestamp wrap and every revolution's azimuth wrap, and late
+// packets must stay missing from the coverage. Then the same impairments
+// through LiDARReader: duplicated and late packets must not reach the
+// revolutions.
+
+#include "continuity_tracker.h"
+#include "lidar_reader.hpp"
+#include "test_util.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+using Packet = std::vector<uint8_t>;
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = uint8_t(v >> 8);
+  p[1] = uint8_t(v & 0xFF);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  put16(p, uint16_t(v >> 16));
+  put16(p + 2, uint16_t(v & 0xFFFF));
+}
+
+struct StreamConfig {
+  const char* name;
+  double resolution;  // degrees between points
+  double fov;         // degrees, centred on 180
+};
+
+/// The msop_emulator sensor model: blocks advance 16 points of azimuth,
+/// blocks outside the field of view are not sent but their time passes, and
+/// the last packet of a revolution is padded with invalid blocks.
+/// Timestamps wrap 2 s into the stream.
+static std::vector<Packet> makeStream(const StreamConfig& config, int count, int& packets_per_rev) {
+  const int block_step = int(std::lround(config.resolution * 100 * MSOPPacketView::MEASUREMENTS_PER_BLOCK));
+  const int fov_start  = int(std::lround((180.0 - config.fov / 2) * 100));
+  const int fov_end    = int(std::lround((180.0 + config.fov / 2) * 100));
+  const double us_per_block = 1e5 * block_step / 36000.0;  // 10 Hz
+  double time_us = 0xFFFFFFFFu - 2e6;
+  auto inView = [&](int az) { return az >= fov_start && az < fov_end; };
+
+  int blocks_per_rev = 0;
+  for (int az = 0; az < 36000; az += block_step) blocks_per_rev += inView(az);
+  packets_per_rev = (blocks_per_rev + MSOPPacketView::BLOCK_COUNT - 1) / MSOPPacketView::BLOCK_COUNT;
+
+  int azimuth = 0;
+  auto advance = [&]() {
+    azimuth += block_step;
+    time_us += us_per_block;
+    if (azimuth >= 36000) azimuth = 0;
+  };
+  while (!inView(azimuth)) advance();
+
+  std::vector<Packet> packets(count, Packet(MSOPPacketView::PACKET_SIZE, 0));
+  for (Packet& packet : packets) {
+    put32(&packet[MSOPPacketView::TIMESTAMP_OFFSET], uint32_t(uint64_t(time_us)));
+    bool done = false;
+    for (int b = 0; b < MSOPPacketView::BLOCK_COUNT; ++b) {
+      uint8_t* block = &packet[b * MSOPPacketView::BLOCK_SIZE];
+      if (done) {
+        put16(block, MSOPPacketView::INVALID_BLOCK_FLAG);
+        put16(block + 2, 0xFFFF);
+        continue;
+      }
+      put16(block, MSOPPacketView::VALID_BLOCK_FLAG);
+      put16(block + 2, uint16_t(azimuth));
+      for (int i = 0; i < MSOPPacketView::MEASUREMENTS_PER_BLOCK; ++i) {
+        put16(block + 4 + i * 6, uint16_t(1000 + azimuth % 997));
+        block[4 + i * 6 + 2] = 50;
+      }
+      advance();
+      done = azimuth == 0 || !inView(azimuth);
+    }
+    if (done) {
+      while (!inView(azimuth)) advance();
+    }
+  }
+  return packets;
+}
+
+struct Impaired {
+  std::vector<int> order;     // packet indices in arrival order
+  std::vector<int> accepted;  // the same without repeats and late packets
+  uint64_t dropped = 0, duplicated = 0, reordered = 0;
+};
+
+/// Impair everything after a clean warm-up of 20 revolutions. Impairments
+/// never touch neighbouring packets, so each is visible on its own.
+static Impaired impair(int count, int packets_per_rev, bool outage) {
+  Impaired out;
+  std::srand(17);
+  const int warmup = 20 * packets_per_rev;
+  const int outage_start = count / 2;
+  for (int p = 0; p < count; ++p) {
+    if (p < warmup || p + 2 >= count) {
+      out.order.push_back(p);
+      out.accepted.push_back(p);
+      continue;
+    }
+    // Three whole revolutions plus a bit either side, with clean packets around
+    if (outage && p >= outage_start && p < outage_start + 3 * packets_per_rev + 3) {
+      out.dropped++;
+      continue;
+    }
+    if (outage && p >= outage_start - 20 && p < outage_start + 4 * packets_per_rev) {
+      out.order.push_back(p);
+      out.accepted.push_back(p);
+      continue;
+    }
+    int roll = std::rand() % 100;
+    if (roll < 3) {
+      out.dropped++;
+      ++p;  // keep the neighbour unimpaired
+      out.order.push_back(p);
+      out.accepted.push_back(p);
+    } else if (roll < 5) {
+      // Swap with the next packet: p arrives after p + 1 and is late
+      out.order.insert(out.order.end(), {p + 1, p, p + 2});
+      out.accepted.insert(out.accepted.end(), {p + 1, p + 2});
+      out.reordered++;
+      p += 2;
+    } else if (roll < 7) {
+      out.order.insert(out.order.end(), {p, p});
+      out.accepted.push_back(p);
+      out.duplicated++;
+    } else {
+      out.order.push_back(p);
+      out.accepted.push_back(p);
+    }
+  }
+  return out;
+}
+
+static void checkTracker(const StreamConfig& config) {
+  std::printf("%s:\n", config.name);
+  int packets_per_rev = 0;
+  const int count = 6000;
+  std::vector<Packet> packets = makeStream(config, count, packets_per_rev);
+  Impaired impaired = impair(count, packets_per_rev, true);
+
+  ContinuityTracker tracker;
+  int bad_coverage = 0;
+  uint64_t covered = 0;  // packets received into closed revolutions
+  const int warmup = 20 * packets_per_rev;
+  for (int p : impaired.order) {
+    tracker.addPacket(MSOPPacketView(packets[p].data()));
+    if (!tracker.revolutionClosed()) continue;
+    const RevolutionCoverage& last = tracker.getLastRevolution();
+    covered += last.received;
+    if (p > warmup && (last.received + last.missing != uint32_t(packets_per_rev) ||
+                       last.expected != uint32_t(packets_per_rev))) {
+      ++bad_coverage;
+    }
+  }
+  uint8_t runt[100] = {0};
+  expect(tracker.processPacket(runt, sizeof(runt)) == ContinuityTracker::MALFORMED,
+         "a short datagram is malformed");
+  const ContinuityStats& counters = tracker.getStats();
+  expect(counters.lost == impaired.dropped, "lost packets counted exactly, outage included");
+  expect(counters.duplicates == impaired.duplicated, "duplicates counted");
+  expect(counters.out_of_order == impaired.reordered, "late packets counted");
+  expect(counters.malformed == 1, "malformed datagrams counted");
+  expect(bad_coverage == 0, "every revolution's coverage adds up");
+  // Late packets are dropped before assembly, so coverage must not count them
+  expect(covered <= counters.packets && counters.packets - covered <= uint64_t(packets_per_rev),
+         "coverage counts only packets that are assembled");
+}
+
+/// Write packets in `order` to a capture and read every revolution back.
+static std::vector<std::vector<ScanPoint>> replayScans(const std::vector<Packet>& packets,
+                                                       const std::vector<int>& order,
+                                                       ContinuityStats& counters) {
+  const char* path = "/tmp/test_continuity.pcap";
+  {
+    PcapWriter writer(path);
+    timespec ts = {1700000000, 0};
+    for (int p : order) {
+      writer.write(packets[p].data(), packets[p].size(), ts);
+      ts.tv_nsec += 100000;
+    }
+  }
+  std::unique_ptr<PcapReplay> replay(new PcapReplay(path));
+  replay->setSpeed(0);
+  LiDARReader reader(std::move(replay));
+  std::vector<std::vector<ScanPoint>> scans;
+  std::vector<ScanPoint> scan;
+  while (reader.readScan(scan, LiDARReader::Clock::now()) == LiDARReader::ReadStatus::Ok) {
+    scans.push_back(scan);
+  }
+  counters = reader.continuity();
+  unlink(path);
+  return scans;
+}
+
+static bool sameScans(const std::vector<std::vector<ScanPoint>>& a,
+                      const std::vector<std::vector<ScanPoint>>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t s = 0; s < a.size(); ++s) {
+    if (a[s].size() != b[s].size()) return false;
+    for (size_t i = 0; i < a[s].size(); ++i) {
+      if (a[s][i].raw_azimuth != b[s][i].raw_azimuth || a[s][i].range != b[s][i].range) return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  const StreamConfig configs[] = {
+      {"270 deg FOV, 0.25 deg (no marker)", 0.25, 270.0},
+      {"360 deg FOV, 0.2 deg (marker, short last packet)", 0.2, 360.0},
+      {"180 deg FOV, 0.1 deg", 0.1, 180.0},
+  };
+  for (const StreamConfig& config : configs) checkTracker(config);
+
+  std::printf("LiDARReader with duplicated and late packets:\n");
+  {
+    int packets_per_rev = 0;
+    std::vector<Packet> packets = makeStream(configs[1], 2000, packets_per_rev);
+    Impaired impaired = impair(int(packets.size()), packets_per_rev, false);
+
+    ContinuityStats counters, clean_counters;
+    std::vector<std::vector<ScanPoint>> scans = replayScans(packets, impaired.order, counters);
+    std::vector<std::vector<ScanPoint>> expected = replayScans(packets, impaired.accepted, clean_counters);
+    expect(counters.duplicates == impaired.duplicated && counters.out_of_order == impaired.reordered,
+           "reader counts the duplicated and late packets");
+    expect(!scans.empty() && sameScans(scans, expected),
+           "revolutions match the stream without them");
+  }
+
+  if (!g_ok) {
+    std::printf("Continuity tracker FAILED\n");
+    return 1;
+  }
+  std::printf("Continuity is tracked exactly and repeats never reach a revolution.\n");
+  return 0;
+}
@@ -1,21 +1,33 @@
 #include "lidar_reader.hpp"
+#include "scan_shm.hpp"
 #include <iostream>
 #include <cmath>
 
 int main(int argc, char** argv) {
-  if(argc < 3){
+  bool shared = argc >= 2 && std::string(argv[1]) == "--shm";
+  if(argc < 3 && !shared){
     std::cerr << "Usage: " << argv[0] 
-              << " <LiDAR_IP> <UDP_Port>\n";
+              << " <LiDAR_IP> <UDP_Port>\n"
+              << "       " << argv[0] << " --shm [ring_name]\n";
     return 1;
   }
-  std::string ip   = argv[1];
-  int port         = std::atoi(argv[2]);
 
-  // angle_offset=0, inverted=false
-  LiDARReader reader(ip, port, 0, false);
+  std::vector<ScanPoint> scan;
+  if (shared) {
+    // Next revolution from a running scan_publisher
+    ScanSubscriber subscriber(argc >= 3 ? argv[2] : DEFAULT_SCAN_RING);
+    std::cout << "Reading one full revolution from shared memory...\n";
+    scan = subscriber.readScan();
+  } else {
+    std::string ip   = argv[1];
+    int port         = std::atoi(argv[2]);
 
-  std::cout << "Reading one full scan (192 points)...\n";
-  auto scan = reader.readScan();
+    // angle_offset=0, inverted=false
+    LiDARReader reader(ip, port, 0, false);
+
+    std::cout << "Reading one full revolution...\n";
+    scan = reader.readScan();
+  }
 
   for(int i = 0; i < (int)scan.size(); ++i) {
     double deg = scan[i].angle * 180.0 / M_PI;
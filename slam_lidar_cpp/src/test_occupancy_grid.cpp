@@ -0,0 +1,182 @@
+// src/test_occupancy_grid.cpp
+//
+// Occupancy grid on a synthetic rectangular room: scans are ray cast
+// analytically from a few poses, then walls must come out occupied, the floor
+// free and everything outside unknown, with the same map for one and four
+// threads.
+
+#include "occupancy_grid.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/// Axis-aligned room, walls at these map coordinates.
+struct Room {
+  double min_x, min_y, max_x, max_y;
+};
+
+static const Room ROOM = {-4.0, -3.0, 6.0, 5.0};
+
+/// One revolution of 1440 beams (0.25 degrees) taken inside `room` from `pose`.
+static std::vector<ScanPoint> castScan(const Room& room, const Pose2D& pose) {
+  std::vector<ScanPoint> scan(1440);
+  for (size_t i = 0; i < scan.size(); ++i) {
+    double a = -M_PI + double(i) * (2 * M_PI / scan.size());
+    double dx = std::cos(pose.theta + a), dy = std::sin(pose.theta + a);
+    double range = std::numeric_limits<double>::infinity();
+    if (dx > 0) range = std::min(range, (room.max_x - pose.x) / dx);
+    if (dx < 0) range = std::min(range, (room.min_x - pose.x) / dx);
+    if (dy > 0) range = std::min(range, (room.max_y - pose.y) / dy);
+    if (dy < 0) range = std::min(range, (room.min_y - pose.y) / dy);
+    scan[i].angle       = a;
+    scan[i].range       = range;
+    scan[i].intensity   = 100;
+    scan[i].raw_azimuth = uint16_t(i * 25);
+  }
+  return scan;
+}
+
+static double cellsOccupied(const OccupancyGrid& grid, const Room& room) {
+  // A wall cell counts if it or its inner neighbour is occupied: returns
+  // landing right on the wall line may round to either side
+  int total = 0, occupied = 0;
+  int x0, y0, x1, y1;
+  grid.cellOf(room.min_x, room.min_y, x0, y0);
+  grid.cellOf(room.max_x, room.max_y, x1, y1);
+  for (int cy = y0 + 2; cy <= y1 - 2; ++cy) {
+    total += 2;
+    occupied += grid.probability(x0, cy) > 0.5 || grid.probability(x0 + 1, cy) > 0.5;
+    occupied += grid.probability(x1, cy) > 0.5 || grid.probability(x1 - 1, cy) > 0.5;
+  }
+  for (int cx = x0 + 2; cx <= x1 - 2; ++cx) {
+    total += 2;
+    occupied += grid.probability(cx, y0) > 0.5 || grid.probability(cx, y0 + 1) > 0.5;
+    occupied += grid.probability(cx, y1) > 0.5 || grid.probability(cx, y1 - 1) > 0.5;
+  }
+  return double(occupied) / total;
+}
+
+static double cellsFree(const OccupancyGrid& grid, const Room& room, double margin) {
+  int total = 0, free = 0;
+  int x0, y0, x1, y1;
+  grid.cellOf(room.min_x + margin, room.min_y + margin, x0, y0);
+  grid.cellOf(room.max_x - margin, room.max_y - margin, x1, y1);
+  for (int cy = y0; cy <= y1; ++cy) {
+    for (int cx = x0; cx <= x1; ++cx) {
+      total++;
+      free += grid.probability(cx, cy) < 0.5;
+    }
+  }
+  return double(free) / total;
+}
+
+static bool sameCells(const OccupancyGrid& a, const OccupancyGrid& b) {
+  int ax0, ay0, ax1, ay1, bx0, by0, bx1, by1;
+  if (!a.bounds(ax0, ay0, ax1, ay1) || !b.bounds(bx0, by0, bx1, by1)) return false;
+  if (ax0 != bx0 || ay0 != by0 || ax1 != bx1 || ay1 != by1) return false;
+  for (int cy = ay0; cy <= ay1; ++cy) {
+    for (int cx = ax0; cx <= ax1; ++cx) {
+      if (a.logOdds(cx, cy) != b.logOdds(cx, cy)) return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  const Pose2D poses[] = {{0, 0, 0}, {2.5, 1.0, 0.6}, {-2.0, 3.5, -2.0}, {4.5, -1.5, 3.0}};
+  std::vector<std::vector<ScanPoint>> scans;
+  for (const Pose2D& pose : poses) scans.push_back(castScan(ROOM, pose));
+
+  std::printf("Room %.0f x %.0f m, %zu scans of %zu beams:\n", ROOM.max_x - ROOM.min_x,
+              ROOM.max_y - ROOM.min_y, scans.size(), scans[0].size());
+  OccupancyGrid serial;
+  OccupancyGrid::Options options;
+  options.threads = 4;
+  OccupancyGrid parallel(options);
+  for (size_t i = 0; i < scans.size(); ++i) {
+    serial.integrate(scans[i], poses[i]);
+    parallel.integrate(scans[i], poses[i]);
+  }
+
+  double walls = cellsOccupied(serial, ROOM);
+  double floor = cellsFree(serial, ROOM, 0.15);
+  std::printf("  walls occupied %.1f%%, floor free %.2f%%, %zu tiles, %zu KB\n", walls * 100,
+              floor * 100, serial.tileCount(), serial.memoryBytes() / 1024);
+  expect(walls > 0.98, "walls are occupied");
+  expect(floor > 0.999, "floor is free");
+  int cx, cy;
+  serial.cellOf(ROOM.max_x + 1.0, 0.5, cx, cy);
+  bool outside = serial.logOdds(cx, cy) == 0;
+  serial.cellOf(ROOM.min_x - 0.5, ROOM.max_y + 0.5, cx, cy);
+  outside &= serial.logOdds(cx, cy) == 0;
+  expect(outside, "cells behind the walls stay unknown");
+  expect(serial.stats().cells == parallel.stats().cells && sameCells(serial, parallel),
+         "4 threads build the same map as 1");
+
+  // Repeated observations saturate instead of overflowing
+  for (int i = 0; i < 200; ++i) serial.integrate(scans[0], poses[0]);
+  int16_t clamp = int16_t(std::lround(std::log(0.99 / 0.01) * OccupancyGrid::LOG_ODDS_SCALE));
+  serial.cellOf(0.5, 0.5, cx, cy);
+  bool saturated = serial.logOdds(cx, cy) == -clamp;
+  serial.cellOf(ROOM.max_x - 0.01, 0.02, cx, cy);
+  saturated &= serial.logOdds(cx, cy) == clamp || serial.logOdds(cx + 1, cy) == clamp;
+  expect(saturated, "log-odds saturate at the clamp");
+
+  // Beyond max_range: cleared up to it, nothing marked occupied
+  OccupancyGrid::Options short_range;
+  short_range.max_range = 3.0;
+  OccupancyGrid clipped(short_range);
+  clipped.integrate(scans[0], poses[0]);
+  clipped.cellOf(2.9, 0.0, cx, cy);
+  bool clip_ok = clipped.probability(cx, cy) < 0.5;
+  clipped.cellOf(ROOM.max_x - 0.01, 0.0, cx, cy);
+  clip_ok &= clipped.logOdds(cx, cy) == 0 && clipped.logOdds(cx + 1, cy) == 0;
+  expect(clip_ok, "returns past max_range clear space without a hit");
+
+  // Memory follows the explored area: a second small room far away adds its
+  // own tiles, not the bounding box in between
+  size_t tiles = parallel.tileCount();
+  const Room far_room = {998.0, 998.0, 1002.0, 1002.0};
+  const Pose2D far_pose = {1000.0, 1000.0, 0.0};
+  parallel.integrate(castScan(far_room, far_pose), far_pose);
+  size_t added = parallel.tileCount() - tiles;
+  int x0, y0, x1, y1;
+  parallel.bounds(x0, y0, x1, y1);
+  double box_tiles = double(x1 - x0 + 1) * (y1 - y0 + 1) / OccupancyGrid::TILE_CELLS;
+  std::printf("  far room added %zu tiles; bounding box would be %.0f\n", added, box_tiles);
+  expect(added > 0 && added <= 9, "a distant room allocates only its own tiles");
+
+  std::string path = "/tmp/test_occupancy_grid.pgm";
+  serial.writePgm(path);
+  std::ifstream pgm(path, std::ios::binary | std::ios::ate);
+  serial.bounds(x0, y0, x1, y1);
+  size_t pixels = size_t(x1 - x0 + 1) * size_t(y1 - y0 + 1);
+  expect(pgm && size_t(pgm.tellg()) > pixels && size_t(pgm.tellg()) < pixels + 32,
+         "PGM holds every allocated cell");
+
+  // Throughput, for information: the build may not be optimized
+  for (int threads : {1, 4}) {
+    OccupancyGrid::Options timed;
+    timed.threads = threads;
+    OccupancyGrid grid(timed);
+    const int rounds = 50;
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i) grid.integrate(scans[i % scans.size()], poses[i % scans.size()]);
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+    std::printf("  %d thread%s: %.0f us per scan, %.1f M cell updates/s\n", threads,
+                threads == 1 ? " " : "s", us, double(grid.stats().cells) / rounds / us);
+  }
+
+  if (!g_ok) {
+    std::printf("Occupancy grid FAILED\n");
+    return 1;
+  }
+  std::printf("Occupancy grid matches the room.\n");
+  return 0;
+}
@@ -0,0 +1,111 @@
+// src/test_pcap_io.cpp
+//
+// PcapWriter -> PcapReplay round trip: every payload recorded must replay with
+// the same bytes and the same nanosecond timestamp, records to other ports are
+// skipped, and rewind() replays the capture again from the start.
+
+#include "pcap_io.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+struct Packet {
+  std::vector<uint8_t> payload;
+  uint64_t timestamp_ns;
+};
+
+/// Replay the whole capture, counting payloads whose bytes or timestamp differ.
+static size_t replayAll(PcapReplay& replay, const std::vector<Packet>& sent,
+                        size_t& wrong_bytes, size_t& wrong_times) {
+  size_t count = 0;
+  wrong_bytes = wrong_times = 0;
+  const uint8_t* data;
+  size_t size;
+  uint64_t ts;
+  while (replay.next(data, size, &ts)) {
+    if (count < sent.size()) {
+      const Packet& p = sent[count];
+      if (size != p.payload.size() || std::memcmp(data, p.payload.data(), size) != 0) ++wrong_bytes;
+      if (ts != p.timestamp_ns) ++wrong_times;
+    }
+    ++count;
+  }
+  return count;
+}
+
+int main() {
+  const std::string path = "/tmp/test_pcap_io.pcap";
+  std::srand(11);
+
+  std::vector<Packet> sent(500);
+  uint64_t t = 1700000000ull * 1000000000ull + 987654321ull;
+  for (size_t i = 0; i < sent.size(); ++i) {
+    sent[i].payload.resize(i % 64 == 5 ? 40 + i : 1206);
+    for (uint8_t& b : sent[i].payload) b = uint8_t(std::rand());
+    t += 555555 + std::rand() % 1000;
+    sent[i].timestamp_ns = t;
+  }
+
+  std::printf("Record:\n");
+  size_t expected_size = PCAP_FILE_HEADER_SIZE;
+  {
+    PcapWriter writer(path);
+    PcapWriter difop_writer("/tmp/test_pcap_io_difop.pcap", 2369);
+    for (size_t i = 0; i < sent.size(); ++i) {
+      timespec ts;
+      ts.tv_sec = time_t(sent[i].timestamp_ns / 1000000000ull);
+      ts.tv_nsec = long(sent[i].timestamp_ns % 1000000000ull);
+      writer.write(sent[i].payload.data(), sent[i].payload.size(), ts);
+      expected_size += PCAP_RECORD_PREFIX_SIZE + sent[i].payload.size();
+      if (i == 0) difop_writer.write(sent[i].payload.data(), sent[i].payload.size(), ts);
+    }
+    expect(writer.packets() == sent.size() && writer.bytes() == expected_size,
+           "writer counts every packet and byte");
+  }
+  FILE* file = std::fopen(path.c_str(), "rb");
+  long file_size = -1;
+  if (file) {
+    std::fseek(file, 0, SEEK_END);
+    file_size = std::ftell(file);
+    std::fclose(file);
+  }
+  expect(file_size == long(expected_size), "file is trimmed to the bytes written");
+
+  std::printf("Replay:\n");
+  {
+    PcapReplay replay(path);
+    replay.setSpeed(0);
+    size_t wrong_bytes, wrong_times;
+    size_t count = replayAll(replay, sent, wrong_bytes, wrong_times);
+    expect(count == sent.size() && replay.stats().skipped == 0, "every recorded packet replays");
+    expect(wrong_bytes == 0, "payload bytes are identical");
+    expect(wrong_times == 0, "nanosecond timestamps are identical");
+
+    replay.rewind();
+    count = replayAll(replay, sent, wrong_bytes, wrong_times);
+    expect(count == sent.size() && wrong_bytes == 0 && wrong_times == 0,
+           "rewind replays the same packets again");
+  }
+  {
+    PcapReplay replay("/tmp/test_pcap_io_difop.pcap");
+    replay.setSpeed(0);
+    const uint8_t* data;
+    size_t size;
+    expect(!replay.next(data, size) && replay.stats().skipped == 1, "records to another port are skipped");
+    PcapReplay any("/tmp/test_pcap_io_difop.pcap", 0);
+    any.setSpeed(0);
+    expect(any.next(data, size) && size == sent[0].payload.size(), "port 0 accepts any port");
+  }
+
+  unlink(path.c_str());
+  unlink("/tmp/test_pcap_io_difop.pcap");
+  if (!g_ok) {
+    std::printf("Pcap round trip FAILED\n");
+    return 1;
+  }
+  std::printf("Recorded packets replay with identical bytes and timestamps.\n");
+  return 0;
+}
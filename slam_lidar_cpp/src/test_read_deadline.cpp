@@ -0,0 +1,129 @@
+// src/test_read_deadline.cpp
+//
+// Loopback check of LiDARReader's status-returning receive calls: deadlines
+// on a silent socket, and truncated, oversized and foreign datagrams skipped
+// and counted on the way to a revolution.
+
+#include "lidar_reader.hpp"
+#include "test_util.hpp"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using Status = LiDARReader::ReadStatus;
+using Clock  = LiDARReader::Clock;
+
+static constexpr int PORT = 23700;
+class Sender {
+public:
+  Sender() : fd_(socket(AF_INET, SOCK_DGRAM, 0)) {
+    dest_.sin_family      = AF_INET;
+    dest_.sin_port        = htons(PORT);
+    dest_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  }
+  ~Sender() { close(fd_); }
+
+  void send(const std::vector<uint8_t>& datagram) {
+    sendto(fd_, datagram.data(), datagram.size(), 0,
+           reinterpret_cast<const sockaddr*>(&dest_), sizeof(dest_));
+  }
+
+  /// One data packet and a last-packet marker: a complete revolution. Each
+  /// packet gets a later timestamp, or the reader would drop it as a repeat.
+  void sendRevolution() {
+    send(packet(0, MSOPPacketView::BLOCK_COUNT));
+    send(packet(MSOPPacketView::BLOCK_COUNT * 400, 6));
+  }
+
+private:
+  int fd_;
+  sockaddr_in dest_{};
+  uint32_t timestamp_ = 1000;  // µs, advanced per packet
+
+  static void put16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v >> 8); p[1] = uint8_t(v); }
+
+  std::vector<uint8_t> packet(int azimuth, int valid_blocks) {
+    std::vector<uint8_t> bytes(MSOPPacketView::PACKET_SIZE, 0);
+    timestamp_ += 1000;
+    put16(&bytes[MSOPPacketView::TIMESTAMP_OFFSET], uint16_t(timestamp_ >> 16));
+    put16(&bytes[MSOPPacketView::TIMESTAMP_OFFSET + 2], uint16_t(timestamp_));
+    for (int b = 0; b < MSOPPacketView::BLOCK_COUNT; ++b) {
+      uint8_t* block = &bytes[b * MSOPPacketView::BLOCK_SIZE];
+      bool valid = b < valid_blocks;
+      put16(block + MSOPPacketView::FLAG_OFFSET,
+            valid ? MSOPPacketView::VALID_BLOCK_FLAG : MSOPPacketView::INVALID_BLOCK_FLAG);
+      put16(block + MSOPPacketView::AZIMUTH_OFFSET, valid ? uint16_t(azimuth + b * 400) : 0xFFFF);
+      for (int i = 0; valid && i < MSOPPacketView::MEASUREMENTS_PER_BLOCK; ++i) {
+        uint8_t* result = block + MSOPPacketView::MEASUREMENT_OFFSET + i * MSOPPacketView::MEASUREMENT_SIZE;
+        put16(result + MSOPPacketView::STRONGEST_OFFSET, 2000);
+        result[MSOPPacketView::STRONGEST_OFFSET + 2] = 50;
+      }
+    }
+    return bytes;
+  }
+};
+
+static double millisSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void run(int batch_size) {
+  std::printf("Batch size %d:\n", batch_size);
+  LiDARReader reader("", PORT);
+  reader.setBatchSize(batch_size);
+  Sender sender;
+  std::vector<ScanPoint> scan;
+
+  Clock::time_point start = Clock::now();
+  expect(reader.tryReadScan(scan) == Status::Timeout, "tryReadScan() on a silent socket times out");
+  expect(millisSince(start) < 20, "...without waiting");
+
+  start = Clock::now();
+  Status status = reader.readScan(scan, start + std::chrono::milliseconds(100));
+  double waited = millisSince(start);
+  expect(status == Status::Timeout, "readScan() on a silent socket times out");
+  expect(waited >= 99 && waited < 300, "...at its deadline");
+
+  // Bad datagrams in front of a revolution are skipped and counted
+  sender.send(std::vector<uint8_t>(100, 0xFF));                     // truncated
+  sender.send(std::vector<uint8_t>(1500, 0xFF));                    // oversized
+  sender.send(std::vector<uint8_t>(MSOPPacketView::PACKET_SIZE, 0));       // no block flags
+  sender.sendRevolution();
+  status = reader.readScan(scan, Clock::now() + std::chrono::seconds(1));
+  expect(status == Status::Ok && !scan.empty(), "readScan() assembles the revolution behind them");
+  const auto& counters = reader.receiveCounters();
+  expect(counters.truncated == 1 && counters.foreign == 2, "...and counts 1 truncated, 2 foreign");
+  expect(reader.continuity().malformed == 3, "...which the continuity tracker sees as malformed");
+
+  // Queued but unfinished: tryReadScan() takes what is there and keeps it
+  sender.send(std::vector<uint8_t>(MSOPPacketView::PACKET_SIZE, 0));
+  sender.sendRevolution();
+  usleep(20000);
+  expect(reader.tryReadScan(scan) == Status::Ok, "tryReadScan() completes a queued revolution");
+
+  // readPacket() reports each datagram
+  sender.send(std::vector<uint8_t>(10, 0));
+  sender.send(std::vector<uint8_t>(MSOPPacketView::PACKET_SIZE, 0));
+  sender.sendRevolution();
+  bool completed = false;
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(1);
+  expect(reader.readPacket(deadline, completed) == Status::Truncated, "readPacket() reports a truncated datagram");
+  expect(reader.readPacket(deadline, completed) == Status::Foreign, "readPacket() reports a foreign datagram");
+  expect(reader.readPacket(deadline, completed) == Status::Ok && !completed, "readPacket() takes a data packet");
+  expect(reader.readPacket(deadline, completed) == Status::Ok && completed, "...and the marker closes the revolution");
+  expect(!reader.lastRevolution().empty(), "...which lastRevolution() returns");
+}
+
+int main() {
+  run(1);
+  run(16);
+  if (!g_ok) {
+    std::printf("Deadline-aware receive FAILED\n");
+    return 1;
+  }
+  std::printf("Deadlines hold and bad datagrams are skipped, counted and reported.\n");
+  return 0;
+}
@@ -0,0 +1,178 @@
+// src/test_scan_assembler.cpp
+//
+// ScanAssembler on synthetic packets: a revolution must close on the azimuth
+// wrap and on the last-packet marker with every block in it, a small step back
+// must not close one, a packet with two boundaries must complete only one
+// revolution, and the finished revolution the consumer holds must not change
+// while the next one fills the other buffer.
+
+#include "scan_assembler.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <vector>
+
+static const int STEP = 400;  // centidegrees between blocks: 90 blocks per turn
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = uint8_t(v >> 8);
+  p[1] = uint8_t(v & 0xFF);
+}
+
+/// Twelve blocks starting at `first_azimuth`, STEP apart; every point's
+/// distance is `tag` mm so a block can be traced to the packet it came from.
+/// With `last`, blocks 6-11 carry the invalid flag (the last-packet marker).
+static std::vector<uint8_t> makePacket(int first_azimuth, uint16_t tag, bool last = false) {
+  std::vector<uint8_t> packet(MSOPPacketView::PACKET_SIZE, 0);
+  for (int b = 0; b < MSOPPacketView::BLOCK_COUNT; ++b) {
+    uint8_t* block = &packet[b * MSOPPacketView::BLOCK_SIZE];
+    bool invalid = last && b >= 6;
+    put16(block, invalid ? MSOPPacketView::INVALID_BLOCK_FLAG : MSOPPacketView::VALID_BLOCK_FLAG);
+    put16(block + 2, uint16_t((first_azimuth + b * STEP) % AzimuthTable::SIZE));
+    for (int i = 0; i < MSOPPacketView::MEASUREMENTS_PER_BLOCK && !invalid; ++i) {
+      put16(block + 4 + i * 6, tag);
+      block[4 + i * 6 + 2] = 50;
+    }
+  }
+  return packet;
+}
+
+/// Feed packets continuing the sweep from block `next_block`; returns true
+/// as soon as one completes a revolution.
+static bool feed(ScanAssembler& assembler, int& next_block, int packets, uint16_t tag) {
+  bool completed = false;
+  for (int p = 0; p < packets; ++p) {
+    std::vector<uint8_t> packet = makePacket(next_block * STEP, tag);
+    next_block += MSOPPacketView::BLOCK_COUNT;
+    completed |= assembler.addPacket(MSOPPacketView(packet.data()));
+  }
+  return completed;
+}
+
+static bool sameRevolution(const std::vector<ScanPoint>& a, const std::vector<ScanPoint>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].raw_azimuth != b[i].raw_azimuth || a[i].range != b[i].range) return false;
+  }
+  return true;
+}
+
+int main() {
+  AzimuthTable table;
+  const size_t blocks_per_turn = AzimuthTable::SIZE / STEP;
+  const size_t points_per_turn = blocks_per_turn * MSOPPacketView::MEASUREMENTS_PER_BLOCK;
+
+  std::printf("Azimuth wrap:\n");
+  {
+    ScanAssembler assembler(table);
+    int next_block = 0;
+    // 7 packets hold blocks 0-83; the 8th holds 84-89 and 0-5 of the next turn
+    bool early = feed(assembler, next_block, 7, 1000);
+    bool closed = feed(assembler, next_block, 1, 1000);
+    const std::vector<ScanPoint>& done = assembler.completed();
+    expect(!early && closed, "the packet holding the wrap completes the revolution");
+    expect(done.size() == points_per_turn, "revolution holds every block of the turn");
+    expect(!done.empty() && done.front().raw_azimuth == 0 &&
+               done.back().raw_azimuth == AzimuthTable::SIZE - STEP / MSOPPacketView::MEASUREMENTS_PER_BLOCK,
+           "first and last points are at 0 and 359.75 deg");
+    expect(assembler.pendingPoints() == 6 * size_t(MSOPPacketView::MEASUREMENTS_PER_BLOCK),
+           "blocks after the wrap start the next revolution");
+    expect(assembler.stats().wraps == 1 && assembler.stats().markers == 0, "counted as a wrap");
+
+    // Azimuth a little behind the previous block: jitter, not a new turn
+    std::vector<uint8_t> packet = makePacket(6 * STEP - 100, 1000);
+    bool jitter = assembler.addPacket(MSOPPacketView(packet.data()));
+    expect(!jitter && assembler.stats().revolutions == 1, "a small step back does not close a revolution");
+  }
+
+  std::printf("Last-packet marker:\n");
+  {
+    ScanAssembler assembler(table);
+    // Half a turn, then a packet whose blocks 6-11 are invalid
+    int next_block = 0;
+    bool early = feed(assembler, next_block, 3, 1000);
+    std::vector<uint8_t> marker = makePacket(next_block * STEP, 2000, true);
+    bool closed = assembler.addPacket(MSOPPacketView(marker.data()));
+    const std::vector<ScanPoint>& done = assembler.completed();
+    expect(!early && closed, "the marker packet completes the revolution");
+    expect(done.size() == (3 * 12 + 6) * size_t(MSOPPacketView::MEASUREMENTS_PER_BLOCK),
+           "its six valid blocks are the end of the revolution");
+    expect(!done.empty() && done.back().range == 2.0, "last points come from the marker packet");
+    expect(assembler.pendingPoints() == 0 && assembler.stats().markers == 1 && assembler.stats().wraps == 0,
+           "counted as a marker, nothing pending");
+
+    // The sweep restarts at azimuth 0 after the marker without a second close
+    next_block = 0;
+    bool again = feed(assembler, next_block, 2, 1000);
+    expect(!again && assembler.stats().revolutions == 1, "restart after the marker is not a wrap");
+  }
+
+  std::printf("Two boundaries in one packet:\n");
+  {
+    // Wrap, then the marker: valid blocks 87-89 and 0-2 of the next turn
+    ScanAssembler assembler(table);
+    int next_block = 0;
+    feed(assembler, next_block, 7, 1000);
+    std::vector<uint8_t> marker = makePacket(87 * STEP, 2000, true);
+    bool closed = assembler.addPacket(MSOPPacketView(marker.data()));
+    const std::vector<ScanPoint>& done = assembler.completed();
+    expect(closed && done.size() == (84 + 3) * size_t(MSOPPacketView::MEASUREMENTS_PER_BLOCK),
+           "wrap then marker: the whole turn is completed");
+    expect(assembler.stats().revolutions == 1 && assembler.stats().fragments == 1 &&
+               assembler.pendingPoints() == 0,
+           "the blocks between them are dropped as a fragment");
+
+    // Buffer of 8 blocks: in the packet with blocks 84-89 and 0-5, block 88
+    // overflows it and block 0 wraps
+    ScanAssembler small(table, 8 * MSOPPacketView::MEASUREMENTS_PER_BLOCK);
+    next_block = 0;
+    feed(small, next_block, 7, 3000);
+    uint64_t fragments = small.stats().fragments;
+    closed = feed(small, next_block, 1, 3000);
+    const std::vector<ScanPoint>& full = small.completed();
+    expect(closed && full.size() == 8 * size_t(MSOPPacketView::MEASUREMENTS_PER_BLOCK) &&
+               full.front().raw_azimuth == 80 * STEP && small.stats().fragments == fragments + 1 &&
+               small.stats().wraps == 0,
+           "overflow then wrap: the full buffer is completed");
+  }
+
+  std::printf("Double buffer:\n");
+  {
+    ScanAssembler assembler(table);
+    int next_block = 0;
+    feed(assembler, next_block, 8, 1000);
+    const std::vector<ScanPoint>& held = assembler.completed();
+    const ScanPoint* held_data = held.data();
+    std::vector<ScanPoint> copy = held;
+
+    // Most of the next revolution, with other distances, fills the other buffer
+    bool closed = feed(assembler, next_block, 6, 3000);
+    expect(!closed && assembler.pendingPoints() > points_per_turn / 2, "next revolution is filling");
+    expect(held.data() == held_data && sameRevolution(held, copy),
+           "the held revolution is untouched while the next fills");
+
+    // Completing it swaps buffers: the new revolution has the new distances
+    closed = feed(assembler, next_block, 2, 3000);
+    const std::vector<ScanPoint>& next = assembler.completed();
+    expect(closed && next.data() != held_data && next.size() == points_per_turn &&
+               next[points_per_turn / 2].range == 3.0,
+           "the next revolution arrives in the other buffer");
+
+    // Many turns later the two buffers are still the same two allocations
+    const ScanPoint* buffers[2] = {held_data, next.data()};
+    bool stable = true;
+    for (int turn = 0; turn < 20; ++turn) {
+      closed = false;
+      while (!closed) closed = feed(assembler, next_block, 1, uint16_t(4000 + turn));
+      const ScanPoint* data = assembler.completed().data();
+      stable &= data == buffers[0] || data == buffers[1];
+    }
+    expect(stable, "buffers are reused, never reallocated");
+  }
+
+  if (!g_ok) {
+    std::printf("Scan assembler FAILED\n");
+    return 1;
+  }
+  std::printf("Scan assembler closes revolutions where it should.\n");
+  return 0;
+}
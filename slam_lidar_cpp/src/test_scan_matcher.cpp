@@ -0,0 +1,152 @@
+// src/test_scan_matcher.cpp
+//
+// Point-to-line ICP on scans ray cast in a synthetic room with a few boxes:
+// known offsets must be recovered scan to scan and scan to submap, a
+// featureless corridor must be reported as not converged, and matching must
+// not allocate once its buffers have grown.
+
+#include "scan_matcher.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t g_allocations = 0;
+
+void* operator new(size_t size) {
+  ++g_allocations;
+  void* memory = std::malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+struct Segment {
+  double x0, y0, x1, y1;
+};
+
+/// Room 12 x 8 m with three boxes.
+static std::vector<Segment> roomScene() {
+  std::vector<Segment> scene = {{-5, -3, 7, -3}, {7, -3, 7, 5}, {7, 5, -5, 5}, {-5, 5, -5, -3}};
+  const double boxes[][4] = {{2, 1, 3, 1.6}, {-3, -2, -2.2, -1.5}, {4.5, -2, 5, 0.5}};
+  for (const auto& b : boxes) {
+    scene.push_back({b[0], b[1], b[2], b[1]});
+    scene.push_back({b[2], b[1], b[2], b[3]});
+    scene.push_back({b[2], b[3], b[0], b[3]});
+    scene.push_back({b[0], b[3], b[0], b[1]});
+  }
+  return scene;
+}
+
+/// One revolution of 1440 beams from `pose`, with uniform range noise of
+/// ±`noise` m and no return past 30 m.
+static std::vector<ScanPoint> castScan(const std::vector<Segment>& scene, const Pose2D& pose,
+                                       double noise, uint32_t seed) {
+  std::vector<ScanPoint> scan(1440);
+  for (size_t i = 0; i < scan.size(); ++i) {
+    double a = -M_PI + double(i) * (2 * M_PI / scan.size());
+    double dx = std::cos(pose.theta + a), dy = std::sin(pose.theta + a);
+    double range = std::numeric_limits<double>::infinity();
+    for (const Segment& s : scene) {
+      // pose + t·d = s0 + u·(s1 - s0)
+      double ex = s.x1 - s.x0, ey = s.y1 - s.y0;
+      double det = dx * -ey + dy * ex;
+      if (std::fabs(det) < 1e-12) continue;
+      double wx = s.x0 - pose.x, wy = s.y0 - pose.y;
+      double t = (wx * -ey + wy * ex) / det;
+      double u = (dx * wy - dy * wx) / det;
+      if (t > 0 && u >= 0 && u <= 1 && t < range) range = t;
+    }
+    seed = seed * 1664525u + 1013904223u;
+    if (range > 30) range = std::numeric_limits<double>::infinity();
+    else range += noise * (2.0 * (seed >> 8) / double(1 << 24) - 1.0);
+    scan[i].angle       = a;
+    scan[i].range       = range;
+    scan[i].intensity   = 100;
+    scan[i].raw_azimuth = uint16_t(i * 25);
+  }
+  return scan;
+}
+
+/// Pose of `b` in the frame of `a`.
+static Pose2D relative(const Pose2D& a, const Pose2D& b) {
+  double c = std::cos(a.theta), s = std::sin(a.theta);
+  double dx = b.x - a.x, dy = b.y - a.y;
+  return {c * dx + s * dy, -s * dx + c * dy, std::remainder(b.theta - a.theta, 2 * M_PI)};
+}
+
+static bool near(const Pose2D& estimate, const Pose2D& truth, double meters, double radians) {
+  return std::hypot(estimate.x - truth.x, estimate.y - truth.y) < meters &&
+         std::fabs(std::remainder(estimate.theta - truth.theta, 2 * M_PI)) < radians;
+}
+
+static void print(const char* what, const ScanMatcher::Result& r, const Pose2D& truth, double us) {
+  std::printf("  %s: %d iterations, %zu correspondences, rms %.1f mm, error %.1f mm %.3f deg, %.0f us\n",
+              what, r.iterations, r.correspondences, r.rms * 1000,
+              std::hypot(r.pose.x - truth.x, r.pose.y - truth.y) * 1000,
+              std::fabs(std::remainder(r.pose.theta - truth.theta, 2 * M_PI)) * 180 / M_PI, us);
+}
+
+int main() {
+  const std::vector<Segment> scene = roomScene();
+  const Pose2D a = {0.0, 0.0, 0.1};
+  const Pose2D b = {0.25, -0.12, 0.16};
+  std::vector<ScanPoint> scan_a = castScan(scene, a, 0.005, 1);
+  std::vector<ScanPoint> scan_b = castScan(scene, b, 0.005, 2);
+
+  std::printf("Scan to scan, offset %.0f mm %.1f deg:\n",
+              std::hypot(b.x - a.x, b.y - a.y) * 1000, (b.theta - a.theta) * 180 / M_PI);
+  ScanMatcher matcher;
+  matcher.setTarget(scan_a);
+  Pose2D truth = relative(a, b);
+  auto start = Clock::now();
+  ScanMatcher::Result r = matcher.match(scan_b, Pose2D());
+  double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  print("from identity", r, truth, us);
+  expect(r.converged, "converges from an identity guess");
+  expect(near(r.pose, truth, 0.01, 0.002), "recovers the offset within 10 mm and 0.1 deg");
+  expect(r.iterations < matcher.options().max_iterations, "stops before the iteration limit");
+
+  uint64_t allocations = g_allocations;
+  ScanMatcher::Result again = matcher.match(scan_b, Pose2D());
+  matcher.setTarget(scan_b);
+  matcher.match(scan_a, Pose2D());
+  expect(g_allocations == allocations && again.pose.x == r.pose.x,
+         "matching reuses its buffers: no allocation");
+
+  // Submap: three scans at known poses, seen from the newest
+  std::printf("Scan to submap:\n");
+  const Pose2D keys[] = {{-1.0, 2.0, -0.4}, {0.0, 0.0, 0.1}, {1.0, 0.5, 0.3}};
+  matcher.clearTarget(keys[2]);
+  for (uint32_t k = 0; k < 3; ++k) matcher.addToTarget(castScan(scene, keys[k], 0.005, 10 + k), keys[k]);
+  const Pose2D c = {1.4, 0.3, 0.38};
+  const Pose2D guess = {1.25, 0.45, 0.32};
+  start = Clock::now();
+  r = matcher.match(castScan(scene, c, 0.005, 20), guess);
+  us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  print("from a guess off by 200 mm", r, c, us);
+  std::printf("  submap holds %zu points with normals\n", matcher.targetSize());
+  expect(r.converged && near(r.pose, c, 0.01, 0.002), "aligns with a submap of three scans");
+
+  // A long corridor pins the cross-track position and heading only
+  std::printf("Corridor:\n");
+  const std::vector<Segment> corridor = {{-200, -1, 200, -1}, {-200, 1.2, 200, 1.2}};
+  matcher.setTarget(castScan(corridor, Pose2D(), 0.005, 30));
+  r = matcher.match(castScan(corridor, {0.3, 0.05, 0.02}, 0.005, 31), Pose2D());
+  std::printf("  %d iterations, %zu correspondences\n", r.iterations, r.correspondences);
+  expect(!r.converged, "a featureless corridor is not reported as converged");
+
+  if (!g_ok) {
+    std::printf("Scan matcher FAILED\n");
+    return 1;
+  }
+  std::printf("Scan matcher recovers the offsets.\n");
+  return 0;
+}
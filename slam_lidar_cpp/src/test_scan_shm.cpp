@@ -0,0 +1,186 @@
+// src/test_scan_shm.cpp
+//
+// Shared-memory scan ring: a publisher thread overwrites a small ring as fast
+// as it can while readers with their own mappings copy and view scans in
+// place. Every point carries its revolution number, so a torn read that the
+// seqlock let through shows up as mixed numbers.
+
+#include "scan_shm.hpp"
+#include "test_util.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Status = ScanSubscriber::ReadStatus;
+using Clock  = ScanSubscriber::Clock;
+
+static constexpr uint32_t MAX_POINTS = 4096;
+static constexpr uint64_t SCANS      = 20000;
+static size_t sizeOf(uint64_t number) { return 500 + number * 37 % 3500; }
+
+static std::vector<ScanPoint> makeScan(uint64_t number, size_t size) {
+  std::vector<ScanPoint> scan(size);
+  for (size_t i = 0; i < size; ++i) {
+    scan[i].angle     = double(i);
+    scan[i].range     = double(number);
+    scan[i].intensity = double(number);
+  }
+  return scan;
+}
+
+/// `slow` yields the CPU while reading, so even on one core the publisher
+/// gets to overwrite the slot under a view.
+static bool consistent(const ScanPoint* points, const ScanInfo& info, bool slow = false) {
+  bool ok = info.size == sizeOf(info.number);
+  for (size_t i = 0; i < info.size; ++i) {
+    ok &= points[i].range == double(info.number) && points[i].angle == double(i);
+    if (slow && i % 512 == 0) std::this_thread::yield();
+  }
+  return ok;
+}
+
+struct ReaderResult {
+  uint64_t scans = 0, torn = 0, views = 0, invalidated = 0, undetected = 0, retries = 0, skipped = 0;
+};
+
+/// Copy scans until the publisher closes the ring, viewing one in place
+/// between copies.
+static void readUntilClosed(const std::string& name, ReaderResult& result) {
+  ScanSubscriber subscriber(name);
+  std::vector<ScanPoint> scan;
+  while (true) {
+    Status status = subscriber.readScan(scan, Clock::now() + std::chrono::seconds(5));
+    if (status != Status::Ok) break;
+    result.scans++;
+    if (!consistent(scan.data(), subscriber.lastInfo())) result.torn++;
+
+    ScanSubscriber::ScanView view;
+    if (subscriber.latest(view)) {
+      result.views++;
+      bool ok = consistent(view.points, view.info, true);
+      if (!subscriber.stillValid(view)) {
+        result.invalidated++;
+      } else if (!ok) {
+        result.undetected++;
+      }
+    }
+  }
+  result.retries = subscriber.retries();
+  result.skipped = subscriber.skipped();
+}
+
+int main() {
+  const std::string name = "/test_scan_shm." + std::to_string(getpid());
+  shm_unlink(name.c_str());
+
+  std::printf("Single thread:\n");
+  bool threw = false;
+  try {
+    ScanSubscriber missing(name);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  expect(threw, "subscribing to a ring nobody published throws");
+
+  {
+    ScanPublisher publisher(name, 4, MAX_POINTS);
+    ScanSubscriber subscriber(name);
+    std::vector<ScanPoint> scan;
+
+    Clock::time_point start = Clock::now();
+    Status status = subscriber.readScan(scan, start + std::chrono::milliseconds(50));
+    double waited = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    expect(status == Status::Timeout && waited >= 49 && waited < 250, "readScan() on an empty ring times out at its deadline");
+
+    publisher.publish(makeScan(1, sizeOf(1)));
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Ok &&
+           consistent(scan.data(), subscriber.lastInfo()), "a published revolution is read back intact");
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Timeout, "...and only once");
+
+    ScanSubscriber::ScanView view;
+    expect(subscriber.latest(view) && view.info.number == 1 && consistent(view.points, view.info),
+           "latest() views it in place");
+    for (uint64_t n = 2; n <= 4; ++n) publisher.publish(makeScan(n, sizeOf(n)));
+    expect(subscriber.stillValid(view), "...valid while the publisher is elsewhere in the ring");
+    publisher.publish(makeScan(5, sizeOf(5)));
+    expect(!subscriber.stillValid(view), "...and not once it comes round again");
+
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Ok && subscriber.lastInfo().number == 5 &&
+           subscriber.skipped() == 3, "readScan() takes the newest and counts the skipped");
+
+    std::vector<ScanPoint> big = makeScan(6, MAX_POINTS + 100);
+    publisher.publish(big);
+    subscriber.readScan(scan, Clock::now());
+    expect(scan.size() == MAX_POINTS && subscriber.lastInfo().dropped == 100, "points beyond the slot are cut and counted");
+  }
+  {
+    // A new publisher with the same layout takes the ring over
+    ScanSubscriber subscriber(name);
+    std::vector<ScanPoint> scan;
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Ok, "a closed ring still serves its last revolution");
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Closed, "...then reports Closed");
+    ScanPublisher publisher(name, 4, MAX_POINTS);
+    publisher.publish(makeScan(7, sizeOf(7)));
+    expect(subscriber.readScan(scan, Clock::now()) == Status::Ok && subscriber.lastInfo().number == 7,
+           "a restarted publisher keeps numbering for old readers");
+  }
+  {
+    // Readers write the header, so the group's write bit must survive the umask
+    auto mode = [&]() {
+      struct stat st{};
+      return stat(("/dev/shm" + name).c_str(), &st) == 0 ? st.st_mode & 0777 : 0;
+    };
+    umask(022);
+    shm_unlink(name.c_str());
+    { ScanPublisher publisher(name, 4, MAX_POINTS); }
+    expect(mode() == ScanPublisher::DEFAULT_MODE, "a new ring is group-writable despite the umask");
+    { ScanPublisher publisher(name, 4, MAX_POINTS, 0600); }
+    expect(mode() == 0600, "a publisher taking over its own ring applies its mode");
+  }
+  shm_unlink(name.c_str());
+
+  std::printf("Publisher thread and 2 readers, 2-slot ring:\n");
+  std::unique_ptr<ScanPublisher> publisher(new ScanPublisher(name, 2, MAX_POINTS));
+  std::vector<std::vector<ScanPoint>> scans;
+  for (uint64_t n = 0; n < 16; ++n) scans.push_back(makeScan(n, MAX_POINTS));
+
+  ReaderResult results[2];
+  std::thread readers[2];
+  for (int r = 0; r < 2; ++r) readers[r] = std::thread(readUntilClosed, name, std::ref(results[r]));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  std::vector<ScanPoint> scan;
+  for (uint64_t n = 1; n <= SCANS; ++n) {
+    // Reuse a prebuilt scan, rewritten with this number
+    scan = scans[n % scans.size()];
+    scan.resize(sizeOf(n));
+    for (auto& p : scan) p.range = double(n);
+    publisher->publish(scan);
+  }
+  publisher.reset();   // Closes the ring: readers stop
+  for (auto& reader : readers) reader.join();
+  shm_unlink(name.c_str());
+
+  for (int r = 0; r < 2; ++r) {
+    const ReaderResult& res = results[r];
+    std::printf("  reader %d: %llu copies (%llu retried, %llu skipped), %llu views (%llu overwritten while read)\n",
+                r, (unsigned long long)res.scans, (unsigned long long)res.retries,
+                (unsigned long long)res.skipped, (unsigned long long)res.views,
+                (unsigned long long)res.invalidated);
+    expect(res.scans > 0 && res.torn == 0, "every copy is one whole revolution");
+    expect(res.undetected == 0, "every torn view is caught by stillValid()");
+  }
+
+  if (!g_ok) {
+    std::printf("Shared-memory scan ring FAILED\n");
+    return 1;
+  }
+  std::printf("Readers only ever saw whole revolutions.\n");
+  return 0;
+}
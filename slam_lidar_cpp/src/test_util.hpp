@@ -0,0 +1,14 @@
+// src/test_util.hpp
+//
+// Check helper shared by the unit tests: one aligned "ok"/"FAILED" line per
+// check, and g_ok for the summary line and exit status at the end of main().
+
+#pragma once
+#include <cstdio>
+
+inline bool g_ok = true;
+
+inline void expect(bool condition, const char* what) {
+  std::printf("  %-58s %s\n", what, condition ? "ok" : "FAILED");
+  g_ok &= condition;
+}